@@ -6,7 +6,9 @@
 
 #include <arpa/inet.h>
 #include <elf.h>
+#include <string.h>
 
+#include <algorithm>
 #include <vector>
 
 #include "base/bits.h"
@@ -25,6 +27,8 @@ using Dyn = Elf32_Dyn;
 using Half = Elf32_Half;
 using Nhdr = Elf32_Nhdr;
 using Phdr = Elf32_Phdr;
+using Shdr = Elf32_Shdr;
+using Sym = Elf32_Sym;
 using Word = Elf32_Word;
 #else
 using Ehdr = Elf64_Ehdr;
@@ -32,6 +36,8 @@ using Dyn = Elf64_Dyn;
 using Half = Elf64_Half;
 using Nhdr = Elf64_Nhdr;
 using Phdr = Elf64_Phdr;
+using Shdr = Elf64_Shdr;
+using Sym = Elf64_Sym;
 using Word = Elf64_Word;
 #endif
 
@@ -84,6 +90,20 @@ std::vector<ElfSegment> FindElfSegments(const void* elf_mapped_base,
   return segments;
 }
 
+// Returns whether the |size| bytes at |offset| are within |elf_file|.
+bool IsInFile(span<const char> elf_file, uint64_t offset, uint64_t size) {
+  return offset <= elf_file.size() && size <= elf_file.size() - offset;
+}
+
+// Returns the first section of |type|, or null if there is none.
+const Shdr* FindElfSection(span<const Shdr> sections, Word type) {
+  for (const Shdr& section : sections) {
+    if (section.sh_type == type)
+      return &section;
+  }
+  return nullptr;
+}
+
 }  // namespace
 
 Optional<std::string> ReadElfBuildId(const void* elf_base) {
@@ -128,5 +148,60 @@ Optional<std::string> ReadElfLibraryName(const void* elf_base) {
   return nullopt;
 }
 
+std::vector<ElfSymbol> ReadElfFunctionSymbols(span<const char> elf_file) {
+  std::vector<ElfSymbol> symbols;
+  if (elf_file.size() < sizeof(Ehdr) ||
+      strncmp(elf_file.data(), ELFMAG, SELFMAG) != 0) {
+    return symbols;
+  }
+
+  const Ehdr* elf_header = reinterpret_cast<const Ehdr*>(elf_file.data());
+  if (elf_header->e_shentsize != sizeof(Shdr) ||
+      !IsInFile(elf_file, elf_header->e_shoff,
+                static_cast<uint64_t>(elf_header->e_shnum) * sizeof(Shdr))) {
+    return symbols;
+  }
+  span<const Shdr> sections(
+      reinterpret_cast<const Shdr*>(elf_file.data() + elf_header->e_shoff),
+      elf_header->e_shnum);
+
+  const Shdr* symtab = FindElfSection(sections, SHT_SYMTAB);
+  if (!symtab)
+    symtab = FindElfSection(sections, SHT_DYNSYM);
+  if (!symtab || symtab->sh_entsize != sizeof(Sym) ||
+      symtab->sh_link >= sections.size() ||
+      !IsInFile(elf_file, symtab->sh_offset, symtab->sh_size)) {
+    return symbols;
+  }
+  const Shdr& strtab = sections[symtab->sh_link];
+  if (strtab.sh_size == 0 ||
+      !IsInFile(elf_file, strtab.sh_offset, strtab.sh_size) ||
+      elf_file[strtab.sh_offset + strtab.sh_size - 1] != '\0') {
+    return symbols;
+  }
+  const char* names = elf_file.data() + strtab.sh_offset;
+
+  span<const Sym> elf_symbols(
+      reinterpret_cast<const Sym*>(elf_file.data() + symtab->sh_offset),
+      symtab->sh_size / sizeof(Sym));
+  for (const Sym& elf_symbol : elf_symbols) {
+    // ELF32_ST_TYPE() and ELF64_ST_TYPE() are the same.
+    if (ELF64_ST_TYPE(elf_symbol.st_info) != STT_FUNC ||
+        elf_symbol.st_shndx == SHN_UNDEF || elf_symbol.st_value == 0 ||
+        elf_symbol.st_name >= strtab.sh_size) {
+      continue;
+    }
+    symbols.push_back({static_cast<uintptr_t>(elf_symbol.st_value),
+                       static_cast<size_t>(elf_symbol.st_size),
+                       names + elf_symbol.st_name});
+  }
+
+  std::sort(symbols.begin(), symbols.end(),
+            [](const ElfSymbol& a, const ElfSymbol& b) {
+              return a.address < b.address;
+            });
+  return symbols;
+}
+
 }  // namespace debug
 }  // namespace base
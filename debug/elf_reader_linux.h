@@ -5,9 +5,14 @@
 #ifndef BASE_DEBUG_ELF_READER_LINUX_H_
 #define BASE_DEBUG_ELF_READER_LINUX_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <string>
+#include <vector>
 
 #include "base/base_export.h"
+#include "base/containers/span.h"
 #include "base/optional.h"
 
 namespace base {
@@ -22,6 +27,25 @@ Optional<std::string> BASE_EXPORT ReadElfBuildId(const void* elf_base);
 // The caller must ensure that the file is fully mapped in memory.
 Optional<std::string> BASE_EXPORT ReadElfLibraryName(const void* elf_base);
 
+// A function symbol of an ELF file.
+struct ElfSymbol {
+  // Link-time address of the function; add the load bias of the file to get
+  // its address in memory.
+  uintptr_t address;
+  // Size of the function in bytes, or 0 if unknown.
+  size_t size;
+  // Mangled name, pointing into the file contents.
+  const char* name;
+};
+
+// Returns the function symbols of the ELF file whose whole contents are
+// |elf_file|, sorted by address. Unlike the functions above, this needs the
+// file as it is on disk (e.g. mapped with MemoryMappedFile) rather than as
+// loaded, since section headers are not loaded. The full symbol table is used
+// if the file has one, otherwise the dynamic symbol table.
+std::vector<ElfSymbol> BASE_EXPORT
+ReadElfFunctionSymbols(span<const char> elf_file);
+
 }  // namespace debug
 }  // namespace base
 
@@ -6,6 +6,10 @@
 
 #include <dlfcn.h>
 
+#include <string>
+#include <vector>
+
+#include "base/compiler_specific.h"
 #include "base/files/memory_mapped_file.h"
 #include "base/strings/string_util.h"
 #include "build/build_config.h"
@@ -66,5 +70,37 @@ TEST(ElfReaderTest, ReadElfLibraryName) {
       << kLibraryName;
 }
 
+#if !defined(OS_ANDROID)
+// Unmangled and not inlined, so that it has its own symbol.
+extern "C" NOINLINE void ElfReaderTestFunction() {}
+
+TEST(ElfReaderTest, ReadElfFunctionSymbols) {
+  // Referenced so that the linker keeps it.
+  ElfReaderTestFunction();
+
+  MemoryMappedFile file;
+  ASSERT_TRUE(file.Initialize(FilePath("/proc/self/exe")));
+  std::vector<ElfSymbol> symbols = ReadElfFunctionSymbols(
+      make_span(reinterpret_cast<const char*>(file.data()), file.length()));
+  ASSERT_FALSE(symbols.empty());
+
+  bool found = false;
+  for (size_t i = 0; i < symbols.size(); ++i) {
+    if (i > 0) {
+      EXPECT_LE(symbols[i - 1].address, symbols[i].address);
+    }
+    if (std::string(symbols[i].name) == "ElfReaderTestFunction")
+      found = true;
+  }
+  EXPECT_TRUE(found);
+}
+#endif  // !defined(OS_ANDROID)
+
+TEST(ElfReaderTest, ReadElfFunctionSymbolsInvalidFile) {
+  const char kNotElf[] = "not an ELF file";
+  EXPECT_TRUE(ReadElfFunctionSymbols(make_span(kNotElf)).empty());
+  EXPECT_TRUE(ReadElfFunctionSymbols(span<const char>()).empty());
+}
+
 }  // namespace debug
 }  // namespace base
@@ -0,0 +1,161 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/debug/elf_symbol_cache_linux.h"
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <link.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "base/debug/elf_reader_linux.h"
+#include "base/files/file_path.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/threading/thread_restrictions.h"
+
+namespace base {
+namespace debug {
+
+namespace {
+
+// The file of the main executable, which the dynamic linker gives no name.
+constexpr char kSelfExe[] = "/proc/self/exe";
+
+}  // namespace
+
+struct ElfSymbolCache::Symbol {
+  bool Contains(uintptr_t address) const {
+    return address >= start && address < end;
+  }
+
+  // Demangles |name| on first use.
+  const char* GetDemangledName() const {
+    const char* demangled = demangled_name.load(std::memory_order_acquire);
+    if (demangled)
+      return demangled;
+
+    int status = 0;
+    char* result = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    const char* expected = nullptr;
+    const char* desired = status == 0 && result ? result : name;
+    if (demangled_name.compare_exchange_strong(expected, desired,
+                                               std::memory_order_acq_rel)) {
+      return desired;
+    }
+    // Another thread demangled it first.
+    free(result);
+    return expected;
+  }
+
+  // Address range of the function in memory. Functions of unknown size extend
+  // to the next symbol.
+  uintptr_t start = 0;
+  uintptr_t end = 0;
+  // Mangled name, in the mapped file.
+  const char* name = nullptr;
+  // Demangled name, or |name| if it is not mangled. Never freed.
+  mutable std::atomic<const char*> demangled_name{nullptr};
+};
+
+struct ElfSymbolCache::Module {
+  MemoryMappedFile file;
+  // Sorted by address.
+  std::unique_ptr<Symbol[]> symbols;
+  size_t num_symbols = 0;
+};
+
+// static
+ElfSymbolCache* ElfSymbolCache::GetInstance() {
+  static NoDestructor<ElfSymbolCache> instance;
+  return instance.get();
+}
+
+ElfSymbolCache::ElfSymbolCache() {
+  for (std::atomic<const Symbol*>& slot : recent_symbols_)
+    slot.store(nullptr, std::memory_order_relaxed);
+}
+
+ElfSymbolCache::~ElfSymbolCache() = default;
+
+const char* ElfSymbolCache::Lookup(const void* address) {
+  const uintptr_t pc = reinterpret_cast<uintptr_t>(address);
+  std::atomic<const Symbol*>& slot =
+      recent_symbols_[(pc ^ (pc >> 12)) % kRecentSymbolsSize];
+  const Symbol* symbol = slot.load(std::memory_order_acquire);
+  if (!symbol || !symbol->Contains(pc)) {
+    symbol = FindSymbol(pc);
+    if (!symbol)
+      return nullptr;
+    slot.store(symbol, std::memory_order_release);
+  }
+  return symbol->GetDemangledName();
+}
+
+const ElfSymbolCache::Symbol* ElfSymbolCache::FindSymbol(uintptr_t address) {
+  Dl_info info;
+  link_map* map = nullptr;
+  if (!dladdr1(reinterpret_cast<void*>(address), &info,
+               reinterpret_cast<void**>(&map), RTLD_DL_LINKMAP) ||
+      !map) {
+    return nullptr;
+  }
+
+  const Module* module;
+  {
+    AutoLock lock(modules_lock_);
+    module = GetModule(map->l_addr, map->l_name[0] ? map->l_name : kSelfExe);
+  }
+
+  // Modules are immutable once loaded, so they can be searched without the
+  // lock.
+  const Symbol* symbols = module->symbols.get();
+  const Symbol* next = std::upper_bound(
+      symbols, symbols + module->num_symbols, address,
+      [](uintptr_t address, const Symbol& symbol) {
+        return address < symbol.start;
+      });
+  if (next == symbols)
+    return nullptr;
+  const Symbol* symbol = next - 1;
+  return symbol->Contains(address) ? symbol : nullptr;
+}
+
+const ElfSymbolCache::Module* ElfSymbolCache::GetModule(uintptr_t load_bias,
+                                                        const char* path) {
+  modules_lock_.AssertAcquired();
+  std::unique_ptr<Module>& module = modules_[load_bias];
+  if (module)
+    return module.get();
+
+  module = std::make_unique<Module>();
+  // Symbolization is a debugging aid that may run on any thread.
+  ThreadRestrictions::ScopedAllowIO allow_io;
+  if (!module->file.Initialize(FilePath(path)))
+    return module.get();
+
+  std::vector<ElfSymbol> elf_symbols = ReadElfFunctionSymbols(
+      make_span(reinterpret_cast<const char*>(module->file.data()),
+                module->file.length()));
+  module->num_symbols = elf_symbols.size();
+  module->symbols.reset(new Symbol[elf_symbols.size()]);
+  for (size_t i = 0; i < elf_symbols.size(); ++i) {
+    Symbol& symbol = module->symbols[i];
+    symbol.start = load_bias + elf_symbols[i].address;
+    if (elf_symbols[i].size) {
+      symbol.end = symbol.start + elf_symbols[i].size;
+    } else if (i + 1 < elf_symbols.size()) {
+      symbol.end = load_bias + elf_symbols[i + 1].address;
+    } else {
+      symbol.end = symbol.start + 1;
+    }
+    symbol.name = elf_symbols[i].name;
+  }
+  return module.get();
+}
+
+}  // namespace debug
+}  // namespace base
@@ -0,0 +1,74 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_DEBUG_ELF_SYMBOL_CACHE_LINUX_H_
+#define BASE_DEBUG_ELF_SYMBOL_CACHE_LINUX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+
+#include "base/base_export.h"
+#include "base/containers/flat_map.h"
+#include "base/macros.h"
+#include "base/no_destructor.h"
+#include "base/synchronization/lock.h"
+
+namespace base {
+namespace debug {
+
+// Maps code addresses of the current process to the names of their functions,
+// using the symbol tables of the loaded ELF files. Each file is mapped and its
+// symbols are read and sorted the first time one of its addresses is looked
+// up, and recently found symbols are remembered in a lock-free table, so
+// symbolizing many stacks, as leak reports and heap profiles do, costs about a
+// table lookup per frame instead of a pass over a symbol table on disk.
+//
+// Unlike google::Symbolize(), lookups allocate and take locks on a miss, so
+// this must not be used from signal handlers. Files that cannot be opened,
+// e.g. in a sandboxed process, have no symbols. Files unloaded with dlclose()
+// are not forgotten.
+class BASE_EXPORT ElfSymbolCache {
+ public:
+  static ElfSymbolCache* GetInstance();
+
+  // Returns the demangled name of the function containing |address|, or null
+  // if it is unknown. The name remains valid for the lifetime of the process.
+  const char* Lookup(const void* address);
+
+ private:
+  friend class NoDestructor<ElfSymbolCache>;
+
+  struct Module;
+  struct Symbol;
+
+  ElfSymbolCache();
+  ~ElfSymbolCache();
+
+  // Finds the symbol containing |address| in the symbol tables.
+  const Symbol* FindSymbol(uintptr_t address);
+
+  // Returns the module loaded at |load_bias| from |path|, reading its symbols
+  // if this is the first lookup in it.
+  const Module* GetModule(uintptr_t load_bias, const char* path);
+
+  // Recently found symbols, indexed by a hash of the looked up address. Each
+  // slot holds a pointer to an immutable Symbol that is never freed, so
+  // readers need no lock and cannot see a torn entry.
+  static constexpr size_t kRecentSymbolsSize = 4096;
+  std::atomic<const Symbol*> recent_symbols_[kRecentSymbolsSize];
+
+  Lock modules_lock_;
+  // Modules by load bias. Never erased, so that Symbols stay valid.
+  flat_map<uintptr_t, std::unique_ptr<Module>> modules_;
+
+  DISALLOW_COPY_AND_ASSIGN(ElfSymbolCache);
+};
+
+}  // namespace debug
+}  // namespace base
+
+#endif  // BASE_DEBUG_ELF_SYMBOL_CACHE_LINUX_H_
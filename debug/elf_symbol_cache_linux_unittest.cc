@@ -0,0 +1,49 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/debug/elf_symbol_cache_linux.h"
+
+#include <string>
+
+#include "base/compiler_specific.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace debug {
+
+namespace {
+
+NOINLINE int ElfSymbolCacheTestFunction(int value) {
+  return value * 3 + 1;
+}
+
+}  // namespace
+
+TEST(ElfSymbolCacheTest, LookupFunction) {
+  // Look up an address inside the function rather than its entry, as stack
+  // traces do.
+  const char* address =
+      reinterpret_cast<const char*>(&ElfSymbolCacheTestFunction) + 1;
+  const char* name = ElfSymbolCache::GetInstance()->Lookup(address);
+  ASSERT_TRUE(name);
+  EXPECT_NE(std::string::npos,
+            std::string(name).find("ElfSymbolCacheTestFunction"))
+      << name;
+  // Names are demangled.
+  EXPECT_NE(std::string::npos, std::string(name).find("base::debug::"))
+      << name;
+
+  // Repeated lookups return the cached name.
+  EXPECT_EQ(name, ElfSymbolCache::GetInstance()->Lookup(address));
+  EXPECT_EQ(4, ElfSymbolCacheTestFunction(1));
+}
+
+TEST(ElfSymbolCacheTest, LookupUnknownAddress) {
+  EXPECT_FALSE(ElfSymbolCache::GetInstance()->Lookup(nullptr));
+  int on_stack = 0;
+  EXPECT_FALSE(ElfSymbolCache::GetInstance()->Lookup(&on_stack));
+}
+
+}  // namespace debug
+}  // namespace base
@@ -0,0 +1,65 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/debug/stack_trace.h"
+
+#include <string>
+
+#include "base/compiler_specific.h"
+#include "base/debug/alias.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+namespace debug {
+
+namespace {
+
+constexpr int kCaptureIterations = 100000;
+constexpr int kToStringIterations = 100;
+
+// Adds |depth| frames to the stack before capturing it.
+NOINLINE StackTrace CaptureAtDepth(int depth) {
+  if (depth > 0) {
+    StackTrace trace = CaptureAtDepth(depth - 1);
+    // Prevents tail call optimization.
+    Alias(&depth);
+    return trace;
+  }
+  return StackTrace();
+}
+
+}  // namespace
+
+TEST(StackTracePerfTest, Capture) {
+  size_t frames = 0;
+  TimeTicks start = TimeTicks::Now();
+  for (int i = 0; i < kCaptureIterations; ++i) {
+    size_t count;
+    CaptureAtDepth(16).Addresses(&count);
+    frames += count;
+  }
+  TimeDelta elapsed = TimeTicks::Now() - start;
+  ASSERT_GT(frames, 0u);
+  perf_test::PrintResult(
+      "StackTrace", "_capture", "",
+      elapsed.InMicrosecondsF() * 1000 / kCaptureIterations, "ns", true);
+}
+
+TEST(StackTracePerfTest, ToString) {
+  StackTrace trace = CaptureAtDepth(16);
+  size_t length = 0;
+  TimeTicks start = TimeTicks::Now();
+  for (int i = 0; i < kToStringIterations; ++i)
+    length += trace.ToString().size();
+  TimeDelta elapsed = TimeTicks::Now() - start;
+  ASSERT_GT(length, 0u);
+  perf_test::PrintResult("StackTrace", "_to_string", "",
+                         elapsed.InMicrosecondsF() / kToStringIterations, "us",
+                         true);
+}
+
+}  // namespace debug
+}  // namespace base
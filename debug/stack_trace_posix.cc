@@ -52,6 +52,7 @@
 #include "build/build_config.h"
 
 #if defined(USE_SYMBOLIZE)
+#include "base/debug/elf_symbol_cache_linux.h"
 #include "base/third_party/symbolize/symbolize.h"
 #endif
 
@@ -173,7 +174,16 @@ void ProcessBacktrace(void *const *trace,
     // Subtract by one as return address of function may be in the next
     // function when a function is annotated as noreturn.
     void* address = static_cast<char*>(trace[i]) - 1;
-    if (google::Symbolize(address, buf, sizeof(buf)))
+
+    // Outside of signal handlers, use the process-wide symbol cache, which
+    // makes printing many stacks much cheaper but allocates.
+    const char* symbol = nullptr;
+    if (in_signal_handler == 0)
+      symbol = ElfSymbolCache::GetInstance()->Lookup(address);
+
+    if (symbol)
+      handler->HandleOutput(symbol);
+    else if (google::Symbolize(address, buf, sizeof(buf)))
       handler->HandleOutput(buf);
     else
       handler->HandleOutput("<unknown>");
@@ -803,6 +813,17 @@ StackTrace::StackTrace(size_t count) {
 #if !defined(__UCLIBC__) && !defined(_AIX)
   count = std::min(arraysize(trace_), count);
 
+#if BUILDFLAG(CAN_UNWIND_WITH_FRAME_POINTERS)
+  // Walking frame pointers is much cheaper than backtrace(), which runs the
+  // DWARF unwinder and may allocate. It cannot unwind through the frame of a
+  // signal handler though, so crash reports still use backtrace().
+  if (in_signal_handler == 0) {
+    count_ = TraceStackFramePointers(const_cast<const void**>(trace_), count,
+                                     0);
+    return;
+  }
+#endif  // BUILDFLAG(CAN_UNWIND_WITH_FRAME_POINTERS)
+
   // Though the backtrace API man page does not list any possible negative
   // return values, we take no chance.
   count_ = base::saturated_cast<size_t>(backtrace(trace_, count));
@@ -6,11 +6,15 @@
 
 #include <array>
 
+#include "base/compiler_specific.h"
 #include "base/debug/activity_tracker.h"
 #include "base/debug/alias.h"
+#include "base/debug/task_profiler.h"
+#include "base/debug/thread_heap_usage_tracker.h"
 #include "base/no_destructor.h"
 #include "base/pending_task.h"
 #include "base/threading/thread_local.h"
+#include "base/time/time.h"
 #include "base/trace_event/trace_event.h"
 
 namespace base {
@@ -29,6 +33,33 @@ ThreadLocalPointer<const PendingTask>* GetTLSForCurrentPendingTask() {
   return tls_for_current_pending_task.get();
 }
 
+// Runs |pending_task| and reports its costs to the TaskProfiler.
+void RunProfiledTask(PendingTask* pending_task) {
+  const bool track_heap = ThreadHeapUsageTracker::IsHeapTrackingEnabled();
+  const bool track_cpu = ThreadTicks::IsSupported();
+  ThreadHeapUsageTracker heap_usage_tracker;
+  if (track_heap)
+    heap_usage_tracker.Start();
+  const ThreadTicks start_thread_ticks =
+      track_cpu ? ThreadTicks::Now() : ThreadTicks();
+  const TimeTicks start_ticks = TimeTicks::Now();
+
+  std::move(pending_task->task).Run();
+
+  TaskProfiler::Stats stats;
+  stats.run_count = 1;
+  stats.wall_time = TimeTicks::Now() - start_ticks;
+  if (track_cpu)
+    stats.cpu_time = ThreadTicks::Now() - start_thread_ticks;
+  if (track_heap) {
+    // Nested tasks are accounted to this one too.
+    heap_usage_tracker.Stop(false);
+    stats.alloc_ops = heap_usage_tracker.usage().alloc_ops;
+    stats.alloc_bytes = heap_usage_tracker.usage().alloc_bytes;
+  }
+  TaskProfiler::GetInstance()->RecordTaskRun(pending_task->posted_from, stats);
+}
+
 }  // namespace
 
 TaskAnnotator::TaskAnnotator() = default;
@@ -98,7 +129,10 @@ void TaskAnnotator::RunTask(const char* queue_function,
 
   if (g_task_annotator_observer)
     g_task_annotator_observer->BeforeRunTask(pending_task);
-  std::move(pending_task->task).Run();
+  if (UNLIKELY(TaskProfiler::IsEnabled()))
+    RunProfiledTask(pending_task);
+  else
+    std::move(pending_task->task).Run();
 
   tls_for_current_pending_task->Set(previous_pending_task);
 }
@@ -0,0 +1,338 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/debug/task_profiler.h"
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+
+#include "base/files/file_path.h"
+#include "base/logging.h"
+#include "base/no_destructor.h"
+#include "base/strings/string_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/trace_event/memory_allocator_dump.h"
+#include "base/trace_event/memory_dump_manager.h"
+#include "base/trace_event/process_memory_dump.h"
+
+namespace base {
+namespace debug {
+
+namespace {
+
+// Number of locations with the largest allocated bytes that OnMemoryDump()
+// reports.
+constexpr size_t kMaxDumpedEntries = 100;
+
+uint64_t GetSortValue(const TaskProfiler::Stats& stats,
+                      TaskProfiler::SortKey sort_key) {
+  switch (sort_key) {
+    case TaskProfiler::SortKey::kRunCount:
+      return stats.run_count;
+    case TaskProfiler::SortKey::kAllocOps:
+      return stats.alloc_ops;
+    case TaskProfiler::SortKey::kAllocBytes:
+      return stats.alloc_bytes;
+    case TaskProfiler::SortKey::kCpuTime:
+      return stats.cpu_time.InMicroseconds();
+    case TaskProfiler::SortKey::kWallTime:
+      return stats.wall_time.InMicroseconds();
+  }
+  NOTREACHED();
+  return 0;
+}
+
+// Returns "<function>@<file basename>:<line>", or the program counter for
+// locations without source information, with characters that are not allowed
+// in allocator dump names replaced.
+std::string GetDumpName(const Location& location) {
+  std::string name;
+  if (location.has_source_info()) {
+    name = StringPrintf(
+        "%s@%s:%d", location.function_name(),
+        FilePath::FromUTF8Unsafe(location.file_name()).BaseName().AsUTF8Unsafe()
+            .c_str(),
+        location.line_number());
+  } else {
+    name = StringPrintf("pc_%p", location.program_counter());
+  }
+  for (char& c : name) {
+    if (!IsAsciiAlpha(c) && !IsAsciiDigit(c) && c != '_' && c != '.' &&
+        c != ':' && c != '@' && c != '-') {
+      c = '_';
+    }
+  }
+  return "task_profiler/" + name;
+}
+
+}  // namespace
+
+// Costs of the tasks a thread ran, written only by that thread. The counters
+// are atomics so that they can be read while the thread updates them, but are
+// only ever loaded and stored, never read-modify-written.
+class TaskProfiler::ThreadTable {
+ public:
+  ThreadTable() = default;
+  ~ThreadTable() = default;
+
+  void Record(const Location& posted_from, const Stats& stats) {
+    EntryCounters*& counters = index_[posted_from];
+    if (!counters)
+      counters = AddEntry(posted_from);
+    Add(&counters->run_count, stats.run_count);
+    Add(&counters->alloc_ops, stats.alloc_ops);
+    Add(&counters->alloc_bytes, stats.alloc_bytes);
+    Add(&counters->cpu_time_us, stats.cpu_time.InMicroseconds());
+    Add(&counters->wall_time_us, stats.wall_time.InMicroseconds());
+  }
+
+  // Adds the entries of this table to |entries|. Can be called from any
+  // thread.
+  void AccumulateEntries(std::unordered_map<Location, Stats>* entries) const {
+    // Pairs with the release store in AddEntry(), so that the locations of the
+    // published entries are visible.
+    size_t remaining = size_.load(std::memory_order_acquire);
+    for (const Chunk* chunk = &first_chunk_; remaining;
+         chunk = chunk->next.load(std::memory_order_acquire)) {
+      for (size_t i = 0; i < kChunkSize && remaining; ++i, --remaining) {
+        const EntryCounters& counters = chunk->entries[i];
+        Stats stats;
+        stats.run_count = counters.run_count.load(std::memory_order_relaxed);
+        stats.alloc_ops = counters.alloc_ops.load(std::memory_order_relaxed);
+        stats.alloc_bytes =
+            counters.alloc_bytes.load(std::memory_order_relaxed);
+        stats.cpu_time = TimeDelta::FromMicroseconds(
+            counters.cpu_time_us.load(std::memory_order_relaxed));
+        stats.wall_time = TimeDelta::FromMicroseconds(
+            counters.wall_time_us.load(std::memory_order_relaxed));
+        (*entries)[counters.posted_from] += stats;
+      }
+    }
+  }
+
+  // All tables, and tables of exited threads. Guarded by TaskProfiler::lock_.
+  ThreadTable* next = nullptr;
+  ThreadTable* next_orphaned = nullptr;
+
+ private:
+  static constexpr size_t kChunkSize = 64;
+
+  struct EntryCounters {
+    Location posted_from;
+    std::atomic<uint64_t> run_count{0};
+    std::atomic<uint64_t> alloc_ops{0};
+    std::atomic<uint64_t> alloc_bytes{0};
+    std::atomic<int64_t> cpu_time_us{0};
+    std::atomic<int64_t> wall_time_us{0};
+  };
+
+  // Entries are never moved once published, so tables grow by whole chunks.
+  struct Chunk {
+    EntryCounters entries[kChunkSize];
+    std::atomic<Chunk*> next{nullptr};
+  };
+
+  template <typename T>
+  static void Add(std::atomic<T>* counter, T value) {
+    counter->store(counter->load(std::memory_order_relaxed) + value,
+                   std::memory_order_relaxed);
+  }
+
+  EntryCounters* AddEntry(const Location& posted_from) {
+    const size_t index = size_.load(std::memory_order_relaxed);
+    if (index && index % kChunkSize == 0) {
+      Chunk* chunk = new Chunk;
+      last_chunk_->next.store(chunk, std::memory_order_release);
+      last_chunk_ = chunk;
+      owned_chunks_.emplace_back(chunk);
+    }
+    EntryCounters* counters = &last_chunk_->entries[index % kChunkSize];
+    counters->posted_from = posted_from;
+    size_.store(index + 1, std::memory_order_release);
+    return counters;
+  }
+
+  Chunk first_chunk_;
+  Chunk* last_chunk_ = &first_chunk_;
+  std::vector<std::unique_ptr<Chunk>> owned_chunks_;
+
+  // Number of published entries.
+  std::atomic<size_t> size_{0};
+
+  // Only used by the thread that owns the table.
+  std::unordered_map<Location, EntryCounters*> index_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadTable);
+};
+
+TaskProfiler::Stats::Stats() = default;
+
+TaskProfiler::Stats::Stats(const Stats& other) = default;
+
+TaskProfiler::Stats::~Stats() = default;
+
+TaskProfiler::Stats& TaskProfiler::Stats::operator+=(const Stats& other) {
+  run_count += other.run_count;
+  alloc_ops += other.alloc_ops;
+  alloc_bytes += other.alloc_bytes;
+  cpu_time += other.cpu_time;
+  wall_time += other.wall_time;
+  return *this;
+}
+
+TaskProfiler::Entry::Entry(const Location& posted_from, const Stats& stats)
+    : posted_from(posted_from), stats(stats) {}
+
+TaskProfiler::Entry::Entry(const Entry& other) = default;
+
+TaskProfiler::Entry::~Entry() = default;
+
+// static
+std::atomic<bool> TaskProfiler::enabled_{false};
+
+// static
+TaskProfiler* TaskProfiler::GetInstance() {
+  static NoDestructor<TaskProfiler> instance;
+  return instance.get();
+}
+
+TaskProfiler::TaskProfiler() : thread_table_tls_(&OnThreadExit) {}
+
+TaskProfiler::~TaskProfiler() = default;
+
+void TaskProfiler::Enable() {
+  bool register_dump_provider;
+  {
+    AutoLock lock(lock_);
+    register_dump_provider = !registered_with_memory_dump_manager_;
+    registered_with_memory_dump_manager_ = true;
+  }
+  // OnMemoryDump() takes |lock_|, so register without holding it.
+  if (register_dump_provider) {
+    trace_event::MemoryDumpManager::GetInstance()->RegisterDumpProvider(
+        this, "TaskProfiler", nullptr);
+  }
+  enabled_.store(true, std::memory_order_relaxed);
+}
+
+void TaskProfiler::Disable() {
+  enabled_.store(false, std::memory_order_relaxed);
+}
+
+std::vector<TaskProfiler::Entry> TaskProfiler::GetEntries(
+    SortKey sort_key) const {
+  std::unordered_map<Location, Stats> stats_by_location;
+  {
+    AutoLock lock(lock_);
+    for (const ThreadTable* table = thread_tables_; table; table = table->next)
+      table->AccumulateEntries(&stats_by_location);
+  }
+
+  std::vector<Entry> entries;
+  entries.reserve(stats_by_location.size());
+  for (const auto& location_and_stats : stats_by_location)
+    entries.emplace_back(location_and_stats.first, location_and_stats.second);
+  std::stable_sort(entries.begin(), entries.end(),
+                   [sort_key](const Entry& lhs, const Entry& rhs) {
+                     return GetSortValue(lhs.stats, sort_key) >
+                            GetSortValue(rhs.stats, sort_key);
+                   });
+  return entries;
+}
+
+std::string TaskProfiler::GetReport(SortKey sort_key,
+                                    size_t max_entries) const {
+  std::vector<Entry> entries = GetEntries(sort_key);
+  std::string report = StringPrintf("%10s %12s %14s %12s %12s  %s\n", "runs",
+                                    "allocs", "alloc_bytes", "cpu_us",
+                                    "wall_us", "posted_from");
+  for (size_t i = 0; i < entries.size() && i < max_entries; ++i) {
+    const Stats& stats = entries[i].stats;
+    StringAppendF(&report, "%10llu %12llu %14llu %12lld %12lld  %s\n",
+                  static_cast<unsigned long long>(stats.run_count),
+                  static_cast<unsigned long long>(stats.alloc_ops),
+                  static_cast<unsigned long long>(stats.alloc_bytes),
+                  static_cast<long long>(stats.cpu_time.InMicroseconds()),
+                  static_cast<long long>(stats.wall_time.InMicroseconds()),
+                  entries[i].posted_from.ToString().c_str());
+  }
+  return report;
+}
+
+void TaskProfiler::RecordTaskRun(const Location& posted_from,
+                                 const Stats& stats) {
+  GetThreadTable()->Record(posted_from, stats);
+}
+
+bool TaskProfiler::OnMemoryDump(const trace_event::MemoryDumpArgs& args,
+                                trace_event::ProcessMemoryDump* pmd) {
+  using trace_event::MemoryAllocatorDump;
+  if (args.level_of_detail !=
+      trace_event::MemoryDumpLevelOfDetail::DETAILED) {
+    return true;
+  }
+
+  std::vector<Entry> entries = GetEntries(SortKey::kAllocBytes);
+  if (entries.size() > kMaxDumpedEntries)
+    entries.erase(entries.begin() + kMaxDumpedEntries, entries.end());
+  for (const Entry& entry : entries) {
+    // Locations in files with the same basename and line share a dump name,
+    // which keeps the one that allocated the most.
+    const std::string dump_name = GetDumpName(entry.posted_from);
+    if (pmd->GetAllocatorDump(dump_name))
+      continue;
+    MemoryAllocatorDump* dump = pmd->CreateAllocatorDump(dump_name);
+    dump->AddScalar("run_count", MemoryAllocatorDump::kUnitsObjects,
+                    entry.stats.run_count);
+    dump->AddScalar("alloc_count", MemoryAllocatorDump::kUnitsObjects,
+                    entry.stats.alloc_ops);
+    dump->AddScalar(MemoryAllocatorDump::kNameSize,
+                    MemoryAllocatorDump::kUnitsBytes, entry.stats.alloc_bytes);
+    dump->AddScalar(
+        "cpu_time_us", "us",
+        static_cast<uint64_t>(entry.stats.cpu_time.InMicroseconds()));
+    dump->AddScalar(
+        "wall_time_us", "us",
+        static_cast<uint64_t>(entry.stats.wall_time.InMicroseconds()));
+  }
+  return true;
+}
+
+TaskProfiler::ThreadTable* TaskProfiler::GetThreadTable() {
+  ThreadTable* table = static_cast<ThreadTable*>(thread_table_tls_.Get());
+  if (table)
+    return table;
+
+  {
+    AutoLock lock(lock_);
+    if (orphaned_thread_tables_) {
+      table = orphaned_thread_tables_;
+      orphaned_thread_tables_ = table->next_orphaned;
+      table->next_orphaned = nullptr;
+    }
+  }
+  if (!table) {
+    table = new ThreadTable;
+    AutoLock lock(lock_);
+    table->next = thread_tables_;
+    thread_tables_ = table;
+  }
+  thread_table_tls_.Set(table);
+  return table;
+}
+
+// static
+void TaskProfiler::OnThreadExit(void* thread_table) {
+  // The table keeps the costs of the exited thread, and a new thread adds to
+  // it instead of allocating a table.
+  ThreadTable* table = static_cast<ThreadTable*>(thread_table);
+  TaskProfiler* profiler = GetInstance();
+  AutoLock lock(profiler->lock_);
+  table->next_orphaned = profiler->orphaned_thread_tables_;
+  profiler->orphaned_thread_tables_ = table;
+}
+
+}  // namespace debug
+}  // namespace base
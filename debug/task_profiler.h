@@ -0,0 +1,136 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_DEBUG_TASK_PROFILER_H_
+#define BASE_DEBUG_TASK_PROFILER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/location.h"
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/thread_local_storage.h"
+#include "base/time/time.h"
+#include "base/trace_event/memory_dump_provider.h"
+
+namespace base {
+
+template <typename T>
+class NoDestructor;
+
+namespace debug {
+
+// Accounts the cost of tasks to the location they were posted from: how many
+// times they ran, their wall and thread CPU time and, if heap tracking is
+// enabled with ThreadHeapUsageTracker::EnableHeapTracking(), the number and
+// size of their heap allocations. TaskAnnotator::RunTask() reports every task
+// it runs while the profiler is enabled, which costs a few clock reads per
+// task, and nothing when it is disabled.
+//
+// Each thread adds its tasks' costs to its own table, without locks or atomic
+// read-modify-writes; GetEntries() sums the tables of all threads. Costs of a
+// task include those of nested tasks it runs, e.g. with a nested RunLoop.
+//
+// The costs can be read with GetEntries() or GetReport(), or through the
+// MemoryDumpManager, which dumps the locations with the largest allocated
+// bytes in detailed dumps as "task_profiler/<location>" allocator dumps.
+class BASE_EXPORT TaskProfiler : public trace_event::MemoryDumpProvider {
+ public:
+  // Total costs of the tasks posted from a location.
+  struct BASE_EXPORT Stats {
+    Stats();
+    Stats(const Stats& other);
+    ~Stats();
+
+    Stats& operator+=(const Stats& other);
+
+    uint64_t run_count = 0;
+    uint64_t alloc_ops = 0;
+    uint64_t alloc_bytes = 0;
+    TimeDelta cpu_time;
+    TimeDelta wall_time;
+  };
+
+  struct BASE_EXPORT Entry {
+    Entry(const Location& posted_from, const Stats& stats);
+    Entry(const Entry& other);
+    ~Entry();
+
+    Location posted_from;
+    Stats stats;
+  };
+
+  enum class SortKey {
+    kRunCount,
+    kAllocOps,
+    kAllocBytes,
+    kCpuTime,
+    kWallTime,
+  };
+
+  static TaskProfiler* GetInstance();
+
+  // Starts accounting tasks, and registers the profiler with the
+  // MemoryDumpManager the first time.
+  void Enable();
+  void Disable();
+
+  static bool IsEnabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  // Returns the costs of the tasks run so far by all threads, largest first by
+  // |sort_key|.
+  std::vector<Entry> GetEntries(SortKey sort_key) const;
+
+  // Returns a table of the first |max_entries| of GetEntries(|sort_key|), one
+  // line per location.
+  std::string GetReport(SortKey sort_key, size_t max_entries) const;
+
+  // Adds a run of a task posted from |posted_from| with the given costs to the
+  // table of the current thread.
+  void RecordTaskRun(const Location& posted_from, const Stats& stats);
+
+  // trace_event::MemoryDumpProvider:
+  bool OnMemoryDump(const trace_event::MemoryDumpArgs& args,
+                    trace_event::ProcessMemoryDump* pmd) override;
+
+ private:
+  friend class NoDestructor<TaskProfiler>;
+
+  // The table of a thread.
+  class ThreadTable;
+
+  TaskProfiler();
+  ~TaskProfiler() override;
+
+  // Returns the table of the current thread, creating it if needed.
+  ThreadTable* GetThreadTable();
+  static void OnThreadExit(void* thread_table);
+
+  static std::atomic<bool> enabled_;
+
+  ThreadLocalStorage::Slot thread_table_tls_;
+
+  mutable Lock lock_;
+  bool registered_with_memory_dump_manager_ = false;
+  // All tables, linked through ThreadTable::next. Tables are never freed so
+  // that they can be read without synchronizing with their thread.
+  ThreadTable* thread_tables_ = nullptr;
+  // Tables of exited threads, which new threads reuse.
+  ThreadTable* orphaned_thread_tables_ = nullptr;
+
+  DISALLOW_COPY_AND_ASSIGN(TaskProfiler);
+};
+
+}  // namespace debug
+}  // namespace base
+
+#endif  // BASE_DEBUG_TASK_PROFILER_H_
@@ -0,0 +1,218 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/debug/task_profiler.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/allocator/buildflags.h"
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/debug/task_annotator.h"
+#include "base/debug/thread_heap_usage_tracker.h"
+#include "base/location.h"
+#include "base/pending_task.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread.h"
+#include "base/trace_event/memory_allocator_dump.h"
+#include "base/trace_event/process_memory_dump.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace debug {
+
+namespace {
+
+void AllocatingTask() {
+  std::unique_ptr<std::vector<char>> buffer =
+      std::make_unique<std::vector<char>>(1024);
+  (*buffer)[0] = 1;
+}
+
+void RunTask(const Location& posted_from, OnceClosure task) {
+  PendingTask pending_task(posted_from, std::move(task));
+  TaskAnnotator annotator;
+  annotator.WillQueueTask(nullptr, &pending_task);
+  annotator.RunTask(nullptr, &pending_task);
+}
+
+// Returns the stats of |posted_from|, or empty stats if no task posted from it
+// was recorded.
+TaskProfiler::Stats GetStats(const Location& posted_from) {
+  for (const TaskProfiler::Entry& entry :
+       TaskProfiler::GetInstance()->GetEntries(
+           TaskProfiler::SortKey::kRunCount)) {
+    if (entry.posted_from == posted_from)
+      return entry.stats;
+  }
+  return TaskProfiler::Stats();
+}
+
+// Returns the allocator dump of the tasks posted from |posted_from| in a
+// detailed dump of the profiler, or null if there is none.
+const trace_event::MemoryAllocatorDump* DumpLocation(
+    const Location& posted_from,
+    trace_event::ProcessMemoryDump* pmd) {
+  EXPECT_TRUE(
+      TaskProfiler::GetInstance()->OnMemoryDump(pmd->dump_args(), pmd));
+  return pmd->GetAllocatorDump(
+      StringPrintf("task_profiler/%s@task_profiler_unittest.cc:%d",
+                   posted_from.function_name(), posted_from.line_number()));
+}
+
+// Returns the value of the scalar |name| of |dump|, or 0 if there is none.
+uint64_t GetScalar(const trace_event::MemoryAllocatorDump& dump,
+                   const std::string& name) {
+  for (const trace_event::MemoryAllocatorDump::Entry& entry : dump.entries()) {
+    if (entry.name == name)
+      return entry.value_uint64;
+  }
+  return 0;
+}
+
+class TaskProfilerTest : public testing::Test {
+ protected:
+  void SetUp() override { TaskProfiler::GetInstance()->Enable(); }
+  void TearDown() override { TaskProfiler::GetInstance()->Disable(); }
+};
+
+}  // namespace
+
+TEST_F(TaskProfilerTest, RecordsTasksByLocation) {
+  const Location first = FROM_HERE;
+  const Location second = FROM_HERE;
+  for (int i = 0; i < 3; ++i)
+    RunTask(first, BindOnce(&AllocatingTask));
+  RunTask(second, DoNothing());
+
+  TaskProfiler::Stats first_stats = GetStats(first);
+  EXPECT_EQ(3u, first_stats.run_count);
+  EXPECT_GE(first_stats.wall_time, TimeDelta());
+  EXPECT_EQ(1u, GetStats(second).run_count);
+
+  std::vector<TaskProfiler::Entry> entries =
+      TaskProfiler::GetInstance()->GetEntries(
+          TaskProfiler::SortKey::kRunCount);
+  for (size_t i = 1; i < entries.size(); ++i)
+    EXPECT_GE(entries[i - 1].stats.run_count, entries[i].stats.run_count);
+}
+
+TEST_F(TaskProfilerTest, DisabledDoesNotRecord) {
+  const Location posted_from = FROM_HERE;
+  RunTask(posted_from, DoNothing());
+  TaskProfiler::GetInstance()->Disable();
+  RunTask(posted_from, DoNothing());
+  EXPECT_EQ(1u, GetStats(posted_from).run_count);
+}
+
+TEST_F(TaskProfilerTest, MergesThreads) {
+  const Location posted_from = FROM_HERE;
+  RunTask(posted_from, DoNothing());
+
+  Thread thread("TaskProfilerTest");
+  ASSERT_TRUE(thread.Start());
+  WaitableEvent done(WaitableEvent::ResetPolicy::MANUAL,
+                     WaitableEvent::InitialState::NOT_SIGNALED);
+  thread.task_runner()->PostTask(
+      FROM_HERE, BindOnce(
+                     [](const Location& posted_from, WaitableEvent* done) {
+                       RunTask(posted_from, DoNothing());
+                       RunTask(posted_from, DoNothing());
+                       done->Signal();
+                     },
+                     posted_from, &done));
+  done.Wait();
+  EXPECT_EQ(3u, GetStats(posted_from).run_count);
+
+  // The costs of exited threads are kept.
+  thread.Stop();
+  EXPECT_EQ(3u, GetStats(posted_from).run_count);
+}
+
+TEST_F(TaskProfilerTest, OnMemoryDump) {
+  const Location posted_from = FROM_HERE;
+  TaskProfiler::Stats stats;
+  stats.run_count = 2;
+  stats.alloc_ops = 3;
+  stats.alloc_bytes = 4096;
+  stats.cpu_time = TimeDelta::FromMicroseconds(5);
+  stats.wall_time = TimeDelta::FromMicroseconds(7);
+  TaskProfiler::GetInstance()->RecordTaskRun(posted_from, stats);
+
+  trace_event::ProcessMemoryDump detailed_pmd(
+      {trace_event::MemoryDumpLevelOfDetail::DETAILED});
+  const trace_event::MemoryAllocatorDump* dump =
+      DumpLocation(posted_from, &detailed_pmd);
+  ASSERT_TRUE(dump);
+  EXPECT_EQ(2u, GetScalar(*dump, "run_count"));
+  EXPECT_EQ(3u, GetScalar(*dump, "alloc_count"));
+  EXPECT_EQ(4096u,
+            GetScalar(*dump, trace_event::MemoryAllocatorDump::kNameSize));
+  EXPECT_EQ(5u, GetScalar(*dump, "cpu_time_us"));
+  EXPECT_EQ(7u, GetScalar(*dump, "wall_time_us"));
+
+  // Only detailed dumps report tasks.
+  trace_event::ProcessMemoryDump light_pmd(
+      {trace_event::MemoryDumpLevelOfDetail::LIGHT});
+  EXPECT_FALSE(DumpLocation(posted_from, &light_pmd));
+}
+
+#if BUILDFLAG(USE_ALLOCATOR_SHIM)
+class TestingThreadHeapUsageTracker : public ThreadHeapUsageTracker {
+ public:
+  using ThreadHeapUsageTracker::DisableHeapTrackingForTesting;
+};
+
+class TaskProfilerHeapTest : public TaskProfilerTest {
+ protected:
+  void SetUp() override {
+    TaskProfilerTest::SetUp();
+    ThreadHeapUsageTracker::EnableHeapTracking();
+  }
+  void TearDown() override {
+    TestingThreadHeapUsageTracker::DisableHeapTrackingForTesting();
+    TaskProfilerTest::TearDown();
+  }
+};
+
+TEST_F(TaskProfilerHeapTest, AttributesAllocations) {
+  const Location posted_from = FROM_HERE;
+  for (int i = 0; i < 3; ++i)
+    RunTask(posted_from, BindOnce(&AllocatingTask));
+
+  // Each task allocates at least the 1024 bytes of its buffer.
+  TaskProfiler::Stats stats = GetStats(posted_from);
+  EXPECT_EQ(3u, stats.run_count);
+  EXPECT_GE(stats.alloc_ops, 3u);
+  EXPECT_GE(stats.alloc_bytes, 3u * 1024);
+
+  trace_event::ProcessMemoryDump pmd(
+      {trace_event::MemoryDumpLevelOfDetail::DETAILED});
+  const trace_event::MemoryAllocatorDump* dump =
+      DumpLocation(posted_from, &pmd);
+  ASSERT_TRUE(dump);
+  EXPECT_EQ(stats.alloc_ops, GetScalar(*dump, "alloc_count"));
+  EXPECT_EQ(stats.alloc_bytes,
+            GetScalar(*dump, trace_event::MemoryAllocatorDump::kNameSize));
+}
+#endif  // BUILDFLAG(USE_ALLOCATOR_SHIM)
+
+TEST_F(TaskProfilerTest, Report) {
+  const Location posted_from = FROM_HERE;
+  RunTask(posted_from, DoNothing());
+  std::string report = TaskProfiler::GetInstance()->GetReport(
+      TaskProfiler::SortKey::kWallTime, 1000);
+  EXPECT_NE(std::string::npos, report.find("posted_from")) << report;
+  EXPECT_NE(std::string::npos, report.find(posted_from.ToString())) << report;
+
+  report = TaskProfiler::GetInstance()->GetReport(
+      TaskProfiler::SortKey::kWallTime, 0);
+  EXPECT_EQ(std::string::npos, report.find(posted_from.ToString())) << report;
+}
+
+}  // namespace debug
+}  // namespace base
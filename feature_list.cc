@@ -417,16 +417,25 @@ void FeatureList::GetFeatureOverridesImpl(std::string* enable_overrides,
 }
 
 bool FeatureList::CheckFeatureIdentity(const Feature& feature) {
-  AutoLock auto_lock(feature_identity_tracker_lock_);
-
-  auto it = feature_identity_tracker_.find(feature.name);
-  if (it == feature_identity_tracker_.end()) {
-    // If it's not tracked yet, register it.
-    feature_identity_tracker_[feature.name] = &feature;
-    return true;
+  using FeatureMap = std::map<std::string, const Feature*>;
+  {
+    RefCountedSnapshot<FeatureMap>::ReadScope tracker(
+        feature_identity_tracker_);
+    auto it = tracker->find(feature.name);
+    // Compare address of |feature| to the existing tracked entry.
+    if (it != tracker->end())
+      return it->second == &feature;
   }
-  // Compare address of |feature| to the existing tracked entry.
-  return it->second == &feature;
+
+  // If it's not tracked yet, register it. Another thread may have registered
+  // it since the lookup above, in which case the entry is left as is.
+  bool is_tracked_feature = true;
+  feature_identity_tracker_.Update(
+      [&feature, &is_tracked_feature](FeatureMap* tracker) {
+        auto result = tracker->emplace(feature.name, &feature);
+        is_tracked_feature = result.first->second == &feature;
+      });
+  return is_tracked_feature;
 }
 
 FeatureList::OverrideEntry::OverrideEntry(OverrideState overridden_state,
@@ -15,7 +15,7 @@
 #include "base/macros.h"
 #include "base/metrics/persistent_memory_allocator.h"
 #include "base/strings/string_piece.h"
-#include "base/synchronization/lock.h"
+#include "base/synchronization/ref_counted_snapshot.h"
 
 namespace base {
 
@@ -289,11 +289,12 @@ class BASE_EXPORT FeatureList {
   // exists.
   std::map<std::string, OverrideEntry> overrides_;
 
-  // Locked map that keeps track of seen features, to ensure a single feature is
-  // only defined once. This verification is only done in builds with DCHECKs
-  // enabled.
-  Lock feature_identity_tracker_lock_;
-  std::map<std::string, const Feature*> feature_identity_tracker_;
+  // Map that keeps track of seen features, to ensure a single feature is only
+  // defined once. This verification is only done in builds with DCHECKs
+  // enabled. Every feature check reads it, and new features are only added
+  // the first time they are checked, so readers don't lock.
+  RefCountedSnapshot<std::map<std::string, const Feature*>>
+      feature_identity_tracker_;
 
   // Whether this object has been fully initialized. This gets set to true as a
   // result of FinalizeInitialization().
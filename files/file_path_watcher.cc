@@ -28,6 +28,15 @@ bool FilePathWatcher::RecursiveWatchAvailable() {
 #endif
 }
 
+FilePathWatcher::ChangeSet::ChangeSet() = default;
+
+FilePathWatcher::ChangeSet::ChangeSet(ChangeSet&& other) = default;
+
+FilePathWatcher::ChangeSet& FilePathWatcher::ChangeSet::operator=(
+    ChangeSet&& other) = default;
+
+FilePathWatcher::ChangeSet::~ChangeSet() = default;
+
 FilePathWatcher::PlatformDelegate::PlatformDelegate(): cancelled_(false) {
 }
 
@@ -35,6 +44,14 @@ FilePathWatcher::PlatformDelegate::~PlatformDelegate() {
   DCHECK(is_cancelled());
 }
 
+bool FilePathWatcher::PlatformDelegate::WatchWithChangeSet(
+    const FilePath& path,
+    bool recursive,
+    TimeDelta debounce,
+    const ChangesCallback& callback) {
+  return false;
+}
+
 bool FilePathWatcher::Watch(const FilePath& path,
                             bool recursive,
                             const Callback& callback) {
@@ -43,4 +60,14 @@ bool FilePathWatcher::Watch(const FilePath& path,
   return impl_->Watch(path, recursive, callback);
 }
 
+bool FilePathWatcher::WatchWithChangeSet(const FilePath& path,
+                                         bool recursive,
+                                         TimeDelta debounce,
+                                         const ChangesCallback& callback) {
+  DCHECK(sequence_checker_.CalledOnValidSequence());
+  DCHECK(path.IsAbsolute());
+  DCHECK_GE(debounce, TimeDelta());
+  return impl_->WatchWithChangeSet(path, recursive, debounce, callback);
+}
+
 }  // namespace base
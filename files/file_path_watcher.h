@@ -8,6 +8,7 @@
 #define BASE_FILES_FILE_PATH_WATCHER_H_
 
 #include <memory>
+#include <vector>
 
 #include "base/base_export.h"
 #include "base/callback.h"
@@ -16,6 +17,7 @@
 #include "base/memory/ref_counted.h"
 #include "base/sequence_checker.h"
 #include "base/sequenced_task_runner.h"
+#include "base/time/time.h"
 
 namespace base {
 
@@ -37,6 +39,31 @@ class BASE_EXPORT FilePathWatcher {
   // that case, the callback won't be invoked again.
   typedef base::Callback<void(const FilePath& path, bool error)> Callback;
 
+  // The changes reported to a ChangesCallback.
+  struct BASE_EXPORT ChangeSet {
+    ChangeSet();
+    ChangeSet(ChangeSet&& other);
+    ChangeSet& operator=(ChangeSet&& other);
+    ~ChangeSet();
+
+    // Paths that were created, deleted or modified, sorted and without
+    // duplicates. A path may be the watched path itself or, for a directory,
+    // any path below it.
+    std::vector<FilePath> paths;
+
+    // True if the OS dropped notifications, e.g. because its event queue
+    // overflowed. |paths| is then incomplete and the client should rescan the
+    // watched path.
+    bool overflow = false;
+
+   private:
+    DISALLOW_COPY_AND_ASSIGN(ChangeSet);
+  };
+
+  // Callback type for WatchWithChangeSet().
+  typedef base::RepeatingCallback<void(const ChangeSet& changes)>
+      ChangesCallback;
+
   // Used internally to encapsulate different members on different platforms.
   class PlatformDelegate {
    public:
@@ -48,6 +75,14 @@ class BASE_EXPORT FilePathWatcher {
                        bool recursive,
                        const Callback& callback) WARN_UNUSED_RESULT = 0;
 
+    // Like Watch(), but reports which paths changed, in batches. The default
+    // implementation returns false.
+    virtual bool WatchWithChangeSet(const FilePath& path,
+                                    bool recursive,
+                                    TimeDelta debounce,
+                                    const ChangesCallback& callback)
+        WARN_UNUSED_RESULT;
+
     // Stop watching. This is called from FilePathWatcher's dtor in order to
     // allow to shut down properly while the object is still alive.
     virtual void Cancel() = 0;
@@ -97,6 +132,18 @@ class BASE_EXPORT FilePathWatcher {
   // Watch() will return false in the case of failure.
   bool Watch(const FilePath& path, bool recursive, const Callback& callback);
 
+  // Like Watch(), but invokes |callback| with the set of paths that changed.
+  // Changes are accumulated for |debounce| after the first one is seen and then
+  // delivered together, which keeps the number of callbacks low when a large
+  // tree is modified; a zero |debounce| delivers each batch read from the OS
+  // as soon as it is processed.
+  //
+  // Only supported on Linux and Android; returns false elsewhere.
+  bool WatchWithChangeSet(const FilePath& path,
+                          bool recursive,
+                          TimeDelta debounce,
+                          const ChangesCallback& callback);
+
  private:
   std::unique_ptr<PlatformDelegate> impl_;
 
@@ -2,27 +2,33 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
-#include "base/files/file_path_watcher.h"
+#include "base/files/file_path_watcher_linux.h"
 
+#include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 #include <sys/inotify.h>
 #include <sys/ioctl.h>
 #include <sys/select.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <algorithm>
-#include <map>
+#include <limits>
 #include <memory>
-#include <set>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "base/bind.h"
-#include "base/files/file_enumerator.h"
+#include "base/containers/flat_map.h"
+#include "base/containers/flat_set.h"
+#include "base/files/dir_reader_linux.h"
 #include "base/files/file_path.h"
+#include "base/files/file_path_watcher.h"
 #include "base/files/file_util.h"
 #include "base/lazy_instance.h"
 #include "base/location.h"
@@ -32,7 +38,6 @@
 #include "base/memory/weak_ptr.h"
 #include "base/posix/eintr_wrapper.h"
 #include "base/single_thread_task_runner.h"
-#include "base/stl_util.h"
 #include "base/synchronization/lock.h"
 #include "base/threading/platform_thread.h"
 #include "base/threading/sequenced_task_runner_handle.h"
@@ -45,6 +50,18 @@ namespace {
 class FilePathWatcherImpl;
 class InotifyReader;
 
+// An inotify event, as handed by InotifyReader to a FilePathWatcherImpl.
+struct InotifyEvent {
+  InotifyEvent(int watch, uint32_t mask, const FilePath::StringType& child)
+      : watch(watch), mask(mask), child(child) {}
+
+  int watch;
+  uint32_t mask;
+  FilePath::StringType child;
+};
+
+using InotifyEvents = std::vector<InotifyEvent>;
+
 class InotifyReaderThreadDelegate final : public PlatformThread::Delegate {
  public:
   InotifyReaderThreadDelegate(int inotify_fd) : inotify_fd_(inotify_fd){};
@@ -71,16 +88,35 @@ class InotifyReader {
   // change. Returns kInvalidWatch on failure.
   Watch AddWatch(const FilePath& path, FilePathWatcherImpl* watcher);
 
+  // Like AddWatch() for each directory of |paths|. |watches| receives one
+  // watch per path, kInvalidWatch for the paths that could not be watched.
+  // |lock_| is taken once per batch of paths rather than once per path, which
+  // matters when registering large trees.
+  void AddWatches(const std::vector<FilePath>& paths,
+                  FilePathWatcherImpl* watcher,
+                  std::vector<Watch>* watches);
+
   // Remove |watch| if it's valid.
   void RemoveWatch(Watch watch, FilePathWatcherImpl* watcher);
 
-  // Callback for InotifyReaderTask.
-  void OnInotifyEvent(const inotify_event* event);
+  // Like RemoveWatch() for each of |watches|.
+  void RemoveWatches(const std::vector<Watch>& watches,
+                     FilePathWatcherImpl* watcher);
+
+  // Callback for InotifyReaderThreadDelegate. Dispatches the |size| bytes of
+  // events in |buffer|, handing each watcher all of its events at once.
+  void OnInotifyEvents(const char* buffer, size_t size);
 
  private:
   friend struct LazyInstanceTraitsBase<InotifyReader>;
 
-  typedef std::set<FilePathWatcherImpl*> WatcherSet;
+  // Most watches have a single watcher.
+  typedef flat_set<FilePathWatcherImpl*> WatcherSet;
+
+  // Maximum number of watches added or removed under one acquisition of
+  // |lock_|, so that the inotify thread is not starved while a large tree is
+  // being registered.
+  static constexpr size_t kMaxWatchesPerBatch = 256;
 
   InotifyReader();
   // There is no destructor because |g_inotify_reader| is a
@@ -90,6 +126,9 @@ class InotifyReader {
   // Returns true on successful thread creation.
   bool StartThread();
 
+  Watch AddWatchLocked(const FilePath& path, FilePathWatcherImpl* watcher);
+  void RemoveWatchLocked(Watch watch, FilePathWatcherImpl* watcher);
+
   // We keep track of which delegates want to be notified on which watches.
   std::unordered_map<Watch, WatcherSet> watchers_;
 
@@ -108,30 +147,98 @@ class InotifyReader {
   DISALLOW_COPY_AND_ASSIGN(InotifyReader);
 };
 
+// The directories below a recursively watched path, indexed by their inotify
+// watch. Only the base name of each directory is stored and full paths are
+// rebuilt from the chain of parents when needed, which keeps the index small
+// for trees with many directories.
+class RecursiveWatchIndex {
+ public:
+  using Node = uint32_t;
+
+  // The root node stands for the watched path itself. Its watch is owned by
+  // the last FilePathWatcherImpl::WatchEntry, not by the index.
+  static constexpr Node kRoot = 0;
+  static constexpr Node kInvalidNode = std::numeric_limits<Node>::max();
+
+  RecursiveWatchIndex();
+  RecursiveWatchIndex(RecursiveWatchIndex&& other);
+  RecursiveWatchIndex& operator=(RecursiveWatchIndex&& other);
+  ~RecursiveWatchIndex();
+
+  // Returns the node watched by |watch|, or kInvalidNode.
+  Node FindByWatch(InotifyReader::Watch watch) const;
+
+  // Returns the child of |parent| named |name|, or kInvalidNode.
+  Node FindChild(Node parent, const FilePath::StringType& name) const;
+
+  // Adds an unwatched child named |name| to |parent|, which must not have one
+  // already.
+  Node AddChild(Node parent, const FilePath::StringType& name);
+
+  // Adds unwatched children named |names| to |parent|, which must not have any
+  // yet. |nodes| receives the new nodes, in the order of |names|.
+  void AddChildren(Node parent,
+                   const std::vector<FilePath::StringType>& names,
+                   std::vector<Node>* nodes);
+
+  InotifyReader::Watch GetWatch(Node node) const {
+    return entries_[node].watch;
+  }
+  void SetWatch(Node node, InotifyReader::Watch watch);
+
+  // Returns the path of |node|, given the path |root| of kRoot.
+  FilePath GetPath(Node node, const FilePath& root) const;
+
+  // Removes |node|, which must not be kRoot, and all its descendants. Their
+  // watches are appended to |watches|.
+  void RemoveSubtree(Node node, std::vector<InotifyReader::Watch>* watches);
+
+  // Returns the watches of all nodes.
+  std::vector<InotifyReader::Watch> GetWatches() const;
+
+ private:
+  struct Entry {
+    FilePath::StringType name;
+    Node parent = kInvalidNode;
+    InotifyReader::Watch watch = InotifyReader::kInvalidWatch;
+    // Sorted by name.
+    std::vector<Node> children;
+  };
+
+  Node NewEntry(Node parent, FilePath::StringType name);
+
+  // Indexed by Node. Entries of removed nodes are recycled via |free_nodes_|.
+  std::vector<Entry> entries_;
+  std::vector<Node> free_nodes_;
+
+  std::unordered_map<InotifyReader::Watch, Node> nodes_by_watch_;
+};
+
 class FilePathWatcherImpl : public FilePathWatcher::PlatformDelegate {
  public:
   FilePathWatcherImpl();
   ~FilePathWatcherImpl() override;
 
-  // Called for each event coming from the watch. |fired_watch| identifies the
-  // watch that fired, |child| indicates what has changed, and is relative to
-  // the currently watched path for |fired_watch|.
+  // Called with the events read in one go from the inotify file descriptor for
+  // the watches of this watcher, in order. For each event, |watch| identifies
+  // the watch that fired, |child| indicates what has changed, and is relative
+  // to the currently watched path for |watch|. An event with IN_Q_OVERFLOW in
+  // its |mask| means events were lost.
+  void OnFilePathChanged(InotifyEvents events);
+
+ private:
+  void OnFilePathChangedOnOriginSequence(InotifyEvents events);
+
+  // Handles one event from OnFilePathChangedOnOriginSequence().
   //
   // |created| is true if the object appears.
   // |deleted| is true if the object disappears.
   // |is_dir| is true if the object is a directory.
-  void OnFilePathChanged(InotifyReader::Watch fired_watch,
-                         const FilePath::StringType& child,
-                         bool created,
-                         bool deleted,
-                         bool is_dir);
-
- private:
-  void OnFilePathChangedOnOriginSequence(InotifyReader::Watch fired_watch,
-                                         const FilePath::StringType& child,
-                                         bool created,
-                                         bool deleted,
-                                         bool is_dir);
+  void ProcessEvent(InotifyReader::Watch fired_watch,
+                    const FilePath::StringType& child,
+                    bool created,
+                    bool deleted,
+                    bool is_dir);
 
   // Start watching |path| for changes and notify |delegate| on each change.
   // Returns true if watch for |path| has been added successfully.
@@ -139,9 +246,29 @@ class FilePathWatcherImpl : public FilePathWatcher::PlatformDelegate {
              bool recursive,
              const FilePathWatcher::Callback& callback) override;
 
+  bool WatchWithChangeSet(
+      const FilePath& path,
+      bool recursive,
+      TimeDelta debounce,
+      const FilePathWatcher::ChangesCallback& callback) override;
+
   // Cancel the watch. This unregisters the instance with InotifyReader.
   void Cancel() override;
 
+  // Sets up the watches for |path| once the callbacks have been set.
+  void StartWatching(const FilePath& path, bool recursive);
+
+  // Records that |path| changed. The change is reported by
+  // NotifyPendingChanges().
+  void RecordChange(const FilePath& path);
+
+  // Runs |callback_| if a change was recorded, or schedules the delivery of
+  // |pending_changes_| to |changes_callback_|. May delete |this|.
+  void NotifyPendingChanges();
+
+  // Delivers |pending_changes_| to |changes_callback_|. May delete |this|.
+  void FlushPendingChanges();
+
   // Inotify watches are installed for all directory components of |target_|.
   // A WatchEntry instance holds:
   // - |watch|: the watch descriptor for a component.
@@ -168,17 +295,23 @@ class FilePathWatcherImpl : public FilePathWatcher::PlatformDelegate {
   // - This is a no-op if the watch is not recursive.
   // - If |target_| does not exist, then clear all the recursive watches.
   // - Assuming |target_| exists, passing kInvalidWatch as |fired_watch| forces
-  //   addition of recursive watches for |target_|.
-  // - Otherwise, only the directory associated with |fired_watch| and its
-  //   sub-directories will be reconfigured.
-  void UpdateRecursiveWatches(InotifyReader::Watch fired_watch, bool is_dir);
-
-  // Enumerate recursively through |path| and add / update watches.
-  void UpdateRecursiveWatchesForPath(const FilePath& path);
-
-  // Do internal bookkeeping to update mappings between |watch| and its
-  // associated full path |path|.
-  void TrackWatchForRecursion(InotifyReader::Watch watch, const FilePath& path);
+  //   the recursive watches to be rebuilt for the whole tree.
+  // - Otherwise, only the subdirectory |child| of the directory associated
+  //   with |fired_watch| is added or removed, according to |created| and
+  //   |deleted|.
+  void UpdateRecursiveWatches(InotifyReader::Watch fired_watch,
+                              const FilePath::StringType& child,
+                              bool created,
+                              bool deleted,
+                              bool is_dir);
+
+  // Rebuilds |recursive_watches_| for the whole tree below |target_|. Watches
+  // of directories that are still present are kept.
+  void RebuildRecursiveWatches();
+
+  // Adds watches for all directories below |node|, whose path is |path|.
+  void AddRecursiveWatches(RecursiveWatchIndex::Node node,
+                           const FilePath& path);
 
   // Remove all the recursive watches.
   void RemoveRecursiveWatches();
@@ -189,8 +322,23 @@ class FilePathWatcherImpl : public FilePathWatcher::PlatformDelegate {
 
   bool HasValidWatchVector() const;
 
-  // Callback to notify upon changes.
+  // Callback to notify upon changes. Only one of |callback_| and
+  // |changes_callback_| is set.
   FilePathWatcher::Callback callback_;
+  FilePathWatcher::ChangesCallback changes_callback_;
+
+  // How long changes are accumulated before being delivered to
+  // |changes_callback_|.
+  TimeDelta debounce_;
+
+  // Whether a change was recorded since the last notification.
+  bool has_pending_changes_;
+
+  // Whether a delayed FlushPendingChanges() is posted.
+  bool flush_scheduled_;
+
+  // The changes to deliver to |changes_callback_|.
+  FilePathWatcher::ChangeSet pending_changes_;
 
   // The file or directory we're supposed to watch.
   FilePath target_;
@@ -202,8 +350,8 @@ class FilePathWatcherImpl : public FilePathWatcher::PlatformDelegate {
   // |target_| and always stores an empty next component name in |subdir|.
   WatchVector watches_;
 
-  std::unordered_map<InotifyReader::Watch, FilePath> recursive_paths_by_watch_;
-  std::map<FilePath, InotifyReader::Watch> recursive_watches_by_path_;
+  // The sub-directories of |target_| and their watches, if |recursive_|.
+  RecursiveWatchIndex recursive_watches_;
 
   // Read only while INotifyReader::lock_ is held, and used to post asynchronous
   // notifications to the Watcher on its home task_runner(). Ideally this should
@@ -225,6 +373,7 @@ void InotifyReaderThreadDelegate::ThreadMain() {
   CHECK_LE(0, inotify_fd_);
   CHECK_GT(FD_SETSIZE, inotify_fd_);
 
+  std::vector<char> buffer;
   while (true) {
     fd_set rfds;
     FD_ZERO(&rfds);
@@ -247,24 +396,19 @@ void InotifyReaderThreadDelegate::ThreadMain() {
       return;
     }
 
-    std::vector<char> buffer(buffer_size);
+    // The buffer is kept across reads to avoid reallocating it every time.
+    if (buffer.size() < static_cast<size_t>(buffer_size))
+      buffer.resize(buffer_size);
 
     ssize_t bytes_read =
-        HANDLE_EINTR(read(inotify_fd_, &buffer[0], buffer_size));
+        HANDLE_EINTR(read(inotify_fd_, buffer.data(), buffer_size));
 
     if (bytes_read < 0) {
       DPLOG(WARNING) << "read from inotify fd failed";
       return;
     }
 
-    ssize_t i = 0;
-    while (i < bytes_read) {
-      inotify_event* event = reinterpret_cast<inotify_event*>(&buffer[i]);
-      size_t event_size = sizeof(inotify_event) + event->len;
-      DCHECK(i + event_size <= static_cast<size_t>(bytes_read));
-      g_inotify_reader.Get().OnInotifyEvent(event);
-      i += event_size;
-    }
+    g_inotify_reader.Get().OnInotifyEvents(buffer.data(), bytes_read);
   }
 }
 
@@ -295,6 +439,55 @@ InotifyReader::Watch InotifyReader::AddWatch(
     return kInvalidWatch;
 
   AutoLock auto_lock(lock_);
+  return AddWatchLocked(path, watcher);
+}
+
+void InotifyReader::AddWatches(const std::vector<FilePath>& paths,
+                               FilePathWatcherImpl* watcher,
+                               std::vector<Watch>* watches) {
+  watches->clear();
+  if (!valid_) {
+    watches->resize(paths.size(), kInvalidWatch);
+    return;
+  }
+
+  watches->reserve(paths.size());
+  for (size_t begin = 0; begin < paths.size(); begin += kMaxWatchesPerBatch) {
+    size_t end = std::min(paths.size(), begin + kMaxWatchesPerBatch);
+    AutoLock auto_lock(lock_);
+    for (size_t i = begin; i < end; ++i)
+      watches->push_back(AddWatchLocked(paths[i], watcher));
+  }
+}
+
+void InotifyReader::RemoveWatch(Watch watch, FilePathWatcherImpl* watcher) {
+  if (!valid_ || (watch == kInvalidWatch))
+    return;
+
+  AutoLock auto_lock(lock_);
+  RemoveWatchLocked(watch, watcher);
+}
+
+void InotifyReader::RemoveWatches(const std::vector<Watch>& watches,
+                                  FilePathWatcherImpl* watcher) {
+  if (!valid_)
+    return;
+
+  for (size_t begin = 0; begin < watches.size();
+       begin += kMaxWatchesPerBatch) {
+    size_t end = std::min(watches.size(), begin + kMaxWatchesPerBatch);
+    AutoLock auto_lock(lock_);
+    for (size_t i = begin; i < end; ++i) {
+      if (watches[i] != kInvalidWatch)
+        RemoveWatchLocked(watches[i], watcher);
+    }
+  }
+}
+
+InotifyReader::Watch InotifyReader::AddWatchLocked(
+    const FilePath& path,
+    FilePathWatcherImpl* watcher) {
+  lock_.AssertAcquired();
 
   Watch watch = inotify_add_watch(inotify_fd_, path.value().c_str(),
                                   IN_ATTRIB | IN_CREATE | IN_DELETE |
@@ -309,40 +502,210 @@ InotifyReader::Watch InotifyReader::AddWatch(
   return watch;
 }
 
-void InotifyReader::RemoveWatch(Watch watch, FilePathWatcherImpl* watcher) {
-  if (!valid_ || (watch == kInvalidWatch))
+void InotifyReader::RemoveWatchLocked(Watch watch,
+                                      FilePathWatcherImpl* watcher) {
+  lock_.AssertAcquired();
+
+  auto it = watchers_.find(watch);
+  if (it == watchers_.end())
     return;
 
+  it->second.erase(watcher);
+
+  if (it->second.empty()) {
+    watchers_.erase(it);
+    inotify_rm_watch(inotify_fd_, watch);
+  }
+}
+
+void InotifyReader::OnInotifyEvents(const char* buffer, size_t size) {
+  flat_map<FilePathWatcherImpl*, InotifyEvents> events_by_watcher;
+
   AutoLock auto_lock(lock_);
 
-  watchers_[watch].erase(watcher);
+  size_t i = 0;
+  while (i < size) {
+    const inotify_event* event =
+        reinterpret_cast<const inotify_event*>(&buffer[i]);
+    size_t event_size = sizeof(inotify_event) + event->len;
+    DCHECK(i + event_size <= size);
+    i += event_size;
+
+    if (event->mask & IN_Q_OVERFLOW) {
+      // Events were dropped, so every watcher may have missed some.
+      WatcherSet all_watchers;
+      for (const auto& it : watchers_)
+        all_watchers.insert(it.second.begin(), it.second.end());
+      for (FilePathWatcherImpl* watcher : all_watchers) {
+        events_by_watcher[watcher].emplace_back(
+            kInvalidWatch, IN_Q_OVERFLOW, FilePath::StringType());
+      }
+      continue;
+    }
+
+    if (event->mask & IN_IGNORED)
+      continue;
+
+    auto it = watchers_.find(event->wd);
+    if (it == watchers_.end())
+      continue;
 
-  if (watchers_[watch].empty()) {
-    watchers_.erase(watch);
-    inotify_rm_watch(inotify_fd_, watch);
+    FilePath::StringType child(event->len ? event->name
+                                          : FILE_PATH_LITERAL(""));
+    for (FilePathWatcherImpl* watcher : it->second)
+      events_by_watcher[watcher].emplace_back(event->wd, event->mask, child);
   }
+
+  for (auto& it : events_by_watcher)
+    it.first->OnFilePathChanged(std::move(it.second));
 }
 
-void InotifyReader::OnInotifyEvent(const inotify_event* event) {
-  if (event->mask & IN_IGNORED)
+constexpr RecursiveWatchIndex::Node RecursiveWatchIndex::kRoot;
+constexpr RecursiveWatchIndex::Node RecursiveWatchIndex::kInvalidNode;
+
+RecursiveWatchIndex::RecursiveWatchIndex() : entries_(1) {}
+
+RecursiveWatchIndex::RecursiveWatchIndex(RecursiveWatchIndex&& other) =
+    default;
+
+RecursiveWatchIndex& RecursiveWatchIndex::operator=(
+    RecursiveWatchIndex&& other) = default;
+
+RecursiveWatchIndex::~RecursiveWatchIndex() = default;
+
+RecursiveWatchIndex::Node RecursiveWatchIndex::FindByWatch(
+    InotifyReader::Watch watch) const {
+  auto it = nodes_by_watch_.find(watch);
+  return it == nodes_by_watch_.end() ? kInvalidNode : it->second;
+}
+
+RecursiveWatchIndex::Node RecursiveWatchIndex::FindChild(
+    Node parent,
+    const FilePath::StringType& name) const {
+  const std::vector<Node>& children = entries_[parent].children;
+  auto it = std::lower_bound(
+      children.begin(), children.end(), name,
+      [this](Node node, const FilePath::StringType& name) {
+        return entries_[node].name < name;
+      });
+  if (it == children.end() || entries_[*it].name != name)
+    return kInvalidNode;
+  return *it;
+}
+
+RecursiveWatchIndex::Node RecursiveWatchIndex::AddChild(
+    Node parent,
+    const FilePath::StringType& name) {
+  DCHECK_EQ(kInvalidNode, FindChild(parent, name));
+  Node node = NewEntry(parent, name);
+  std::vector<Node>& children = entries_[parent].children;
+  auto it = std::lower_bound(
+      children.begin(), children.end(), name,
+      [this](Node node, const FilePath::StringType& name) {
+        return entries_[node].name < name;
+      });
+  children.insert(it, node);
+  return node;
+}
+
+void RecursiveWatchIndex::AddChildren(
+    Node parent,
+    const std::vector<FilePath::StringType>& names,
+    std::vector<Node>* nodes) {
+  DCHECK(entries_[parent].children.empty());
+  nodes->clear();
+  nodes->reserve(names.size());
+  for (const FilePath::StringType& name : names)
+    nodes->push_back(NewEntry(parent, name));
+
+  // Sort once rather than inserting each child at its place, which would be
+  // quadratic for directories with many subdirectories.
+  std::vector<Node> children(*nodes);
+  std::sort(children.begin(), children.end(), [this](Node a, Node b) {
+    return entries_[a].name < entries_[b].name;
+  });
+  entries_[parent].children = std::move(children);
+}
+
+void RecursiveWatchIndex::SetWatch(Node node, InotifyReader::Watch watch) {
+  Entry& entry = entries_[node];
+  DCHECK_NE(kRoot, node);
+  DCHECK_EQ(InotifyReader::kInvalidWatch, entry.watch);
+  if (watch == InotifyReader::kInvalidWatch)
     return;
+  // Two paths can lead to the same directory, e.g. through bind mounts. Only
+  // the first one is tracked.
+  if (nodes_by_watch_.emplace(watch, node).second)
+    entry.watch = watch;
+}
 
-  FilePath::StringType child(event->len ? event->name : FILE_PATH_LITERAL(""));
-  AutoLock auto_lock(lock_);
+FilePath RecursiveWatchIndex::GetPath(Node node, const FilePath& root) const {
+  std::vector<const FilePath::StringType*> names;
+  for (; node != kRoot; node = entries_[node].parent)
+    names.push_back(&entries_[node].name);
+
+  FilePath path = root;
+  for (auto it = names.rbegin(); it != names.rend(); ++it)
+    path = path.Append(**it);
+  return path;
+}
+
+void RecursiveWatchIndex::RemoveSubtree(
+    Node node,
+    std::vector<InotifyReader::Watch>* watches) {
+  DCHECK_NE(kRoot, node);
+
+  std::vector<Node>& siblings = entries_[entries_[node].parent].children;
+  siblings.erase(std::find(siblings.begin(), siblings.end(), node));
+
+  std::vector<Node> pending = {node};
+  while (!pending.empty()) {
+    Node current = pending.back();
+    pending.pop_back();
+    Entry& entry = entries_[current];
+
+    auto it = nodes_by_watch_.find(entry.watch);
+    if (it != nodes_by_watch_.end() && it->second == current) {
+      nodes_by_watch_.erase(it);
+      watches->push_back(entry.watch);
+    }
+    pending.insert(pending.end(), entry.children.begin(),
+                   entry.children.end());
+    entry = Entry();
+    free_nodes_.push_back(current);
+  }
+}
+
+std::vector<InotifyReader::Watch> RecursiveWatchIndex::GetWatches() const {
+  std::vector<InotifyReader::Watch> watches;
+  watches.reserve(nodes_by_watch_.size());
+  for (const auto& it : nodes_by_watch_)
+    watches.push_back(it.first);
+  return watches;
+}
 
-  for (WatcherSet::iterator watcher = watchers_[event->wd].begin();
-       watcher != watchers_[event->wd].end();
-       ++watcher) {
-    (*watcher)->OnFilePathChanged(event->wd,
-                                  child,
-                                  event->mask & (IN_CREATE | IN_MOVED_TO),
-                                  event->mask & (IN_DELETE | IN_MOVED_FROM),
-                                  event->mask & IN_ISDIR);
+RecursiveWatchIndex::Node RecursiveWatchIndex::NewEntry(
+    Node parent,
+    FilePath::StringType name) {
+  Node node;
+  if (free_nodes_.empty()) {
+    CHECK_LT(entries_.size(), static_cast<size_t>(kInvalidNode));
+    node = static_cast<Node>(entries_.size());
+    entries_.emplace_back();
+  } else {
+    node = free_nodes_.back();
+    free_nodes_.pop_back();
   }
+  entries_[node].name = std::move(name);
+  entries_[node].parent = parent;
+  return node;
 }
 
 FilePathWatcherImpl::FilePathWatcherImpl()
-    : recursive_(false), weak_factory_(this) {
+    : has_pending_changes_(false),
+      flush_scheduled_(false),
+      recursive_(false),
+      weak_factory_(this) {
   weak_ptr_ = weak_factory_.GetWeakPtr();
 }
 
@@ -350,11 +713,7 @@ FilePathWatcherImpl::~FilePathWatcherImpl() {
   DCHECK(!task_runner() || task_runner()->RunsTasksInCurrentSequence());
 }
 
-void FilePathWatcherImpl::OnFilePathChanged(InotifyReader::Watch fired_watch,
-                                            const FilePath::StringType& child,
-                                            bool created,
-                                            bool deleted,
-                                            bool is_dir) {
+void FilePathWatcherImpl::OnFilePathChanged(InotifyEvents events) {
   DCHECK(!task_runner()->RunsTasksInCurrentSequence());
 
   // This method is invoked on the Inotify thread. Switch to task_runner() to
@@ -363,19 +722,38 @@ void FilePathWatcherImpl::OnFilePathChanged(InotifyReader::Watch fired_watch,
   task_runner()->PostTask(
       FROM_HERE,
       BindOnce(&FilePathWatcherImpl::OnFilePathChangedOnOriginSequence,
-               weak_ptr_, fired_watch, child, created, deleted, is_dir));
+               weak_ptr_, std::move(events)));
 }
 
 void FilePathWatcherImpl::OnFilePathChangedOnOriginSequence(
-    InotifyReader::Watch fired_watch,
-    const FilePath::StringType& child,
-    bool created,
-    bool deleted,
-    bool is_dir) {
+    InotifyEvents events) {
   DCHECK(task_runner()->RunsTasksInCurrentSequence());
   DCHECK(!watches_.empty());
   DCHECK(HasValidWatchVector());
 
+  for (const InotifyEvent& event : events) {
+    if (event.mask & IN_Q_OVERFLOW) {
+      // Changes were missed, so neither the watches nor the client's view of
+      // |target_| can be trusted anymore.
+      pending_changes_.overflow = true;
+      UpdateWatches();
+      RecordChange(target_);
+      continue;
+    }
+    ProcessEvent(event.watch, event.child,
+                 event.mask & (IN_CREATE | IN_MOVED_TO),
+                 event.mask & (IN_DELETE | IN_MOVED_FROM),
+                 event.mask & IN_ISDIR);
+  }
+
+  NotifyPendingChanges();
+}
+
+void FilePathWatcherImpl::ProcessEvent(InotifyReader::Watch fired_watch,
+                                       const FilePath::StringType& child,
+                                       bool created,
+                                       bool deleted,
+                                       bool is_dir) {
   // Used below to avoid multiple recursive updates.
   bool did_update = false;
 
@@ -439,18 +817,25 @@ void FilePathWatcherImpl::OnFilePathChangedOnOriginSequence(
         (change_on_target_path && deleted) ||
         (change_on_target_path && created && PathExists(target_))) {
       if (!did_update) {
-        UpdateRecursiveWatches(fired_watch, is_dir);
+        UpdateRecursiveWatches(fired_watch, child, created, deleted, is_dir);
         did_update = true;
       }
-      callback_.Run(target_, false /* error */);
+      // A direct child of a watched directory is reported by its own path.
+      bool is_child_of_target = watch_entry.subdir.empty() &&
+                                watch_entry.linkname.empty() && !child.empty();
+      RecordChange(is_child_of_target ? target_.Append(child) : target_);
       return;
     }
   }
 
-  if (ContainsKey(recursive_paths_by_watch_, fired_watch)) {
+  RecursiveWatchIndex::Node node = recursive_watches_.FindByWatch(fired_watch);
+  if (node != RecursiveWatchIndex::kInvalidNode) {
+    FilePath changed_path = recursive_watches_.GetPath(node, target_);
+    if (!child.empty())
+      changed_path = changed_path.Append(child);
     if (!did_update)
-      UpdateRecursiveWatches(fired_watch, is_dir);
-    callback_.Run(target_, false /* error */);
+      UpdateRecursiveWatches(fired_watch, child, created, deleted, is_dir);
+    RecordChange(changed_path);
   }
 }
 
@@ -459,8 +844,26 @@ bool FilePathWatcherImpl::Watch(const FilePath& path,
                                 const FilePathWatcher::Callback& callback) {
   DCHECK(target_.empty());
 
-  set_task_runner(SequencedTaskRunnerHandle::Get());
   callback_ = callback;
+  StartWatching(path, recursive);
+  return true;
+}
+
+bool FilePathWatcherImpl::WatchWithChangeSet(
+    const FilePath& path,
+    bool recursive,
+    TimeDelta debounce,
+    const FilePathWatcher::ChangesCallback& callback) {
+  DCHECK(target_.empty());
+
+  changes_callback_ = callback;
+  debounce_ = debounce;
+  StartWatching(path, recursive);
+  return true;
+}
+
+void FilePathWatcherImpl::StartWatching(const FilePath& path, bool recursive) {
+  set_task_runner(SequencedTaskRunnerHandle::Get());
   target_ = path;
   recursive_ = recursive;
 
@@ -471,11 +874,10 @@ bool FilePathWatcherImpl::Watch(const FilePath& path,
     watches_.push_back(WatchEntry(comps[i]));
   watches_.push_back(WatchEntry(FilePath::StringType()));
   UpdateWatches();
-  return true;
 }
 
 void FilePathWatcherImpl::Cancel() {
-  if (!callback_) {
+  if (!callback_ && !changes_callback_) {
     // Watch() was never called.
     set_cancelled();
     return;
@@ -486,6 +888,9 @@ void FilePathWatcherImpl::Cancel() {
 
   set_cancelled();
   callback_.Reset();
+  changes_callback_.Reset();
+  pending_changes_ = FilePathWatcher::ChangeSet();
+  has_pending_changes_ = false;
 
   for (size_t i = 0; i < watches_.size(); ++i)
     g_inotify_reader.Get().RemoveWatch(watches_[i].watch, this);
@@ -494,6 +899,53 @@ void FilePathWatcherImpl::Cancel() {
   RemoveRecursiveWatches();
 }
 
+void FilePathWatcherImpl::RecordChange(const FilePath& path) {
+  has_pending_changes_ = true;
+  if (changes_callback_)
+    pending_changes_.paths.push_back(path);
+}
+
+void FilePathWatcherImpl::NotifyPendingChanges() {
+  if (!has_pending_changes_)
+    return;
+
+  if (callback_) {
+    // All the events read at once are reported with a single notification.
+    has_pending_changes_ = false;
+    callback_.Run(target_, false /* error */);
+    return;
+  }
+
+  DCHECK(changes_callback_);
+  if (debounce_.is_zero()) {
+    FlushPendingChanges();
+    return;
+  }
+  if (flush_scheduled_)
+    return;
+  flush_scheduled_ = true;
+  task_runner()->PostDelayedTask(
+      FROM_HERE,
+      BindOnce(&FilePathWatcherImpl::FlushPendingChanges,
+               weak_factory_.GetWeakPtr()),
+      debounce_);
+}
+
+void FilePathWatcherImpl::FlushPendingChanges() {
+  DCHECK(task_runner()->RunsTasksInCurrentSequence());
+  flush_scheduled_ = false;
+  if (!has_pending_changes_)
+    return;
+  has_pending_changes_ = false;
+
+  FilePathWatcher::ChangeSet changes = std::move(pending_changes_);
+  pending_changes_ = FilePathWatcher::ChangeSet();
+  std::sort(changes.paths.begin(), changes.paths.end());
+  changes.paths.erase(std::unique(changes.paths.begin(), changes.paths.end()),
+                      changes.paths.end());
+  changes_callback_.Run(changes);
+}
+
 void FilePathWatcherImpl::UpdateWatches() {
   // Ensure this runs on the task_runner() exclusively in order to avoid
   // concurrency issues.
@@ -522,11 +974,15 @@ void FilePathWatcherImpl::UpdateWatches() {
   }
 
   UpdateRecursiveWatches(InotifyReader::kInvalidWatch,
-                         false /* is directory? */);
+                         FilePath::StringType(), false /* created? */,
+                         false /* deleted? */, false /* is directory? */);
 }
 
 void FilePathWatcherImpl::UpdateRecursiveWatches(
     InotifyReader::Watch fired_watch,
+    const FilePath::StringType& child,
+    bool created,
+    bool deleted,
     bool is_dir) {
   DCHECK(HasValidWatchVector());
 
@@ -540,97 +996,135 @@ void FilePathWatcherImpl::UpdateRecursiveWatches(
 
   // Check to see if this is a forced update or if some component of |target_|
   // has changed. For these cases, redo the watches for |target_| and below.
-  if (!ContainsKey(recursive_paths_by_watch_, fired_watch) &&
-      fired_watch != watches_.back().watch) {
-    UpdateRecursiveWatchesForPath(target_);
+  RecursiveWatchIndex::Node dir =
+      fired_watch == watches_.back().watch
+          ? RecursiveWatchIndex::kRoot
+          : recursive_watches_.FindByWatch(fired_watch);
+  if (fired_watch == InotifyReader::kInvalidWatch ||
+      dir == RecursiveWatchIndex::kInvalidNode) {
+    RebuildRecursiveWatches();
     return;
   }
 
-  // Underneath |target_|, only directory changes trigger watch updates.
-  if (!is_dir)
+  // Underneath |target_|, only subdirectories appearing or disappearing
+  // trigger watch updates, and only for the subdirectory concerned.
+  if (!is_dir || child.empty() || !(created || deleted))
     return;
 
-  const FilePath& changed_dir =
-      ContainsKey(recursive_paths_by_watch_, fired_watch) ?
-      recursive_paths_by_watch_[fired_watch] :
-      target_;
-
-  std::map<FilePath, InotifyReader::Watch>::iterator start_it =
-      recursive_watches_by_path_.lower_bound(changed_dir);
-  std::map<FilePath, InotifyReader::Watch>::iterator end_it = start_it;
-  for (; end_it != recursive_watches_by_path_.end(); ++end_it) {
-    const FilePath& cur_path = end_it->first;
-    if (!changed_dir.IsParent(cur_path))
-      break;
-    if (!DirectoryExists(cur_path))
-      g_inotify_reader.Get().RemoveWatch(end_it->second, this);
+  std::vector<InotifyReader::Watch> removed_watches;
+  RecursiveWatchIndex::Node node = recursive_watches_.FindChild(dir, child);
+  if (deleted) {
+    if (node != RecursiveWatchIndex::kInvalidNode)
+      recursive_watches_.RemoveSubtree(node, &removed_watches);
+    g_inotify_reader.Get().RemoveWatches(removed_watches, this);
+    return;
+  }
+
+  FilePath path = recursive_watches_.GetPath(dir, target_).Append(child);
+  InotifyReader::Watch watch = g_inotify_reader.Get().AddWatch(path, this);
+  if (node != RecursiveWatchIndex::kInvalidNode) {
+    // The directory may already have been found by a scan of its parent, in
+    // which case inotify returns the watch it already has.
+    if (watch != InotifyReader::kInvalidWatch &&
+        watch == recursive_watches_.GetWatch(node)) {
+      return;
+    }
+    recursive_watches_.RemoveSubtree(node, &removed_watches);
+    // |watch| may be shared with a stale node.
+    removed_watches.erase(
+        std::remove(removed_watches.begin(), removed_watches.end(), watch),
+        removed_watches.end());
+    g_inotify_reader.Get().RemoveWatches(removed_watches, this);
   }
-  recursive_watches_by_path_.erase(start_it, end_it);
-  UpdateRecursiveWatchesForPath(changed_dir);
+
+  node = recursive_watches_.AddChild(dir, child);
+  recursive_watches_.SetWatch(node, watch);
+  AddRecursiveWatches(node, path);
 }
 
-void FilePathWatcherImpl::UpdateRecursiveWatchesForPath(const FilePath& path) {
+void FilePathWatcherImpl::RebuildRecursiveWatches() {
   DCHECK(recursive_);
-  DCHECK(!path.empty());
-  DCHECK(DirectoryExists(path));
-
-  // Note: SHOW_SYM_LINKS exposes symlinks as symlinks, so they are ignored
-  // rather than followed. Following symlinks can easily lead to the undesirable
-  // situation where the entire file system is being watched.
-  FileEnumerator enumerator(
-      path,
-      true /* recursive enumeration */,
-      FileEnumerator::DIRECTORIES | FileEnumerator::SHOW_SYM_LINKS);
-  for (FilePath current = enumerator.Next();
-       !current.empty();
-       current = enumerator.Next()) {
-    DCHECK(enumerator.GetInfo().IsDirectory());
-
-    if (!ContainsKey(recursive_watches_by_path_, current)) {
-      // Add new watches.
-      InotifyReader::Watch watch =
-          g_inotify_reader.Get().AddWatch(current, this);
-      TrackWatchForRecursion(watch, current);
-    } else {
-      // Update existing watches.
-      InotifyReader::Watch old_watch = recursive_watches_by_path_[current];
-      DCHECK_NE(InotifyReader::kInvalidWatch, old_watch);
-      InotifyReader::Watch watch =
-          g_inotify_reader.Get().AddWatch(current, this);
-      if (watch != old_watch) {
-        g_inotify_reader.Get().RemoveWatch(old_watch, this);
-        recursive_paths_by_watch_.erase(old_watch);
-        recursive_watches_by_path_.erase(current);
-        TrackWatchForRecursion(watch, current);
-      }
+
+  RecursiveWatchIndex old_watches;
+  std::swap(old_watches, recursive_watches_);
+  AddRecursiveWatches(RecursiveWatchIndex::kRoot, target_);
+
+  // inotify returns the existing watch for directories that were already
+  // watched, so only drop the watches that are no longer in use.
+  std::vector<InotifyReader::Watch> stale_watches;
+  for (InotifyReader::Watch watch : old_watches.GetWatches()) {
+    if (recursive_watches_.FindByWatch(watch) ==
+        RecursiveWatchIndex::kInvalidNode) {
+      stale_watches.push_back(watch);
     }
   }
+  g_inotify_reader.Get().RemoveWatches(stale_watches, this);
 }
 
-void FilePathWatcherImpl::TrackWatchForRecursion(InotifyReader::Watch watch,
-                                                 const FilePath& path) {
+void FilePathWatcherImpl::AddRecursiveWatches(RecursiveWatchIndex::Node node,
+                                              const FilePath& path) {
   DCHECK(recursive_);
   DCHECK(!path.empty());
-  DCHECK(target_.IsParent(path));
 
-  if (watch == InotifyReader::kInvalidWatch)
-    return;
+  // Walk the tree one level at a time. A directory is only read once it is
+  // watched, so a subdirectory created concurrently is either found by the
+  // walk or reported by an event on its parent. All the watches of a level are
+  // registered in one go.
+  std::vector<std::pair<RecursiveWatchIndex::Node, FilePath>> level;
+  level.emplace_back(node, path);
+  std::vector<std::pair<RecursiveWatchIndex::Node, FilePath>> next_level;
+  std::vector<FilePath> next_paths;
+  std::vector<InotifyReader::Watch> next_watches;
+  std::vector<FilePath::StringType> subdirs;
+  std::vector<RecursiveWatchIndex::Node> subdir_nodes;
+  while (!level.empty()) {
+    next_level.clear();
+    next_paths.clear();
+    for (const auto& dir : level) {
+      DirReaderLinux reader(dir.second.value().c_str());
+      if (!reader.IsValid())
+        continue;
+
+      // Note: symlinks are ignored rather than followed. Following symlinks
+      // can easily lead to the undesirable situation where the entire file
+      // system is being watched.
+      subdirs.clear();
+      while (reader.Next()) {
+        const char* name = reader.name();
+        if (!strcmp(name, ".") || !strcmp(name, ".."))
+          continue;
+        unsigned char type = reader.type();
+        if (type == DT_UNKNOWN) {
+          struct stat st;
+          if (fstatat(reader.fd(), name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+            continue;
+          if (S_ISDIR(st.st_mode))
+            type = DT_DIR;
+        }
+        if (type == DT_DIR)
+          subdirs.push_back(name);
+      }
+
+      recursive_watches_.AddChildren(dir.first, subdirs, &subdir_nodes);
+      for (size_t i = 0; i < subdirs.size(); ++i) {
+        next_paths.push_back(dir.second.Append(subdirs[i]));
+        next_level.emplace_back(subdir_nodes[i], next_paths.back());
+      }
+    }
 
-  DCHECK(!ContainsKey(recursive_paths_by_watch_, watch));
-  DCHECK(!ContainsKey(recursive_watches_by_path_, path));
-  recursive_paths_by_watch_[watch] = path;
-  recursive_watches_by_path_[path] = watch;
+    g_inotify_reader.Get().AddWatches(next_paths, this, &next_watches);
+    for (size_t i = 0; i < next_level.size(); ++i)
+      recursive_watches_.SetWatch(next_level[i].first, next_watches[i]);
+    std::swap(level, next_level);
+  }
 }
 
 void FilePathWatcherImpl::RemoveRecursiveWatches() {
   if (!recursive_)
     return;
 
-  for (const auto& it : recursive_paths_by_watch_)
-    g_inotify_reader.Get().RemoveWatch(it.first, this);
-
-  recursive_paths_by_watch_.clear();
-  recursive_watches_by_path_.clear();
+  g_inotify_reader.Get().RemoveWatches(recursive_watches_.GetWatches(), this);
+  recursive_watches_ = RecursiveWatchIndex();
 }
 
 void FilePathWatcherImpl::AddWatchForBrokenSymlink(const FilePath& path,
@@ -672,6 +1166,14 @@ bool FilePathWatcherImpl::HasValidWatchVector() const {
 
 }  // namespace
 
+namespace internal {
+
+void InjectInotifyEventsForTesting(const char* buffer, size_t size) {
+  g_inotify_reader.Get().OnInotifyEvents(buffer, size);
+}
+
+}  // namespace internal
+
 FilePathWatcher::FilePathWatcher() {
   sequence_checker_.DetachFromSequence();
   impl_ = std::make_unique<FilePathWatcherImpl>();
@@ -0,0 +1,24 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_FILES_FILE_PATH_WATCHER_LINUX_H_
+#define BASE_FILES_FILE_PATH_WATCHER_LINUX_H_
+
+#include <stddef.h>
+
+#include "base/base_export.h"
+
+namespace base {
+namespace internal {
+
+// Dispatches the |size| bytes of inotify events in |buffer| to the watchers as
+// if they had been read from the inotify file descriptor. Must not be called
+// on the sequence of a watcher that should receive them.
+BASE_EXPORT void InjectInotifyEventsForTesting(const char* buffer,
+                                               size_t size);
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_FILES_FILE_PATH_WATCHER_LINUX_H_
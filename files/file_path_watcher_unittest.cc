@@ -11,6 +11,7 @@
 #include <sys/stat.h>
 #endif
 
+#include <algorithm>
 #include <set>
 
 #include "base/bind.h"
@@ -41,6 +42,13 @@
 #include "base/files/file_descriptor_watcher_posix.h"
 #endif  // defined(OS_POSIX)
 
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+#include <sys/inotify.h>
+
+#include "base/files/file_path_watcher_linux.h"
+#include "base/threading/thread.h"
+#endif  // defined(OS_LINUX) || defined(OS_ANDROID)
+
 namespace base {
 
 namespace {
@@ -795,6 +803,135 @@ TEST_F(FilePathWatcherTest, LinkedDirectoryPart3) {
 
 #endif  // OS_LINUX
 
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+// Verify that a recursive watch set up on an existing tree covers all of it.
+TEST_F(FilePathWatcherTest, RecursiveWatchOnExistingTree) {
+  FilePath dir(temp_dir_.GetPath().AppendASCII("tree"));
+  FilePath deepest = dir;
+  for (int i = 0; i < 10; ++i) {
+    for (int j = 0; j < 20; ++j) {
+      ASSERT_TRUE(base::CreateDirectory(
+          deepest.AppendASCII(base::StringPrintf("sibling%d", j))));
+    }
+    deepest = deepest.AppendASCII(base::StringPrintf("level%d", i));
+    ASSERT_TRUE(base::CreateDirectory(deepest));
+  }
+
+  FilePathWatcher watcher;
+  std::unique_ptr<TestDelegate> delegate(new TestDelegate(collector()));
+  ASSERT_TRUE(SetupWatch(dir, &watcher, delegate.get(), true));
+
+  ASSERT_TRUE(WriteFile(deepest.AppendASCII("file"), "content"));
+  ASSERT_TRUE(WaitForEvents());
+
+  // A subtree that is moved away stops being watched, and one that is moved
+  // in starts being watched.
+  FilePath moved_out(temp_dir_.GetPath().AppendASCII("moved"));
+  ASSERT_TRUE(base::Move(dir.AppendASCII("level0"), moved_out));
+  ASSERT_TRUE(WaitForEvents());
+  ASSERT_TRUE(WriteFile(moved_out.AppendASCII("level1").AppendASCII("file"),
+                        "content"));
+  ASSERT_FALSE(WaitForEventsWithTimeout(TestTimeouts::tiny_timeout()));
+
+  ASSERT_TRUE(base::Move(moved_out, dir.AppendASCII("sibling0")
+                                        .AppendASCII("moved_in")));
+  ASSERT_TRUE(WaitForEvents());
+  ASSERT_TRUE(WriteFile(dir.AppendASCII("sibling0")
+                            .AppendASCII("moved_in")
+                            .AppendASCII("level1")
+                            .AppendASCII("level2")
+                            .AppendASCII("file"),
+                        "content"));
+  ASSERT_TRUE(WaitForEvents());
+}
+
+// Verify that WatchWithChangeSet() reports the paths that changed.
+TEST_F(FilePathWatcherTest, ChangeSet) {
+  FilePath dir(temp_dir_.GetPath().AppendASCII("dir"));
+  FilePath subdir(dir.AppendASCII("subdir"));
+  ASSERT_TRUE(base::CreateDirectory(subdir));
+
+  std::set<FilePath> expected = {dir.AppendASCII("file"),
+                                 subdir.AppendASCII("file1"),
+                                 subdir.AppendASCII("file2")};
+  std::set<FilePath> seen;
+  RunLoop run_loop;
+  FilePathWatcher watcher;
+  ASSERT_TRUE(watcher.WatchWithChangeSet(
+      dir, true, TimeDelta::FromMilliseconds(50),
+      BindRepeating(
+          [](std::set<FilePath>* seen, const std::set<FilePath>* expected,
+             const RepeatingClosure& quit,
+             const FilePathWatcher::ChangeSet& changes) {
+            EXPECT_FALSE(changes.overflow);
+            EXPECT_FALSE(changes.paths.empty());
+            EXPECT_TRUE(std::is_sorted(changes.paths.begin(),
+                                       changes.paths.end()));
+            seen->insert(changes.paths.begin(), changes.paths.end());
+            if (std::includes(seen->begin(), seen->end(), expected->begin(),
+                              expected->end())) {
+              quit.Run();
+            }
+          },
+          &seen, &expected, run_loop.QuitClosure())));
+
+  for (const FilePath& path : expected)
+    ASSERT_TRUE(WriteFile(path, "content"));
+
+  ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+      FROM_HERE, run_loop.QuitClosure(), TestTimeouts::action_timeout());
+  run_loop.Run();
+  EXPECT_TRUE(std::includes(seen.begin(), seen.end(), expected.begin(),
+                            expected.end()));
+}
+
+// Verify that WatchWithChangeSet() asks for a rescan of the watched path when
+// inotify drops events.
+TEST_F(FilePathWatcherTest, ChangeSetOverflow) {
+  FilePath dir(temp_dir_.GetPath().AppendASCII("dir"));
+  ASSERT_TRUE(base::CreateDirectory(dir));
+
+  bool overflow = false;
+  RunLoop run_loop;
+  FilePathWatcher watcher;
+  ASSERT_TRUE(watcher.WatchWithChangeSet(
+      dir, true, TimeDelta(),
+      BindRepeating(
+          [](const FilePath* dir, bool* overflow, const RepeatingClosure& quit,
+             const FilePathWatcher::ChangeSet& changes) {
+            if (!changes.overflow)
+              return;
+            EXPECT_TRUE(ContainsValue(changes.paths, *dir));
+            *overflow = true;
+            quit.Run();
+          },
+          &dir, &overflow, run_loop.QuitClosure())));
+
+  // Like the inotify thread, inject the event off the watcher's sequence.
+  inotify_event event = {};
+  event.wd = -1;
+  event.mask = IN_Q_OVERFLOW;
+  Thread thread("InotifyEventInjector");
+  ASSERT_TRUE(thread.Start());
+  thread.task_runner()->PostTask(
+      FROM_HERE, BindOnce(&internal::InjectInotifyEventsForTesting,
+                          reinterpret_cast<const char*>(&event),
+                          sizeof(event)));
+
+  ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+      FROM_HERE, run_loop.QuitClosure(), TestTimeouts::action_timeout());
+  run_loop.Run();
+  EXPECT_TRUE(overflow);
+}
+#else
+TEST_F(FilePathWatcherTest, ChangeSetUnsupported) {
+  FilePathWatcher watcher;
+  EXPECT_FALSE(watcher.WatchWithChangeSet(
+      temp_dir_.GetPath(), false, TimeDelta(),
+      BindRepeating([](const FilePathWatcher::ChangeSet& changes) {})));
+}
+#endif  // defined(OS_LINUX) || defined(OS_ANDROID)
+
 enum Permission {
   Read,
   Write,
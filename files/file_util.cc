@@ -8,12 +8,20 @@
 #include <io.h>
 #endif
 #include <stdio.h>
+#if defined(OS_POSIX) || defined(OS_FUCHSIA)
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
 
+#include <algorithm>
 #include <fstream>
 #include <limits>
 
+#include "base/containers/span.h"
+#include "base/files/file.h"
 #include "base/files/file_enumerator.h"
 #include "base/files/file_path.h"
+#include "base/files/memory_mapped_file.h"
 #include "base/logging.h"
 #include "base/strings/string_piece.h"
 #include "base/strings/string_util.h"
@@ -124,6 +132,89 @@ bool TextContentsEqual(const FilePath& filename1, const FilePath& filename2) {
 }
 #endif  // !defined(OS_NACL_NONSFI)
 
+#if defined(OS_POSIX) || defined(OS_FUCHSIA)
+namespace {
+
+// Reads |file| into |contents|, stopping after |max_size| bytes. Regular files
+// are read with positional reads into a buffer sized from fstat(), so a file
+// whose size is accurate is read with a single allocation and no copy. Other
+// files (pipes, character devices) are read sequentially in chunks.
+bool ReadFileContents(File* file, std::string* contents, size_t max_size) {
+  // Many files supplied in |path| have incorrect size (proc files etc).
+  // Hence, the size reported by fstat() is only used to size the first read,
+  // and reading continues until EOF regardless.
+  constexpr size_t kDefaultChunkSize = 1 << 16;
+  // File::Read() takes an int size.
+  constexpr size_t kMaxChunkSize = 1 << 30;
+
+  struct stat file_info;
+  bool is_regular_file = false;
+  size_t chunk_size = kDefaultChunkSize;
+  if (fstat(file->GetPlatformFile(), &file_info) == 0 &&
+      S_ISREG(file_info.st_mode) && file_info.st_size > 0) {
+    is_regular_file = true;
+    // Read one byte past the expected end so that a correct size hint
+    // observes EOF without an extra syscall.
+    chunk_size = std::min<uint64_t>(file_info.st_size, max_size) + 1;
+  }
+
+  size_t bytes_read_so_far = 0;
+  bool read_status = true;
+  std::string local_contents;
+  for (;;) {
+    const size_t request_size = std::min(chunk_size, kMaxChunkSize);
+    if (local_contents.size() < bytes_read_so_far + request_size)
+      local_contents.resize(bytes_read_so_far + request_size);
+    int bytes_read_this_pass =
+        is_regular_file
+            ? file->Read(bytes_read_so_far, &local_contents[bytes_read_so_far],
+                         request_size)
+            : file->ReadAtCurrentPos(&local_contents[bytes_read_so_far],
+                                     request_size);
+    if (bytes_read_this_pass < 0) {
+      read_status = false;
+      break;
+    }
+    if (max_size - bytes_read_so_far <
+        static_cast<size_t>(bytes_read_this_pass)) {
+      // Read more than max_size bytes, bail out.
+      bytes_read_so_far = max_size;
+      read_status = false;
+      break;
+    }
+    bytes_read_so_far += bytes_read_this_pass;
+    // File::Read*() keep reading until the buffer is full or EOF is reached,
+    // so a short read means EOF.
+    if (static_cast<size_t>(bytes_read_this_pass) < request_size)
+      break;
+    // The size hint was wrong; continue with the default chunk size.
+    chunk_size = kDefaultChunkSize;
+  }
+
+  if (contents) {
+    contents->swap(local_contents);
+    contents->resize(bytes_read_so_far);
+  }
+  return read_status;
+}
+
+}  // namespace
+
+bool ReadFileToStringWithMaxSize(const FilePath& path,
+                                 std::string* contents,
+                                 size_t max_size) {
+  if (contents)
+    contents->clear();
+  if (path.ReferencesParent())
+    return false;
+  // Open the file directly rather than through File's constructor, which does
+  // not mark the descriptor close-on-exec.
+  File file(HANDLE_EINTR(open(path.value().c_str(), O_RDONLY | O_CLOEXEC)));
+  if (!file.IsValid())
+    return false;
+  return ReadFileContents(&file, contents, max_size);
+}
+#else
 bool ReadFileToStringWithMaxSize(const FilePath& path,
                                  std::string* contents,
                                  size_t max_size) {
@@ -185,12 +276,27 @@ bool ReadFileToStringWithMaxSize(const FilePath& path,
 
   return read_status;
 }
+#endif  // defined(OS_POSIX) || defined(OS_FUCHSIA)
 
 bool ReadFileToString(const FilePath& path, std::string* contents) {
   return ReadFileToStringWithMaxSize(path, contents,
                                      std::numeric_limits<size_t>::max());
 }
 
+bool ReadFileToSpan(const FilePath& path,
+                    MemoryMappedFile* mapped_file,
+                    span<const uint8_t>* contents) {
+  DCHECK(mapped_file);
+  DCHECK(contents);
+  *contents = span<const uint8_t>();
+  if (path.ReferencesParent())
+    return false;
+  if (!mapped_file->Initialize(path, MemoryMappedFile::READ_ONLY))
+    return false;
+  *contents = make_span(mapped_file->data(), mapped_file->length());
+  return true;
+}
+
 #if !defined(OS_NACL_NONSFI)
 bool IsDirectoryEmpty(const FilePath& dir_path) {
   FileEnumerator files(dir_path, false,
@@ -22,6 +22,7 @@
 #endif
 
 #include "base/base_export.h"
+#include "base/containers/span.h"
 #include "base/files/file.h"
 #include "base/files/file_path.h"
 #include "base/strings/string16.h"
@@ -38,6 +39,7 @@
 namespace base {
 
 class Environment;
+class MemoryMappedFile;
 class Time;
 
 //-----------------------------------------------------------------------------
@@ -178,6 +180,17 @@ BASE_EXPORT bool ReadFileToStringWithMaxSize(const FilePath& path,
                                              std::string* contents,
                                              size_t max_size);
 
+// Maps the file at |path| read-only into |mapped_file| and points |contents|
+// at its bytes, so that large files can be read without copying them into a
+// std::string. |contents| is only valid while |mapped_file| is alive.
+// |mapped_file| must not already be valid. Returns false and sets |contents|
+// to an empty span on error, which includes a |path| containing path traversal
+// components ('..') and files that cannot be mapped, such as pipes or empty
+// files; use ReadFileToString() for those.
+BASE_EXPORT bool ReadFileToSpan(const FilePath& path,
+                                MemoryMappedFile* mapped_file,
+                                span<const uint8_t>* contents);
+
 #if defined(OS_POSIX) || defined(OS_FUCHSIA)
 
 // Read exactly |bytes| bytes from file descriptor |fd|, storing the result
@@ -0,0 +1,134 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/files/file_util.h"
+
+#include <string>
+#include <vector>
+
+#include "base/files/file.h"
+#include "base/files/file_path.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/macros.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+
+namespace {
+
+constexpr int64_t kMegabyte = 1024 * 1024;
+
+// Copies |from| to |to| through a userspace buffer, the way CopyFile() did
+// before it learned to let the kernel do the copy. Used as the baseline.
+bool CopyFileWithBuffer(const FilePath& from, const FilePath& to) {
+  File infile(from, File::FLAG_OPEN | File::FLAG_READ);
+  File outfile(to, File::FLAG_WRITE | File::FLAG_CREATE_ALWAYS);
+  if (!infile.IsValid() || !outfile.IsValid())
+    return false;
+  std::vector<char> buffer(32768);
+  for (;;) {
+    int bytes_read = infile.ReadAtCurrentPos(buffer.data(), buffer.size());
+    if (bytes_read < 0)
+      return false;
+    if (bytes_read == 0)
+      return true;
+    if (outfile.WriteAtCurrentPos(buffer.data(), bytes_read) != bytes_read)
+      return false;
+  }
+}
+
+class FileUtilPerfTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    source_ = temp_dir_.GetPath().AppendASCII("source");
+  }
+
+  void CreateSource(int64_t size) {
+    File file(source_, File::FLAG_CREATE_ALWAYS | File::FLAG_WRITE);
+    ASSERT_TRUE(file.IsValid());
+    std::string chunk(kMegabyte, '\0');
+    for (int64_t i = 0; i < size; i += kMegabyte) {
+      for (size_t j = 0; j < chunk.size(); j += 4096)
+        chunk[j] = static_cast<char>(i / kMegabyte + j);
+      ASSERT_EQ(static_cast<int>(chunk.size()),
+                file.WriteAtCurrentPos(chunk.data(), chunk.size()));
+    }
+  }
+
+  template <typename CopyFunction>
+  void MeasureCopy(const std::string& trace,
+                   int64_t size,
+                   CopyFunction copy_function) {
+    constexpr int kIterations = 4;
+    TimeDelta total;
+    for (int i = 0; i < kIterations; ++i) {
+      FilePath dest = temp_dir_.GetPath().AppendASCII("dest");
+      TimeTicks start = TimeTicks::Now();
+      ASSERT_TRUE(copy_function(source_, dest));
+      total += TimeTicks::Now() - start;
+      ASSERT_TRUE(DeleteFile(dest, false));
+    }
+    perf_test::PrintResult(
+        "CopyFile", std::to_string(size / kMegabyte) + "MB", trace,
+        (size / kMegabyte) * kIterations / total.InSecondsF(), "MB/s", true);
+  }
+
+  ScopedTempDir temp_dir_;
+  FilePath source_;
+};
+
+}  // namespace
+
+TEST_F(FileUtilPerfTest, CopyFile) {
+  for (int64_t size : {16 * kMegabyte, 256 * kMegabyte}) {
+    CreateSource(size);
+    MeasureCopy("userspace_buffer", size, &CopyFileWithBuffer);
+    MeasureCopy("CopyFile", size,
+                [](const FilePath& from, const FilePath& to) {
+                  return CopyFile(from, to);
+                });
+  }
+}
+
+TEST_F(FileUtilPerfTest, ReadFile) {
+  constexpr int kIterations = 8;
+  for (int64_t size : {1 * kMegabyte, 64 * kMegabyte}) {
+    CreateSource(size);
+    const std::string modifier = std::to_string(size / kMegabyte) + "MB";
+
+    TimeDelta total;
+    for (int i = 0; i < kIterations; ++i) {
+      std::string contents;
+      TimeTicks start = TimeTicks::Now();
+      ASSERT_TRUE(ReadFileToString(source_, &contents));
+      total += TimeTicks::Now() - start;
+      ASSERT_EQ(size, static_cast<int64_t>(contents.size()));
+    }
+    perf_test::PrintResult("ReadFile", modifier, "ReadFileToString",
+                           total.InMillisecondsF() / kIterations, "ms", true);
+
+    // Touch every page so that the comparison includes the page faults.
+    total = TimeDelta();
+    for (int i = 0; i < kIterations; ++i) {
+      MemoryMappedFile mapped_file;
+      span<const uint8_t> contents;
+      TimeTicks start = TimeTicks::Now();
+      ASSERT_TRUE(ReadFileToSpan(source_, &mapped_file, &contents));
+      uint8_t checksum = 0;
+      for (size_t j = 0; j < contents.size(); j += 4096)
+        checksum ^= contents[j];
+      total += TimeTicks::Now() - start;
+      ASSERT_EQ(size, static_cast<int64_t>(contents.size()));
+      ignore_result(checksum);
+    }
+    perf_test::PrintResult("ReadFile", modifier, "ReadFileToSpan",
+                           total.InMillisecondsF() / kIterations, "ms", true);
+  }
+}
+
+}  // namespace base
@@ -58,6 +58,12 @@
 #include <grp.h>
 #endif
 
+#if defined(OS_LINUX)
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#endif
+
 // We need to do this on AIX due to some inconsistencies in how AIX
 // handles XOPEN_SOURCE and ALL_SOURCE.
 #if defined(OS_AIX)
@@ -151,7 +157,118 @@ bool AdvanceEnumeratorWithStat(FileEnumerator* traversal,
   return true;
 }
 
+#if defined(OS_LINUX)
+// Not all kernel headers we build against are recent enough to provide these.
+#if !defined(FICLONE)
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+#if !defined(FALLOC_FL_KEEP_SIZE)
+#define FALLOC_FL_KEEP_SIZE 0x01
+#endif
+
+// Upper bound on the bytes requested from a single copy_file_range() or
+// sendfile() call. The kernel clamps requests to just under 2 GB anyway.
+constexpr size_t kKernelCopyChunkSize = 1u << 30;
+
+// A kernel-side copy primitive. Copies up to |length| bytes from the current
+// position of |in_fd| to the current position of |out_fd|, advancing both.
+using KernelCopyFunction = ssize_t (*)(int in_fd, int out_fd, size_t length);
+
+ssize_t CopyFileRange(int in_fd, int out_fd, size_t length) {
+#if defined(__NR_copy_file_range)
+  return syscall(__NR_copy_file_range, in_fd, nullptr, out_fd, nullptr,
+                 length, 0u);
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+ssize_t SendFile(int in_fd, int out_fd, size_t length) {
+  return sendfile(out_fd, in_fd, nullptr, length);
+}
+
+// Returns true if |error| means that a kernel copy primitive cannot be used for
+// this pair of files (old kernel, cross-filesystem copy, unsupported file
+// system, seccomp policy...), rather than that an I/O error happened.
+bool IsKernelCopyUnsupportedError(int error) {
+  return error == ENOSYS || error == EXDEV || error == EINVAL ||
+         error == EOPNOTSUPP || error == EPERM || error == EBADF;
+}
+
+// Runs |copy| until it reports end of file. Returns false only on a genuine
+// I/O error. When the primitive turns out to be unusable, returns true with
+// |*unsupported| set; the file positions then reflect whatever was copied.
+bool CopyWithKernelFunction(KernelCopyFunction copy,
+                            int in_fd,
+                            int out_fd,
+                            bool* unsupported) {
+  *unsupported = false;
+  for (;;) {
+    ssize_t copied = HANDLE_EINTR(copy(in_fd, out_fd, kKernelCopyChunkSize));
+    if (copied == 0)
+      return true;
+    if (copied < 0) {
+      *unsupported = IsKernelCopyUnsupportedError(errno);
+      return *unsupported;
+    }
+  }
+}
+
+// Copies as much of |infile| into |outfile| as the kernel can do without
+// bouncing the data through userspace. Tries, in order, a FICLONE reflink
+// (copy-on-write file systems such as btrfs and XFS), copy_file_range(2) and
+// sendfile(2), preallocating the destination first. Returns false on I/O
+// error. On success, any data the kernel did not copy (for instance because
+// none of the primitives are supported, or because the file lives on a pseudo
+// file system whose reported size is bogus) is left for the caller to copy
+// from the current file positions.
+bool CopyFileContentsInKernel(File* infile, File* outfile) {
+  const int in_fd = infile->GetPlatformFile();
+  const int out_fd = outfile->GetPlatformFile();
+
+  struct stat in_stat;
+  if (fstat(in_fd, &in_stat) < 0 || !S_ISREG(in_stat.st_mode) ||
+      in_stat.st_size <= 0) {
+    return true;
+  }
+  const off_t in_pos = lseek(in_fd, 0, SEEK_CUR);
+  const off_t out_pos = lseek(out_fd, 0, SEEK_CUR);
+  if (in_pos < 0 || out_pos < 0 || in_pos >= in_stat.st_size)
+    return true;
+
+  // A reflink shares the source extents with the destination, so it is only
+  // equivalent to a copy when the whole file lands in an empty destination.
+  struct stat out_stat;
+  if (in_pos == 0 && out_pos == 0 && fstat(out_fd, &out_stat) == 0 &&
+      S_ISREG(out_stat.st_mode) && out_stat.st_size == 0 &&
+      ioctl(out_fd, FICLONE, in_fd) == 0) {
+    return lseek(in_fd, 0, SEEK_END) >= 0 && lseek(out_fd, 0, SEEK_END) >= 0;
+  }
+
+  // Reserve the blocks up front so the file system can lay the copy out
+  // contiguously. FALLOC_FL_KEEP_SIZE leaves the visible file size alone in
+  // case the copy ends up shorter. Failure here is harmless.
+  ignore_result(HANDLE_EINTR(fallocate(out_fd, FALLOC_FL_KEEP_SIZE, out_pos,
+                                       in_stat.st_size - in_pos)));
+
+  bool unsupported;
+  if (!CopyWithKernelFunction(&CopyFileRange, in_fd, out_fd, &unsupported))
+    return false;
+  if (!unsupported)
+    return true;
+  return CopyWithKernelFunction(&SendFile, in_fd, out_fd, &unsupported);
+}
+#endif  // defined(OS_LINUX)
+
 bool CopyFileContents(File* infile, File* outfile) {
+#if defined(OS_LINUX)
+  if (!CopyFileContentsInKernel(infile, outfile))
+    return false;
+  // Normally the kernel copied everything and the loop below only observes
+  // EOF; otherwise it copies whatever is left.
+#endif
+
   static constexpr size_t kBufferSize = 32768;
   std::vector<char> buffer(kBufferSize);
 
@@ -24,6 +24,7 @@
 #include "base/files/file_enumerator.h"
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
+#include "base/files/memory_mapped_file.h"
 #include "base/files/scoped_file.h"
 #include "base/files/scoped_temp_dir.h"
 #include "base/guid.h"
@@ -2208,6 +2209,47 @@ TEST_F(FileUtilTest, CopyFile) {
   EXPECT_TRUE(IsDirectoryEmpty(dest_dir));
 }
 
+TEST_F(FileUtilTest, CopyLargeFile) {
+  // Use a size that is not a multiple of any buffer or page size, with
+  // contents that vary so that misplaced chunks are detected.
+  const size_t kSize = 3 * 1024 * 1024 + 17;
+  std::string data(kSize, '\0');
+  for (size_t i = 0; i < kSize; ++i)
+    data[i] = static_cast<char>(i * 31 + (i >> 12));
+
+  FilePath from = temp_dir_.GetPath().Append(FPL("large_from"));
+  ASSERT_EQ(static_cast<int>(kSize), WriteFile(from, data.data(), kSize));
+
+  // Start from a longer destination to make sure it gets truncated.
+  FilePath to = temp_dir_.GetPath().Append(FPL("large_to"));
+  std::string longer(kSize * 2, 'x');
+  ASSERT_EQ(static_cast<int>(longer.size()),
+            WriteFile(to, longer.data(), longer.size()));
+
+  ASSERT_TRUE(CopyFile(from, to));
+  EXPECT_TRUE(ContentsEqual(from, to));
+
+  // CopyDirectory() shares the same copy path.
+  FilePath dir = temp_dir_.GetPath().Append(FPL("large_dir"));
+  ASSERT_TRUE(CreateDirectory(dir));
+  ASSERT_TRUE(CopyFile(from, dir.Append(FPL("inner"))));
+  FilePath dir_copy = temp_dir_.GetPath().Append(FPL("large_dir_copy"));
+  ASSERT_TRUE(CopyDirectory(dir, dir_copy, true));
+  EXPECT_TRUE(ContentsEqual(from, dir_copy.Append(FPL("inner"))));
+}
+
+#if defined(OS_LINUX)
+TEST_F(FileUtilTest, CopyFileFromProcFileSystem) {
+  // Files in /proc report a bogus size, so their contents must not be
+  // truncated by any size-based copy path.
+  FilePath to = temp_dir_.GetPath().Append(FPL("cpuinfo"));
+  ASSERT_TRUE(CopyFile(FilePath("/proc/cpuinfo"), to));
+  std::string contents;
+  ASSERT_TRUE(ReadFileToString(to, &contents));
+  EXPECT_FALSE(contents.empty());
+}
+#endif  // defined(OS_LINUX)
+
 // file_util winds up using autoreleased objects on the Mac, so this needs
 // to be a PlatformTest.
 typedef PlatformTest ReadOnlyFileUtilTest;
@@ -3224,6 +3266,39 @@ TEST_F(FileUtilTest, ReadFileToStringWithLargeFile) {
   EXPECT_EQ(std::string(kLargeFileSize - 1, 'c'), actual_data);
 }
 
+TEST_F(FileUtilTest, ReadFileToSpan) {
+  FilePath file_path =
+      temp_dir_.GetPath().Append(FILE_PATH_LITERAL("ReadFileToSpanTest"));
+  std::string data(kLargeFileSize, 'c');
+  data[0] = 'a';
+  data[kLargeFileSize - 1] = 'z';
+  ASSERT_EQ(static_cast<int>(kLargeFileSize),
+            WriteFile(file_path, data.c_str(), kLargeFileSize));
+
+  MemoryMappedFile mapped_file;
+  span<const uint8_t> contents;
+  ASSERT_TRUE(ReadFileToSpan(file_path, &mapped_file, &contents));
+  ASSERT_EQ(kLargeFileSize, contents.size());
+  EXPECT_EQ(data, std::string(reinterpret_cast<const char*>(contents.data()),
+                              contents.size()));
+
+  // Path traversal components are rejected.
+  FilePath parent_path = temp_dir_.GetPath()
+                             .Append(FILE_PATH_LITERAL(".."))
+                             .Append(temp_dir_.GetPath().BaseName())
+                             .Append(FILE_PATH_LITERAL("ReadFileToSpanTest"));
+  MemoryMappedFile parent_mapped_file;
+  EXPECT_FALSE(ReadFileToSpan(parent_path, &parent_mapped_file, &contents));
+  EXPECT_TRUE(contents.empty());
+
+  // Missing files fail cleanly.
+  MemoryMappedFile missing_mapped_file;
+  EXPECT_FALSE(ReadFileToSpan(
+      temp_dir_.GetPath().Append(FILE_PATH_LITERAL("DoesNotExist")),
+      &missing_mapped_file, &contents));
+  EXPECT_TRUE(contents.empty());
+}
+
 TEST_F(FileUtilTest, TouchFile) {
   FilePath data_dir =
       temp_dir_.GetPath().Append(FILE_PATH_LITERAL("FilePathTest"));
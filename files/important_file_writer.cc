@@ -7,6 +7,9 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+
+#include <map>
+#include <set>
 #include <string>
 #include <utility>
 
@@ -22,6 +25,7 @@
 #include "base/metrics/histogram_functions.h"
 #include "base/metrics/histogram_macros.h"
 #include "base/numerics/safe_conversions.h"
+#include "base/posix/eintr_wrapper.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_util.h"
 #include "base/task_runner.h"
@@ -30,6 +34,12 @@
 #include "base/time/time.h"
 #include "build/build_config.h"
 
+#if defined(OS_POSIX) || defined(OS_FUCHSIA)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace base {
 
 namespace {
@@ -129,32 +139,16 @@ void DeleteTmpFile(const FilePath& tmp_file_path,
   }
 }
 
-}  // namespace
-
-// static
-bool ImportantFileWriter::WriteFileAtomically(const FilePath& path,
-                                              StringPiece data,
-                                              StringPiece histogram_suffix) {
-#if defined(OS_CHROMEOS)
-  // On Chrome OS, chrome gets killed when it cannot finish shutdown quickly,
-  // and this function seems to be one of the slowest shutdown steps.
-  // Include some info to the report for investigation. crbug.com/418627
-  // TODO(hashimoto): Remove this.
-  struct {
-    size_t data_size;
-    char path[128];
-  } file_info;
-  file_info.data_size = data.size();
-  strlcpy(file_info.path, path.value().c_str(), arraysize(file_info.path));
-  debug::Alias(&file_info);
-#endif
-
-  // Write the data to a temp file then rename to avoid data loss if we crash
-  // while writing the file. Ensure that the temp file is on the same volume
-  // as target file, so it can be moved in one step, and that the temp file
-  // is securely created.
-  FilePath tmp_file_path;
-  if (!CreateTemporaryFileInDir(path.DirName(), &tmp_file_path)) {
+// Creates a temporary file next to |path| and writes |data| to it, leaving it
+// open in |tmp_file| so that it can be flushed. Ensures that the temp file is
+// on the same volume as |path|, so it can be moved in one step, and that it is
+// securely created. On failure, logs, deletes the temp file and returns false.
+bool WriteTempFile(const FilePath& path,
+                   StringPiece data,
+                   StringPiece histogram_suffix,
+                   FilePath* tmp_file_path,
+                   File* tmp_file) {
+  if (!CreateTemporaryFileInDir(path.DirName(), tmp_file_path)) {
     UmaHistogramExactLinearWithSuffix(
         "ImportantFile.FileCreateError", histogram_suffix,
         -base::File::GetLastFileError(), -base::File::FILE_ERROR_MAX);
@@ -163,41 +157,58 @@ bool ImportantFileWriter::WriteFileAtomically(const FilePath& path,
     return false;
   }
 
-  File tmp_file(tmp_file_path, File::FLAG_OPEN | File::FLAG_WRITE);
-  if (!tmp_file.IsValid()) {
+  tmp_file->Initialize(*tmp_file_path, File::FLAG_OPEN | File::FLAG_WRITE);
+  if (!tmp_file->IsValid()) {
     UmaHistogramExactLinearWithSuffix(
         "ImportantFile.FileOpenError", histogram_suffix,
-        -tmp_file.error_details(), -base::File::FILE_ERROR_MAX);
+        -tmp_file->error_details(), -base::File::FILE_ERROR_MAX);
     LogFailure(path, histogram_suffix, FAILED_OPENING,
                "could not open temporary file");
-    DeleteFile(tmp_file_path, false);
+    DeleteFile(*tmp_file_path, false);
     return false;
   }
 
   // If this fails in the wild, something really bad is going on.
   const int data_length = checked_cast<int32_t>(data.length());
-  int bytes_written = tmp_file.Write(0, data.data(), data_length);
+  int bytes_written = tmp_file->Write(0, data.data(), data_length);
   if (bytes_written < data_length) {
     UmaHistogramExactLinearWithSuffix(
         "ImportantFile.FileWriteError", histogram_suffix,
         -base::File::GetLastFileError(), -base::File::FILE_ERROR_MAX);
-  }
-  bool flush_success = tmp_file.Flush();
-  tmp_file.Close();
-
-  if (bytes_written < data_length) {
+    tmp_file->Close();
     LogFailure(path, histogram_suffix, FAILED_WRITING,
                "error writing, bytes_written=" + IntToString(bytes_written));
-    DeleteTmpFile(tmp_file_path, histogram_suffix);
+    DeleteTmpFile(*tmp_file_path, histogram_suffix);
     return false;
   }
 
+  return true;
+}
+
+// Flushes and closes |tmp_file|, the temporary file for |path|. If
+// |already_flushed| is true, the data was flushed by other means and the file
+// is only closed. On failure, logs, deletes the temp file and returns false.
+bool FlushTempFile(const FilePath& path,
+                   StringPiece histogram_suffix,
+                   const FilePath& tmp_file_path,
+                   File* tmp_file,
+                   bool already_flushed = false) {
+  bool flush_success = already_flushed || tmp_file->Flush();
+  tmp_file->Close();
+
   if (!flush_success) {
     LogFailure(path, histogram_suffix, FAILED_FLUSHING, "error flushing");
     DeleteTmpFile(tmp_file_path, histogram_suffix);
     return false;
   }
+  return true;
+}
 
+// Renames the flushed temporary file |tmp_file_path| over |path|. On failure,
+// logs, deletes the temp file and returns false.
+bool MoveTempFileIntoPlace(const FilePath& path,
+                           StringPiece histogram_suffix,
+                           const FilePath& tmp_file_path) {
   base::File::Error replace_file_error = base::File::FILE_OK;
   if (!ReplaceFile(tmp_file_path, path, &replace_file_error)) {
     UmaHistogramExactLinearWithSuffix("ImportantFile.FileRenameError",
@@ -208,10 +219,241 @@ bool ImportantFileWriter::WriteFileAtomically(const FilePath& path,
     DeleteTmpFile(tmp_file_path, histogram_suffix);
     return false;
   }
-
   return true;
 }
 
+// Flushes the directory entries of |dir|, making renames into it durable. Not
+// needed (nor possible) on Windows, where MoveFileEx() is write-through.
+void FlushDirectory(const FilePath& dir) {
+#if defined(OS_POSIX) || defined(OS_FUCHSIA)
+  int fd = HANDLE_EINTR(open(dir.value().c_str(), O_RDONLY | O_CLOEXEC));
+  if (fd < 0) {
+    DPLOG(WARNING) << "could not open directory " << dir.value();
+    return;
+  }
+  if (HANDLE_EINTR(fsync(fd)) != 0)
+    DPLOG(WARNING) << "could not flush directory " << dir.value();
+  IGNORE_EINTR(close(fd));
+#endif
+}
+
+#if defined(OS_LINUX)
+// Starts write-back of the dirty pages of all of |files| without waiting for
+// it, so that the flushes that follow wait on I/O that the disk received as one
+// burst instead of issuing it file by file.
+void StartWriteBack(const std::vector<File*>& files) {
+  for (File* file : files) {
+    if (HANDLE_EINTR(sync_file_range(file->GetPlatformFile(), 0, 0,
+                                     SYNC_FILE_RANGE_WRITE)) != 0) {
+      DVPLOG(1) << "sync_file_range";
+    }
+  }
+}
+
+// Flushes all of |files| with a single syncfs() if they live on the same file
+// system. Returns false if that is not possible or failed, in which case the
+// files must be flushed individually.
+bool SyncFileSystemOf(const std::vector<File*>& files) {
+  if (files.empty())
+    return false;
+  dev_t device = 0;
+  for (size_t i = 0; i < files.size(); ++i) {
+    struct stat file_info;
+    if (fstat(files[i]->GetPlatformFile(), &file_info) != 0)
+      return false;
+    if (i == 0)
+      device = file_info.st_dev;
+    else if (file_info.st_dev != device)
+      return false;
+  }
+  return syncfs(files[0]->GetPlatformFile()) == 0;
+}
+#endif  // defined(OS_LINUX)
+
+}  // namespace
+
+// static
+bool ImportantFileWriter::WriteFileAtomically(const FilePath& path,
+                                              StringPiece data,
+                                              StringPiece histogram_suffix) {
+#if defined(OS_CHROMEOS)
+  // On Chrome OS, chrome gets killed when it cannot finish shutdown quickly,
+  // and this function seems to be one of the slowest shutdown steps.
+  // Include some info to the report for investigation. crbug.com/418627
+  // TODO(hashimoto): Remove this.
+  struct {
+    size_t data_size;
+    char path[128];
+  } file_info;
+  file_info.data_size = data.size();
+  strlcpy(file_info.path, path.value().c_str(), arraysize(file_info.path));
+  debug::Alias(&file_info);
+#endif
+
+  // Write the data to a temp file then rename to avoid data loss if we crash
+  // while writing the file.
+  FilePath tmp_file_path;
+  File tmp_file;
+  return WriteTempFile(path, data, histogram_suffix, &tmp_file_path,
+                       &tmp_file) &&
+         FlushTempFile(path, histogram_suffix, tmp_file_path, &tmp_file) &&
+         MoveTempFileIntoPlace(path, histogram_suffix, tmp_file_path);
+}
+
+struct ImportantFileCommitScheduler::PendingCommit {
+  FilePath path;
+  std::unique_ptr<std::string> data;
+  OnceClosure before_write_callback;
+  OnceCallback<void(bool success)> after_write_callback;
+  std::string histogram_suffix;
+};
+
+ImportantFileCommitScheduler::ImportantFileCommitScheduler(
+    scoped_refptr<SequencedTaskRunner> task_runner,
+    bool use_syncfs)
+    : task_runner_(std::move(task_runner)), use_syncfs_(use_syncfs) {
+  DCHECK(task_runner_);
+}
+
+ImportantFileCommitScheduler::~ImportantFileCommitScheduler() {
+  // Writes are still pending if the CommitPending() task was dropped, e.g.
+  // because |task_runner_| was shut down. Report them as failed.
+  for (auto& commit : pending_commits_) {
+    if (commit->after_write_callback)
+      std::move(commit->after_write_callback).Run(false);
+  }
+}
+
+void ImportantFileCommitScheduler::ScheduleCommit(
+    const FilePath& path,
+    std::unique_ptr<std::string> data,
+    OnceClosure before_write_callback,
+    OnceCallback<void(bool success)> after_write_callback,
+    const std::string& histogram_suffix) {
+  auto commit = std::make_unique<PendingCommit>();
+  commit->path = path;
+  commit->data = std::move(data);
+  commit->before_write_callback = std::move(before_write_callback);
+  commit->after_write_callback = std::move(after_write_callback);
+  commit->histogram_suffix = histogram_suffix;
+
+  {
+    AutoLock auto_lock(lock_);
+    if (pending_commits_.empty())
+      oldest_pending_commit_time_ = TimeTicks::Now();
+    pending_commits_.push_back(std::move(commit));
+    if (commit_posted_)
+      return;
+    commit_posted_ = true;
+  }
+
+  Closure task = AdaptCallbackForRepeating(
+      BindOnce(&ImportantFileCommitScheduler::CommitPending, this));
+  if (!task_runner_->PostTask(FROM_HERE, MakeCriticalClosure(task))) {
+    // Posting the task to background message loop is not expected
+    // to fail, but if it does, avoid losing data and just hit the disk
+    // on the current thread.
+    NOTREACHED();
+
+    task.Run();
+  }
+}
+
+void ImportantFileCommitScheduler::CommitPending() {
+  std::vector<std::unique_ptr<PendingCommit>> commits;
+  TimeTicks oldest_commit_time;
+  {
+    AutoLock auto_lock(lock_);
+    commits.swap(pending_commits_);
+    oldest_commit_time = oldest_pending_commit_time_;
+    commit_posted_ = false;
+  }
+  if (commits.empty())
+    return;
+
+  // Only the most recent data for a given path is written, but every request
+  // gets its callbacks run.
+  std::map<FilePath, PendingCommit*> latest_commit_for_path;
+  for (const auto& commit : commits)
+    latest_commit_for_path[commit->path] = commit.get();
+
+  for (auto& commit : commits) {
+    if (commit->before_write_callback)
+      std::move(commit->before_write_callback).Run();
+  }
+
+  struct BatchEntry {
+    PendingCommit* commit;
+    FilePath tmp_file_path;
+    File tmp_file;
+    bool success;
+  };
+  std::vector<BatchEntry> batch;
+  batch.reserve(latest_commit_for_path.size());
+  for (const auto& commit : commits) {
+    if (latest_commit_for_path[commit->path] == commit.get())
+      batch.push_back({commit.get(), FilePath(), File(), false});
+  }
+
+  TimeTicks start_time = TimeTicks::Now();
+
+  // Phase 1: write all temporary files.
+  std::vector<File*> written_files;
+  for (BatchEntry& entry : batch) {
+    entry.success = WriteTempFile(entry.commit->path, *entry.commit->data,
+                                  entry.commit->histogram_suffix,
+                                  &entry.tmp_file_path, &entry.tmp_file);
+    if (entry.success)
+      written_files.push_back(&entry.tmp_file);
+  }
+
+  // Phase 2: make their contents durable, back to back.
+  bool already_flushed = false;
+#if defined(OS_LINUX)
+  if (use_syncfs_ && written_files.size() > 1)
+    already_flushed = SyncFileSystemOf(written_files);
+  if (!already_flushed && written_files.size() > 1)
+    StartWriteBack(written_files);
+#endif
+  for (BatchEntry& entry : batch) {
+    if (entry.success) {
+      entry.success = FlushTempFile(entry.commit->path,
+                                    entry.commit->histogram_suffix,
+                                    entry.tmp_file_path, &entry.tmp_file,
+                                    already_flushed);
+    }
+  }
+
+  // Phase 3: atomically replace the targets, then make the renames durable
+  // with one flush per directory.
+  std::set<FilePath> directories;
+  for (BatchEntry& entry : batch) {
+    if (!entry.success)
+      continue;
+    entry.success = MoveTempFileIntoPlace(entry.commit->path,
+                                          entry.commit->histogram_suffix,
+                                          entry.tmp_file_path);
+    if (entry.success)
+      directories.insert(entry.commit->path.DirName());
+  }
+  for (const FilePath& directory : directories)
+    FlushDirectory(directory);
+
+  const TimeTicks end_time = TimeTicks::Now();
+  UmaHistogramCounts100("ImportantFile.BatchSize", batch.size());
+  UmaHistogramTimes("ImportantFile.BatchCommitTime", end_time - start_time);
+  UmaHistogramTimes("ImportantFile.BatchCommitLatency",
+                    end_time - oldest_commit_time);
+
+  std::map<FilePath, bool> results;
+  for (const BatchEntry& entry : batch)
+    results[entry.commit->path] = entry.success;
+  for (auto& commit : commits) {
+    if (commit->after_write_callback)
+      std::move(commit->after_write_callback).Run(results[commit->path]);
+  }
+}
+
 ImportantFileWriter::ImportantFileWriter(
     const FilePath& path,
     scoped_refptr<SequencedTaskRunner> task_runner,
@@ -255,6 +497,14 @@ void ImportantFileWriter::WriteNow(std::unique_ptr<std::string> data) {
     return;
   }
 
+  if (commit_scheduler_) {
+    commit_scheduler_->ScheduleCommit(
+        path_, std::move(data), std::move(before_next_write_callback_),
+        std::move(after_next_write_callback_), histogram_suffix_);
+    ClearPendingWrite();
+    return;
+  }
+
   Closure task = AdaptCallbackForRepeating(
       BindOnce(&WriteScopedStringToFileAtomically, path_, std::move(data),
                std::move(before_next_write_callback_),
@@ -308,6 +558,12 @@ void ImportantFileWriter::ClearPendingWrite() {
   serializer_ = nullptr;
 }
 
+void ImportantFileWriter::SetCommitScheduler(
+    scoped_refptr<ImportantFileCommitScheduler> commit_scheduler) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  commit_scheduler_ = std::move(commit_scheduler);
+}
+
 void ImportantFileWriter::SetTimerForTesting(Timer* timer_override) {
   timer_override_ = timer_override;
 }
@@ -5,7 +5,9 @@
 #ifndef BASE_FILES_IMPORTANT_FILE_WRITER_H_
 #define BASE_FILES_IMPORTANT_FILE_WRITER_H_
 
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "base/base_export.h"
 #include "base/callback.h"
@@ -14,6 +16,7 @@
 #include "base/memory/ref_counted.h"
 #include "base/sequence_checker.h"
 #include "base/strings/string_piece.h"
+#include "base/synchronization/lock.h"
 #include "base/time/time.h"
 #include "base/timer/timer.h"
 
@@ -21,6 +24,76 @@ namespace base {
 
 class SequencedTaskRunner;
 
+// Commits the writes of any number of ImportantFileWriters sharing it in
+// batches, so that state files saved close together in time cost one burst of
+// disk flushes instead of one per file. A batch is committed as follows: every
+// file is written to its temporary file, all temporary files are flushed, every
+// temporary file is renamed over its target, and finally each directory that
+// received a file is flushed once (on POSIX) so that the renames are durable.
+// On Linux, a batch whose files all live on the same file system is flushed
+// with a single syncfs() call (see |use_syncfs|); otherwise write-back of all
+// files is started at once with sync_file_range() before they are flushed one
+// by one, so the disk sees one burst of writes. Elsewhere the files are simply
+// flushed back to back.
+//
+// Each file is still replaced atomically and independently of the others: a
+// failure to write one file does not affect the rest of its batch. Writes
+// submitted while a batch is being committed accumulate and form the next
+// batch, so the batch window adapts to the speed of the disk. When the same
+// file is written more than once within a batch, only the most recent data is
+// written.
+//
+// This class is thread-safe; writers may live on different sequences.
+class BASE_EXPORT ImportantFileCommitScheduler
+    : public RefCountedThreadSafe<ImportantFileCommitScheduler> {
+ public:
+  // Commits run on |task_runner|, which must allow blocking. If |use_syncfs|
+  // is true, batches whose files all live on the same file system are flushed
+  // with one syncfs() call on Linux. This also flushes unrelated dirty data of
+  // that file system and, on kernels before 4.13, does not report write-back
+  // errors; pass false on busy file systems or when such errors matter.
+  // Writes still pending when the scheduler is destroyed, e.g. because
+  // |task_runner| dropped the commit task at shutdown, are reported as failed.
+  explicit ImportantFileCommitScheduler(
+      scoped_refptr<SequencedTaskRunner> task_runner,
+      bool use_syncfs = true);
+
+  // Queues |data| to be atomically written to |path| in the next batch.
+  // |before_write_callback| and |after_write_callback| may be null; they are
+  // run on the commit task runner, as with ImportantFileWriter.
+  void ScheduleCommit(const FilePath& path,
+                      std::unique_ptr<std::string> data,
+                      OnceClosure before_write_callback,
+                      OnceCallback<void(bool success)> after_write_callback,
+                      const std::string& histogram_suffix);
+
+ private:
+  friend class RefCountedThreadSafe<ImportantFileCommitScheduler>;
+  struct PendingCommit;
+
+  ~ImportantFileCommitScheduler();
+
+  // Commits everything queued so far. Runs on |task_runner_|.
+  void CommitPending();
+
+  const scoped_refptr<SequencedTaskRunner> task_runner_;
+  const bool use_syncfs_;
+
+  // Protects the members below.
+  Lock lock_;
+
+  // Writes waiting for the next batch.
+  std::vector<std::unique_ptr<PendingCommit>> pending_commits_;
+
+  // Time at which the oldest entry of |pending_commits_| was queued.
+  TimeTicks oldest_pending_commit_time_;
+
+  // Whether a CommitPending() task is posted and has not started yet.
+  bool commit_posted_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(ImportantFileCommitScheduler);
+};
+
 // Helper for atomically writing a file to ensure that it won't be corrupted by
 // *application* crash during write (implemented as create, flush, rename).
 //
@@ -113,6 +186,12 @@ class BASE_EXPORT ImportantFileWriter {
     return commit_interval_;
   }
 
+  // Routes the writes of this writer through |commit_scheduler| instead of
+  // posting them to |task_runner| one by one. Pass null to go back to
+  // independent writes.
+  void SetCommitScheduler(
+      scoped_refptr<ImportantFileCommitScheduler> commit_scheduler);
+
   // Overrides the timer to use for scheduling writes with |timer_override|.
   void SetTimerForTesting(Timer* timer_override);
 
@@ -135,6 +214,9 @@ class BASE_EXPORT ImportantFileWriter {
   // TaskRunner for the thread on which file I/O can be done.
   const scoped_refptr<SequencedTaskRunner> task_runner_;
 
+  // Optional scheduler batching this writer's commits with other writers'.
+  scoped_refptr<ImportantFileCommitScheduler> commit_scheduler_;
+
   // Timer used to schedule commit after ScheduleWrite.
   OneShotTimer timer_;
 
@@ -17,6 +17,7 @@
 #include "base/run_loop.h"
 #include "base/single_thread_task_runner.h"
 #include "base/test/metrics/histogram_tester.h"
+#include "base/test/test_simple_task_runner.h"
 #include "base/threading/thread.h"
 #include "base/threading/thread_task_runner_handle.h"
 #include "base/time/time.h"
@@ -348,4 +349,96 @@ TEST_F(ImportantFileWriterTest, WriteFileAtomicallyHistogramSuffixTest) {
   histogram_tester.ExpectTotalCount("ImportantFile.FileCreateError.test", 1);
 }
 
+TEST_F(ImportantFileWriterTest, CommitSchedulerBatchesWriters) {
+  base::HistogramTester histogram_tester;
+  auto scheduler = MakeRefCounted<ImportantFileCommitScheduler>(
+      ThreadTaskRunnerHandle::Get());
+  FilePath other_file = file_.DirName().AppendASCII("other-file");
+  ImportantFileWriter writer(file_, ThreadTaskRunnerHandle::Get());
+  ImportantFileWriter other_writer(other_file, ThreadTaskRunnerHandle::Get());
+  writer.SetCommitScheduler(scheduler);
+  other_writer.SetCommitScheduler(scheduler);
+
+  WriteCallbacksObserver other_write_callback_observer;
+  write_callback_observer_.ObserveNextWriteCallbacks(&writer);
+  writer.WriteNow(std::make_unique<std::string>("foo"));
+  other_write_callback_observer.ObserveNextWriteCallbacks(&other_writer);
+  other_writer.WriteNow(std::make_unique<std::string>("bar"));
+  // Supersedes "foo" within the same batch.
+  writer.WriteNow(std::make_unique<std::string>("baz"));
+  EXPECT_FALSE(PathExists(file_));
+  RunLoop().RunUntilIdle();
+
+  EXPECT_EQ(CALLED_WITH_SUCCESS,
+            write_callback_observer_.GetAndResetObservationState());
+  EXPECT_EQ(CALLED_WITH_SUCCESS,
+            other_write_callback_observer.GetAndResetObservationState());
+  EXPECT_EQ("baz", GetFileContent(file_));
+  EXPECT_EQ("bar", GetFileContent(other_file));
+  histogram_tester.ExpectUniqueSample("ImportantFile.BatchSize", 2, 1);
+  histogram_tester.ExpectTotalCount("ImportantFile.BatchCommitTime", 1);
+  histogram_tester.ExpectTotalCount("ImportantFile.BatchCommitLatency", 1);
+
+  // Writes after a commit form a new batch.
+  writer.WriteNow(std::make_unique<std::string>("qux"));
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ("qux", GetFileContent(file_));
+  histogram_tester.ExpectBucketCount("ImportantFile.BatchSize", 1, 1);
+}
+
+TEST_F(ImportantFileWriterTest, CommitSchedulerIsolatesFailures) {
+  auto scheduler = MakeRefCounted<ImportantFileCommitScheduler>(
+      ThreadTaskRunnerHandle::Get(), false /* use_syncfs */);
+  // Use an invalid file path (relative paths are invalid) to get an error.
+  ImportantFileWriter bad_writer(FilePath().AppendASCII("bad/../path"),
+                                 ThreadTaskRunnerHandle::Get());
+  // Two valid files, so that their write-back is started together before they
+  // are flushed one by one where sync_file_range() is available.
+  FilePath other_file = file_.DirName().AppendASCII("other-file");
+  ImportantFileWriter writer(file_, ThreadTaskRunnerHandle::Get());
+  ImportantFileWriter other_writer(other_file, ThreadTaskRunnerHandle::Get());
+  bad_writer.SetCommitScheduler(scheduler);
+  writer.SetCommitScheduler(scheduler);
+  other_writer.SetCommitScheduler(scheduler);
+
+  WriteCallbacksObserver bad_write_callback_observer;
+  bad_write_callback_observer.ObserveNextWriteCallbacks(&bad_writer);
+  bad_writer.WriteNow(std::make_unique<std::string>("foo"));
+  write_callback_observer_.ObserveNextWriteCallbacks(&writer);
+  writer.WriteNow(std::make_unique<std::string>("bar"));
+  WriteCallbacksObserver other_write_callback_observer;
+  other_write_callback_observer.ObserveNextWriteCallbacks(&other_writer);
+  other_writer.WriteNow(std::make_unique<std::string>("baz"));
+  RunLoop().RunUntilIdle();
+
+  EXPECT_EQ(CALLED_WITH_ERROR,
+            bad_write_callback_observer.GetAndResetObservationState());
+  EXPECT_EQ(CALLED_WITH_SUCCESS,
+            write_callback_observer_.GetAndResetObservationState());
+  EXPECT_EQ(CALLED_WITH_SUCCESS,
+            other_write_callback_observer.GetAndResetObservationState());
+  EXPECT_FALSE(PathExists(bad_writer.path()));
+  EXPECT_EQ("bar", GetFileContent(file_));
+  EXPECT_EQ("baz", GetFileContent(other_file));
+}
+
+TEST_F(ImportantFileWriterTest, CommitSchedulerFailsDroppedCommits) {
+  auto task_runner = MakeRefCounted<TestSimpleTaskRunner>();
+  auto scheduler = MakeRefCounted<ImportantFileCommitScheduler>(task_runner);
+  ImportantFileWriter writer(file_, task_runner);
+  writer.SetCommitScheduler(scheduler);
+  write_callback_observer_.ObserveNextWriteCallbacks(&writer);
+  writer.WriteNow(std::make_unique<std::string>("foo"));
+  writer.SetCommitScheduler(nullptr);
+  scheduler = nullptr;
+  EXPECT_EQ(NOT_CALLED, write_callback_observer_.GetAndResetObservationState());
+
+  // Dropping the commit task, as a task runner does at shutdown, releases the
+  // last reference to the scheduler.
+  task_runner->ClearPendingTasks();
+  EXPECT_EQ(CALLED_WITH_ERROR,
+            write_callback_observer_.GetAndResetObservationState());
+  EXPECT_FALSE(PathExists(file_));
+}
+
 }  // namespace base
@@ -4,12 +4,22 @@
 
 #include "base/files/memory_mapped_file.h"
 
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+#include <fcntl.h>
+#endif
+
+#include <algorithm>
+#include <memory>
 #include <utility>
 
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/callback.h"
 #include "base/files/file_path.h"
 #include "base/logging.h"
 #include "base/numerics/safe_math.h"
 #include "base/sys_info.h"
+#include "base/task_scheduler/post_task.h"
 #include "build/build_config.h"
 
 namespace base {
@@ -99,6 +109,7 @@ bool MemoryMappedFile::Initialize(File file,
     DCHECK_GE(region.offset, 0);
 
   file_ = std::move(file);
+  file_offset_ = region.offset;
 
   if (!MapFileRegionToMemory(region, access)) {
     CloseHandles();
@@ -112,6 +123,55 @@ bool MemoryMappedFile::IsValid() const {
   return data_ != nullptr;
 }
 
+void MemoryMappedFile::Prefetch(size_t offset, size_t size, OnceClosure reply) {
+  DCHECK(IsValid());
+  DCHECK_LE(offset, length_);
+  size = std::min(size, length_ - offset);
+
+  // Work on a separate handle so that the task does not depend on the
+  // lifetime of this object.
+  File file = file_.Duplicate();
+  const TaskTraits traits = {MayBlock(), TaskPriority::BACKGROUND,
+                             TaskShutdownBehavior::CONTINUE_ON_SHUTDOWN};
+  OnceClosure task;
+  if (file.IsValid() && size > 0) {
+    task = BindOnce(&MemoryMappedFile::PrefetchFileRegion, std::move(file),
+                    file_offset_ + static_cast<int64_t>(offset), size);
+  } else {
+    task = DoNothing::Once();
+  }
+
+  if (reply) {
+    PostTaskWithTraitsAndReply(FROM_HERE, traits, std::move(task),
+                               std::move(reply));
+  } else {
+    PostTaskWithTraits(FROM_HERE, traits, std::move(task));
+  }
+}
+
+// static
+void MemoryMappedFile::PrefetchFileRegion(File file,
+                                          int64_t offset,
+                                          size_t size) {
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  // readahead() populates the page cache without copying anything out.
+  if (readahead(file.GetPlatformFile(), offset, size) == 0)
+    return;
+#endif
+
+  // Elsewhere, read the region through a scratch buffer.
+  constexpr size_t kChunkSize = 1 << 20;
+  std::unique_ptr<char[]> buffer(new char[kChunkSize]);
+  while (size > 0) {
+    const int chunk = static_cast<int>(std::min(size, kChunkSize));
+    const int bytes_read = file.Read(offset, buffer.get(), chunk);
+    if (bytes_read <= 0)
+      return;
+    offset += bytes_read;
+    size -= bytes_read;
+  }
+}
+
 // static
 void MemoryMappedFile::CalculateVMAlignedBoundaries(int64_t start,
                                                     size_t size,
@@ -9,6 +9,7 @@
 #include <stdint.h>
 
 #include "base/base_export.h"
+#include "base/callback_forward.h"
 #include "base/files/file.h"
 #include "base/macros.h"
 #include "build/build_config.h"
@@ -46,6 +47,31 @@ class BASE_EXPORT MemoryMappedFile {
     READ_WRITE_EXTEND,
   };
 
+  // Hints about how the mapped memory is going to be accessed. They are
+  // advisory: the kernel may ignore them, and they never change the contents
+  // of the mapping.
+  enum AccessHint {
+    // Default readahead behavior.
+    HINT_NORMAL,
+
+    // Pages will be accessed in order; read ahead aggressively and drop pages
+    // soon after they are accessed (MADV_SEQUENTIAL).
+    HINT_SEQUENTIAL,
+
+    // Pages will be accessed in random order; disable readahead so that each
+    // lookup only reads the pages it needs (MADV_RANDOM).
+    HINT_RANDOM,
+
+    // The whole mapping will be needed soon; start reading it into the page
+    // cache asynchronously (MADV_WILLNEED).
+    HINT_WILL_NEED,
+
+    // Back the mapping with transparent huge pages where the kernel supports
+    // it for this kind of mapping (MADV_HUGEPAGE). This reduces TLB misses
+    // for large mappings with scattered accesses.
+    HINT_HUGE_PAGE,
+  };
+
   // The default constructor sets all members to invalid/null values.
   MemoryMappedFile();
   ~MemoryMappedFile();
@@ -100,6 +126,26 @@ class BASE_EXPORT MemoryMappedFile {
   // Is file_ a valid file handle that points to an open, memory mapped file?
   bool IsValid() const;
 
+  // When set before Initialize(), the mapping is pre-faulted as it is created
+  // (MAP_POPULATE on Linux), so that a cold scan over it does not take a page
+  // fault per page. Initialize() then blocks until the whole region has been
+  // read from disk. Elsewhere this falls back to Advise(HINT_WILL_NEED), which
+  // only starts reading the pages in, and does nothing where that hint is not
+  // supported (e.g. Windows 7).
+  void set_populate(bool populate) { populate_ = populate; }
+
+  // Passes |hint| for the whole mapping to the kernel. Returns false if the
+  // hint is not supported on this platform or was rejected.
+  bool Advise(AccessHint hint);
+
+  // Reads the pages of the mapping in [offset, offset + size) into the page
+  // cache on a background task, so that later accesses to them are cheap minor
+  // faults rather than disk reads. The task works on its own handle to the
+  // file, so it is safe to destroy this object while the prefetch is in
+  // flight. If |reply| is not null, it is posted back to the current sequence
+  // once the prefetch is done.
+  void Prefetch(size_t offset, size_t size, OnceClosure reply);
+
  private:
   // Given the arbitrarily aligned memory region [start, size], returns the
   // boundaries of the region aligned to the granularity specified by the OS,
@@ -120,10 +166,19 @@ class BASE_EXPORT MemoryMappedFile {
   // Closes all open handles.
   void CloseHandles();
 
+  // Reads [offset, offset + size) of |file| so that it ends up in the page
+  // cache. Runs on a background task for Prefetch().
+  static void PrefetchFileRegion(File file, int64_t offset, size_t size);
+
   File file_;
   uint8_t* data_;
   size_t length_;
 
+  // Offset in |file_| of the byte at |data_|.
+  int64_t file_offset_;
+
+  bool populate_;
+
 #if defined(OS_WIN)
   win::ScopedHandle file_mapping_;
 #endif
@@ -0,0 +1,131 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/files/memory_mapped_file.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "base/files/file.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/process/process_metrics.h"
+#include "base/rand_util.h"
+#include "base/time/time.h"
+#include "build/build_config.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+
+namespace {
+
+constexpr size_t kFileSize = 128 * 1024 * 1024;
+constexpr size_t kPageSize = 4096;
+
+class MemoryMappedFilePerfTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    path_ = temp_dir_.GetPath().AppendASCII("mapped");
+    File file(path_, File::FLAG_CREATE_ALWAYS | File::FLAG_WRITE);
+    ASSERT_TRUE(file.IsValid());
+    std::string chunk(1024 * 1024, 'x');
+    for (size_t i = 0; i < kFileSize; i += chunk.size()) {
+      ASSERT_EQ(static_cast<int>(chunk.size()),
+                file.WriteAtCurrentPos(chunk.data(), chunk.size()));
+    }
+  }
+
+  // Maps the file with |configure| applied, then reads one byte from each of
+  // |num_reads| pages chosen by |next_page|, and reports the time and page
+  // faults it took.
+  template <typename Configure, typename NextPage>
+  void Measure(const std::string& trace,
+               Configure configure,
+               size_t num_reads,
+               NextPage next_page) {
+    std::unique_ptr<ProcessMetrics> metrics =
+        ProcessMetrics::CreateCurrentProcessMetrics();
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+    PageFaultCounts faults_before;
+    ASSERT_TRUE(metrics->GetPageFaultCounts(&faults_before));
+#endif
+
+    TimeTicks start = TimeTicks::Now();
+    MemoryMappedFile map;
+    configure(&map);
+    ASSERT_TRUE(map.IsValid());
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < num_reads; ++i)
+      checksum ^= map.data()[next_page(i) * kPageSize];
+    TimeDelta elapsed = TimeTicks::Now() - start;
+    EXPECT_EQ(num_reads % 2 ? 'x' : 0, checksum);
+
+    perf_test::PrintResult("MemoryMappedFile", "_time", trace,
+                           elapsed.InMillisecondsF(), "ms", true);
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+    PageFaultCounts faults_after;
+    ASSERT_TRUE(metrics->GetPageFaultCounts(&faults_after));
+    perf_test::PrintResult("MemoryMappedFile", "_minor_faults", trace,
+                           static_cast<size_t>(faults_after.minor -
+                                               faults_before.minor),
+                           "faults", false);
+    perf_test::PrintResult("MemoryMappedFile", "_major_faults", trace,
+                           static_cast<size_t>(faults_after.major -
+                                               faults_before.major),
+                           "faults", false);
+#endif
+  }
+
+  ScopedTempDir temp_dir_;
+  FilePath path_;
+};
+
+}  // namespace
+
+TEST_F(MemoryMappedFilePerfTest, SequentialScan) {
+  const size_t kPages = kFileSize / kPageSize;
+  auto sequential = [](size_t i) { return i; };
+  Measure("default",
+          [this](MemoryMappedFile* map) { map->Initialize(path_); }, kPages,
+          sequential);
+  Measure("sequential",
+          [this](MemoryMappedFile* map) {
+            map->Initialize(path_);
+            map->Advise(MemoryMappedFile::HINT_SEQUENTIAL);
+          },
+          kPages, sequential);
+  Measure("populate",
+          [this](MemoryMappedFile* map) {
+            map->set_populate(true);
+            map->Initialize(path_);
+          },
+          kPages, sequential);
+}
+
+TEST_F(MemoryMappedFilePerfTest, RandomLookups) {
+  const size_t kPages = kFileSize / kPageSize;
+  const size_t kLookups = 16 * 1024;
+  auto random = [kPages](size_t i) { return RandGenerator(kPages); };
+  Measure("default",
+          [this](MemoryMappedFile* map) { map->Initialize(path_); }, kLookups,
+          random);
+  Measure("random",
+          [this](MemoryMappedFile* map) {
+            map->Initialize(path_);
+            map->Advise(MemoryMappedFile::HINT_RANDOM);
+          },
+          kLookups, random);
+  Measure("huge_page",
+          [this](MemoryMappedFile* map) {
+            map->Initialize(path_);
+            map->Advise(MemoryMappedFile::HINT_HUGE_PAGE);
+          },
+          kLookups, random);
+}
+
+}  // namespace base
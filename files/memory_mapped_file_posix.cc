@@ -13,6 +13,7 @@
 
 #include "base/logging.h"
 #include "base/numerics/safe_conversions.h"
+#include "base/sys_info.h"
 #include "base/threading/thread_restrictions.h"
 #include "build/build_config.h"
 
@@ -22,7 +23,8 @@
 
 namespace base {
 
-MemoryMappedFile::MemoryMappedFile() : data_(nullptr), length_(0) {}
+MemoryMappedFile::MemoryMappedFile()
+    : data_(nullptr), length_(0), file_offset_(0), populate_(false) {}
 
 #if !defined(OS_NACL)
 bool MemoryMappedFile::MapFileRegionToMemory(
@@ -159,7 +161,13 @@ bool MemoryMappedFile::MapFileRegionToMemory(
       break;
   }
 
-  data_ = static_cast<uint8_t*>(mmap(nullptr, map_size, flags, MAP_SHARED,
+  int map_flags = MAP_SHARED;
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  if (populate_)
+    map_flags |= MAP_POPULATE;
+#endif
+
+  data_ = static_cast<uint8_t*>(mmap(nullptr, map_size, flags, map_flags,
                                      file_.GetPlatformFile(), map_start));
   if (data_ == MAP_FAILED) {
     DPLOG(ERROR) << "mmap " << file_.GetPlatformFile();
@@ -167,8 +175,60 @@ bool MemoryMappedFile::MapFileRegionToMemory(
   }
 
   data_ += data_offset;
+
+#if !defined(OS_LINUX) && !defined(OS_ANDROID)
+  if (populate_)
+    Advise(HINT_WILL_NEED);
+#endif
+
   return true;
 }
+
+bool MemoryMappedFile::Advise(AccessHint hint) {
+  DCHECK(IsValid());
+
+  int advice = MADV_NORMAL;
+  switch (hint) {
+    case HINT_NORMAL:
+      advice = MADV_NORMAL;
+      break;
+    case HINT_SEQUENTIAL:
+      advice = MADV_SEQUENTIAL;
+      break;
+    case HINT_RANDOM:
+      advice = MADV_RANDOM;
+      break;
+    case HINT_WILL_NEED:
+      advice = MADV_WILLNEED;
+      break;
+    case HINT_HUGE_PAGE:
+#if defined(MADV_HUGEPAGE)
+      advice = MADV_HUGEPAGE;
+      break;
+#else
+      return false;
+#endif
+  }
+
+  // madvise() wants a page-aligned start; |data_| is only aligned when the
+  // whole file is mapped.
+  const uintptr_t page_mask = SysInfo::VMAllocationGranularity() - 1;
+  const uintptr_t start = reinterpret_cast<uintptr_t>(data_) & ~page_mask;
+  const size_t size = reinterpret_cast<uintptr_t>(data_) + length_ - start;
+  // The kernel may reject hints it doesn't support, such as MADV_HUGEPAGE
+  // without transparent huge pages, and callers treat hints as best effort.
+  if (madvise(reinterpret_cast<void*>(start), size, advice) != 0) {
+    DVPLOG(1) << "madvise";
+    return false;
+  }
+  return true;
+}
+#else
+bool MemoryMappedFile::Advise(AccessHint hint) {
+  DCHECK(IsValid());
+  // NaCl has no madvise().
+  return false;
+}
 #endif
 
 void MemoryMappedFile::CloseHandles() {
@@ -180,6 +240,7 @@ void MemoryMappedFile::CloseHandles() {
 
   data_ = nullptr;
   length_ = 0;
+  file_offset_ = 0;
 }
 
 }  // namespace base
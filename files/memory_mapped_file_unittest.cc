@@ -11,6 +11,9 @@
 
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
+#include "base/run_loop.h"
+#include "base/test/scoped_task_environment.h"
+#include "build/build_config.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "testing/platform_test.h"
 
@@ -238,6 +241,58 @@ TEST_F(MemoryMappedFileTest, ExtendableFile) {
   EXPECT_EQ("BAZ", contents.substr(kFileSize, 3));
 }
 
+TEST_F(MemoryMappedFileTest, PopulatedMapping) {
+  const size_t kFileSize = 68 * 1024;
+  CreateTemporaryTestFile(kFileSize);
+  MemoryMappedFile map;
+  map.set_populate(true);
+  ASSERT_TRUE(map.Initialize(temp_file_path()));
+  ASSERT_EQ(kFileSize, map.length());
+  EXPECT_TRUE(CheckBufferContents(map.data(), kFileSize, 0));
+}
+
+TEST_F(MemoryMappedFileTest, Advise) {
+  const size_t kFileSize = 68 * 1024;
+  const size_t kOffset = 5 * 1024 + 3;
+  CreateTemporaryTestFile(kFileSize);
+  File file(temp_file_path(), File::FLAG_OPEN | File::FLAG_READ);
+  MemoryMappedFile::Region region = {kOffset, kFileSize - kOffset};
+  MemoryMappedFile map;
+  ASSERT_TRUE(map.Initialize(std::move(file), region));
+
+#if defined(OS_POSIX)
+  // Hints work on unaligned regions too.
+  EXPECT_TRUE(map.Advise(MemoryMappedFile::HINT_SEQUENTIAL));
+  EXPECT_TRUE(map.Advise(MemoryMappedFile::HINT_RANDOM));
+  EXPECT_TRUE(map.Advise(MemoryMappedFile::HINT_WILL_NEED));
+  EXPECT_TRUE(map.Advise(MemoryMappedFile::HINT_NORMAL));
+#endif
+  // Huge pages may be disabled by the system, but must never break the
+  // mapping.
+  map.Advise(MemoryMappedFile::HINT_HUGE_PAGE);
+
+  EXPECT_TRUE(CheckBufferContents(map.data(), kFileSize - kOffset, kOffset));
+}
+
+TEST_F(MemoryMappedFileTest, Prefetch) {
+  test::ScopedTaskEnvironment scoped_task_environment;
+  const size_t kFileSize = 256 * 1024;
+  CreateTemporaryTestFile(kFileSize);
+
+  auto map = std::make_unique<MemoryMappedFile>();
+  ASSERT_TRUE(map->Initialize(temp_file_path()));
+
+  RunLoop run_loop;
+  map->Prefetch(4096, kFileSize, run_loop.QuitClosure());
+  run_loop.Run();
+  EXPECT_TRUE(CheckBufferContents(map->data(), kFileSize, 0));
+
+  // The mapping may go away while a prefetch is still pending.
+  map->Prefetch(0, kFileSize, OnceClosure());
+  map.reset();
+  scoped_task_environment.RunUntilIdle();
+}
+
 }  // namespace
 
 }  // namespace base
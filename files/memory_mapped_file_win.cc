@@ -10,6 +10,7 @@
 #include <limits>
 
 #include "base/files/file_path.h"
+#include "base/logging.h"
 #include "base/strings/string16.h"
 #include "base/threading/thread_restrictions.h"
 
@@ -17,8 +18,8 @@
 
 namespace base {
 
-MemoryMappedFile::MemoryMappedFile() : data_(NULL), length_(0) {
-}
+MemoryMappedFile::MemoryMappedFile()
+    : data_(NULL), length_(0), file_offset_(0), populate_(false) {}
 
 bool MemoryMappedFile::MapFileRegionToMemory(
     const MemoryMappedFile::Region& region,
@@ -91,6 +92,34 @@ bool MemoryMappedFile::MapFileRegionToMemory(
   if (data_ == NULL)
     return false;
   data_ += data_offset;
+
+  if (populate_)
+    Advise(HINT_WILL_NEED);
+
+  return true;
+}
+
+bool MemoryMappedFile::Advise(AccessHint hint) {
+  DCHECK(IsValid());
+  // Windows has no equivalent of madvise() for file mappings, except for
+  // PrefetchVirtualMemory(), which starts reading the pages in like
+  // MADV_WILLNEED and is only available on Windows 8 and later.
+  if (hint != HINT_WILL_NEED)
+    return false;
+
+  using PrefetchVirtualMemoryFunction =
+      BOOL(WINAPI*)(HANDLE, ULONG_PTR, PWIN32_MEMORY_RANGE_ENTRY, ULONG);
+  static const auto prefetch_virtual_memory =
+      reinterpret_cast<PrefetchVirtualMemoryFunction>(::GetProcAddress(
+          ::GetModuleHandle(L"kernel32.dll"), "PrefetchVirtualMemory"));
+  if (!prefetch_virtual_memory)
+    return false;
+
+  WIN32_MEMORY_RANGE_ENTRY range = {data_, length_};
+  if (!prefetch_virtual_memory(::GetCurrentProcess(), 1, &range, 0)) {
+    DVPLOG(1) << "PrefetchVirtualMemory";
+    return false;
+  }
   return true;
 }
 
@@ -104,6 +133,7 @@ void MemoryMappedFile::CloseHandles() {
 
   data_ = NULL;
   length_ = 0;
+  file_offset_ = 0;
 }
 
 }  // namespace base
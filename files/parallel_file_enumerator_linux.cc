@@ -0,0 +1,198 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/files/parallel_file_enumerator_linux.h"
+
+#include <dirent.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <utility>
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/files/dir_reader_linux.h"
+#include "base/files/file_enumerator.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/sequenced_task_runner.h"
+#include "base/synchronization/atomic_flag.h"
+#include "base/task_runner.h"
+#include "base/task_scheduler/post_task.h"
+#include "base/threading/scoped_blocking_call.h"
+#include "base/threading/sequenced_task_runner_handle.h"
+
+namespace base {
+
+namespace {
+
+// Number of entries accumulated by a task before they are handed to the
+// client. Big enough to amortize the cost of posting, small enough to stream.
+constexpr size_t kBatchSize = 512;
+
+}  // namespace
+
+// State shared by the tasks of one enumeration.
+class ParallelFileEnumerator::Core
+    : public RefCountedThreadSafe<ParallelFileEnumerator::Core> {
+ public:
+  Core(int file_type,
+       EntriesCallback entries_callback,
+       OnceClosure done_callback,
+       const TaskTraits& traits)
+      : file_type_(file_type),
+        entries_callback_(std::move(entries_callback)),
+        done_callback_(std::move(done_callback)),
+        task_runner_(CreateTaskRunnerWithTraits(
+            TaskTraits::Override(traits, {MayBlock()}))),
+        reply_task_runner_(SequencedTaskRunnerHandle::Get()) {}
+
+  void Start(const FilePath& root_path) {
+    subtle::NoBarrier_Store(&pending_directories_, 1);
+    PostReadDirectory(root_path);
+  }
+
+  // Stops the enumeration. Must be called on the reply sequence.
+  void Cancel() {
+    DCHECK(reply_task_runner_->RunsTasksInCurrentSequence());
+    cancelled_.Set();
+  }
+
+ private:
+  friend class RefCountedThreadSafe<Core>;
+  ~Core() = default;
+
+  void PostReadDirectory(FilePath path) {
+    task_runner_->PostTask(
+        FROM_HERE, BindOnce(&Core::ReadDirectory, this, std::move(path)));
+  }
+
+  // Reads the entries of |path|, fans its subdirectories out to new tasks
+  // and reports the entries that match |file_type_|.
+  void ReadDirectory(const FilePath& path) {
+    if (!cancelled_.IsSet()) {
+      ScopedBlockingCall scoped_blocking_call(BlockingType::MAY_BLOCK);
+      std::vector<Entry> entries;
+      DirReaderLinux reader(path.value().c_str());
+      if (reader.IsValid()) {
+        while (reader.Next()) {
+          const char* name = reader.name();
+          if (!strcmp(name, ".") || !strcmp(name, ".."))
+            continue;
+
+          FilePath entry_path = path.Append(name);
+          bool is_directory;
+          unsigned char type = reader.type();
+          if (type == DT_UNKNOWN) {
+            struct stat st;
+            if (fstatat(reader.fd(), name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+              continue;
+            is_directory = S_ISDIR(st.st_mode);
+          } else {
+            is_directory = type == DT_DIR;
+          }
+
+          if (is_directory) {
+            subtle::NoBarrier_AtomicIncrement(&pending_directories_, 1);
+            PostReadDirectory(entry_path);
+          }
+
+          if (file_type_ & (is_directory ? FileEnumerator::DIRECTORIES
+                                         : FileEnumerator::FILES)) {
+            entries.emplace_back(std::move(entry_path), is_directory);
+            if (entries.size() == kBatchSize) {
+              PostEntries(std::move(entries));
+              entries.clear();
+              entries.reserve(kBatchSize);
+            }
+          }
+        }
+      }
+      if (!entries.empty())
+        PostEntries(std::move(entries));
+    }
+
+    // The last directory to finish reports completion. Its batches, like all
+    // other tasks' batches, were posted before this point, so |done_callback_|
+    // runs after every batch.
+    if (subtle::Barrier_AtomicIncrement(&pending_directories_, -1) == 0) {
+      reply_task_runner_->PostTask(FROM_HERE,
+                                   BindOnce(&Core::RunDoneCallback, this));
+    }
+  }
+
+  void PostEntries(std::vector<Entry> entries) {
+    reply_task_runner_->PostTask(
+        FROM_HERE, BindOnce(&Core::RunEntriesCallback, this,
+                            std::move(entries)));
+  }
+
+  void RunEntriesCallback(std::vector<Entry> entries) {
+    if (!cancelled_.IsSet())
+      entries_callback_.Run(std::move(entries));
+  }
+
+  void RunDoneCallback() {
+    if (!cancelled_.IsSet())
+      std::move(done_callback_).Run();
+  }
+
+  const int file_type_;
+  const EntriesCallback entries_callback_;
+  OnceClosure done_callback_;
+  const scoped_refptr<TaskRunner> task_runner_;
+  const scoped_refptr<SequencedTaskRunner> reply_task_runner_;
+
+  // Number of directories posted for reading and not yet done.
+  subtle::Atomic32 pending_directories_ = 0;
+
+  AtomicFlag cancelled_;
+
+  DISALLOW_COPY_AND_ASSIGN(Core);
+};
+
+ParallelFileEnumerator::Entry::Entry() = default;
+
+ParallelFileEnumerator::Entry::Entry(FilePath path, bool is_directory)
+    : path(std::move(path)), is_directory(is_directory) {}
+
+ParallelFileEnumerator::Entry::Entry(const Entry& other) = default;
+
+ParallelFileEnumerator::Entry::Entry(Entry&& other) = default;
+
+ParallelFileEnumerator::Entry& ParallelFileEnumerator::Entry::operator=(
+    const Entry& other) = default;
+
+ParallelFileEnumerator::Entry& ParallelFileEnumerator::Entry::operator=(
+    Entry&& other) = default;
+
+ParallelFileEnumerator::Entry::~Entry() = default;
+
+ParallelFileEnumerator::ParallelFileEnumerator(
+    const FilePath& root_path,
+    int file_type,
+    EntriesCallback entries_callback,
+    OnceClosure done_callback,
+    const TaskTraits& traits)
+    : core_(MakeRefCounted<Core>(file_type,
+                                 std::move(entries_callback),
+                                 std::move(done_callback),
+                                 traits)),
+      root_path_(root_path) {
+  DCHECK(file_type & (FileEnumerator::FILES | FileEnumerator::DIRECTORIES));
+}
+
+ParallelFileEnumerator::~ParallelFileEnumerator() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  core_->Cancel();
+}
+
+void ParallelFileEnumerator::Start() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  DCHECK(!started_);
+  started_ = true;
+  core_->Start(root_path_);
+}
+
+}  // namespace base
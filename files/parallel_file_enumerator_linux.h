@@ -0,0 +1,87 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_FILES_PARALLEL_FILE_ENUMERATOR_LINUX_H_
+#define BASE_FILES_PARALLEL_FILE_ENUMERATOR_LINUX_H_
+
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/callback.h"
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/sequence_checker.h"
+#include "base/task_scheduler/task_traits.h"
+
+namespace base {
+
+// Recursively enumerates a directory tree using all available TaskScheduler
+// workers. Unlike FileEnumerator, which walks the tree on one thread and
+// stat()s every entry, each directory is read with getdents64() (see
+// DirReaderLinux) in its own task, and entry types come from d_type, so a
+// stat() is only needed on file systems that do not report it.
+//
+// Results are delivered in batches, in no particular order, on the sequence
+// on which the enumerator was created. Symbolic links are never followed and
+// are reported as files. Directories that cannot be read are skipped.
+//
+// Deleting the enumerator stops delivery of results immediately; tasks that
+// are already running finish reading their directory and then stop.
+//
+// Example:
+//
+//   enumerator_ = std::make_unique<ParallelFileEnumerator>(
+//       root, FileEnumerator::FILES,
+//       BindRepeating(&Indexer::OnEntries, Unretained(this)),
+//       BindOnce(&Indexer::OnEnumerationDone, Unretained(this)));
+//   enumerator_->Start();
+class BASE_EXPORT ParallelFileEnumerator {
+ public:
+  struct BASE_EXPORT Entry {
+    Entry();
+    Entry(FilePath path, bool is_directory);
+    Entry(const Entry& other);
+    Entry(Entry&& other);
+    Entry& operator=(const Entry& other);
+    Entry& operator=(Entry&& other);
+    ~Entry();
+
+    // Full path of the entry, starting with the root path.
+    FilePath path;
+    bool is_directory = false;
+  };
+
+  using EntriesCallback = RepeatingCallback<void(std::vector<Entry> entries)>;
+
+  // |file_type| is a mask of FileEnumerator::FILES and
+  // FileEnumerator::DIRECTORIES selecting which entries are reported; the
+  // whole tree below |root_path| is traversed either way. |entries_callback|
+  // receives the results in batches and |done_callback| runs after the last
+  // batch. Tasks run with |traits|, to which MayBlock() is added.
+  ParallelFileEnumerator(const FilePath& root_path,
+                         int file_type,
+                         EntriesCallback entries_callback,
+                         OnceClosure done_callback,
+                         const TaskTraits& traits = TaskTraits());
+  ~ParallelFileEnumerator();
+
+  // Starts the enumeration. Must be called at most once.
+  void Start();
+
+ private:
+  class Core;
+
+  const scoped_refptr<Core> core_;
+  const FilePath root_path_;
+  bool started_ = false;
+
+  SEQUENCE_CHECKER(sequence_checker_);
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelFileEnumerator);
+};
+
+}  // namespace base
+
+#endif  // BASE_FILES_PARALLEL_FILE_ENUMERATOR_LINUX_H_
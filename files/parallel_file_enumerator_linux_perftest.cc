@@ -0,0 +1,128 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/files/parallel_file_enumerator_linux.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/files/file_enumerator.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/task_scheduler/scheduler_worker_pool_params.h"
+#include "base/task_scheduler/task_scheduler.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+
+namespace {
+
+constexpr int kIterations = 5;
+constexpr int kDirectories = 64;
+constexpr int kFilesPerDirectory = 200;
+
+class ParallelFileEnumeratorPerfTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    // Two levels of directories, so that the parallel enumerator has work to
+    // spread as soon as the root has been read.
+    for (int i = 0; i < kDirectories; ++i) {
+      FilePath dir = root()
+                         .AppendASCII("dir" + IntToString(i % 8))
+                         .AppendASCII("sub" + IntToString(i));
+      ASSERT_TRUE(CreateDirectory(dir));
+      for (int j = 0; j < kFilesPerDirectory; ++j) {
+        ASSERT_EQ(0,
+                  WriteFile(dir.AppendASCII("file" + IntToString(j)), "", 0));
+      }
+    }
+  }
+
+  const FilePath& root() const { return temp_dir_.GetPath(); }
+
+  size_t EnumerateSerially() {
+    size_t count = 0;
+    FileEnumerator enumerator(root(), true,
+                              FileEnumerator::FILES |
+                                  FileEnumerator::SHOW_SYM_LINKS);
+    for (FilePath path = enumerator.Next(); !path.empty();
+         path = enumerator.Next()) {
+      ++count;
+    }
+    return count;
+  }
+
+  size_t EnumerateInParallel() {
+    size_t count = 0;
+    RunLoop run_loop;
+    ParallelFileEnumerator enumerator(
+        root(), FileEnumerator::FILES,
+        BindRepeating(
+            [](size_t* count,
+               std::vector<ParallelFileEnumerator::Entry> entries) {
+              *count += entries.size();
+            },
+            &count),
+        run_loop.QuitClosure());
+    enumerator.Start();
+    run_loop.Run();
+    return count;
+  }
+
+  template <typename EnumerateFunction>
+  void Measure(const std::string& trace, EnumerateFunction enumerate) {
+    size_t count = 0;
+    TimeTicks start = TimeTicks::Now();
+    for (int i = 0; i < kIterations; ++i)
+      count = enumerate();
+    TimeDelta elapsed = TimeTicks::Now() - start;
+    ASSERT_EQ(static_cast<size_t>(kDirectories * kFilesPerDirectory), count);
+    perf_test::PrintResult("ParallelFileEnumerator", "_time_per_tree", trace,
+                           elapsed.InMillisecondsF() / kIterations, "ms",
+                           true);
+  }
+
+  MessageLoop message_loop_;
+  ScopedTempDir temp_dir_;
+};
+
+// Starts a TaskScheduler whose pools each run at most |max_tasks| tasks.
+void StartTaskScheduler(int max_tasks) {
+  const SchedulerWorkerPoolParams params(max_tasks, TimeDelta::FromSeconds(30));
+  TaskScheduler::Create("ParallelFileEnumeratorPerfTest");
+  TaskScheduler::GetInstance()->Start({params, params, params, params});
+}
+
+void StopTaskScheduler() {
+  TaskScheduler::GetInstance()->FlushForTesting();
+  TaskScheduler::GetInstance()->Shutdown();
+  TaskScheduler::GetInstance()->JoinForTesting();
+  TaskScheduler::SetInstance(nullptr);
+}
+
+}  // namespace
+
+TEST_F(ParallelFileEnumeratorPerfTest, EnumerateTree) {
+  // Warm the dentry cache, so that all variants read from memory.
+  EnumerateSerially();
+  Measure("file_enumerator", [this]() { return EnumerateSerially(); });
+
+  for (int workers : {1, 2, 4, 8}) {
+    StartTaskScheduler(workers);
+    Measure("parallel_" + IntToString(workers) + "_workers",
+            [this]() { return EnumerateInParallel(); });
+    StopTaskScheduler();
+  }
+}
+
+}  // namespace base
@@ -0,0 +1,133 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/files/parallel_file_enumerator_linux.h"
+
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/files/file_enumerator.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/test/scoped_task_environment.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+class ParallelFileEnumeratorTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    // Build a tree with enough entries per directory to span several
+    // batches and several getdents64() calls.
+    for (int i = 0; i < 4; ++i) {
+      FilePath dir = root().AppendASCII("dir" + IntToString(i));
+      ASSERT_TRUE(
+          CreateDirectory(dir.AppendASCII("nested").AppendASCII("deep")));
+      for (int j = 0; j < 300; ++j) {
+        ASSERT_EQ(0, WriteFile(dir.AppendASCII("file" + IntToString(j)), "",
+                               0));
+      }
+      ASSERT_EQ(0, WriteFile(dir.AppendASCII("nested").AppendASCII("deep")
+                                 .AppendASCII("leaf"),
+                             "", 0));
+    }
+    ASSERT_TRUE(CreateSymbolicLink(root(), root().AppendASCII("loop")));
+  }
+
+  const FilePath& root() const { return temp_dir_.GetPath(); }
+
+  // Returns what FileEnumerator reports for |file_type|, without following
+  // symbolic links.
+  std::set<FilePath> EnumerateSerially(int file_type) {
+    std::set<FilePath> results;
+    FileEnumerator enumerator(root(), true,
+                              file_type | FileEnumerator::SHOW_SYM_LINKS);
+    for (FilePath path = enumerator.Next(); !path.empty();
+         path = enumerator.Next()) {
+      results.insert(path);
+    }
+    return results;
+  }
+
+  std::set<FilePath> EnumerateInParallel(int file_type) {
+    std::set<FilePath> results;
+    RunLoop run_loop;
+    ParallelFileEnumerator enumerator(
+        root(), file_type,
+        BindRepeating(
+            [](std::set<FilePath>* results,
+               std::vector<ParallelFileEnumerator::Entry> entries) {
+              for (const auto& entry : entries) {
+                EXPECT_EQ(entry.is_directory, DirectoryExists(entry.path) &&
+                                                  !IsLink(entry.path));
+                EXPECT_TRUE(results->insert(entry.path).second)
+                    << "Same path returned twice";
+              }
+            },
+            &results),
+        run_loop.QuitClosure());
+    enumerator.Start();
+    run_loop.Run();
+    return results;
+  }
+
+  test::ScopedTaskEnvironment scoped_task_environment_;
+  ScopedTempDir temp_dir_;
+};
+
+}  // namespace
+
+TEST_F(ParallelFileEnumeratorTest, MatchesFileEnumerator) {
+  const int kFileTypes[] = {
+      FileEnumerator::FILES, FileEnumerator::DIRECTORIES,
+      FileEnumerator::FILES | FileEnumerator::DIRECTORIES};
+  for (int file_type : kFileTypes) {
+    SCOPED_TRACE(file_type);
+    std::set<FilePath> expected = EnumerateSerially(file_type);
+    EXPECT_FALSE(expected.empty());
+    EXPECT_EQ(expected, EnumerateInParallel(file_type));
+  }
+}
+
+TEST_F(ParallelFileEnumeratorTest, MissingRoot) {
+  bool done = false;
+  RunLoop run_loop;
+  ParallelFileEnumerator enumerator(
+      root().AppendASCII("missing"), FileEnumerator::FILES,
+      BindRepeating([](std::vector<ParallelFileEnumerator::Entry> entries) {
+        ADD_FAILURE() << "Unexpected entries";
+      }),
+      BindOnce(
+          [](bool* done, OnceClosure quit) {
+            *done = true;
+            std::move(quit).Run();
+          },
+          &done, run_loop.QuitClosure()));
+  enumerator.Start();
+  run_loop.Run();
+  EXPECT_TRUE(done);
+}
+
+TEST_F(ParallelFileEnumeratorTest, DeleteStopsCallbacks) {
+  auto enumerator = std::make_unique<ParallelFileEnumerator>(
+      root(), FileEnumerator::FILES,
+      BindRepeating([](std::vector<ParallelFileEnumerator::Entry> entries) {
+        ADD_FAILURE() << "Callback run after deletion";
+      }),
+      BindOnce([] { ADD_FAILURE() << "Callback run after deletion"; }));
+  enumerator->Start();
+  enumerator.reset();
+  scoped_task_environment_.RunUntilIdle();
+}
+
+}  // namespace base
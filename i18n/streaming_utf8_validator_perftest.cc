@@ -22,6 +22,7 @@
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
 #include "base/test/perf_time_logger.h"
+#include "base/test/scoped_perf_counters.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace base {
@@ -89,10 +90,12 @@ bool RunTest(const std::string& description,
              const std::string& test_string,
              int times) {
   base::PerfTimeLogger timer(description.c_str());
+  base::ScopedPerfCounters counters(description.c_str());
   bool result = true;
   for (int i = 0; i < times; ++i) {
     result = target(test_string) && result;
   }
+  counters.Done();
   timer.Done();
   return result;
 }
@@ -47,6 +47,20 @@ std::unique_ptr<DictionaryValue> GenerateLayeredDict(int breadth, int depth) {
   return root;
 }
 
+// Generates a list of |count| doubles with varied magnitudes and digit counts,
+// like the coordinates and measurements found in numeric-heavy documents.
+std::unique_ptr<ListValue> GenerateDoubleList(int count) {
+  auto list = std::make_unique<ListValue>();
+  double value = 0.1;
+  for (int i = 0; i < count; ++i) {
+    list->AppendDouble(value);
+    value = value * 1.37 + 0.29;
+    if (value > 1e12)
+      value /= 1e15;
+  }
+  return list;
+}
+
 }  // namespace
 
 class JSONPerfTest : public testing::Test {
@@ -54,11 +68,14 @@ class JSONPerfTest : public testing::Test {
   void TestWriteAndRead(int breadth, int depth) {
     std::string description = "Breadth: " + std::to_string(breadth) +
                               ", Depth: " + std::to_string(depth);
-    auto dict = GenerateLayeredDict(breadth, depth);
+    TestWriteAndRead(*GenerateLayeredDict(breadth, depth), description);
+  }
+
+  void TestWriteAndRead(const Value& value, const std::string& description) {
     std::string json;
 
     TimeTicks start_write = TimeTicks::Now();
-    JSONWriter::Write(*dict, &json);
+    JSONWriter::Write(value, &json);
     TimeTicks end_write = TimeTicks::Now();
     perf_test::PrintResult("Write", "", description,
                            (end_write - start_write).InMillisecondsF(), "ms",
@@ -81,4 +98,11 @@ TEST_F(JSONPerfTest, StressTest) {
   }
 }
 
+TEST_F(JSONPerfTest, Doubles) {
+  for (int count = 1000; count <= 1000000; count *= 10) {
+    TestWriteAndRead(*GenerateDoubleList(count),
+                     "Doubles: " + std::to_string(count));
+  }
+}
+
 }  // namespace base
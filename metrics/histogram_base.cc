@@ -7,11 +7,9 @@
 #include <limits.h>
 
 #include <memory>
-#include <set>
 #include <utility>
 
 #include "base/json/json_string_value_serializer.h"
-#include "base/lazy_instance.h"
 #include "base/logging.h"
 #include "base/metrics/histogram.h"
 #include "base/metrics/histogram_macros.h"
@@ -22,8 +20,8 @@
 #include "base/pickle.h"
 #include "base/process/process_handle.h"
 #include "base/rand_util.h"
+#include "base/strings/interned_string.h"
 #include "base/strings/stringprintf.h"
-#include "base/synchronization/lock.h"
 #include "base/values.h"
 
 namespace base {
@@ -201,15 +199,11 @@ void HistogramBase::WriteAsciiBucketValue(Count current,
 
 // static
 char const* HistogramBase::GetPermanentName(const std::string& name) {
-  // A set of histogram names that provides the "permanent" lifetime required
-  // by histogram objects for those strings that are not already code constants
-  // or held in persistent memory.
-  static LazyInstance<std::set<std::string>>::Leaky permanent_names;
-  static LazyInstance<Lock>::Leaky permanent_names_lock;
-
-  AutoLock lock(permanent_names_lock.Get());
-  auto result = permanent_names.Get().insert(name);
-  return result.first->c_str();
+  // Interned strings are never freed, which provides the "permanent" lifetime
+  // required by histogram objects for those strings that are not already code
+  // constants or held in persistent memory. Names that were seen before are
+  // found without taking a lock.
+  return InternedString::Intern(name).c_str();
 }
 
 }  // namespace base
@@ -68,6 +68,16 @@ void StatisticsRecorder::EnsureGlobalRecorderWhileLocked() {
   DCHECK_EQ(p, top_);
 }
 
+// static
+HistogramBase* StatisticsRecorder::FindHistogramWhileLocked(StringPiece name) {
+  lock_.Get().AssertAcquired();
+  InternedString interned_name;
+  if (!InternedString::Find(name, &interned_name))
+    return nullptr;
+  const HistogramMap::const_iterator it = top_->histograms_.find(interned_name);
+  return it != top_->histograms_.end() ? it->second : nullptr;
+}
+
 // static
 void StatisticsRecorder::RegisterHistogramProvider(
     const WeakPtr<HistogramProvider>& provider) {
@@ -85,11 +95,10 @@ HistogramBase* StatisticsRecorder::RegisterOrDeleteDuplicate(
   EnsureGlobalRecorderWhileLocked();
 
   const char* const name = histogram->histogram_name();
-  HistogramBase*& registered = top_->histograms_[name];
+  HistogramBase*& registered =
+      top_->histograms_[InternedString::Intern(name)];
 
   if (!registered) {
-    // |name| is guaranteed to never change or be deallocated so long
-    // as the histogram is alive (which is forever).
     registered = histogram;
     ANNOTATE_LEAKING_OBJECT_PTR(histogram);  // see crbug.com/79322
     // If there are callbacks for this histogram, we set the kCallbackExists
@@ -191,10 +200,16 @@ HistogramBase* StatisticsRecorder::FindHistogram(base::StringPiece name) {
   // will acquire the lock at that time.
   ImportGlobalPersistentHistograms();
 
+  // A name that was never interned can't be the name of a registered
+  // histogram. This check doesn't take a lock.
+  InternedString interned_name;
+  if (!InternedString::Find(name, &interned_name))
+    return nullptr;
+
   const AutoLock auto_lock(lock_.Get());
   EnsureGlobalRecorderWhileLocked();
 
-  const HistogramMap::const_iterator it = top_->histograms_.find(name);
+  const HistogramMap::const_iterator it = top_->histograms_.find(interned_name);
   return it != top_->histograms_.end() ? it->second : nullptr;
 }
 
@@ -247,9 +262,9 @@ bool StatisticsRecorder::SetCallback(
   if (!top_->callbacks_.insert({name, cb}).second)
     return false;
 
-  const HistogramMap::const_iterator it = top_->histograms_.find(name);
-  if (it != top_->histograms_.end())
-    it->second->SetFlags(HistogramBase::kCallbackExists);
+  HistogramBase* const histogram = FindHistogramWhileLocked(name);
+  if (histogram)
+    histogram->SetFlags(HistogramBase::kCallbackExists);
 
   return true;
 }
@@ -262,9 +277,9 @@ void StatisticsRecorder::ClearCallback(const std::string& name) {
   top_->callbacks_.erase(name);
 
   // We also clear the flag from the histogram (if it exists).
-  const HistogramMap::const_iterator it = top_->histograms_.find(name);
-  if (it != top_->histograms_.end())
-    it->second->ClearFlags(HistogramBase::kCallbackExists);
+  HistogramBase* const histogram = FindHistogramWhileLocked(name);
+  if (histogram)
+    histogram->ClearFlags(HistogramBase::kCallbackExists);
 }
 
 // static
@@ -288,7 +303,11 @@ void StatisticsRecorder::ForgetHistogramForTesting(base::StringPiece name) {
   const AutoLock auto_lock(lock_.Get());
   EnsureGlobalRecorderWhileLocked();
 
-  const HistogramMap::iterator found = top_->histograms_.find(name);
+  InternedString interned_name;
+  if (!InternedString::Find(name, &interned_name))
+    return;
+
+  const HistogramMap::iterator found = top_->histograms_.find(interned_name);
   if (found == top_->histograms_.end())
     return;
 
@@ -26,6 +26,7 @@
 #include "base/memory/weak_ptr.h"
 #include "base/metrics/histogram_base.h"
 #include "base/metrics/record_histogram_checker.h"
+#include "base/strings/interned_string.h"
 #include "base/strings/string_piece.h"
 #include "base/synchronization/lock.h"
 
@@ -223,7 +224,9 @@ class BASE_EXPORT StatisticsRecorder {
  private:
   typedef std::vector<WeakPtr<HistogramProvider>> HistogramProviders;
 
-  typedef std::unordered_map<StringPiece, HistogramBase*, StringPieceHash>
+  // Keyed by interned names, so that lookups compare pointers instead of
+  // strings.
+  typedef std::unordered_map<InternedString, HistogramBase*, InternedStringHash>
       HistogramMap;
 
   // We keep a map of callbacks to histograms, so that as histograms are
@@ -251,6 +254,11 @@ class BASE_EXPORT StatisticsRecorder {
   // Precondition: The global lock is already acquired.
   static void EnsureGlobalRecorderWhileLocked();
 
+  // Returns the registered histogram named |name|, or null if there is none.
+  //
+  // Precondition: The global lock is already acquired.
+  static HistogramBase* FindHistogramWhileLocked(StringPiece name);
+
   // Gets histogram providers.
   //
   // This method is thread safe.
@@ -5,7 +5,10 @@
 #ifndef BASE_OBSERVER_LIST_THREADSAFE_H_
 #define BASE_OBSERVER_LIST_THREADSAFE_H_
 
+#include <algorithm>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "base/base_export.h"
 #include "base/bind.h"
@@ -17,7 +20,7 @@
 #include "base/observer_list.h"
 #include "base/sequenced_task_runner.h"
 #include "base/stl_util.h"
-#include "base/synchronization/lock.h"
+#include "base/synchronization/ref_counted_snapshot.h"
 #include "base/threading/sequenced_task_runner_handle.h"
 #include "base/threading/thread_local.h"
 #include "build/build_config.h"
@@ -51,6 +54,11 @@
 //   will always be done via PostTask() to another sequence, whereas with the
 //   non-thread-safe observer_list, notifications happen synchronously.
 //
+//   The observers are kept in a copy-on-write snapshot, so Notify() doesn't
+//   lock, and adding or removing an observer copies the list. Notify() posts
+//   one task per sequence, which notifies all the observers registered from
+//   that sequence.
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 namespace base {
@@ -109,19 +117,30 @@ class ObserverListThreadSafe : public internal::ObserverListThreadSafeBase {
     if (!SequencedTaskRunnerHandle::IsSet())
       return;
 
-    AutoLock auto_lock(lock_);
-
     // Add |observer| to the list of observers.
-    DCHECK(!ContainsKey(observers_, observer));
     const scoped_refptr<SequencedTaskRunner> task_runner =
         SequencedTaskRunnerHandle::Get();
-    observers_[observer] = task_runner;
+    observers_.Update([observer, &task_runner](ObserverSet* observers) {
+      DCHECK(!ContainsKey(observers->task_runners, observer));
+      observers->task_runners[observer] = task_runner;
+      auto group = std::find_if(
+          observers->groups.begin(), observers->groups.end(),
+          [&task_runner](const SequenceObservers& group) {
+            return group.task_runner == task_runner;
+          });
+      if (group == observers->groups.end()) {
+        observers->groups.emplace_back();
+        group = observers->groups.end() - 1;
+        group->task_runner = task_runner;
+      }
+      group->observers.push_back(observer);
+    });
 
     // If this is called while a notification is being dispatched on this thread
     // and |policy_| is ALL, |observer| must be notified (if a notification is
     // being dispatched on another thread in parallel, the notification may or
-    // may not make it to |observer| depending on the outcome of the race to
-    // |lock_|).
+    // may not make it to |observer| depending on whether it started before
+    // |observer| was added).
     if (policy_ == ObserverListPolicy::ALL) {
       const NotificationDataBase* current_notification =
           tls_current_notification_.Get().Get();
@@ -142,15 +161,33 @@ class ObserverListThreadSafe : public internal::ObserverListThreadSafeBase {
   // it will be aborted. If a notification has started to run, removing the
   // observer won't stop it.
   void RemoveObserver(ObserverType* observer) {
-    AutoLock auto_lock(lock_);
-    observers_.erase(observer);
+    {
+      typename Snapshot::ReadScope observers(observers_);
+      if (!ContainsKey(observers->task_runners, observer))
+        return;
+    }
+    observers_.Update([observer](ObserverSet* observers) {
+      auto it = observers->task_runners.find(observer);
+      if (it == observers->task_runners.end())
+        return;
+      auto group = std::find_if(
+          observers->groups.begin(), observers->groups.end(),
+          [&it](const SequenceObservers& group) {
+            return group.task_runner == it->second;
+          });
+      DCHECK(group != observers->groups.end());
+      Erase(group->observers, observer);
+      if (group->observers.empty())
+        observers->groups.erase(group);
+      observers->task_runners.erase(it);
+    });
   }
 
   // Verifies that the list is currently empty (i.e. there are no observers).
   void AssertEmpty() const {
 #if DCHECK_IS_ON()
-    AutoLock auto_lock(lock_);
-    DCHECK(observers_.empty());
+    typename Snapshot::ReadScope observers(observers_);
+    DCHECK(observers->task_runners.empty());
 #endif
   }
 
@@ -164,13 +201,20 @@ class ObserverListThreadSafe : public internal::ObserverListThreadSafeBase {
         Bind(&Dispatcher<ObserverType, Method>::Run, m,
              std::forward<Params>(params)...);
 
-    AutoLock lock(lock_);
-    for (const auto& observer : observers_) {
-      observer.second->PostTask(
-          from_here,
-          BindOnce(&ObserverListThreadSafe<ObserverType>::NotifyWrapper, this,
-                   observer.first, NotificationData(this, from_here, method)));
+    {
+      typename Snapshot::ReadScope observers(observers_);
+      for (size_t i = 0; i < observers->groups.size(); ++i) {
+        observers->groups[i].task_runner->PostTask(
+            from_here,
+            BindOnce(&ObserverListThreadSafe<ObserverType>::NotifyGroupWrapper,
+                     this, observers.Retain(), i,
+                     NotificationData(this, from_here, method)));
+      }
     }
+    // An observer set replaced during the notification holds references to
+    // task runners; release it now rather than at the next update of any
+    // snapshot.
+    Snapshot::ReclaimRetired();
   }
 
  private:
@@ -186,16 +230,45 @@ class ObserverListThreadSafe : public internal::ObserverListThreadSafeBase {
     Callback<void(ObserverType*)> method;
   };
 
+  // The observers that were registered from a sequence, in the order they were
+  // added.
+  struct SequenceObservers {
+    scoped_refptr<SequencedTaskRunner> task_runner;
+    std::vector<ObserverType*> observers;
+  };
+
+  struct ObserverSet {
+    // Keys are observers. Values are the SequencedTaskRunners on which they
+    // must be notified.
+    std::unordered_map<ObserverType*, scoped_refptr<SequencedTaskRunner>>
+        task_runners;
+
+    // The same observers, grouped by SequencedTaskRunner.
+    std::vector<SequenceObservers> groups;
+  };
+
+  using Snapshot = RefCountedSnapshot<ObserverSet>;
+
   ~ObserverListThreadSafe() override = default;
 
+  // Notifies the observers of |observers|->groups[|group_index|] that are
+  // still in the list, in the order they were added.
+  void NotifyGroupWrapper(
+      const scoped_refptr<const typename Snapshot::Value>& observers,
+      size_t group_index,
+      const NotificationData& notification) {
+    for (ObserverType* observer : observers->data.groups[group_index].observers)
+      NotifyWrapper(observer, notification);
+  }
+
   void NotifyWrapper(ObserverType* observer,
                      const NotificationData& notification) {
     {
-      AutoLock auto_lock(lock_);
+      typename Snapshot::ReadScope observers(observers_);
 
       // Check whether the observer still needs a notification.
-      auto it = observers_.find(observer);
-      if (it == observers_.end())
+      auto it = observers->task_runners.find(observer);
+      if (it == observers->task_runners.end())
         return;
       DCHECK(it->second->RunsTasksInCurrentSequence());
     }
@@ -221,13 +294,8 @@ class ObserverListThreadSafe : public internal::ObserverListThreadSafeBase {
 
   const ObserverListPolicy policy_ = ObserverListPolicy::ALL;
 
-  // Synchronizes access to |observers_|.
-  mutable Lock lock_;
-
-  // Keys are observers. Values are the SequencedTaskRunners on which they must
-  // be notified.
-  std::unordered_map<ObserverType*, scoped_refptr<SequencedTaskRunner>>
-      observers_;
+  // The observers, replaced as a whole when one is added or removed.
+  Snapshot observers_;
 
   DISALLOW_COPY_AND_ASSIGN(ObserverListThreadSafe);
 };
@@ -22,8 +22,10 @@
 #include "base/task_scheduler/task_scheduler.h"
 #include "base/test/gtest_util.h"
 #include "base/test/scoped_task_environment.h"
+#include "base/test/test_simple_task_runner.h"
 #include "base/threading/platform_thread.h"
 #include "base/threading/thread_restrictions.h"
+#include "base/threading/thread_task_runner_handle.h"
 #include "build/build_config.h"
 #include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -794,6 +796,40 @@ TEST(ObserverListThreadSafeTest, RemoveWhileNotificationIsRunning) {
   observer.Unblock();
 }
 
+// Verify that a notification posts one task per sequence, which notifies the
+// observers of that sequence that are still registered when it runs.
+TEST(ObserverListThreadSafeTest, OneTaskPerSequence) {
+  auto observer_list = MakeRefCounted<ObserverListThreadSafe<Foo>>();
+  auto task_runner_1 = MakeRefCounted<TestSimpleTaskRunner>();
+  auto task_runner_2 = MakeRefCounted<TestSimpleTaskRunner>();
+
+  std::vector<Adder> observers_1(100, Adder(1));
+  std::vector<Adder> observers_2(3, Adder(-1));
+  {
+    ThreadTaskRunnerHandle handle(task_runner_1);
+    for (Adder& observer : observers_1)
+      observer_list->AddObserver(&observer);
+  }
+  {
+    ThreadTaskRunnerHandle handle(task_runner_2);
+    for (Adder& observer : observers_2)
+      observer_list->AddObserver(&observer);
+  }
+
+  observer_list->Notify(FROM_HERE, &Foo::Observe, 10);
+  EXPECT_EQ(1u, task_runner_1->NumPendingTasks());
+  EXPECT_EQ(1u, task_runner_2->NumPendingTasks());
+
+  observer_list->RemoveObserver(&observers_1[50]);
+  task_runner_1->RunPendingTasks();
+  task_runner_2->RunPendingTasks();
+
+  for (size_t i = 0; i < observers_1.size(); ++i)
+    EXPECT_EQ(i == 50 ? 0 : 10, observers_1[i].total);
+  for (const Adder& observer : observers_2)
+    EXPECT_EQ(-10, observer.total);
+}
+
 TEST(ObserverListTest, Existing) {
   ObserverList<Foo> observer_list(ObserverListPolicy::EXISTING_ONLY);
   Adder a(1);
@@ -4,15 +4,19 @@
 
 #include "base/process/internal_linux.h"
 
+#include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <map>
 #include <string>
 #include <vector>
 
 #include "base/files/file_util.h"
 #include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_split.h"
 #include "base/strings/string_util.h"
@@ -47,8 +51,7 @@ pid_t ProcDirSlotToPid(const char* d_name) {
 
   // Read the process's command line.
   pid_t pid;
-  std::string pid_string(d_name);
-  if (!StringToInt(pid_string, &pid)) {
+  if (!StringToInt(StringPiece(d_name, i), &pid)) {
     NOTREACHED();
     return 0;
   }
@@ -111,6 +114,93 @@ bool ParseProcStats(const std::string& stats_data,
   return true;
 }
 
+bool ParseProcStatsPieces(StringPiece stats_data,
+                          std::vector<StringPiece>* proc_stats) {
+  if (stats_data.empty())
+    return false;
+
+  // See ParseProcStats() for the format.
+  size_t open_parens_idx = stats_data.find(" (");
+  size_t close_parens_idx = stats_data.rfind(") ");
+  if (open_parens_idx == StringPiece::npos ||
+      close_parens_idx == StringPiece::npos ||
+      open_parens_idx > close_parens_idx) {
+    DLOG(WARNING) << "Failed to find matched parens in '" << stats_data << "'";
+    NOTREACHED();
+    return false;
+  }
+  open_parens_idx++;
+
+  proc_stats->clear();
+  // PID.
+  proc_stats->push_back(stats_data.substr(0, open_parens_idx));
+  // Process name without parentheses.
+  proc_stats->push_back(stats_data.substr(
+      open_parens_idx + 1, close_parens_idx - (open_parens_idx + 1)));
+
+  // Split the rest by hand; SplitStringPiece() would allocate a new vector.
+  StringPiece rest = stats_data.substr(close_parens_idx + 2);
+  while (!rest.empty()) {
+    size_t end = rest.find_first_of(" \n");
+    proc_stats->push_back(rest.substr(0, end));
+    if (end == StringPiece::npos)
+      break;
+    rest.remove_prefix(end + 1);
+  }
+  return true;
+}
+
+bool ReadProcFileFromFD(int fd, std::string* buffer) {
+  // Most /proc files fit in a page. Use the whole capacity of |buffer| so that
+  // it only grows on the first reads.
+  constexpr size_t kInitialSize = 4096;
+  buffer->resize(std::max(kInitialSize, buffer->capacity()));
+  size_t offset = 0;
+  for (;;) {
+    ssize_t bytes_read = HANDLE_EINTR(
+        pread(fd, &(*buffer)[offset], buffer->size() - offset, offset));
+    if (bytes_read < 0) {
+      buffer->clear();
+      return false;
+    }
+    if (bytes_read == 0)
+      break;
+    offset += bytes_read;
+    if (offset == buffer->size())
+      buffer->resize(buffer->size() * 2);
+  }
+  buffer->resize(offset);
+  return true;
+}
+
+CachedProcFile::CachedProcFile(const FilePath& path) : path_(path) {}
+
+CachedProcFile::~CachedProcFile() = default;
+
+bool CachedProcFile::Read(std::string* buffer) {
+  buffer->clear();
+  // Synchronously reading files in /proc is safe.
+  ThreadRestrictions::ScopedAllowIO allow_io;
+
+  if (!fd_.is_valid()) {
+    if (open_failed_)
+      return false;
+    fd_.reset(HANDLE_EINTR(open(path_.value().c_str(), O_RDONLY | O_CLOEXEC)));
+    if (!fd_.is_valid()) {
+      open_failed_ = true;
+      return false;
+    }
+  }
+
+  if (!ReadProcFileFromFD(fd_.get(), buffer)) {
+    // ESRCH means that the task exited; anything else is unexpected.
+    DPLOG_IF(WARNING, errno != ESRCH) << "Failed to read "
+                                      << path_.MaybeAsASCII();
+    return false;
+  }
+  return !buffer->empty();
+}
+
 typedef std::map<std::string, std::string> ProcStatMap;
 void ParseProcStat(const std::string& contents, ProcStatMap* output) {
   StringPairs key_value_pairs;
@@ -129,6 +219,15 @@ int64_t GetProcStatsFieldAsInt64(const std::vector<std::string>& proc_stats,
   return StringToInt64(proc_stats[field_num], &value) ? value : 0;
 }
 
+int64_t GetProcStatsFieldAsInt64(const std::vector<StringPiece>& proc_stats,
+                                 ProcStatsFields field_num) {
+  DCHECK_GE(field_num, VM_PPID);
+  CHECK_LT(static_cast<size_t>(field_num), proc_stats.size());
+
+  int64_t value;
+  return StringToInt64(proc_stats[field_num], &value) ? value : 0;
+}
+
 size_t GetProcStatsFieldAsSizeT(const std::vector<std::string>& proc_stats,
                                 ProcStatsFields field_num) {
   DCHECK_GE(field_num, VM_PPID);
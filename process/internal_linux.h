@@ -12,7 +12,13 @@
 #include <stdint.h>
 #include <unistd.h>
 
+#include <string>
+#include <vector>
+
 #include "base/files/file_path.h"
+#include "base/files/scoped_file.h"
+#include "base/macros.h"
+#include "base/strings/string_piece.h"
 
 namespace base {
 
@@ -46,6 +52,41 @@ bool ReadProcStats(pid_t pid, std::string* buffer);
 bool ParseProcStats(const std::string& stats_data,
                     std::vector<std::string>* proc_stats);
 
+// Same as ParseProcStats(), but the pieces in |proc_stats| point into
+// |stats_data|, so no strings are allocated.
+bool ParseProcStatsPieces(StringPiece stats_data,
+                          std::vector<StringPiece>* proc_stats);
+
+// Replaces the contents of |buffer| with the contents of the /proc file open
+// as |fd|, read from the start with pread() into the capacity of |buffer|.
+// Returns false and leaves errno set if reading fails.
+bool ReadProcFileFromFD(int fd, std::string* buffer);
+
+// A file in /proc that is opened once and then read again from the start on
+// every Read(). /proc files generate their contents on each read from offset
+// 0, so periodic sampling does not need to reopen them. Since the open file
+// refers to the task it was opened for, reads fail once that task is gone,
+// even if its pid is reused.
+class CachedProcFile {
+ public:
+  explicit CachedProcFile(const FilePath& path);
+  ~CachedProcFile();
+
+  // Replaces the contents of |buffer| with the current contents of the file,
+  // reusing the capacity of |buffer|. Returns true if the file can be read and
+  // is non-empty.
+  bool Read(std::string* buffer);
+
+ private:
+  const FilePath path_;
+  ScopedFD fd_;
+
+  // Set once opening |path_| has failed, to not retry on every Read().
+  bool open_failed_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(CachedProcFile);
+};
+
 // Fields from /proc/<pid>/stat, 0-based. See man 5 proc.
 // If the ordering ever changes, carefully review functions that use these
 // values.
@@ -69,6 +110,8 @@ enum ProcStatsFields {
 // simply |pid|, and the next two values are strings.
 int64_t GetProcStatsFieldAsInt64(const std::vector<std::string>& proc_stats,
                                  ProcStatsFields field_num);
+int64_t GetProcStatsFieldAsInt64(const std::vector<StringPiece>& proc_stats,
+                                 ProcStatsFields field_num);
 
 // Same as GetProcStatsFieldAsInt64(), but for size_t values.
 size_t GetProcStatsFieldAsSizeT(const std::vector<std::string>& proc_stats,
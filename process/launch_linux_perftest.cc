@@ -0,0 +1,90 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/process/launch.h"
+
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/process/process.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+
+namespace {
+
+constexpr size_t kMegabyte = 1024 * 1024;
+constexpr int kLaunches = 50;
+
+// Having a pre-exec delegate forces LaunchProcess() to fork(), which gives the
+// baseline to compare the default launch path with.
+class NoOpPreExecDelegate : public LaunchOptions::PreExecDelegate {
+ public:
+  NoOpPreExecDelegate() = default;
+  ~NoOpPreExecDelegate() override = default;
+
+  void RunAsyncSafe() override {}
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(NoOpPreExecDelegate);
+};
+
+// Returns the average time LaunchProcess() takes to start "true". Waiting for
+// the children to exit is not included.
+TimeDelta MeasureLaunchTime(const LaunchOptions& options) {
+  const std::vector<std::string> argv = {"true"};
+  TimeDelta total;
+  for (int i = 0; i < kLaunches; ++i) {
+    TimeTicks start = TimeTicks::Now();
+    Process process = LaunchProcess(argv, options);
+    total += TimeTicks::Now() - start;
+    EXPECT_TRUE(process.IsValid());
+    int exit_code = -1;
+    EXPECT_TRUE(process.WaitForExit(&exit_code));
+    EXPECT_EQ(0, exit_code);
+  }
+  return total / kLaunches;
+}
+
+}  // namespace
+
+// Reports the launch latency as the resident memory of the parent grows.
+TEST(LaunchProcessPerfTest, LatencyVersusParentRss) {
+  for (size_t rss_megabytes : {0, 256, 1024}) {
+    const size_t size = rss_megabytes * kMegabyte;
+    void* memory = nullptr;
+    if (size) {
+      memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      ASSERT_NE(MAP_FAILED, memory);
+      // Make it resident, so that fork() has page tables to copy.
+      memset(memory, 1, size);
+    }
+
+    const std::string modifier = NumberToString(rss_megabytes) + "MB_rss";
+    LaunchOptions options;
+    perf_test::PrintResult("LaunchProcess", modifier, "default",
+                           MeasureLaunchTime(options).InMillisecondsF(), "ms",
+                           true);
+
+    NoOpPreExecDelegate pre_exec_delegate;
+    options.pre_exec_delegate = &pre_exec_delegate;
+    perf_test::PrintResult("LaunchProcess", modifier, "fork",
+                           MeasureLaunchTime(options).InMillisecondsF(), "ms",
+                           true);
+
+    if (memory)
+      munmap(memory, size);
+  }
+}
+
+}  // namespace base
@@ -4,142 +4,182 @@
 
 #include "base/process/process_iterator.h"
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <unistd.h>
 
-#include "base/files/file_util.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/files/dir_reader_linux.h"
+#include "base/files/scoped_file.h"
 #include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
 #include "base/process/internal_linux.h"
-#include "base/strings/string_split.h"
-#include "base/strings/string_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_piece.h"
 #include "base/threading/thread_restrictions.h"
 
 namespace base {
 
 namespace {
 
-// Reads the |field_num|th field from |proc_stats|.
-// Returns an empty string on failure.
-// This version only handles VM_COMM and VM_STATE, which are the only fields
-// that are strings.
-std::string GetProcStatsFieldAsString(
-    const std::vector<std::string>& proc_stats,
-    internal::ProcStatsFields field_num) {
-  if (field_num < internal::VM_COMM || field_num > internal::VM_STATE) {
-    NOTREACHED();
-    return std::string();
-  }
-
-  if (proc_stats.size() > static_cast<size_t>(field_num))
-    return proc_stats[field_num];
+// Builds the path of |file| in the /proc directory of process |pid_name|,
+// relative to /proc. Returns false if it does not fit.
+bool MakeProcPath(const char* pid_name,
+                  const char* file,
+                  char* path,
+                  size_t path_size) {
+  int length = snprintf(path, path_size, "%s/%s", pid_name, file);
+  return length > 0 && static_cast<size_t>(length) < path_size;
+}
 
-  NOTREACHED();
-  return nullptr;
+// Reads the file |file| of the process |pid_name| in /proc, open as |proc_fd|,
+// into |buffer|. Returns true if successful.
+bool ReadProcFileAt(int proc_fd,
+                    const char* pid_name,
+                    const char* file,
+                    std::string* buffer) {
+  char path[NAME_MAX + 16];
+  if (!MakeProcPath(pid_name, file, path, sizeof(path)))
+    return false;
+  ScopedFD fd(HANDLE_EINTR(openat(proc_fd, path, O_RDONLY | O_CLOEXEC)));
+  if (!fd.is_valid())
+    return false;
+  return internal::ReadProcFileFromFD(fd.get(), buffer);
 }
 
-// Reads /proc/<pid>/cmdline and populates |proc_cmd_line_args| with the command
-// line arguments. Returns true if successful.
-// Note: /proc/<pid>/cmdline contains command line arguments separated by single
-// null characters. We tokenize it into a vector of strings using '\0' as a
-// delimiter.
-bool GetProcCmdline(pid_t pid, std::vector<std::string>* proc_cmd_line_args) {
-  // Synchronously reading files in /proc is safe.
-  ThreadRestrictions::ScopedAllowIO allow_io;
+// Parses the state, parent pid and process group of /proc/<pid>/stat, without
+// splitting the other fields. Returns true if successful.
+bool ParseProcStatHead(StringPiece stats_data,
+                       char* state,
+                       ProcessId* ppid,
+                       ProcessId* pgrp) {
+  // See internal::ParseProcStats() for the format. The process name may
+  // contain ") ", so look for the last one.
+  size_t close_parens_idx = stats_data.rfind(") ");
+  if (close_parens_idx == StringPiece::npos)
+    return false;
+  StringPiece rest = stats_data.substr(close_parens_idx + 2);
 
-  FilePath cmd_line_file = internal::GetProcPidDir(pid).Append("cmdline");
-  std::string cmd_line;
-  if (!ReadFileToString(cmd_line_file, &cmd_line))
+  // "<state> <ppid> <pgrp> ..."
+  StringPiece fields[3];
+  for (StringPiece& field : fields) {
+    size_t end = rest.find(' ');
+    if (end == StringPiece::npos)
+      return false;
+    field = rest.substr(0, end);
+    rest.remove_prefix(end + 1);
+  }
+  if (fields[0].size() != 1)
     return false;
-  std::string delimiters;
-  delimiters.push_back('\0');
-  *proc_cmd_line_args = SplitString(cmd_line, delimiters, KEEP_WHITESPACE,
-                                    SPLIT_WANT_NONEMPTY);
-  return true;
+  *state = fields[0][0];
+  return StringToInt(fields[1], ppid) && StringToInt(fields[2], pgrp);
+}
+
+// Replaces |args| with the null-separated arguments in |cmd_line|.
+void SplitProcCmdline(StringPiece cmd_line, std::vector<std::string>* args) {
+  args->clear();
+  while (!cmd_line.empty()) {
+    size_t end = cmd_line.find('\0');
+    if (end != 0)
+      args->emplace_back(cmd_line.substr(0, end).as_string());
+    if (end == StringPiece::npos)
+      break;
+    cmd_line.remove_prefix(end + 1);
+  }
 }
 
 }  // namespace
 
 ProcessIterator::ProcessIterator(const ProcessFilter* filter)
-    : filter_(filter) {
-  procfs_dir_ = opendir(internal::kProcDir);
-  if (!procfs_dir_) {
+    : ProcessIterator(filter, FIELD_ALL) {}
+
+ProcessIterator::ProcessIterator(const ProcessFilter* filter, int fields)
+    : procfs_reader_(std::make_unique<DirReaderLinux>(internal::kProcDir)),
+      fields_(fields),
+      filter_(filter) {
+  if (!procfs_reader_->IsValid()) {
     // On Android, SELinux may prevent reading /proc. See
     // https://crbug.com/581517 for details.
-    PLOG(ERROR) << "opendir " << internal::kProcDir;
+    PLOG(ERROR) << "open " << internal::kProcDir;
   }
 }
 
-ProcessIterator::~ProcessIterator() {
-  if (procfs_dir_) {
-    closedir(procfs_dir_);
-    procfs_dir_ = nullptr;
-  }
-}
+ProcessIterator::~ProcessIterator() = default;
 
 bool ProcessIterator::CheckForNextProcess() {
   // TODO(port): skip processes owned by different UID
 
-  if (!procfs_dir_) {
-    DLOG(ERROR) << "Skipping CheckForNextProcess(), no procfs_dir_";
+  if (!procfs_reader_->IsValid()) {
+    DLOG(ERROR) << "Skipping CheckForNextProcess(), no procfs_reader_";
     return false;
   }
 
-  pid_t pid = kNullProcessId;
-  std::vector<std::string> cmd_line_args;
-  std::string stats_data;
-  std::vector<std::string> proc_stats;
-
-  // Arbitrarily guess that there will never be more than 200 non-process
-  // files in /proc.  Hardy has 53 and Lucid has 61.
-  int skipped = 0;
-  const int kSkipLimit = 200;
-  while (skipped < kSkipLimit) {
-    dirent* slot = readdir(procfs_dir_);
-    // all done looking through /proc?
-    if (!slot)
-      return false;
+  // Synchronously reading files in /proc is safe.
+  ThreadRestrictions::ScopedAllowIO allow_io;
 
+  const int proc_fd = procfs_reader_->fd();
+  while (procfs_reader_->Next()) {
     // If not a process, keep looking for one.
-    pid = internal::ProcDirSlotToPid(slot->d_name);
-    if (!pid) {
-      skipped++;
+    const unsigned char type = procfs_reader_->type();
+    if (type != DT_DIR && type != DT_UNKNOWN)
       continue;
-    }
-
-    if (!GetProcCmdline(pid, &cmd_line_args))
+    const char* name = procfs_reader_->name();
+    pid_t pid = internal::ProcDirSlotToPid(name);
+    if (!pid)
       continue;
 
-    if (!internal::ReadProcStats(pid, &stats_data))
-      continue;
-    if (!internal::ParseProcStats(stats_data, &proc_stats))
-      continue;
-
-    std::string runstate =
-        GetProcStatsFieldAsString(proc_stats, internal::VM_STATE);
-    if (runstate.size() != 1) {
-      NOTREACHED();
+    // The process may have exited since it was listed.
+    char state;
+    ProcessId ppid;
+    ProcessId pgrp;
+    if (!ReadProcFileAt(proc_fd, name, internal::kStatFile, &buffer_) ||
+        !ParseProcStatHead(buffer_, &state, &ppid, &pgrp)) {
       continue;
     }
 
     // Is the process in 'Zombie' state, i.e. dead but waiting to be reaped?
     // Allowed values: D R S T Z
-    if (runstate[0] != 'Z')
-      break;
+    // If it is, somebody isn't cleaning up after their children (e.g.
+    // WaitForProcessesToExit doesn't clean up after dead children yet).
+    if (state == 'Z')
+      continue;
 
-    // Nope, it's a zombie; somebody isn't cleaning up after their children.
-    // (e.g. WaitForProcessesToExit doesn't clean up after dead children yet.)
-    // There could be a lot of zombies, can't really decrement i here.
-  }
-  if (skipped >= kSkipLimit) {
-    NOTREACHED();
-    return false;
-  }
+    if (fields_ & FIELD_CMD_LINE_ARGS) {
+      if (!ReadProcFileAt(proc_fd, name, "cmdline", &buffer_))
+        continue;
+      SplitProcCmdline(buffer_, &entry_.cmd_line_args_);
+    } else {
+      entry_.cmd_line_args_.clear();
+    }
+
+    entry_.exe_file_.clear();
+    if (fields_ & FIELD_EXE_FILE) {
+      char path[NAME_MAX + 16];
+      char exe_path[PATH_MAX];
+      ssize_t length = -1;
+      if (MakeProcPath(name, "exe", path, sizeof(path))) {
+        length = HANDLE_EINTR(
+            readlinkat(proc_fd, path, exe_path, sizeof(exe_path)));
+      }
+      // Kernel threads have no executable.
+      if (length > 0 && static_cast<size_t>(length) < sizeof(exe_path)) {
+        StringPiece exe(exe_path, length);
+        exe.substr(exe.rfind('/') + 1).CopyToString(&entry_.exe_file_);
+      }
+    }
 
-  entry_.pid_ = pid;
-  entry_.ppid_ = GetProcStatsFieldAsInt64(proc_stats, internal::VM_PPID);
-  entry_.gid_ = GetProcStatsFieldAsInt64(proc_stats, internal::VM_PGRP);
-  entry_.cmd_line_args_.assign(cmd_line_args.begin(), cmd_line_args.end());
-  entry_.exe_file_ = GetProcessExecutablePath(pid).BaseName().value();
-  return true;
+    entry_.pid_ = pid;
+    entry_.ppid_ = ppid;
+    entry_.gid_ = pgrp;
+    return true;
+  }
+  return false;
 }
 
 bool NamedProcessIterator::IncludeEntry() {
@@ -0,0 +1,97 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/process/process_iterator.h"
+
+#include <dirent.h>
+
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/process/internal_linux.h"
+#include "base/process/process_handle.h"
+#include "base/strings/string_split.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+
+namespace {
+
+constexpr int kIterations = 20;
+
+// Lists processes the way ProcessIterator did before it used getdents() and
+// reusable buffers: readdir(), then ReadFileToString() and a full split of
+// each stat and cmdline file. Used as the baseline.
+int CountProcessesWithReaddir() {
+  DIR* dir = opendir(internal::kProcDir);
+  if (!dir)
+    return -1;
+  int count = 0;
+  while (dirent* slot = readdir(dir)) {
+    pid_t pid = internal::ProcDirSlotToPid(slot->d_name);
+    if (!pid)
+      continue;
+    std::string cmd_line;
+    if (!ReadFileToString(internal::GetProcPidDir(pid).Append("cmdline"),
+                          &cmd_line)) {
+      continue;
+    }
+    std::vector<std::string> args =
+        SplitString(cmd_line, std::string(1, '\0'), KEEP_WHITESPACE,
+                    SPLIT_WANT_NONEMPTY);
+    std::string stats_data;
+    std::vector<std::string> proc_stats;
+    if (!internal::ReadProcStats(pid, &stats_data) ||
+        !internal::ParseProcStats(stats_data, &proc_stats) ||
+        proc_stats[internal::VM_STATE] == "Z") {
+      continue;
+    }
+    std::string exe_file =
+        GetProcessExecutablePath(pid).BaseName().value();
+    ++count;
+  }
+  closedir(dir);
+  return count;
+}
+
+int CountProcessesWithIterator(int fields) {
+  ProcessIterator iterator(nullptr, fields);
+  int count = 0;
+  while (iterator.NextProcessEntry())
+    ++count;
+  return count;
+}
+
+template <typename CountFunction>
+void Measure(const std::string& trace, CountFunction count_function) {
+  int count = 0;
+  TimeTicks start = TimeTicks::Now();
+  for (int i = 0; i < kIterations; ++i)
+    count = count_function();
+  TimeDelta elapsed = TimeTicks::Now() - start;
+  ASSERT_GT(count, 0);
+  perf_test::PrintResult("ProcessIterator", "_time_per_process", trace,
+                         elapsed.InMicrosecondsF() / kIterations / count, "us",
+                         true);
+}
+
+}  // namespace
+
+TEST(ProcessIteratorPerfTest, ListProcesses) {
+  Measure("readdir_baseline", &CountProcessesWithReaddir);
+  Measure("all_fields", []() {
+    return CountProcessesWithIterator(ProcessIterator::FIELD_ALL);
+  });
+  Measure("exe_file", []() {
+    return CountProcessesWithIterator(ProcessIterator::FIELD_EXE_FILE);
+  });
+  Measure("no_optional_fields",
+          []() { return CountProcessesWithIterator(0); });
+}
+
+}  // namespace base
@@ -0,0 +1,87 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/process/process_iterator.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/process/launch.h"
+#include "base/process/process.h"
+#include "base/process/process_handle.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Returns the entry of |pid| found by an iterator over |fields|, or an entry
+// with a null pid if there is none.
+ProcessEntry FindProcess(ProcessId pid, int fields) {
+  ProcessIterator iterator(nullptr, fields);
+  while (const ProcessEntry* entry = iterator.NextProcessEntry()) {
+    if (entry->pid() == pid)
+      return *entry;
+  }
+  return ProcessEntry();
+}
+
+}  // namespace
+
+TEST(ProcessIteratorLinuxTest, AllFields) {
+  ProcessEntry entry =
+      FindProcess(GetCurrentProcId(), ProcessIterator::FIELD_ALL);
+  ASSERT_EQ(GetCurrentProcId(), entry.pid());
+  EXPECT_EQ(getppid(), entry.parent_pid());
+  EXPECT_EQ(getpgrp(), entry.gid());
+  EXPECT_EQ(GetProcessExecutablePath(GetCurrentProcessHandle()).BaseName()
+                .value(),
+            entry.exe_file());
+  EXPECT_FALSE(entry.cmd_line_args().empty());
+
+  // The default iterator fills in every field.
+  ProcessIterator iterator(nullptr);
+  bool found = false;
+  while (const ProcessEntry* default_entry = iterator.NextProcessEntry()) {
+    if (default_entry->pid() != GetCurrentProcId())
+      continue;
+    found = true;
+    EXPECT_STREQ(entry.exe_file(), default_entry->exe_file());
+    EXPECT_EQ(entry.cmd_line_args(), default_entry->cmd_line_args());
+  }
+  EXPECT_TRUE(found);
+}
+
+TEST(ProcessIteratorLinuxTest, NoOptionalFields) {
+  ProcessEntry entry = FindProcess(GetCurrentProcId(), 0);
+  ASSERT_EQ(GetCurrentProcId(), entry.pid());
+  EXPECT_EQ(getppid(), entry.parent_pid());
+  EXPECT_EQ(getpgrp(), entry.gid());
+  EXPECT_STREQ("", entry.exe_file());
+  EXPECT_TRUE(entry.cmd_line_args().empty());
+}
+
+TEST(ProcessIteratorLinuxTest, SkipsZombies) {
+  Process child = LaunchProcess(std::vector<std::string>{"true"},
+                                LaunchOptions());
+  ASSERT_TRUE(child.IsValid());
+
+  // Wait for the child to exit, but leave it unreaped.
+  siginfo_t info;
+  ASSERT_EQ(0, HANDLE_EINTR(waitid(P_PID, child.Pid(), &info,
+                                   WEXITED | WNOWAIT)));
+  EXPECT_EQ(kNullProcessId,
+            FindProcess(child.Pid(), ProcessIterator::FIELD_ALL).pid());
+
+  int exit_code;
+  EXPECT_TRUE(child.WaitForExit(&exit_code));
+  EXPECT_EQ(0, exit_code);
+}
+
+}  // namespace base
@@ -13,11 +13,13 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/base_export.h"
 #include "base/gtest_prod_util.h"
 #include "base/macros.h"
 #include "base/process/process_handle.h"
+#include "base/threading/platform_thread.h"
 #include "base/time/time.h"
 #include "base/values.h"
 #include "build/build_config.h"
@@ -41,6 +43,11 @@ namespace base {
 // Full declaration is in process_metrics_iocounters.h.
 struct IoCounters;
 
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+// Full declaration is in taskstats_linux.h.
+struct TaskStats;
+#endif
+
 #if defined(OS_LINUX) || defined(OS_ANDROID)
 // Minor and major page fault counts since the process creation.
 // Both counts are process-wide, and exclude child processes.
@@ -51,6 +58,46 @@ struct PageFaultCounts {
   int64_t minor;
   int64_t major;
 };
+
+// Counters of a process read from /proc in one pass by
+// ProcessMetrics::GetSnapshot(). Counters that could not be read are zero.
+struct BASE_EXPORT ProcessMetricsSnapshot {
+  // From /proc/<pid>/stat.
+  TimeDelta user_cpu;
+  TimeDelta system_cpu;
+  int64_t minor_faults = 0;
+  int64_t major_faults = 0;
+  int num_threads = 0;
+  uint64_t virtual_bytes = 0;
+
+  // From /proc/<pid>/statm.
+  uint64_t resident_bytes = 0;
+  uint64_t shared_bytes = 0;
+
+  // From /proc/<pid>/status.
+  uint64_t peak_resident_bytes = 0;
+  uint64_t swap_bytes = 0;
+  uint64_t voluntary_context_switches = 0;
+  uint64_t involuntary_context_switches = 0;
+
+  // From /proc/<pid>/io, which needs a kernel with CONFIG_TASK_IO_ACCOUNTING
+  // and is usually only readable for processes of the same user.
+  bool has_io_counters = false;
+  uint64_t read_chars = 0;
+  uint64_t write_chars = 0;
+  uint64_t read_syscalls = 0;
+  uint64_t write_syscalls = 0;
+  uint64_t read_bytes = 0;
+  uint64_t write_bytes = 0;
+};
+
+// CPU time of one thread, as read from /proc/<pid>/task/<tid>/stat by
+// ProcessMetrics::GetThreadCPUSnapshots().
+struct BASE_EXPORT ThreadCPUSnapshot {
+  PlatformThreadId tid = kInvalidThreadId;
+  TimeDelta user_cpu;
+  TimeDelta system_cpu;
+};
 #endif  // defined(OS_LINUX) || defined(OS_ANDROID)
 
 // Convert a POSIX timeval to microseconds.
@@ -194,6 +241,33 @@ class BASE_EXPORT ProcessMetrics {
   // Minor and major page fault count as reported by /proc/[pid]/stat.
   // Returns true for success.
   bool GetPageFaultCounts(PageFaultCounts* counts) const;
+
+  // Reads /proc/[pid]/stat, statm, status and io into |snapshot|. The files
+  // are kept open between calls and read into buffers owned by this object,
+  // so sampling many processes periodically neither reopens files nor
+  // allocates, unlike the individual getters above. Returns false if the
+  // process is gone or its stat file cannot be read; the other files are
+  // optional.
+  bool GetSnapshot(ProcessMetricsSnapshot* snapshot);
+
+  // Fills |threads| with the CPU time of each thread of the process, reusing
+  // open files across calls like GetSnapshot(). Returns false if the threads
+  // of the process cannot be listed.
+  bool GetThreadCPUSnapshots(std::vector<ThreadCPUSnapshot>* threads);
+
+  // Fills |stats| from the kernel's taskstats interface (see TaskStatsClient),
+  // which gives CPU time with nanosecond precision and scheduler and I/O
+  // delays. For a process, taskstats only reports CPU time, delays and
+  // context switches. If taskstats is unavailable, as it is without
+  // CAP_NET_ADMIN, the same counters except delays are read from /proc and
+  // |stats->source| is TaskStats::Source::kProc. Returns false if the process
+  // is gone.
+  bool GetTaskStats(TaskStats* stats);
+
+  // Same as GetTaskStats() for the thread |tid| of the process, for which all
+  // counters of TaskStats are reported. When they come from /proc, the files
+  // of the thread are kept open between calls like those of GetSnapshot().
+  bool GetThreadTaskStats(PlatformThreadId tid, TaskStats* stats);
 #endif  // defined(OS_LINUX) || defined(OS_ANDROID)
 
   // Returns total memory usage of malloc.
@@ -235,6 +309,13 @@ class BASE_EXPORT ProcessMetrics {
   uint64_t last_absolute_idle_wakeups_;
 #endif
 
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  // The /proc files and buffers used by GetSnapshot() and
+  // GetThreadCPUSnapshots(). Created on first use.
+  struct ProcFiles;
+  std::unique_ptr<ProcFiles> proc_files_;
+#endif
+
 #if defined(OS_MACOSX)
   // And same thing for package idle exit wakeups.
   TimeTicks last_package_idle_wakeups_time_;
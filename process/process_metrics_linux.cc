@@ -12,19 +12,25 @@
 #include <sys/time.h>
 #include <sys/types.h>
 #include <unistd.h>
+
+#include <algorithm>
 #include <utility>
 
+#include "base/containers/flat_map.h"
 #include "base/files/dir_reader_posix.h"
 #include "base/files/file_util.h"
 #include "base/logging.h"
 #include "base/memory/ptr_util.h"
+#include "base/no_destructor.h"
 #include "base/optional.h"
 #include "base/process/internal_linux.h"
 #include "base/process/process_metrics_iocounters.h"
+#include "base/process/taskstats_linux.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_split.h"
 #include "base/strings/string_tokenizer.h"
 #include "base/strings/string_util.h"
+#include "base/synchronization/lock.h"
 #include "base/threading/thread_restrictions.h"
 #include "build/build_config.h"
 
@@ -147,6 +153,37 @@ int64_t GetProcessCPU(pid_t pid) {
   return total_cpu;
 }
 
+// Calls |callback| with the key and the whitespace-trimmed value of each
+// "key: value" line of |contents|, as found in /proc/<pid>/status and io.
+template <typename Callback>
+void ForEachProcKeyValue(StringPiece contents, Callback callback) {
+  while (!contents.empty()) {
+    size_t line_end = contents.find('\n');
+    StringPiece line = contents.substr(0, line_end);
+    contents.remove_prefix(line_end == StringPiece::npos ? contents.size()
+                                                         : line_end + 1);
+    size_t colon = line.find(':');
+    if (colon == StringPiece::npos)
+      continue;
+    callback(line.substr(0, colon),
+             TrimWhitespaceASCII(line.substr(colon + 1), TRIM_ALL));
+  }
+}
+
+// Parses a "1234" or "1234 kB" value from /proc/<pid>/status into a number
+// of bytes when |is_kb|, or a plain count otherwise.
+uint64_t ParseProcStatusValue(StringPiece value, bool is_kb) {
+  if (is_kb) {
+    if (!value.ends_with(" kB"))
+      return 0;
+    value.remove_suffix(3);
+  }
+  uint64_t result;
+  if (!StringToUint64(value, &result))
+    return 0;
+  return is_kb ? result * 1024 : result;
+}
+
 #if defined(OS_CHROMEOS)
 // Report on Chrome OS GEM object graphics memory. /run/debugfs_gpu is a
 // bind mount into /sys/kernel/debug and synchronously reading the in-memory
@@ -257,6 +294,291 @@ bool ProcessMetrics::GetPageFaultCounts(PageFaultCounts* counts) const {
 }
 #endif  // defined(OS_LINUX) || defined(OS_ANDROID)
 
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+namespace {
+
+// The open stat, statm, status and io files of a /proc/<pid> or
+// /proc/<pid>/task/<tid> directory.
+class ProcTaskFiles {
+ public:
+  explicit ProcTaskFiles(const FilePath& dir)
+      : stat_(dir.Append(internal::kStatFile)),
+        statm_(dir.Append("statm")),
+        status_(dir.Append("status")),
+        io_(dir.Append("io")) {}
+
+  // Reads the files into |snapshot|, using |buffer| and |fields| as scratch
+  // space. Returns false if the stat file cannot be read.
+  bool Read(std::string* buffer,
+            std::vector<StringPiece>* fields,
+            ProcessMetricsSnapshot* snapshot);
+
+ private:
+  internal::CachedProcFile stat_;
+  internal::CachedProcFile statm_;
+  internal::CachedProcFile status_;
+  internal::CachedProcFile io_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProcTaskFiles);
+};
+
+bool ProcTaskFiles::Read(std::string* buffer,
+                         std::vector<StringPiece>* fields,
+                         ProcessMetricsSnapshot* snapshot) {
+  *snapshot = ProcessMetricsSnapshot();
+
+  if (!stat_.Read(buffer) || !internal::ParseProcStatsPieces(*buffer, fields) ||
+      fields->size() <= internal::VM_VSIZE) {
+    return false;
+  }
+  snapshot->user_cpu = internal::ClockTicksToTimeDelta(
+      internal::GetProcStatsFieldAsInt64(*fields, internal::VM_UTIME));
+  snapshot->system_cpu = internal::ClockTicksToTimeDelta(
+      internal::GetProcStatsFieldAsInt64(*fields, internal::VM_STIME));
+  snapshot->minor_faults =
+      internal::GetProcStatsFieldAsInt64(*fields, internal::VM_MINFLT);
+  snapshot->major_faults =
+      internal::GetProcStatsFieldAsInt64(*fields, internal::VM_MAJFLT);
+  snapshot->num_threads =
+      internal::GetProcStatsFieldAsInt64(*fields, internal::VM_NUMTHREADS);
+  snapshot->virtual_bytes =
+      internal::GetProcStatsFieldAsInt64(*fields, internal::VM_VSIZE);
+
+  // The format of /proc/<pid>/statm is "size resident shared text lib data dt",
+  // in pages.
+  if (statm_.Read(buffer)) {
+    StringPiece statm = TrimWhitespaceASCII(*buffer, TRIM_TRAILING);
+    uint64_t pages[3];
+    size_t i = 0;
+    for (; i < arraysize(pages); ++i) {
+      size_t end = statm.find(' ');
+      if (!StringToUint64(statm.substr(0, end), &pages[i]))
+        break;
+      statm.remove_prefix(end == StringPiece::npos ? statm.size() : end + 1);
+    }
+    if (i == arraysize(pages)) {
+      const uint64_t page_size = getpagesize();
+      snapshot->resident_bytes = pages[1] * page_size;
+      snapshot->shared_bytes = pages[2] * page_size;
+    }
+  }
+
+  if (status_.Read(buffer)) {
+    ForEachProcKeyValue(*buffer, [snapshot](StringPiece key,
+                                            StringPiece value) {
+      if (key == "VmHWM")
+        snapshot->peak_resident_bytes = ParseProcStatusValue(value, true);
+      else if (key == "VmSwap")
+        snapshot->swap_bytes = ParseProcStatusValue(value, true);
+      else if (key == "voluntary_ctxt_switches")
+        snapshot->voluntary_context_switches =
+            ParseProcStatusValue(value, false);
+      else if (key == "nonvoluntary_ctxt_switches")
+        snapshot->involuntary_context_switches =
+            ParseProcStatusValue(value, false);
+    });
+  }
+
+  if (io_.Read(buffer)) {
+    snapshot->has_io_counters = true;
+    ForEachProcKeyValue(*buffer, [snapshot](StringPiece key,
+                                            StringPiece value) {
+      uint64_t* target = nullptr;
+      if (key == "rchar")
+        target = &snapshot->read_chars;
+      else if (key == "wchar")
+        target = &snapshot->write_chars;
+      else if (key == "syscr")
+        target = &snapshot->read_syscalls;
+      else if (key == "syscw")
+        target = &snapshot->write_syscalls;
+      else if (key == "read_bytes")
+        target = &snapshot->read_bytes;
+      else if (key == "write_bytes")
+        target = &snapshot->write_bytes;
+      if (target)
+        *target = ParseProcStatusValue(value, false);
+    });
+  }
+
+  return true;
+}
+
+// The taskstats client shared by all ProcessMetrics, so that monitoring many
+// processes does not open a netlink socket for each.
+struct SharedTaskStatsClient {
+  SharedTaskStatsClient() : client(TaskStatsClient::Create()) {}
+
+  // Null if taskstats is not available to this process.
+  const std::unique_ptr<TaskStatsClient> client;
+  Lock lock;
+};
+
+SharedTaskStatsClient* GetSharedTaskStatsClient() {
+  static NoDestructor<SharedTaskStatsClient> shared_client;
+  return shared_client.get();
+}
+
+}  // namespace
+
+// The open /proc files of a process and the buffers they are read into.
+struct ProcessMetrics::ProcFiles {
+  explicit ProcFiles(ProcessHandle process)
+      : proc_dir(internal::GetProcPidDir(process)), process_files(proc_dir) {}
+
+  const FilePath proc_dir;
+  ProcTaskFiles process_files;
+
+  // /proc/<pid>/task/<tid>/stat of the threads seen by the last
+  // GetThreadCPUSnapshots().
+  flat_map<PlatformThreadId, std::unique_ptr<internal::CachedProcFile>>
+      thread_stats;
+  // The files of the threads passed to GetThreadTaskStats() when taskstats is
+  // unavailable. Those of a thread are closed once it is gone.
+  flat_map<PlatformThreadId, std::unique_ptr<ProcTaskFiles>> thread_task_files;
+
+  // Reused across reads so that sampling does not allocate.
+  std::string buffer;
+  std::vector<StringPiece> fields;
+};
+
+ProcessMetrics::~ProcessMetrics() = default;
+
+bool ProcessMetrics::GetSnapshot(ProcessMetricsSnapshot* snapshot) {
+  if (!proc_files_)
+    proc_files_ = std::make_unique<ProcFiles>(process_);
+  return proc_files_->process_files.Read(&proc_files_->buffer,
+                                         &proc_files_->fields, snapshot);
+}
+
+bool ProcessMetrics::GetTaskStats(TaskStats* stats) {
+  SharedTaskStatsClient* shared_client = GetSharedTaskStatsClient();
+  if (shared_client->client) {
+    AutoLock lock(shared_client->lock);
+    if (shared_client->client->GetProcessStats(process_, stats))
+      return true;
+  }
+
+  ProcessMetricsSnapshot snapshot;
+  if (!GetSnapshot(&snapshot))
+    return false;
+  *stats = TaskStats();
+  stats->source = TaskStats::Source::kProc;
+  stats->cpu_time = snapshot.user_cpu + snapshot.system_cpu;
+  stats->voluntary_context_switches = snapshot.voluntary_context_switches;
+  stats->involuntary_context_switches = snapshot.involuntary_context_switches;
+  return true;
+}
+
+bool ProcessMetrics::GetThreadTaskStats(PlatformThreadId tid,
+                                        TaskStats* stats) {
+  SharedTaskStatsClient* shared_client = GetSharedTaskStatsClient();
+  if (shared_client->client) {
+    AutoLock lock(shared_client->lock);
+    if (shared_client->client->GetThreadStats(tid, stats))
+      return true;
+  }
+
+  if (!proc_files_)
+    proc_files_ = std::make_unique<ProcFiles>(process_);
+  ProcFiles* files = proc_files_.get();
+  std::unique_ptr<ProcTaskFiles>& thread_files = files->thread_task_files[tid];
+  if (!thread_files) {
+    thread_files = std::make_unique<ProcTaskFiles>(
+        files->proc_dir.Append("task").Append(IntToString(tid)));
+  }
+  ProcessMetricsSnapshot snapshot;
+  if (!thread_files->Read(&files->buffer, &files->fields, &snapshot)) {
+    // The thread is gone, and its id may be reused by a new thread.
+    files->thread_task_files.erase(tid);
+    return false;
+  }
+  *stats = TaskStats();
+  stats->source = TaskStats::Source::kProc;
+  stats->cpu_time = snapshot.user_cpu + snapshot.system_cpu;
+  stats->user_cpu = snapshot.user_cpu;
+  stats->system_cpu = snapshot.system_cpu;
+  stats->voluntary_context_switches = snapshot.voluntary_context_switches;
+  stats->involuntary_context_switches = snapshot.involuntary_context_switches;
+  stats->minor_faults = snapshot.minor_faults;
+  stats->major_faults = snapshot.major_faults;
+  stats->peak_resident_bytes = snapshot.peak_resident_bytes;
+  stats->read_chars = snapshot.read_chars;
+  stats->write_chars = snapshot.write_chars;
+  stats->read_syscalls = snapshot.read_syscalls;
+  stats->write_syscalls = snapshot.write_syscalls;
+  stats->read_bytes = snapshot.read_bytes;
+  stats->write_bytes = snapshot.write_bytes;
+  return true;
+}
+
+bool ProcessMetrics::GetThreadCPUSnapshots(
+    std::vector<ThreadCPUSnapshot>* threads) {
+  if (!proc_files_)
+    proc_files_ = std::make_unique<ProcFiles>(process_);
+  ProcFiles* files = proc_files_.get();
+
+  threads->clear();
+  {
+    // Synchronously reading files in /proc is safe.
+    ThreadRestrictions::ScopedAllowIO allow_io;
+    DirReaderPosix dir_reader(
+        files->proc_dir.Append("task").value().c_str());
+    if (!dir_reader.IsValid())
+      return false;
+
+    while (dir_reader.Next()) {
+      pid_t tid = internal::ProcDirSlotToPid(dir_reader.name());
+      if (!tid)
+        continue;
+
+      std::unique_ptr<internal::CachedProcFile>& stat_file =
+          files->thread_stats[tid];
+      if (!stat_file) {
+        stat_file = std::make_unique<internal::CachedProcFile>(
+            files->proc_dir.Append("task")
+                .Append(dir_reader.name())
+                .Append(internal::kStatFile));
+      }
+
+      // The thread may have exited since it was listed.
+      if (!stat_file->Read(&files->buffer) ||
+          !internal::ParseProcStatsPieces(files->buffer, &files->fields) ||
+          files->fields.size() <= internal::VM_STIME) {
+        continue;
+      }
+
+      ThreadCPUSnapshot thread;
+      thread.tid = tid;
+      thread.user_cpu = internal::ClockTicksToTimeDelta(
+          internal::GetProcStatsFieldAsInt64(files->fields,
+                                             internal::VM_UTIME));
+      thread.system_cpu = internal::ClockTicksToTimeDelta(
+          internal::GetProcStatsFieldAsInt64(files->fields,
+                                             internal::VM_STIME));
+      threads->push_back(thread);
+    }
+  }
+
+  // Close the files of the threads that are gone.
+  std::sort(threads->begin(), threads->end(),
+            [](const ThreadCPUSnapshot& a, const ThreadCPUSnapshot& b) {
+              return a.tid < b.tid;
+            });
+  auto is_gone = [threads](const auto& entry) {
+    auto it = std::lower_bound(
+        threads->begin(), threads->end(), entry.first,
+        [](const ThreadCPUSnapshot& thread, PlatformThreadId tid) {
+          return thread.tid < tid;
+        });
+    return it == threads->end() || it->tid != entry.first;
+  };
+  EraseIf(files->thread_stats, is_gone);
+  EraseIf(files->thread_task_files, is_gone);
+  return true;
+}
+#endif  // defined(OS_LINUX) || defined(OS_ANDROID)
+
 int ProcessMetrics::GetOpenFdCount() const {
   // Use /proc/<pid>/fd to count the number of entries there.
   FilePath fd_path = internal::GetProcPidDir(process_).Append("fd");
@@ -0,0 +1,77 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/process/process_metrics.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/process/process_metrics_iocounters.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+
+namespace {
+
+constexpr int kIterations = 2000;
+
+// Runs |sample| kIterations times and reports the average time per sample.
+template <typename Sample>
+void Measure(const std::string& trace, Sample sample) {
+  TimeTicks start = TimeTicks::Now();
+  for (int i = 0; i < kIterations; ++i)
+    ASSERT_TRUE(sample());
+  TimeDelta elapsed = TimeTicks::Now() - start;
+  perf_test::PrintResult("ProcessMetrics", "_sample_time", trace,
+                         elapsed.InMicrosecondsF() / kIterations, "us", true);
+}
+
+}  // namespace
+
+// Compares collecting the counters of a process with the individual getters,
+// each of which opens, reads and parses its /proc file, to GetSnapshot().
+TEST(ProcessMetricsPerfTest, Snapshot) {
+  std::unique_ptr<ProcessMetrics> metrics =
+      ProcessMetrics::CreateCurrentProcessMetrics();
+
+  Measure("individual_getters", [&metrics]() {
+    PageFaultCounts counts;
+    IoCounters io_counters;
+    bool ok = metrics->GetPageFaultCounts(&counts);
+    metrics->GetCumulativeCPUUsage();
+    metrics->GetResidentSetSize();
+    metrics->GetVmSwapBytes();
+    metrics->GetIOCounters(&io_counters);
+    return ok;
+  });
+
+  ProcessMetricsSnapshot snapshot;
+  Measure("snapshot",
+          [&metrics, &snapshot]() { return metrics->GetSnapshot(&snapshot); });
+}
+
+TEST(ProcessMetricsPerfTest, ThreadCPUSnapshots) {
+  constexpr int kThreads = 32;
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.push_back(
+        std::make_unique<Thread>(StringPrintf("PerfTestThread%d", i)));
+    ASSERT_TRUE(threads.back()->Start());
+  }
+
+  std::unique_ptr<ProcessMetrics> metrics =
+      ProcessMetrics::CreateCurrentProcessMetrics();
+  std::vector<ThreadCPUSnapshot> snapshots;
+  Measure("thread_snapshots", [&metrics, &snapshots]() {
+    return metrics->GetThreadCPUSnapshots(&snapshots);
+  });
+  EXPECT_GT(snapshots.size(), static_cast<size_t>(kThreads));
+}
+
+}  // namespace base
@@ -32,7 +32,10 @@ int64_t TimeValToMicroseconds(const struct timeval& tv) {
   return ret;
 }
 
+#if !defined(OS_LINUX) && !defined(OS_ANDROID)
+// On Linux and Android, the destructor is defined with ProcFiles.
 ProcessMetrics::~ProcessMetrics() = default;
+#endif
 
 #if !defined(OS_FUCHSIA)
 
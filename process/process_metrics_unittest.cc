@@ -26,6 +26,10 @@
 #include "testing/gtest/include/gtest/gtest.h"
 #include "testing/multiprocess_func_list.h"
 
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+#include "base/process/taskstats_linux.h"
+#endif
+
 #if defined(OS_MACOSX)
 #include <sys/mman.h>
 #endif
@@ -627,6 +631,99 @@ TEST(ProcessMetricsTestLinux, GetPageFaultCounts) {
   ASSERT_GT(counts_after.minor, counts.minor);
   ASSERT_GE(counts_after.major, counts.major);
 }
+
+TEST(ProcessMetricsTestLinux, GetSnapshot) {
+  std::unique_ptr<ProcessMetrics> process_metrics(
+      ProcessMetrics::CreateCurrentProcessMetrics());
+
+  ProcessMetricsSnapshot snapshot;
+  ASSERT_TRUE(process_metrics->GetSnapshot(&snapshot));
+  EXPECT_GT(snapshot.minor_faults, 0);
+  EXPECT_GE(snapshot.num_threads, 1);
+  EXPECT_GT(snapshot.virtual_bytes, 0u);
+  EXPECT_GT(snapshot.resident_bytes, 0u);
+  EXPECT_GE(snapshot.peak_resident_bytes, snapshot.resident_bytes);
+  EXPECT_GT(snapshot.voluntary_context_switches +
+                snapshot.involuntary_context_switches,
+            0u);
+
+  // The snapshot agrees with the individual getters.
+  PageFaultCounts counts;
+  ASSERT_TRUE(process_metrics->GetPageFaultCounts(&counts));
+  EXPECT_GE(counts.minor, snapshot.minor_faults);
+
+  // Reading again through the open files sees new activity.
+  {
+    const size_t kMappedSize = 4 * (1 << 20);
+    SharedMemory memory;
+    ASSERT_TRUE(memory.CreateAndMapAnonymous(kMappedSize));
+    memset(memory.memory(), 42, kMappedSize);
+    memory.Unmap();
+  }
+  ProcessMetricsSnapshot snapshot_after;
+  ASSERT_TRUE(process_metrics->GetSnapshot(&snapshot_after));
+  EXPECT_GT(snapshot_after.minor_faults, snapshot.minor_faults);
+  EXPECT_GE(snapshot_after.user_cpu + snapshot_after.system_cpu,
+            snapshot.user_cpu + snapshot.system_cpu);
+  EXPECT_EQ(snapshot.has_io_counters, snapshot_after.has_io_counters);
+  if (snapshot_after.has_io_counters) {
+    EXPECT_GE(snapshot_after.read_chars, snapshot.read_chars);
+  }
+}
+
+TEST(ProcessMetricsTestLinux, GetThreadCPUSnapshots) {
+  std::unique_ptr<ProcessMetrics> process_metrics(
+      ProcessMetrics::CreateCurrentProcessMetrics());
+
+  auto contains_thread = [](const std::vector<ThreadCPUSnapshot>& threads,
+                            PlatformThreadId tid) {
+    for (const ThreadCPUSnapshot& thread : threads) {
+      if (thread.tid == tid)
+        return true;
+    }
+    return false;
+  };
+
+  std::vector<ThreadCPUSnapshot> threads;
+  ASSERT_TRUE(process_metrics->GetThreadCPUSnapshots(&threads));
+  EXPECT_TRUE(contains_thread(threads, PlatformThread::CurrentId()));
+
+  Thread thread("ThreadCPUSnapshotTest");
+  ASSERT_TRUE(thread.Start());
+  ASSERT_TRUE(process_metrics->GetThreadCPUSnapshots(&threads));
+  EXPECT_TRUE(contains_thread(threads, PlatformThread::CurrentId()));
+  EXPECT_TRUE(contains_thread(threads, thread.GetThreadId()));
+
+  const PlatformThreadId stopped_tid = thread.GetThreadId();
+  thread.Stop();
+  ASSERT_TRUE(process_metrics->GetThreadCPUSnapshots(&threads));
+  EXPECT_FALSE(contains_thread(threads, stopped_tid));
+}
+
+// Passes with and without taskstats, which needs CAP_NET_ADMIN.
+TEST(ProcessMetricsTestLinux, GetTaskStats) {
+  std::unique_ptr<ProcessMetrics> process_metrics(
+      ProcessMetrics::CreateCurrentProcessMetrics());
+
+  TaskStats process_stats;
+  ASSERT_TRUE(process_metrics->GetTaskStats(&process_stats));
+  EXPECT_GT(process_stats.voluntary_context_switches +
+                process_stats.involuntary_context_switches,
+            0u);
+
+  TaskStats thread_stats;
+  ASSERT_TRUE(process_metrics->GetThreadTaskStats(PlatformThread::CurrentId(),
+                                                  &thread_stats));
+  EXPECT_EQ(process_stats.source, thread_stats.source);
+  EXPECT_GT(thread_stats.minor_faults, 0u);
+
+  Thread thread("TaskStatsTest");
+  ASSERT_TRUE(thread.Start());
+  const PlatformThreadId tid = thread.GetThreadId();
+  EXPECT_TRUE(process_metrics->GetThreadTaskStats(tid, &thread_stats));
+  thread.Stop();
+  EXPECT_FALSE(process_metrics->GetThreadTaskStats(tid, &thread_stats));
+}
 #endif  // defined(OS_ANDROID) || defined(OS_LINUX)
 
 }  // namespace debug
@@ -16,6 +16,7 @@
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
 #include "base/files/scoped_file.h"
+#include "base/files/scoped_temp_dir.h"
 #include "base/logging.h"
 #include "base/macros.h"
 #include "base/path_service.h"
@@ -74,7 +75,6 @@
 #include <zircon/processargs.h>
 #include <zircon/syscalls.h>
 #include "base/base_paths_fuchsia.h"
-#include "base/files/scoped_temp_dir.h"
 #include "base/fuchsia/file_utils.h"
 #include "base/fuchsia/fuchsia_logging.h"
 #endif
@@ -1352,6 +1352,55 @@ TEST_F(ProcessUtilTest, InvalidCurrentDirectory) {
   EXPECT_TRUE(process.WaitForExit(&exit_code));
   EXPECT_NE(kSuccess, exit_code);
 }
+
+// The program is looked up in the PATH of the child's environment, which may
+// differ from the parent's.
+TEST_F(ProcessUtilTest, LaunchProcessSearchesChildPath) {
+  const char kBaseTest[] = "BASE_TEST";
+  EnvironmentMap env_changes;
+  env_changes["PATH"] = "/nonexistent:" + test_helper_path_.DirName().value();
+  env_changes[kBaseTest] = "found";
+  EXPECT_EQ("found",
+            TestLaunchProcess(
+                {test_helper_path_.BaseName().value(), "-e", kBaseTest},
+                env_changes, false /* clear_environ */, 0 /* clone_flags */));
+}
+
+// Like execvp(), files without a known executable format are run by the
+// shell, whether or not they are searched in the PATH.
+TEST_F(ProcessUtilTest, LaunchProcessRunsScripts) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const FilePath script = temp_dir.GetPath().AppendASCII("script");
+  const char kScript[] = "exit $1\n";
+  ASSERT_EQ(static_cast<int>(strlen(kScript)),
+            WriteFile(script, kScript, strlen(kScript)));
+  ASSERT_TRUE(SetPosixFilePermissions(script, FILE_PERMISSION_USER_MASK));
+
+  LaunchOptions options;
+  Process process = LaunchProcess({script.value(), "3"}, options);
+  ASSERT_TRUE(process.IsValid());
+  int exit_code = kSuccess;
+  EXPECT_TRUE(process.WaitForExit(&exit_code));
+  EXPECT_EQ(3, exit_code);
+
+  options.environ["PATH"] = temp_dir.GetPath().value();
+  process = LaunchProcess({"script", "4"}, options);
+  ASSERT_TRUE(process.IsValid());
+  EXPECT_TRUE(process.WaitForExit(&exit_code));
+  EXPECT_EQ(4, exit_code);
+}
+
+TEST_F(ProcessUtilTest, LaunchProcessExecFailure) {
+  LaunchOptions options;
+  Process process =
+      LaunchProcess({"/nonexistent/program", "--flag"}, options);
+  ASSERT_TRUE(process.IsValid());
+
+  int exit_code = kSuccess;
+  EXPECT_TRUE(process.WaitForExit(&exit_code));
+  EXPECT_EQ(127, exit_code);
+}
 #endif  // defined(OS_LINUX)
 
 }  // namespace base
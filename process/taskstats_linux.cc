@@ -0,0 +1,249 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/process/taskstats_linux.h"
+
+#include <errno.h>
+#include <linux/genetlink.h>
+#include <linux/netlink.h>
+#include <linux/taskstats.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+
+namespace base {
+
+namespace {
+
+// Large enough for any reply: a taskstats reply is about 400 bytes.
+constexpr size_t kBufferSize = 4096;
+
+constexpr char kTaskStatsFamilyName[] = TASKSTATS_GENL_NAME;
+
+// Returns the attribute of |type| among the |size| bytes of attributes at
+// |attributes|, or null if there is none.
+const nlattr* FindAttribute(const char* attributes, size_t size, int type) {
+  while (size >= NLA_HDRLEN) {
+    const nlattr* attribute = reinterpret_cast<const nlattr*>(attributes);
+    if (attribute->nla_len < NLA_HDRLEN || attribute->nla_len > size)
+      return nullptr;
+    if ((attribute->nla_type & NLA_TYPE_MASK) == type)
+      return attribute;
+    const size_t aligned_length = NLA_ALIGN(attribute->nla_len);
+    if (aligned_length >= size)
+      return nullptr;
+    attributes += aligned_length;
+    size -= aligned_length;
+  }
+  return nullptr;
+}
+
+const char* AttributePayload(const nlattr* attribute) {
+  return reinterpret_cast<const char*>(attribute) + NLA_HDRLEN;
+}
+
+size_t AttributePayloadSize(const nlattr* attribute) {
+  return attribute->nla_len - NLA_HDRLEN;
+}
+
+void ConvertTaskStats(const taskstats& raw, TaskStats* stats) {
+  *stats = TaskStats();
+  stats->source = TaskStats::Source::kTaskStats;
+  stats->cpu_time = TimeDelta::FromNanoseconds(raw.cpu_run_real_total);
+  stats->user_cpu = TimeDelta::FromMicroseconds(raw.ac_utime);
+  stats->system_cpu = TimeDelta::FromMicroseconds(raw.ac_stime);
+  stats->cpu_delay = TimeDelta::FromNanoseconds(raw.cpu_delay_total);
+  stats->cpu_delay_count = raw.cpu_count;
+  stats->block_io_delay = TimeDelta::FromNanoseconds(raw.blkio_delay_total);
+  stats->block_io_delay_count = raw.blkio_count;
+  stats->swap_in_delay = TimeDelta::FromNanoseconds(raw.swapin_delay_total);
+  stats->swap_in_delay_count = raw.swapin_count;
+  stats->voluntary_context_switches = raw.nvcsw;
+  stats->involuntary_context_switches = raw.nivcsw;
+  stats->minor_faults = raw.ac_minflt;
+  stats->major_faults = raw.ac_majflt;
+  // In KB.
+  stats->peak_resident_bytes = raw.hiwater_rss * 1024;
+  stats->read_chars = raw.read_char;
+  stats->write_chars = raw.write_char;
+  stats->read_syscalls = raw.read_syscalls;
+  stats->write_syscalls = raw.write_syscalls;
+  stats->read_bytes = raw.read_bytes;
+  stats->write_bytes = raw.write_bytes;
+}
+
+}  // namespace
+
+// static
+std::unique_ptr<TaskStatsClient> TaskStatsClient::Create() {
+  ScopedFD socket(
+      ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_GENERIC));
+  if (!socket.is_valid()) {
+    DVPLOG(1) << "socket";
+    return nullptr;
+  }
+
+  sockaddr_nl address = {};
+  address.nl_family = AF_NETLINK;
+  if (bind(socket.get(), reinterpret_cast<sockaddr*>(&address),
+           sizeof(address)) != 0) {
+    DVPLOG(1) << "bind";
+    return nullptr;
+  }
+
+  std::unique_ptr<TaskStatsClient> client(
+      new TaskStatsClient(std::move(socket)));
+  if (!client->ResolveFamily())
+    return nullptr;
+
+  // The family is visible to everyone, but requests need CAP_NET_ADMIN.
+  // Query the calling thread to find out.
+  TaskStats stats;
+  if (!client->GetThreadStats(PlatformThread::CurrentId(), &stats))
+    return nullptr;
+  return client;
+}
+
+TaskStatsClient::TaskStatsClient(ScopedFD socket)
+    : socket_(std::move(socket)), buffer_(kBufferSize) {}
+
+TaskStatsClient::~TaskStatsClient() = default;
+
+bool TaskStatsClient::GetThreadStats(PlatformThreadId tid, TaskStats* stats) {
+  return GetStats(TASKSTATS_CMD_ATTR_PID, tid, stats);
+}
+
+bool TaskStatsClient::GetProcessStats(ProcessId pid, TaskStats* stats) {
+  return GetStats(TASKSTATS_CMD_ATTR_TGID, pid, stats);
+}
+
+bool TaskStatsClient::ResolveFamily() {
+  const char* attributes;
+  size_t attributes_size;
+  if (!Transact(GENL_ID_CTRL, CTRL_CMD_GETFAMILY, CTRL_ATTR_FAMILY_NAME,
+                kTaskStatsFamilyName, sizeof(kTaskStatsFamilyName),
+                &attributes, &attributes_size)) {
+    return false;
+  }
+  const nlattr* id =
+      FindAttribute(attributes, attributes_size, CTRL_ATTR_FAMILY_ID);
+  if (!id || AttributePayloadSize(id) < sizeof(family_id_))
+    return false;
+  memcpy(&family_id_, AttributePayload(id), sizeof(family_id_));
+  return true;
+}
+
+bool TaskStatsClient::GetStats(uint16_t command_attribute,
+                               uint32_t id,
+                               TaskStats* stats) {
+  DCHECK(family_id_);
+  const char* attributes;
+  size_t attributes_size;
+  if (!Transact(family_id_, TASKSTATS_CMD_GET, command_attribute, &id,
+                sizeof(id), &attributes, &attributes_size)) {
+    return false;
+  }
+
+  // The reply nests the id of the task and its statistics in an aggregate.
+  const nlattr* aggregate = FindAttribute(
+      attributes, attributes_size,
+      command_attribute == TASKSTATS_CMD_ATTR_PID ? TASKSTATS_TYPE_AGGR_PID
+                                                  : TASKSTATS_TYPE_AGGR_TGID);
+  if (!aggregate)
+    return false;
+  const nlattr* raw_stats =
+      FindAttribute(AttributePayload(aggregate),
+                    AttributePayloadSize(aggregate), TASKSTATS_TYPE_STATS);
+  if (!raw_stats)
+    return false;
+
+  // Older kernels return a shorter struct, newer ones a longer one; the
+  // fields used here are in every version.
+  taskstats raw = {};
+  memcpy(&raw, AttributePayload(raw_stats),
+         std::min(sizeof(raw), AttributePayloadSize(raw_stats)));
+  ConvertTaskStats(raw, stats);
+  return true;
+}
+
+bool TaskStatsClient::Transact(uint16_t family,
+                               uint8_t command,
+                               uint16_t attribute_type,
+                               const void* attribute,
+                               size_t attribute_size,
+                               const char** attributes,
+                               size_t* attributes_size) {
+  const size_t request_size = NLMSG_LENGTH(GENL_HDRLEN) +
+                              NLA_ALIGN(NLA_HDRLEN + attribute_size);
+  DCHECK_LE(request_size, buffer_.size());
+  memset(buffer_.data(), 0, request_size);
+
+  const uint32_t sequence = ++sequence_;
+  nlmsghdr* request = reinterpret_cast<nlmsghdr*>(buffer_.data());
+  request->nlmsg_len = request_size;
+  request->nlmsg_type = family;
+  request->nlmsg_flags = NLM_F_REQUEST;
+  request->nlmsg_seq = sequence;
+  genlmsghdr* request_header =
+      reinterpret_cast<genlmsghdr*>(NLMSG_DATA(request));
+  request_header->cmd = command;
+  request_header->version = TASKSTATS_GENL_VERSION;
+  nlattr* request_attribute = reinterpret_cast<nlattr*>(
+      reinterpret_cast<char*>(request_header) + GENL_HDRLEN);
+  request_attribute->nla_type = attribute_type;
+  request_attribute->nla_len = NLA_HDRLEN + attribute_size;
+  memcpy(reinterpret_cast<char*>(request_attribute) + NLA_HDRLEN, attribute,
+         attribute_size);
+
+  sockaddr_nl kernel = {};
+  kernel.nl_family = AF_NETLINK;
+  if (HANDLE_EINTR(sendto(socket_.get(), buffer_.data(), request_size, 0,
+                          reinterpret_cast<sockaddr*>(&kernel),
+                          sizeof(kernel))) !=
+      static_cast<ssize_t>(request_size)) {
+    DPLOG(ERROR) << "sendto";
+    return false;
+  }
+
+  for (;;) {
+    ssize_t bytes_received =
+        HANDLE_EINTR(recv(socket_.get(), buffer_.data(), buffer_.size(), 0));
+    if (bytes_received < 0) {
+      DPLOG(ERROR) << "recv";
+      return false;
+    }
+
+    int remaining = static_cast<int>(bytes_received);
+    for (nlmsghdr* reply = reinterpret_cast<nlmsghdr*>(buffer_.data());
+         NLMSG_OK(reply, remaining); reply = NLMSG_NEXT(reply, remaining)) {
+      // Skip the replies to earlier requests that failed halfway.
+      if (reply->nlmsg_seq != sequence)
+        continue;
+
+      if (reply->nlmsg_type == NLMSG_ERROR) {
+        const nlmsgerr* error =
+            reinterpret_cast<const nlmsgerr*>(NLMSG_DATA(reply));
+        // ESRCH is expected for tasks that exited; EPERM without
+        // CAP_NET_ADMIN.
+        errno = -error->error;
+        return false;
+      }
+      if (reply->nlmsg_type != family ||
+          reply->nlmsg_len < NLMSG_LENGTH(GENL_HDRLEN)) {
+        return false;
+      }
+      *attributes = reinterpret_cast<const char*>(NLMSG_DATA(reply)) +
+                    GENL_HDRLEN;
+      *attributes_size = reply->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+      return true;
+    }
+  }
+}
+
+}  // namespace base
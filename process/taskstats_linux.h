@@ -0,0 +1,124 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_PROCESS_TASKSTATS_LINUX_H_
+#define BASE_PROCESS_TASKSTATS_LINUX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/files/scoped_file.h"
+#include "base/macros.h"
+#include "base/process/process_handle.h"
+#include "base/threading/platform_thread.h"
+#include "base/time/time.h"
+
+namespace base {
+
+// Accounting of a process or thread, as reported by the kernel's taskstats
+// interface, or read from /proc by ProcessMetrics::GetTaskStats() when
+// taskstats is unavailable. Counters that are not available are zero.
+struct BASE_EXPORT TaskStats {
+  enum class Source {
+    // The counters come from the taskstats netlink interface.
+    kTaskStats,
+    // The counters were read from /proc; there are no delay statistics.
+    kProc,
+  };
+  Source source = Source::kTaskStats;
+
+  // Time spent on a CPU, with nanosecond precision.
+  TimeDelta cpu_time;
+  TimeDelta user_cpu;
+  TimeDelta system_cpu;
+
+  // Time spent waiting for a CPU while runnable, for synchronous block I/O
+  // and for swapping pages in, and the number of such waits. These need
+  // delay accounting, which recent kernels only enable with the
+  // kernel.task_delayacct sysctl or the delayacct boot option.
+  TimeDelta cpu_delay;
+  uint64_t cpu_delay_count = 0;
+  TimeDelta block_io_delay;
+  uint64_t block_io_delay_count = 0;
+  TimeDelta swap_in_delay;
+  uint64_t swap_in_delay_count = 0;
+
+  uint64_t voluntary_context_switches = 0;
+  uint64_t involuntary_context_switches = 0;
+  uint64_t minor_faults = 0;
+  uint64_t major_faults = 0;
+  uint64_t peak_resident_bytes = 0;
+
+  // Same as the counters of /proc/<pid>/io.
+  uint64_t read_chars = 0;
+  uint64_t write_chars = 0;
+  uint64_t read_syscalls = 0;
+  uint64_t write_syscalls = 0;
+  uint64_t read_bytes = 0;
+  uint64_t write_bytes = 0;
+};
+
+// Queries the taskstats generic netlink family of the kernel. Compared to
+// parsing /proc, one request returns all counters of a task in binary form,
+// CPU time has nanosecond rather than clock tick precision, and scheduler
+// and I/O delays are available.
+//
+// The kernel only answers processes with CAP_NET_ADMIN, so Create() fails
+// for most processes; callers should fall back to /proc. A client is not
+// thread-safe.
+//
+// For a whole process, the kernel only reports CPU time, delays and context
+// switches, summed over its live threads and over the threads that exited
+// since taskstats was first used for it; the other counters are zero.
+class BASE_EXPORT TaskStatsClient {
+ public:
+  // Returns null if taskstats is not available to this process.
+  static std::unique_ptr<TaskStatsClient> Create();
+
+  ~TaskStatsClient();
+
+  // Fills |stats| for the thread |tid| or the process |pid|. Returns false if
+  // the task does not exist or the request fails.
+  bool GetThreadStats(PlatformThreadId tid, TaskStats* stats);
+  bool GetProcessStats(ProcessId pid, TaskStats* stats);
+
+ private:
+  explicit TaskStatsClient(ScopedFD socket);
+
+  // Resolves the id of the taskstats family. Returns false if the kernel
+  // does not support taskstats.
+  bool ResolveFamily();
+
+  // Sends a request of |family| with |command| and a single attribute, and
+  // waits for the reply. On success, |attributes| and |attributes_size|
+  // describe the attributes of the reply, which are valid until the next
+  // request.
+  bool Transact(uint16_t family,
+                uint8_t command,
+                uint16_t attribute_type,
+                const void* attribute,
+                size_t attribute_size,
+                const char** attributes,
+                size_t* attributes_size);
+
+  // Shared by GetThreadStats() and GetProcessStats().
+  bool GetStats(uint16_t command_attribute, uint32_t id, TaskStats* stats);
+
+  const ScopedFD socket_;
+  uint16_t family_id_ = 0;
+  uint32_t sequence_ = 0;
+
+  // Holds requests and replies.
+  std::vector<char> buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(TaskStatsClient);
+};
+
+}  // namespace base
+
+#endif  // BASE_PROCESS_TASKSTATS_LINUX_H_
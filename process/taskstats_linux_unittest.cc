@@ -0,0 +1,80 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/process/taskstats_linux.h"
+
+#include <memory>
+
+#include "base/process/process_handle.h"
+#include "base/threading/platform_thread.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Spins for |duration| of wall time, so that the caller accumulates CPU time.
+void BusyLoop(TimeDelta duration) {
+  TimeTicks end = TimeTicks::Now() + duration;
+  while (TimeTicks::Now() < end) {
+  }
+}
+
+}  // namespace
+
+// taskstats needs CAP_NET_ADMIN, so these tests only check the client when
+// the test runs with it.
+TEST(TaskStatsClientTest, ThreadStats) {
+  std::unique_ptr<TaskStatsClient> client = TaskStatsClient::Create();
+  if (!client)
+    return;
+
+  TaskStats before;
+  ASSERT_TRUE(client->GetThreadStats(PlatformThread::CurrentId(), &before));
+  EXPECT_EQ(TaskStats::Source::kTaskStats, before.source);
+
+  BusyLoop(TimeDelta::FromMilliseconds(50));
+
+  TaskStats after;
+  ASSERT_TRUE(client->GetThreadStats(PlatformThread::CurrentId(), &after));
+  EXPECT_GT(after.cpu_time, before.cpu_time);
+  EXPECT_GE(after.user_cpu + after.system_cpu,
+            before.user_cpu + before.system_cpu);
+  EXPECT_GT(after.minor_faults, 0u);
+  EXPECT_GT(after.peak_resident_bytes, 0u);
+}
+
+TEST(TaskStatsClientTest, ProcessStats) {
+  std::unique_ptr<TaskStatsClient> client = TaskStatsClient::Create();
+  if (!client)
+    return;
+
+  BusyLoop(TimeDelta::FromMilliseconds(10));
+
+  // The process total includes the CPU time of this thread.
+  TaskStats thread;
+  ASSERT_TRUE(client->GetThreadStats(PlatformThread::CurrentId(), &thread));
+  TaskStats process;
+  ASSERT_TRUE(client->GetProcessStats(GetCurrentProcId(), &process));
+  EXPECT_GT(thread.cpu_time, TimeDelta());
+  EXPECT_GE(process.cpu_time, thread.cpu_time);
+}
+
+TEST(TaskStatsClientTest, MissingTask) {
+  std::unique_ptr<TaskStatsClient> client = TaskStatsClient::Create();
+  if (!client)
+    return;
+
+  // Larger than the maximum pid of Linux.
+  constexpr PlatformThreadId kMissingTid = 1 << 23;
+  TaskStats stats;
+  EXPECT_FALSE(client->GetThreadStats(kMissingTid, &stats));
+  EXPECT_FALSE(client->GetProcessStats(kMissingTid, &stats));
+
+  // The client still works after a failed request.
+  EXPECT_TRUE(client->GetThreadStats(PlatformThread::CurrentId(), &stats));
+}
+
+}  // namespace base
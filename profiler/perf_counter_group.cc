@@ -0,0 +1,169 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/profiler/perf_counter_group.h"
+
+#include "base/logging.h"
+#include "build/build_config.h"
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "base/posix/eintr_wrapper.h"
+#endif
+
+namespace base {
+
+namespace {
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+
+constexpr uint64_t kHardwareEvents[PerfCounterGroup::kNumCounters] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+// Opens a counter of |event| for the calling thread on any CPU, in the group
+// led by |group_fd|, or leading a new group if it is -1.
+int OpenCounter(uint64_t event, int group_fd) {
+  perf_event_attr attr = {};
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = event;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                     PERF_FORMAT_TOTAL_TIME_RUNNING;
+  // Members count whenever the leader does.
+  attr.disabled = group_fd == -1;
+  // Counting kernel events usually requires privileges.
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return syscall(__NR_perf_event_open, &attr, 0, -1, group_fd,
+                 PERF_FLAG_FD_CLOEXEC);
+}
+
+#endif  // defined(OS_LINUX) || defined(OS_ANDROID)
+
+}  // namespace
+
+PerfCounterGroup::Values::Values() = default;
+
+double PerfCounterGroup::Values::GetInstructionsPerCycle() const {
+  if (!IsAvailable(kCycles) || !IsAvailable(kInstructions) ||
+      !counts[kCycles]) {
+    return 0;
+  }
+  return static_cast<double>(counts[kInstructions]) / counts[kCycles];
+}
+
+PerfCounterGroup::PerfCounterGroup() {
+  for (int& fd : fds_)
+    fd = -1;
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  for (int counter = 0; counter < kNumCounters; ++counter) {
+    // Counters the CPU does not have, or that do not fit on the PMU with the
+    // others, fail to open.
+    fds_[counter] = OpenCounter(kHardwareEvents[counter], leader_fd_);
+    if (fds_[counter] < 0) {
+      DPLOG_IF(WARNING, counter == kCycles) << "perf_event_open";
+      continue;
+    }
+    if (leader_fd_ == -1)
+      leader_fd_ = fds_[counter];
+    opened_mask_ |= 1u << counter;
+  }
+#endif
+}
+
+PerfCounterGroup::~PerfCounterGroup() {
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  for (int fd : fds_) {
+    if (fd >= 0)
+      IGNORE_EINTR(close(fd));
+  }
+#endif
+}
+
+// static
+const char* PerfCounterGroup::GetCounterName(Counter counter) {
+  switch (counter) {
+    case kCycles:
+      return "cycles";
+    case kInstructions:
+      return "instructions";
+    case kCacheMisses:
+      return "cache_misses";
+    case kBranchMisses:
+      return "branch_misses";
+    case kNumCounters:
+      break;
+  }
+  NOTREACHED();
+  return "";
+}
+
+void PerfCounterGroup::Start() {
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  if (leader_fd_ == -1)
+    return;
+  ioctl(leader_fd_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(leader_fd_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+void PerfCounterGroup::Stop() {
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  if (leader_fd_ == -1)
+    return;
+  ioctl(leader_fd_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+PerfCounterGroup::Values PerfCounterGroup::Read() const {
+  Values values;
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  if (leader_fd_ == -1)
+    return values;
+
+  // The layout of a PERF_FORMAT_GROUP read: the number of counters, the times
+  // the group was enabled and running, then the counts in the order the
+  // counters joined the group.
+  struct {
+    uint64_t nr;
+    uint64_t time_enabled;
+    uint64_t time_running;
+    uint64_t counts[kNumCounters];
+  } data;
+  const ssize_t size = HANDLE_EINTR(read(leader_fd_, &data, sizeof(data)));
+  if (size < static_cast<ssize_t>(3 * sizeof(uint64_t)) ||
+      static_cast<size_t>(size) < (3 + data.nr) * sizeof(uint64_t) ||
+      data.nr > kNumCounters) {
+    DLOG(WARNING) << "Failed to read perf counters";
+    return values;
+  }
+
+  // A group that never ran has no counts, rather than zero counts.
+  if (data.time_enabled && !data.time_running)
+    return values;
+  const bool multiplexed = data.time_running != data.time_enabled;
+  size_t index = 0;
+  for (int counter = 0; counter < kNumCounters && index < data.nr;
+       ++counter) {
+    if (!(opened_mask_ & (1u << counter)))
+      continue;
+    uint64_t count = data.counts[index++];
+    if (multiplexed) {
+      count = static_cast<uint64_t>(static_cast<double>(count) *
+                                    data.time_enabled / data.time_running);
+    }
+    values.counts[counter] = count;
+    values.available_mask |= 1u << counter;
+  }
+#endif
+  return values;
+}
+
+}  // namespace base
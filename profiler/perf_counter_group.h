@@ -0,0 +1,96 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_PROFILER_PERF_COUNTER_GROUP_H_
+#define BASE_PROFILER_PERF_COUNTER_GROUP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "base/base_export.h"
+#include "base/macros.h"
+
+namespace base {
+
+// Hardware performance counters of the thread that creates the group, read
+// with perf_event_open() on Linux and Android. The counters of a group are
+// scheduled on the PMU together, so that ratios between them, like the
+// instructions per cycle, are meaningful.
+//
+// Counters that cannot be opened, because the platform has no perf events,
+// the kernel does not allow them (see /proc/sys/kernel/perf_event_paranoid),
+// or the CPU does not have them, are reported as unavailable. Only user-space
+// events are counted.
+//
+// Example:
+//   PerfCounterGroup counters;
+//   counters.Start();
+//   DoWork();
+//   counters.Stop();
+//   PerfCounterGroup::Values values = counters.Read();
+//   if (values.IsAvailable(PerfCounterGroup::kInstructions))
+//     ...
+class BASE_EXPORT PerfCounterGroup {
+ public:
+  enum Counter {
+    kCycles,
+    kInstructions,
+    kCacheMisses,
+    kBranchMisses,
+    kNumCounters,
+  };
+
+  struct BASE_EXPORT Values {
+    Values();
+
+    bool IsAvailable(Counter counter) const {
+      return (available_mask >> counter) & 1;
+    }
+
+    // Returns the instructions per cycle, or 0 if either count is unavailable
+    // or no cycles were counted.
+    double GetInstructionsPerCycle() const;
+
+    // Bit |counter| is set if |counts[counter]| holds a count.
+    uint32_t available_mask = 0;
+    uint64_t counts[kNumCounters] = {};
+  };
+
+  // Opens the counters of the calling thread. They are stopped.
+  PerfCounterGroup();
+  ~PerfCounterGroup();
+
+  // Returns "cycles", "instructions", "cache_misses" or "branch_misses".
+  static const char* GetCounterName(Counter counter);
+
+  // Whether any counter could be opened.
+  bool IsAvailable() const { return opened_mask_ != 0; }
+
+  // Resets the counts and starts counting. Must be called on the thread that
+  // created the group.
+  void Start();
+
+  // Stops counting, keeping the counts.
+  void Stop();
+
+  // Returns the counts since Start(), which can be read while counting. If the
+  // kernel multiplexed the group with others, the counts are scaled to the
+  // time it was enabled.
+  Values Read() const;
+
+ private:
+  // File descriptors of the counters, or -1 for those that could not be
+  // opened. The first opened counter leads the group.
+  int fds_[kNumCounters];
+  int leader_fd_ = -1;
+
+  // Bit |counter| is set if the counter is in the group.
+  uint32_t opened_mask_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(PerfCounterGroup);
+};
+
+}  // namespace base
+
+#endif  // BASE_PROFILER_PERF_COUNTER_GROUP_H_
@@ -0,0 +1,84 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/profiler/perf_counter_group.h"
+
+#include "base/compiler_specific.h"
+#include "base/debug/alias.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+NOINLINE int Spin(int iterations) {
+  int sum = 0;
+  for (int i = 0; i < iterations; ++i) {
+    sum += i;
+    debug::Alias(&sum);
+  }
+  return sum;
+}
+
+}  // namespace
+
+TEST(PerfCounterGroupTest, Names) {
+  EXPECT_STREQ("cycles", PerfCounterGroup::GetCounterName(
+                             PerfCounterGroup::kCycles));
+  EXPECT_STREQ("instructions", PerfCounterGroup::GetCounterName(
+                                   PerfCounterGroup::kInstructions));
+  EXPECT_STREQ("cache_misses", PerfCounterGroup::GetCounterName(
+                                   PerfCounterGroup::kCacheMisses));
+  EXPECT_STREQ("branch_misses", PerfCounterGroup::GetCounterName(
+                                    PerfCounterGroup::kBranchMisses));
+}
+
+TEST(PerfCounterGroupTest, NotStarted) {
+  PerfCounterGroup counters;
+  PerfCounterGroup::Values values = counters.Read();
+  for (int i = 0; i < PerfCounterGroup::kNumCounters; ++i) {
+    const auto counter = static_cast<PerfCounterGroup::Counter>(i);
+    if (values.IsAvailable(counter)) {
+      EXPECT_EQ(0u, values.counts[counter]);
+    }
+  }
+}
+
+// Perf events may not be available on the bots, in which case nothing is
+// counted but nothing fails either.
+TEST(PerfCounterGroupTest, CountInstructions) {
+  PerfCounterGroup counters;
+  if (!counters.IsAvailable()) {
+    EXPECT_EQ(0u, counters.Read().available_mask);
+    EXPECT_EQ(0, counters.Read().GetInstructionsPerCycle());
+    return;
+  }
+
+  counters.Start();
+  EXPECT_NE(0, Spin(100000));
+  counters.Stop();
+  PerfCounterGroup::Values values = counters.Read();
+  if (values.IsAvailable(PerfCounterGroup::kInstructions)) {
+    EXPECT_GE(values.counts[PerfCounterGroup::kInstructions], 100000u);
+  }
+  if (values.IsAvailable(PerfCounterGroup::kCycles)) {
+    EXPECT_GT(values.counts[PerfCounterGroup::kCycles], 0u);
+  }
+  if (values.IsAvailable(PerfCounterGroup::kCycles) &&
+      values.IsAvailable(PerfCounterGroup::kInstructions)) {
+    EXPECT_GT(values.GetInstructionsPerCycle(), 0);
+  }
+
+  // Counters are stopped, and restart from zero.
+  EXPECT_EQ(values.counts[PerfCounterGroup::kInstructions],
+            counters.Read().counts[PerfCounterGroup::kInstructions]);
+  counters.Start();
+  counters.Stop();
+  if (values.IsAvailable(PerfCounterGroup::kInstructions)) {
+    EXPECT_LT(counters.Read().counts[PerfCounterGroup::kInstructions],
+              values.counts[PerfCounterGroup::kInstructions]);
+  }
+}
+
+}  // namespace base
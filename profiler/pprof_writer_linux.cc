@@ -0,0 +1,340 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/profiler/pprof_writer_linux.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/debug/elf_symbol_cache_linux.h"
+#include "base/files/file_path.h"
+#include "base/logging.h"
+#include "base/strings/string_util.h"
+
+namespace base {
+
+namespace {
+
+// Field numbers of the messages in profile.proto.
+enum ProfileField {
+  kProfileSampleType = 1,
+  kProfileSample = 2,
+  kProfileMapping = 3,
+  kProfileLocation = 4,
+  kProfileFunction = 5,
+  kProfileStringTable = 6,
+  kProfileTimeNanos = 9,
+  kProfileDurationNanos = 10,
+  kProfilePeriodType = 11,
+  kProfilePeriod = 12,
+};
+
+enum ValueTypeField {
+  kValueTypeType = 1,
+  kValueTypeUnit = 2,
+};
+
+enum SampleField {
+  kSampleLocationId = 1,
+  kSampleValue = 2,
+};
+
+enum MappingField {
+  kMappingId = 1,
+  kMappingMemoryStart = 2,
+  kMappingMemoryLimit = 3,
+  kMappingFileOffset = 4,
+  kMappingFilename = 5,
+};
+
+enum LocationField {
+  kLocationId = 1,
+  kLocationMappingId = 2,
+  kLocationAddress = 3,
+  kLocationLine = 4,
+};
+
+enum LineField {
+  kLineFunctionId = 1,
+};
+
+enum FunctionField {
+  kFunctionId = 1,
+  kFunctionName = 2,
+};
+
+enum WireType {
+  kWireTypeVarint = 0,
+  kWireTypeLengthDelimited = 2,
+};
+
+// Output is written to the file in chunks of about this size.
+constexpr size_t kFlushThreshold = 64 * 1024;
+
+void AppendVarint(uint64_t value, std::string* output) {
+  while (value >= 0x80) {
+    output->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  output->push_back(static_cast<char>(value));
+}
+
+void AppendKey(int field, WireType wire_type, std::string* output) {
+  AppendVarint((static_cast<uint64_t>(field) << 3) | wire_type, output);
+}
+
+// Appends a varint field. Negative values take ten bytes, as for int64 fields
+// in protocol buffers.
+void AppendVarintField(int field, uint64_t value, std::string* output) {
+  AppendKey(field, kWireTypeVarint, output);
+  AppendVarint(value, output);
+}
+
+void AppendLengthDelimitedField(int field,
+                                StringPiece data,
+                                std::string* output) {
+  AppendKey(field, kWireTypeLengthDelimited, output);
+  AppendVarint(data.size(), output);
+  data.AppendToString(output);
+}
+
+// Appends a repeated varint field in the packed encoding.
+template <typename T>
+void AppendPackedVarintField(int field,
+                             const std::vector<T>& values,
+                             std::string* output) {
+  std::string packed;
+  for (T value : values)
+    AppendVarint(static_cast<uint64_t>(value), &packed);
+  AppendLengthDelimitedField(field, packed, output);
+}
+
+}  // namespace
+
+// static
+std::unique_ptr<PprofWriter> PprofWriter::Create(
+    const FilePath& path,
+    const std::vector<ValueType>& sample_types,
+    ValueType period_type,
+    int64_t period) {
+  File file(path, File::FLAG_CREATE_ALWAYS | File::FLAG_WRITE);
+  if (!file.IsValid()) {
+    DPLOG(ERROR) << "Failed to create " << path.value();
+    return nullptr;
+  }
+  std::unique_ptr<PprofWriter> writer(
+      new PprofWriter(std::move(file), TimeTicks::Now()));
+  writer->WriteHeader(sample_types, period_type, period);
+  return writer;
+}
+
+PprofWriter::PprofWriter(File file, TimeTicks start_ticks)
+    : file_(std::move(file)), start_ticks_(start_ticks) {}
+
+PprofWriter::~PprofWriter() {
+  if (!finished_)
+    Finish();
+}
+
+void PprofWriter::AddSample(const void* const* stack,
+                            size_t stack_depth,
+                            const std::vector<int64_t>& values) {
+  DCHECK(!finished_);
+  std::vector<uint64_t> location_ids(stack_depth);
+  for (size_t i = 0; i < stack_depth; ++i) {
+    location_ids[i] =
+        InternLocation(reinterpret_cast<uintptr_t>(stack[i]), i > 0);
+  }
+
+  message_.clear();
+  AppendPackedVarintField(kSampleLocationId, location_ids, &message_);
+  AppendPackedVarintField(kSampleValue, values, &message_);
+  WriteMessage(kProfileSample, message_);
+}
+
+bool PprofWriter::Finish() {
+  DCHECK(!finished_);
+  finished_ = true;
+  TimeDelta duration =
+      duration_.is_zero() ? TimeTicks::Now() - start_ticks_ : duration_;
+  AppendVarintField(kProfileDurationNanos, duration.InNanoseconds(), &buffer_);
+  Flush();
+  return !failed_;
+}
+
+void PprofWriter::WriteHeader(const std::vector<ValueType>& sample_types,
+                              ValueType period_type,
+                              int64_t period) {
+  // The first string of the table must be empty.
+  InternString(std::string());
+
+  for (const ValueType& sample_type : sample_types) {
+    int64_t type = InternString(sample_type.type);
+    int64_t unit = InternString(sample_type.unit);
+    message_.clear();
+    AppendVarintField(kValueTypeType, type, &message_);
+    AppendVarintField(kValueTypeUnit, unit, &message_);
+    WriteMessage(kProfileSampleType, message_);
+  }
+
+  int64_t type = InternString(period_type.type);
+  int64_t unit = InternString(period_type.unit);
+  message_.clear();
+  AppendVarintField(kValueTypeType, type, &message_);
+  AppendVarintField(kValueTypeUnit, unit, &message_);
+  WriteMessage(kProfilePeriodType, message_);
+  AppendVarintField(kProfilePeriod, period, &buffer_);
+  AppendVarintField(kProfileTimeNanos,
+                    (Time::Now() - Time::UnixEpoch()).InNanoseconds(),
+                    &buffer_);
+
+  // Only mappings of code can contain locations. Others, such as "[stack]",
+  // are not files.
+  std::string proc_maps;
+  std::vector<debug::MappedMemoryRegion> regions;
+  if (!debug::ReadProcMaps(&proc_maps) ||
+      !debug::ParseProcMaps(proc_maps, &regions)) {
+    DLOG(ERROR) << "Failed to read /proc/self/maps";
+  }
+  for (debug::MappedMemoryRegion& region : regions) {
+    if ((region.permissions & debug::MappedMemoryRegion::EXECUTE) &&
+        StartsWith(region.path, "/", CompareCase::SENSITIVE)) {
+      mappings_.push_back(std::move(region));
+    }
+  }
+  std::sort(mappings_.begin(), mappings_.end(),
+            [](const debug::MappedMemoryRegion& a,
+               const debug::MappedMemoryRegion& b) {
+              return a.start < b.start;
+            });
+
+  for (size_t i = 0; i < mappings_.size(); ++i) {
+    const debug::MappedMemoryRegion& mapping = mappings_[i];
+    int64_t filename = InternString(mapping.path);
+    message_.clear();
+    AppendVarintField(kMappingId, i + 1, &message_);
+    AppendVarintField(kMappingMemoryStart, mapping.start, &message_);
+    AppendVarintField(kMappingMemoryLimit, mapping.end, &message_);
+    AppendVarintField(kMappingFileOffset, mapping.offset, &message_);
+    AppendVarintField(kMappingFilename, filename, &message_);
+    WriteMessage(kProfileMapping, message_);
+  }
+}
+
+int64_t PprofWriter::InternString(const std::string& string) {
+  auto result = strings_.emplace(string, strings_.size());
+  if (result.second)
+    WriteMessage(kProfileStringTable, string);
+  return result.first->second;
+}
+
+uint64_t PprofWriter::InternLocation(uintptr_t address,
+                                     bool is_return_address) {
+  auto result = locations_.emplace(address, locations_.size() + 1);
+  const uint64_t id = result.first->second;
+  if (!result.second)
+    return id;
+
+  // A return address may be the first instruction of the next function, when
+  // the call does not return.
+  const char* name = debug::ElfSymbolCache::GetInstance()->Lookup(
+      reinterpret_cast<const void*>(address - (is_return_address ? 1 : 0)));
+  const uint64_t function_id = name ? InternFunction(name) : 0;
+  const uint64_t mapping_id = FindMapping(address);
+
+  message_.clear();
+  AppendVarintField(kLocationId, id, &message_);
+  if (mapping_id)
+    AppendVarintField(kLocationMappingId, mapping_id, &message_);
+  AppendVarintField(kLocationAddress, address, &message_);
+  if (function_id) {
+    std::string line;
+    AppendVarintField(kLineFunctionId, function_id, &line);
+    AppendLengthDelimitedField(kLocationLine, line, &message_);
+  }
+  WriteMessage(kProfileLocation, message_);
+  return id;
+}
+
+uint64_t PprofWriter::InternFunction(const char* name) {
+  auto result = functions_.emplace(name, functions_.size() + 1);
+  const uint64_t id = result.first->second;
+  if (!result.second)
+    return id;
+
+  int64_t name_index = InternString(name);
+  message_.clear();
+  AppendVarintField(kFunctionId, id, &message_);
+  AppendVarintField(kFunctionName, name_index, &message_);
+  WriteMessage(kProfileFunction, message_);
+  return id;
+}
+
+uint64_t PprofWriter::FindMapping(uintptr_t address) const {
+  auto next = std::upper_bound(
+      mappings_.begin(), mappings_.end(), address,
+      [](uintptr_t address, const debug::MappedMemoryRegion& mapping) {
+        return address < mapping.start;
+      });
+  if (next == mappings_.begin() || address >= (next - 1)->end)
+    return 0;
+  return next - mappings_.begin();
+}
+
+void PprofWriter::WriteMessage(int field, const std::string& message) {
+  AppendLengthDelimitedField(field, message, &buffer_);
+  if (buffer_.size() >= kFlushThreshold)
+    Flush();
+}
+
+void PprofWriter::Flush() {
+  if (buffer_.empty() || failed_)
+    return;
+  int size = static_cast<int>(buffer_.size());
+  if (file_.WriteAtCurrentPos(buffer_.data(), size) != size) {
+    DPLOG(ERROR) << "Failed to write profile";
+    failed_ = true;
+  }
+  buffer_.clear();
+}
+
+bool WriteHeapProfileToPprof(
+    const std::vector<SamplingHeapProfiler::Sample>& samples,
+    const FilePath& path) {
+  // The sampling interval varies, so each sample is weighed by the bytes it
+  // stands for rather than by a fixed period.
+  std::unique_ptr<PprofWriter> writer = PprofWriter::Create(
+      path, {{"objects", "count"}, {"space", "bytes"}}, {"space", "bytes"}, 0);
+  if (!writer)
+    return false;
+  for (const SamplingHeapProfiler::Sample& sample : samples) {
+    const int64_t count =
+        sample.size ? (sample.total + sample.size / 2) / sample.size : 0;
+    writer->AddSample(sample.stack.data(), sample.stack.size(),
+                      {count, static_cast<int64_t>(sample.total)});
+  }
+  return writer->Finish();
+}
+
+bool WriteCallStackProfileToPprof(
+    const StackSamplingProfiler::CallStackProfile& profile,
+    const FilePath& path) {
+  const int64_t period = profile.sampling_period.InNanoseconds();
+  std::unique_ptr<PprofWriter> writer = PprofWriter::Create(
+      path, {{"samples", "count"}, {"cpu", "nanoseconds"}},
+      {"cpu", "nanoseconds"}, period);
+  if (!writer)
+    return false;
+  writer->set_duration(profile.profile_duration);
+  std::vector<const void*> stack;
+  for (const StackSamplingProfiler::Sample& sample : profile.samples) {
+    stack.clear();
+    for (const StackSamplingProfiler::Frame& frame : sample.frames)
+      stack.push_back(reinterpret_cast<const void*>(frame.instruction_pointer));
+    writer->AddSample(stack.data(), stack.size(), {1, period});
+  }
+  return writer->Finish();
+}
+
+}  // namespace base
@@ -0,0 +1,150 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_PROFILER_PPROF_WRITER_LINUX_H_
+#define BASE_PROFILER_PPROF_WRITER_LINUX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/debug/proc_maps_linux.h"
+#include "base/files/file.h"
+#include "base/macros.h"
+#include "base/profiler/stack_sampling_profiler.h"
+#include "base/sampling_heap_profiler/sampling_heap_profiler.h"
+#include "base/time/time.h"
+
+namespace base {
+
+class FilePath;
+
+// Writes a profile of the current process to a file in the pprof format, the
+// uncompressed protocol buffer described by profile.proto in
+// https://github.com/google/pprof, which `pprof` and other standard tools read
+// directly. Samples are written to the file as they are added, together with
+// the locations, functions and strings they are the first to use, so memory
+// use only grows with the number of distinct addresses.
+//
+// Executable mappings are read from /proc/self/maps when the writer is
+// created, and addresses are symbolized in-process with
+// debug::ElfSymbolCache. Locations that cannot be symbolized are left for
+// pprof to symbolize from the mapped files.
+//
+// The writer does blocking I/O and is not thread safe.
+//
+// Example:
+//   std::unique_ptr<PprofWriter> writer = PprofWriter::Create(
+//       path, {{"samples", "count"}}, {"samples", "count"}, 1);
+//   for (const auto& stack : stacks)
+//     writer->AddSample(stack.data(), stack.size(), {1});
+//   bool success = writer->Finish();
+class BASE_EXPORT PprofWriter {
+ public:
+  // Kind and unit of the sample values, e.g. {"space", "bytes"}.
+  struct ValueType {
+    const char* type;
+    const char* unit;
+  };
+
+  // Creates the file at |path| and writes the header of a profile whose
+  // samples each have one value per entry of |sample_types|, taken every
+  // |period| units of |period_type|. Returns null if the file cannot be
+  // created.
+  static std::unique_ptr<PprofWriter> Create(
+      const FilePath& path,
+      const std::vector<ValueType>& sample_types,
+      ValueType period_type,
+      int64_t period);
+
+  // Finishes the profile if Finish() was not called.
+  ~PprofWriter();
+
+  // Adds a sample of |values| at the stack of |stack_depth| instruction
+  // pointers in |stack|, innermost frame first. All frames but the innermost
+  // are return addresses, so they are symbolized as the preceding call
+  // instruction.
+  void AddSample(const void* const* stack,
+                 size_t stack_depth,
+                 const std::vector<int64_t>& values);
+
+  // Sets the duration of the profile, which is otherwise the time from
+  // Create() to Finish().
+  void set_duration(TimeDelta duration) { duration_ = duration; }
+
+  // Writes the duration of the profile and flushes the file. Returns false if
+  // any write failed. No samples can be added afterwards.
+  bool Finish();
+
+ private:
+  PprofWriter(File file, TimeTicks start_ticks);
+
+  // Writes the header of the profile, which refers to no locations.
+  void WriteHeader(const std::vector<ValueType>& sample_types,
+                   ValueType period_type,
+                   int64_t period);
+
+  // Returns the index of |string| in the string table, adding it if needed.
+  int64_t InternString(const std::string& string);
+
+  // Returns the id of the location of |address|, adding it if needed.
+  uint64_t InternLocation(uintptr_t address, bool is_return_address);
+
+  // Returns the id of the function named |name|, adding it if needed.
+  uint64_t InternFunction(const char* name);
+
+  // Returns the id of the mapping containing |address|, or 0 if there is none.
+  uint64_t FindMapping(uintptr_t address) const;
+
+  // Appends the length-delimited Profile field |field| holding |message| to
+  // the output.
+  void WriteMessage(int field, const std::string& message);
+
+  // Writes the output buffered so far to the file.
+  void Flush();
+
+  File file_;
+  const TimeTicks start_ticks_;
+  TimeDelta duration_;
+  bool finished_ = false;
+  bool failed_ = false;
+
+  // Profile fields not yet written to |file_|.
+  std::string buffer_;
+  // Scratch buffer for encoding messages.
+  std::string message_;
+
+  // Executable mappings, sorted by address. The id of each is its index plus
+  // one.
+  std::vector<debug::MappedMemoryRegion> mappings_;
+
+  std::unordered_map<std::string, int64_t> strings_;
+  std::unordered_map<uintptr_t, uint64_t> locations_;
+  std::unordered_map<std::string, uint64_t> functions_;
+
+  DISALLOW_COPY_AND_ASSIGN(PprofWriter);
+};
+
+// Writes |samples| of the SamplingHeapProfiler to |path| as a pprof heap
+// profile with the estimated number of allocated objects and bytes. Returns
+// true if successful.
+BASE_EXPORT bool WriteHeapProfileToPprof(
+    const std::vector<SamplingHeapProfiler::Sample>& samples,
+    const FilePath& path);
+
+// Writes |profile| of the StackSamplingProfiler, which must have been
+// recorded in the current process, to |path| as a pprof CPU profile. Returns
+// true if successful.
+BASE_EXPORT bool WriteCallStackProfileToPprof(
+    const StackSamplingProfiler::CallStackProfile& profile,
+    const FilePath& path);
+
+}  // namespace base
+
+#endif  // BASE_PROFILER_PPROF_WRITER_LINUX_H_
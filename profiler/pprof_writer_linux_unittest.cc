@@ -0,0 +1,307 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/profiler/pprof_writer_linux.h"
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/compiler_specific.h"
+#include "base/debug/alias.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/strings/string_piece.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Long enough for the tests to refer to its first few bytes.
+NOINLINE int PprofWriterTestFunction(int value) {
+  int result = 0;
+  for (int i = 0; i < value; ++i)
+    result += i * value;
+  return result;
+}
+
+// A field of a protocol buffer message, holding either a varint or bytes.
+struct Field {
+  uint64_t varint = 0;
+  std::string bytes;
+};
+
+using Message = std::multimap<int, Field>;
+
+bool ReadVarint(StringPiece* data, uint64_t* value) {
+  *value = 0;
+  for (int shift = 0; shift < 64 && !data->empty(); shift += 7) {
+    uint8_t byte = static_cast<uint8_t>((*data)[0]);
+    data->remove_prefix(1);
+    *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+// Decodes the varint and length-delimited fields of |data|, which are the only
+// wire types PprofWriter uses.
+bool ParseMessage(StringPiece data, Message* message) {
+  message->clear();
+  while (!data.empty()) {
+    uint64_t key;
+    if (!ReadVarint(&data, &key))
+      return false;
+    Field field;
+    switch (key & 7) {
+      case 0:
+        if (!ReadVarint(&data, &field.varint))
+          return false;
+        break;
+      case 2: {
+        uint64_t size;
+        if (!ReadVarint(&data, &size) || size > data.size())
+          return false;
+        field.bytes = data.substr(0, size).as_string();
+        data.remove_prefix(size);
+        break;
+      }
+      default:
+        return false;
+    }
+    message->emplace(static_cast<int>(key >> 3), field);
+  }
+  return true;
+}
+
+std::vector<uint64_t> ParsePackedVarints(StringPiece data) {
+  std::vector<uint64_t> values;
+  uint64_t value;
+  while (ReadVarint(&data, &value))
+    values.push_back(value);
+  return values;
+}
+
+// Returns the fields |number| of |message|, parsed as messages.
+std::vector<Message> GetMessages(const Message& message, int number) {
+  std::vector<Message> messages;
+  auto range = message.equal_range(number);
+  for (auto it = range.first; it != range.second; ++it) {
+    messages.emplace_back();
+    EXPECT_TRUE(ParseMessage(it->second.bytes, &messages.back()));
+  }
+  return messages;
+}
+
+uint64_t GetVarint(const Message& message, int number) {
+  auto it = message.find(number);
+  return it == message.end() ? 0 : it->second.varint;
+}
+
+class PprofWriterTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    path_ = temp_dir_.GetPath().AppendASCII("profile.pb");
+  }
+
+  // Reads and parses the profile written to |path_|.
+  void ReadProfile(Message* profile) {
+    std::string data;
+    ASSERT_TRUE(ReadFileToString(path_, &data));
+    ASSERT_TRUE(ParseMessage(data, profile));
+    string_table_.clear();
+    auto range = profile->equal_range(6);
+    for (auto it = range.first; it != range.second; ++it)
+      string_table_.push_back(it->second.bytes);
+  }
+
+  std::string GetString(uint64_t index) {
+    return index < string_table_.size() ? string_table_[index] : "<invalid>";
+  }
+
+  ScopedTempDir temp_dir_;
+  FilePath path_;
+  std::vector<std::string> string_table_;
+};
+
+}  // namespace
+
+TEST_F(PprofWriterTest, WriteSamples) {
+  const void* function = reinterpret_cast<const char*>(
+                             &PprofWriterTestFunction) + 1;
+  const void* caller = reinterpret_cast<const char*>(&ParseMessage) + 8;
+  // Keeps PprofWriterTestFunction() in the binary, to be symbolized below.
+  debug::Alias(function);
+  {
+    std::unique_ptr<PprofWriter> writer = PprofWriter::Create(
+        path_, {{"samples", "count"}, {"space", "bytes"}}, {"space", "bytes"},
+        1024);
+    ASSERT_TRUE(writer);
+    const void* stack[] = {function, caller};
+    writer->AddSample(stack, 2, {1, 100});
+    writer->AddSample(stack, 1, {3, -5});
+    writer->set_duration(TimeDelta::FromSeconds(2));
+    EXPECT_TRUE(writer->Finish());
+  }
+
+  Message profile;
+  ASSERT_NO_FATAL_FAILURE(ReadProfile(&profile));
+  ASSERT_FALSE(string_table_.empty());
+  EXPECT_EQ("", string_table_[0]);
+  EXPECT_EQ(1024u, GetVarint(profile, 12));
+  EXPECT_EQ(2000000000u, GetVarint(profile, 10));
+  EXPECT_NE(0u, GetVarint(profile, 9));
+
+  std::vector<Message> sample_types = GetMessages(profile, 1);
+  ASSERT_EQ(2u, sample_types.size());
+  EXPECT_EQ("samples", GetString(GetVarint(sample_types[0], 1)));
+  EXPECT_EQ("count", GetString(GetVarint(sample_types[0], 2)));
+  EXPECT_EQ("space", GetString(GetVarint(sample_types[1], 1)));
+  EXPECT_EQ("bytes", GetString(GetVarint(sample_types[1], 2)));
+
+  // The code of this test is in an executable mapping.
+  std::vector<Message> mappings = GetMessages(profile, 3);
+  ASSERT_FALSE(mappings.empty());
+
+  // Locations are shared by samples.
+  std::vector<Message> locations = GetMessages(profile, 4);
+  ASSERT_EQ(2u, locations.size());
+  std::map<uint64_t, Message> locations_by_id;
+  for (const Message& location : locations) {
+    EXPECT_NE(0u, GetVarint(location, 2));
+    locations_by_id[GetVarint(location, 1)] = location;
+  }
+
+  std::vector<Message> samples = GetMessages(profile, 2);
+  ASSERT_EQ(2u, samples.size());
+  std::vector<uint64_t> location_ids =
+      ParsePackedVarints(samples[0].find(1)->second.bytes);
+  ASSERT_EQ(2u, location_ids.size());
+  EXPECT_EQ(std::vector<uint64_t>({location_ids[0]}),
+            ParsePackedVarints(samples[1].find(1)->second.bytes));
+  EXPECT_EQ(std::vector<uint64_t>({1, 100}),
+            ParsePackedVarints(samples[0].find(2)->second.bytes));
+  EXPECT_EQ(std::vector<uint64_t>({3, static_cast<uint64_t>(-5)}),
+            ParsePackedVarints(samples[1].find(2)->second.bytes));
+
+  // The innermost location is symbolized.
+  const Message& leaf = locations_by_id[location_ids[0]];
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(function), GetVarint(leaf, 3));
+  std::vector<Message> lines = GetMessages(leaf, 4);
+  ASSERT_EQ(1u, lines.size());
+  uint64_t function_id = GetVarint(lines[0], 1);
+  std::string name;
+  for (const Message& function_message : GetMessages(profile, 5)) {
+    if (GetVarint(function_message, 1) == function_id)
+      name = GetString(GetVarint(function_message, 2));
+  }
+  EXPECT_NE(std::string::npos, name.find("PprofWriterTestFunction")) << name;
+}
+
+TEST_F(PprofWriterTest, WriteHeapProfile) {
+  // Records an allocation directly, so that the test doesn't depend on the
+  // allocator shim. It is larger than the sampling interval, so it is sampled.
+  const size_t kSize = 4567;
+  char block[1];
+  SamplingHeapProfiler::InitTLSSlot();
+  SamplingHeapProfiler* profiler = SamplingHeapProfiler::GetInstance();
+  profiler->SuppressRandomnessForTest(true);
+  profiler->SetSamplingInterval(1024);
+  uint32_t id = profiler->Start();
+  SamplingHeapProfiler::RecordAlloc(block, kSize);
+  std::vector<SamplingHeapProfiler::Sample> samples;
+  for (const SamplingHeapProfiler::Sample& sample : profiler->GetSamples(id)) {
+    if (sample.size == kSize)
+      samples.push_back(sample);
+  }
+  SamplingHeapProfiler::RecordFree(block);
+  profiler->Stop();
+  // Restore the defaults for the tests that run after this one.
+  profiler->SetSamplingInterval(128 * 1024);
+  profiler->SuppressRandomnessForTest(false);
+  ASSERT_EQ(1u, samples.size());
+
+  // A sample standing for 10.5 allocations, which rounds to 11 objects.
+  void* function = reinterpret_cast<void*>(&PprofWriterTestFunction);
+  void* caller = reinterpret_cast<char*>(&ParseMessage) + 8;
+  samples.push_back(samples[0]);
+  samples[1].size = 100;
+  samples[1].total = 1050;
+  samples[1].stack = {function, caller};
+  ASSERT_TRUE(WriteHeapProfileToPprof(samples, path_));
+
+  Message profile;
+  ASSERT_NO_FATAL_FAILURE(ReadProfile(&profile));
+  std::vector<Message> sample_types = GetMessages(profile, 1);
+  ASSERT_EQ(2u, sample_types.size());
+  EXPECT_EQ("objects", GetString(GetVarint(sample_types[0], 1)));
+  EXPECT_EQ("count", GetString(GetVarint(sample_types[0], 2)));
+  EXPECT_EQ("space", GetString(GetVarint(sample_types[1], 1)));
+  EXPECT_EQ("bytes", GetString(GetVarint(sample_types[1], 2)));
+
+  std::map<uint64_t, uint64_t> addresses_by_location_id;
+  for (const Message& location : GetMessages(profile, 4))
+    addresses_by_location_id[GetVarint(location, 1)] = GetVarint(location, 3);
+
+  std::vector<Message> written_samples = GetMessages(profile, 2);
+  ASSERT_EQ(2u, written_samples.size());
+  const uint64_t total = samples[0].total;
+  EXPECT_EQ(std::vector<uint64_t>({(total + kSize / 2) / kSize, total}),
+            ParsePackedVarints(written_samples[0].find(2)->second.bytes));
+  EXPECT_EQ(std::vector<uint64_t>({11, 1050}),
+            ParsePackedVarints(written_samples[1].find(2)->second.bytes));
+
+  // Each location holds the address of the corresponding frame.
+  for (size_t i = 0; i < samples.size(); ++i) {
+    std::vector<uint64_t> location_ids =
+        ParsePackedVarints(written_samples[i].find(1)->second.bytes);
+    ASSERT_EQ(samples[i].stack.size(), location_ids.size());
+    for (size_t j = 0; j < location_ids.size(); ++j) {
+      ASSERT_EQ(1u, addresses_by_location_id.count(location_ids[j]));
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(samples[i].stack[j]),
+                addresses_by_location_id[location_ids[j]]);
+    }
+  }
+}
+
+TEST_F(PprofWriterTest, WriteCallStackProfile) {
+  StackSamplingProfiler::CallStackProfile call_stack_profile;
+  call_stack_profile.sampling_period = TimeDelta::FromMilliseconds(10);
+  call_stack_profile.profile_duration = TimeDelta::FromMilliseconds(30);
+  const uintptr_t function = reinterpret_cast<uintptr_t>(
+      &PprofWriterTestFunction);
+  for (int i = 0; i < 3; ++i) {
+    call_stack_profile.samples.push_back(StackSamplingProfiler::Sample(
+        StackSamplingProfiler::Frame(function + i, 0)));
+  }
+  ASSERT_TRUE(WriteCallStackProfileToPprof(call_stack_profile, path_));
+
+  Message profile;
+  ASSERT_NO_FATAL_FAILURE(ReadProfile(&profile));
+  EXPECT_EQ(10000000u, GetVarint(profile, 12));
+  EXPECT_EQ(30000000u, GetVarint(profile, 10));
+  std::vector<Message> samples = GetMessages(profile, 2);
+  ASSERT_EQ(3u, samples.size());
+  for (const Message& sample : samples) {
+    EXPECT_EQ(std::vector<uint64_t>({1, 10000000}),
+              ParsePackedVarints(sample.find(2)->second.bytes));
+  }
+  EXPECT_EQ(3u, GetMessages(profile, 4).size());
+  // All locations are in the same function.
+  EXPECT_EQ(1u, GetMessages(profile, 5).size());
+}
+
+TEST_F(PprofWriterTest, CreateFails) {
+  EXPECT_FALSE(PprofWriter::Create(
+      temp_dir_.GetPath().AppendASCII("missing").AppendASCII("profile.pb"),
+      {{"samples", "count"}}, {"samples", "count"}, 1));
+}
+
+}  // namespace base
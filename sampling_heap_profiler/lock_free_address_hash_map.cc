@@ -0,0 +1,217 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/sampling_heap_profiler/lock_free_address_hash_map.h"
+
+#include <utility>
+
+#include "base/bits.h"
+#include "base/logging.h"
+#include "base/threading/platform_thread.h"
+
+namespace base {
+
+constexpr uintptr_t LockFreeAddressHashMap::kEmptyKey;
+constexpr uintptr_t LockFreeAddressHashMap::kDeletedKey;
+
+LockFreeAddressHashMap::Table::Table(size_t capacity)
+    : mask(capacity - 1), slots(new Slot[capacity]) {}
+
+LockFreeAddressHashMap::Table::~Table() = default;
+
+LockFreeAddressHashMap::LockFreeAddressHashMap(size_t initial_capacity)
+    : current_table_(std::make_unique<Table>(initial_capacity)) {
+  DCHECK(bits::IsPowerOfTwo(initial_capacity));
+  table_.store(current_table_.get(), std::memory_order_relaxed);
+}
+
+LockFreeAddressHashMap::~LockFreeAddressHashMap() = default;
+
+bool LockFreeAddressHashMap::Contains(void* key) const {
+  const uintptr_t k = reinterpret_cast<uintptr_t>(key);
+  for (;;) {
+    // The table may be cleared while it is probed, in which case the result
+    // is discarded.
+    const uint32_t sequence = sequence_.load(std::memory_order_acquire);
+    if (!(sequence & 1)) {
+      bool found = FindSlot(table_.load(std::memory_order_acquire), k);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence_.load(std::memory_order_relaxed) == sequence)
+        return found;
+    }
+    // Wait for the rebuild to finish.
+    AutoLock lock(rebuild_lock_);
+  }
+}
+
+void* LockFreeAddressHashMap::Insert(void* key, void* value) {
+  const uintptr_t k = reinterpret_cast<uintptr_t>(key);
+  DCHECK_GT(k, kDeletedKey);
+  DCHECK(value);
+
+  EnterWriter();
+  // The table cannot be replaced while there are writers.
+  Table* table = table_.load(std::memory_order_relaxed);
+  void* replaced_value = nullptr;
+  if (Slot* slot = FindSlot(table, k)) {
+    replaced_value = slot->value.exchange(value, std::memory_order_acq_rel);
+  } else {
+    InsertNewKey(table, k, value);
+    size_.fetch_add(1, std::memory_order_relaxed);
+  }
+  const bool needs_rebuild =
+      table->used.load(std::memory_order_relaxed) * 2 > table->mask + 1;
+  ExitWriter();
+
+  if (needs_rebuild)
+    MaybeRebuild();
+  return replaced_value;
+}
+
+void* LockFreeAddressHashMap::Remove(void* key) {
+  const uintptr_t k = reinterpret_cast<uintptr_t>(key);
+  DCHECK_GT(k, kDeletedKey);
+
+  EnterWriter();
+  void* value = nullptr;
+  if (Slot* slot = FindSlot(table_.load(std::memory_order_relaxed), k)) {
+    value = slot->value.exchange(nullptr, std::memory_order_acq_rel);
+    if (value) {
+      slot->key.store(kDeletedKey, std::memory_order_release);
+      size_.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+  ExitWriter();
+  return value;
+}
+
+// static
+size_t LockFreeAddressHashMap::Hash(uintptr_t key) {
+  // Multiplicative hashing: the high half of the product with a random odd
+  // constant depends on all the bits of the address.
+  uint64_t k = static_cast<uint64_t>(key);
+  uint64_t random_bits = 0x4bfdb9df5a6f243bull;
+  return static_cast<size_t>((k * random_bits) >> 32);
+}
+
+// static
+LockFreeAddressHashMap::Slot* LockFreeAddressHashMap::FindSlot(
+    const Table* table,
+    uintptr_t key) {
+  size_t index = Hash(key);
+  for (size_t probes = 0; probes <= table->mask; ++probes, ++index) {
+    Slot* slot = &table->slots[index & table->mask];
+    uintptr_t slot_key = slot->key.load(std::memory_order_acquire);
+    if (slot_key == key)
+      return slot;
+    if (slot_key == kEmptyKey)
+      return nullptr;
+  }
+  return nullptr;
+}
+
+// static
+void LockFreeAddressHashMap::InsertNewKey(Table* table,
+                                          uintptr_t key,
+                                          void* value) {
+  size_t index = Hash(key);
+  for (size_t probes = 0; probes <= table->mask;) {
+    Slot* slot = &table->slots[index & table->mask];
+    uintptr_t slot_key = slot->key.load(std::memory_order_relaxed);
+    if (slot_key != kEmptyKey && slot_key != kDeletedKey) {
+      ++probes;
+      ++index;
+      continue;
+    }
+    // Another writer may take the slot first, in which case look at it again.
+    if (slot->key.compare_exchange_strong(slot_key, key,
+                                          std::memory_order_acq_rel)) {
+      slot->value.store(value, std::memory_order_release);
+      if (slot_key == kEmptyKey)
+        table->used.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+  // Writers rebuild the table before it is half full.
+  NOTREACHED();
+}
+
+void LockFreeAddressHashMap::EnterWriter() {
+  for (;;) {
+    // Pairs with the stores and loads in MaybeRebuild(): either the rebuild
+    // sees this writer, or this writer sees the rebuild.
+    writers_.fetch_add(1, std::memory_order_seq_cst);
+    if (!rebuilding_.load(std::memory_order_seq_cst))
+      return;
+    writers_.fetch_sub(1, std::memory_order_seq_cst);
+    AutoLock lock(rebuild_lock_);
+  }
+}
+
+void LockFreeAddressHashMap::ExitWriter() {
+  writers_.fetch_sub(1, std::memory_order_release);
+}
+
+void LockFreeAddressHashMap::MaybeRebuild() {
+  AutoLock lock(rebuild_lock_);
+  const size_t capacity = current_table_->mask + 1;
+  if (current_table_->used.load(std::memory_order_relaxed) * 2 <= capacity)
+    return;
+
+  // Allocate before stopping readers: freeing or allocating memory while they
+  // wait for the rebuild could recurse into the map from allocator hooks.
+  size_t new_capacity = capacity;
+  while (size() * 4 > new_capacity)
+    new_capacity *= 2;
+  std::unique_ptr<Table> new_table;
+  if (new_capacity != capacity) {
+    new_table = std::make_unique<Table>(new_capacity);
+    outgrown_tables_.reserve(outgrown_tables_.size() + 2);
+  } else if (spare_table_) {
+    new_table = std::move(spare_table_);
+  } else {
+    new_table = std::make_unique<Table>(capacity);
+  }
+
+  // Wait for writers to finish, so that the current table does not change.
+  rebuilding_.store(true, std::memory_order_seq_cst);
+  while (writers_.load(std::memory_order_seq_cst))
+    PlatformThread::YieldCurrentThread();
+
+  // A reused table may still be probed by readers that loaded it before the
+  // last rebuild, so make them retry. A new one is not visible to them yet.
+  const bool reused = new_capacity == capacity;
+  if (reused) {
+    sequence_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i <= new_table->mask; ++i) {
+      new_table->slots[i].key.store(kEmptyKey, std::memory_order_relaxed);
+      new_table->slots[i].value.store(nullptr, std::memory_order_relaxed);
+    }
+    new_table->used.store(0, std::memory_order_relaxed);
+  }
+
+  for (size_t i = 0; i < capacity; ++i) {
+    const Slot& slot = current_table_->slots[i];
+    uintptr_t key = slot.key.load(std::memory_order_relaxed);
+    void* value = slot.value.load(std::memory_order_relaxed);
+    if (key != kEmptyKey && key != kDeletedKey && value)
+      InsertNewKey(new_table.get(), key, value);
+  }
+  table_.store(new_table.get(), std::memory_order_release);
+
+  if (reused) {
+    sequence_.fetch_add(1, std::memory_order_release);
+    spare_table_ = std::move(current_table_);
+  } else {
+    if (spare_table_)
+      outgrown_tables_.push_back(std::move(spare_table_));
+    outgrown_tables_.push_back(std::move(current_table_));
+  }
+  current_table_ = std::move(new_table);
+
+  rebuilding_.store(false, std::memory_order_release);
+}
+
+}  // namespace base
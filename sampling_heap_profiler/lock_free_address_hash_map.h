@@ -0,0 +1,121 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_SAMPLING_HEAP_PROFILER_LOCK_FREE_ADDRESS_HASH_MAP_H_
+#define BASE_SAMPLING_HEAP_PROFILER_LOCK_FREE_ADDRESS_HASH_MAP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+
+namespace base {
+
+// An open-addressed hash map from addresses to pointers, with lock-free
+// |Insert|, |Remove| and |Contains| operations.
+// It does not support concurrent |Insert| and |Remove| of the same key, which
+// the allocator never does for an address it has not returned yet.
+// Concurrent writes of distinct keys are ok, and |Contains| can run
+// concurrently with anything.
+//
+// Keys live in a single array of slots probed linearly. Removing a key leaves
+// a tombstone in its slot, which later insertions reuse. When more than half
+// of the slots are in use, the next writer rebuilds the table, twice as large
+// if more than a quarter of the slots hold keys, or at the same size to drop
+// the tombstones otherwise. This is the only operation that takes a lock:
+// writers wait for it, and readers that raced with it retry, detecting it
+// with a sequence counter. Readers may still be probing a replaced table, so
+// tables are never freed before the map: rebuilds at the same size alternate
+// between two tables, and tables replaced by larger ones take at most as much
+// memory as the current one.
+class BASE_EXPORT LockFreeAddressHashMap {
+ public:
+  // |initial_capacity| must be a power of 2.
+  explicit LockFreeAddressHashMap(size_t initial_capacity);
+  ~LockFreeAddressHashMap();
+
+  // Returns whether |key| is in the map. Never blocks unless the table is
+  // being rebuilt.
+  bool Contains(void* key) const;
+
+  // Maps |key| to the non-null |value|. Returns the value it replaces, or null
+  // if |key| was not in the map.
+  void* Insert(void* key, void* value);
+
+  // Removes |key| from the map and returns its value, or null if |key| was not
+  // in the map.
+  void* Remove(void* key);
+
+  size_t size() const { return size_.load(std::memory_order_relaxed); }
+  size_t capacity() const {
+    return table_.load(std::memory_order_relaxed)->mask + 1;
+  }
+
+ private:
+  static constexpr uintptr_t kEmptyKey = 0;
+  static constexpr uintptr_t kDeletedKey = 1;
+
+  struct Slot {
+    std::atomic<uintptr_t> key{kEmptyKey};
+    std::atomic<void*> value{nullptr};
+  };
+
+  struct Table {
+    explicit Table(size_t capacity);
+    ~Table();
+
+    const size_t mask;
+    std::unique_ptr<Slot[]> slots;
+    // Slots that are not empty, including tombstones.
+    std::atomic<size_t> used{0};
+  };
+
+  static size_t Hash(uintptr_t key);
+
+  // Returns the slot holding |key| in |table|, or null if there is none.
+  static Slot* FindSlot(const Table* table, uintptr_t key);
+
+  // Adds |key| to |table|, which must not hold it.
+  static void InsertNewKey(Table* table, uintptr_t key, void* value);
+
+  // Registers the calling thread as a writer, waiting for any rebuild.
+  void EnterWriter();
+  void ExitWriter();
+
+  // Rebuilds the table if it is still more than half full.
+  void MaybeRebuild();
+
+  std::atomic<Table*> table_;
+  std::atomic<size_t> size_{0};
+
+  // Odd while the table is being rebuilt. See Contains().
+  std::atomic<uint32_t> sequence_{0};
+
+  // Number of threads running Insert() or Remove(), and whether a rebuild is
+  // waiting for them to finish.
+  std::atomic<int> writers_{0};
+  std::atomic<bool> rebuilding_{false};
+
+  // Held while rebuilding the table.
+  mutable Lock rebuild_lock_;
+  // Owns |table_|.
+  std::unique_ptr<Table> current_table_;
+  // Table of the same size as the current one that a rebuild without growth
+  // reuses. It may be the previous table.
+  std::unique_ptr<Table> spare_table_;
+  // Tables that were outgrown.
+  std::vector<std::unique_ptr<Table>> outgrown_tables_;
+
+  DISALLOW_COPY_AND_ASSIGN(LockFreeAddressHashMap);
+};
+
+}  // namespace base
+
+#endif  // BASE_SAMPLING_HEAP_PROFILER_LOCK_FREE_ADDRESS_HASH_MAP_H_
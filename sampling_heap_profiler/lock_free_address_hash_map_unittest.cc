@@ -0,0 +1,123 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/sampling_heap_profiler/lock_free_address_hash_map.h"
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+void* Address(uintptr_t value) {
+  return reinterpret_cast<void*>(value * 16);
+}
+
+TEST(LockFreeAddressHashMapTest, EmptyMap) {
+  LockFreeAddressHashMap map(8);
+  EXPECT_EQ(0u, map.size());
+  EXPECT_EQ(8u, map.capacity());
+  EXPECT_FALSE(map.Contains(Address(1)));
+  EXPECT_EQ(nullptr, map.Remove(Address(1)));
+}
+
+TEST(LockFreeAddressHashMapTest, BasicOperations) {
+  LockFreeAddressHashMap map(8);
+  EXPECT_EQ(nullptr, map.Insert(Address(1), Address(101)));
+  EXPECT_EQ(nullptr, map.Insert(Address(2), Address(102)));
+  EXPECT_EQ(2u, map.size());
+  EXPECT_TRUE(map.Contains(Address(1)));
+  EXPECT_TRUE(map.Contains(Address(2)));
+  EXPECT_FALSE(map.Contains(Address(3)));
+
+  // Inserting an existing key replaces its value.
+  EXPECT_EQ(Address(101), map.Insert(Address(1), Address(201)));
+  EXPECT_EQ(2u, map.size());
+
+  EXPECT_EQ(Address(201), map.Remove(Address(1)));
+  EXPECT_FALSE(map.Contains(Address(1)));
+  EXPECT_EQ(nullptr, map.Remove(Address(1)));
+  EXPECT_TRUE(map.Contains(Address(2)));
+  EXPECT_EQ(1u, map.size());
+
+  // The slot of a removed key can be reused.
+  EXPECT_EQ(nullptr, map.Insert(Address(1), Address(301)));
+  EXPECT_EQ(Address(301), map.Remove(Address(1)));
+  EXPECT_EQ(Address(102), map.Remove(Address(2)));
+  EXPECT_EQ(0u, map.size());
+}
+
+TEST(LockFreeAddressHashMapTest, Grow) {
+  LockFreeAddressHashMap map(8);
+  constexpr uintptr_t kKeys = 1000;
+  for (uintptr_t i = 1; i <= kKeys; ++i)
+    map.Insert(Address(i), Address(i + kKeys));
+  EXPECT_EQ(kKeys, map.size());
+  EXPECT_GE(map.capacity(), 2 * kKeys);
+  for (uintptr_t i = 1; i <= kKeys; ++i)
+    EXPECT_EQ(Address(i + kKeys), map.Remove(Address(i)));
+  EXPECT_EQ(0u, map.size());
+}
+
+TEST(LockFreeAddressHashMapTest, ChurnDoesNotGrow) {
+  LockFreeAddressHashMap map(64);
+  // Tombstones left by removed keys are dropped without growing the table.
+  for (uintptr_t i = 1; i <= 10000; ++i) {
+    map.Insert(Address(i), Address(i));
+    if (i > 4) {
+      EXPECT_EQ(Address(i - 4), map.Remove(Address(i - 4)));
+    }
+  }
+  EXPECT_EQ(4u, map.size());
+  EXPECT_EQ(64u, map.capacity());
+  for (uintptr_t i = 10000 - 3; i <= 10000; ++i)
+    EXPECT_TRUE(map.Contains(Address(i)));
+}
+
+class WriterThread : public SimpleThread {
+ public:
+  WriterThread(LockFreeAddressHashMap* map, uintptr_t first_key)
+      : SimpleThread("LockFreeAddressHashMapWriter"),
+        map_(map),
+        first_key_(first_key) {}
+
+  void Run() override {
+    constexpr uintptr_t kKeys = 5000;
+    for (uintptr_t i = first_key_; i < first_key_ + kKeys; ++i)
+      map_->Insert(Address(i), Address(i));
+    // Remove every other key, checking the others are still there.
+    for (uintptr_t i = first_key_; i < first_key_ + kKeys; i += 2) {
+      EXPECT_EQ(Address(i), map_->Remove(Address(i)));
+      EXPECT_TRUE(map_->Contains(Address(i + 1)));
+    }
+  }
+
+ private:
+  LockFreeAddressHashMap* map_;
+  uintptr_t first_key_;
+
+  DISALLOW_COPY_AND_ASSIGN(WriterThread);
+};
+
+TEST(LockFreeAddressHashMapTest, ConcurrentWriters) {
+  LockFreeAddressHashMap map(8);
+  std::vector<std::unique_ptr<WriterThread>> threads;
+  for (uintptr_t i = 0; i < 8; ++i) {
+    threads.push_back(std::make_unique<WriterThread>(&map, 1 + i * 100000));
+    threads.back()->Start();
+  }
+  for (auto& thread : threads)
+    thread->Join();
+  EXPECT_EQ(8u * 2500, map.size());
+}
+
+}  // namespace
+
+}  // namespace base
@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <memory>
 #include <utility>
 
 #include "base/allocator/allocator_shim.h"
@@ -17,8 +18,7 @@
 #include "base/no_destructor.h"
 #include "base/partition_alloc_buildflags.h"
 #include "base/rand_util.h"
-#include "base/sampling_heap_profiler/lock_free_address_hash_set.h"
-#include "base/threading/thread_local_storage.h"
+#include "base/stl_util.h"
 #include "build/build_config.h"
 
 #if defined(OS_ANDROID) && BUILDFLAG(CAN_UNWIND_WITH_CFI_TABLE) && \
@@ -40,15 +40,19 @@ const uint32_t kSkipBaseAllocatorFrames = 2;
 
 const size_t kDefaultSamplingIntervalBytes = 128 * 1024;
 
+// Initial capacity of the map of sampled addresses.
+const size_t kInitialSamplesCapacity = 1024;
+
+// A thread's buffer is compacted when it has at least this many samples and
+// more than half of them are freed.
+const size_t kMinSamplesToCompact = 64;
+
 // Controls if sample intervals should not be randomized. Used for testing.
 bool g_deterministic;
 
 // A positive value if profiling is running, otherwise it's zero.
 Atomic32 g_running;
 
-// Pointer to the current |LockFreeAddressHashSet|.
-AtomicWord g_sampled_addresses_set;
-
 // Sampling interval parameter, the mean value for intervals between samples.
 AtomicWord g_sampling_interval = kDefaultSamplingIntervalBytes;
 
@@ -176,22 +180,125 @@ SamplingHeapProfiler::Sample::Sample(const Sample&) = default;
 
 SamplingHeapProfiler::Sample::~Sample() = default;
 
+struct SamplingHeapProfiler::SampleRecord {
+  SampleRecord(const Sample& sample, ThreadSamples* owner)
+      : sample(sample), owner(owner) {}
+
+  // Immutable once the record is added to its buffer.
+  Sample sample;
+  ThreadSamples* const owner;
+  // Set once the allocation is freed, after which only |owner| touches the
+  // record again, to delete it.
+  std::atomic<bool> freed{false};
+};
+
+class SamplingHeapProfiler::ThreadSamples {
+ public:
+  ThreadSamples() = default;
+
+  // Takes ownership of |record|. Called on the thread using the buffer only.
+  void Add(std::unique_ptr<SampleRecord> record) {
+    AutoLock lock(lock_);
+    const size_t freed = freed_count_.load(std::memory_order_relaxed);
+    if (records_.size() >= kMinSamplesToCompact &&
+        freed > records_.size() / 2) {
+      const size_t size_before = records_.size();
+      EraseIf(records_, [](const std::unique_ptr<SampleRecord>& record) {
+        return record->freed.load(std::memory_order_acquire);
+      });
+      freed_count_.fetch_sub(size_before - records_.size(),
+                             std::memory_order_relaxed);
+    }
+    records_.push_back(std::move(record));
+  }
+
+  // Marks |record| of this buffer freed. Called on any thread. |record| must
+  // not be used afterwards.
+  void Release(SampleRecord* record) {
+    DCHECK_EQ(this, record->owner);
+    // Counted first, since the record may be deleted as soon as it is marked.
+    freed_count_.fetch_add(1, std::memory_order_relaxed);
+    record->freed.store(true, std::memory_order_release);
+  }
+
+  // Appends copies of the samples of live allocations recorded after
+  // |profile_id| to |samples|.
+  void AppendSamples(uint32_t profile_id, std::vector<Sample>* samples) {
+    AutoLock lock(lock_);
+    for (const std::unique_ptr<SampleRecord>& record : records_) {
+      if (record->sample.ordinal > profile_id &&
+          !record->freed.load(std::memory_order_acquire)) {
+        samples->push_back(record->sample);
+      }
+    }
+  }
+
+  // Links of SamplingHeapProfiler's lists, guarded by its |mutex_|.
+  ThreadSamples* next = nullptr;
+  ThreadSamples* next_orphan = nullptr;
+
+ private:
+  // Only contended by GetSamples().
+  Lock lock_;
+  std::vector<std::unique_ptr<SampleRecord>> records_;
+  // Number of records in |records_| that may be marked freed.
+  std::atomic<size_t> freed_count_{0};
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadSamples);
+};
+
 SamplingHeapProfiler* SamplingHeapProfiler::instance_;
 
-SamplingHeapProfiler::SamplingHeapProfiler() {
+SamplingHeapProfiler::SamplingHeapProfiler()
+    : samples_(kInitialSamplesCapacity) {
   instance_ = this;
-  auto sampled_addresses = std::make_unique<LockFreeAddressHashSet>(64);
-  base::subtle::NoBarrier_Store(
-      &g_sampled_addresses_set,
-      reinterpret_cast<AtomicWord>(sampled_addresses.get()));
-  sampled_addresses_stack_.push(std::move(sampled_addresses));
 }
 
 // static
 void SamplingHeapProfiler::InitTLSSlot() {
-  // Preallocate the TLS slot early, so it can't cause reentracy issues
+  // Preallocate the TLS slots early, so they can't cause reentracy issues
   // when sampling is started.
   ignore_result(AccumulatedBytesTLS().Get());
+  ignore_result(ThreadSamplesTLS().Get());
+}
+
+// static
+ThreadLocalStorage::Slot& SamplingHeapProfiler::ThreadSamplesTLS() {
+  static base::NoDestructor<base::ThreadLocalStorage::Slot> thread_samples_tls(
+      &SamplingHeapProfiler::OnThreadExit);
+  return *thread_samples_tls;
+}
+
+// static
+void SamplingHeapProfiler::OnThreadExit(void* thread_samples) {
+  // Samples of the thread stay alive until their allocations are freed, so
+  // leave them to the next thread that starts sampling. This must not
+  // allocate: allocations would be recorded into a new buffer under |mutex_|.
+  auto* samples = static_cast<ThreadSamples*>(thread_samples);
+  base::AutoLock lock(instance_->mutex_);
+  samples->next_orphan = instance_->orphaned_thread_samples_;
+  instance_->orphaned_thread_samples_ = samples;
+}
+
+SamplingHeapProfiler::ThreadSamples* SamplingHeapProfiler::GetThreadSamples() {
+  ThreadLocalStorage::Slot& slot = ThreadSamplesTLS();
+  auto* thread_samples = static_cast<ThreadSamples*>(slot.Get());
+  if (LIKELY(thread_samples))
+    return thread_samples;
+  {
+    base::AutoLock lock(mutex_);
+    if (orphaned_thread_samples_) {
+      thread_samples = orphaned_thread_samples_;
+      orphaned_thread_samples_ = thread_samples->next_orphan;
+      thread_samples->next_orphan = nullptr;
+    } else {
+      thread_samples = new ThreadSamples();
+      thread_samples->next = thread_samples_;
+      thread_samples_ = thread_samples;
+    }
+  }
+  slot.Set(thread_samples);
+  return thread_samples;
 }
 
 // static
@@ -246,7 +353,7 @@ uint32_t SamplingHeapProfiler::Start() {
 #endif
   InstallAllocatorHooksOnce();
   base::subtle::Barrier_AtomicIncrement(&g_running, 1);
-  return last_sample_ordinal_;
+  return last_sample_ordinal_.load(std::memory_order_relaxed);
 }
 
 void SamplingHeapProfiler::Stop() {
@@ -358,17 +465,25 @@ void SamplingHeapProfiler::DoRecordAlloc(size_t total_allocated,
     return;
   entered_.Set(true);
   {
-    base::AutoLock lock(mutex_);
-    Sample sample(size, total_allocated, ++last_sample_ordinal_);
-    RecordStackTrace(&sample, skip_frames);
-    for (auto* observer : observers_)
-      observer->SampleAdded(sample.ordinal, size, total_allocated);
-    samples_.emplace(address, std::move(sample));
+    uint32_t ordinal =
+        last_sample_ordinal_.fetch_add(1, std::memory_order_relaxed) + 1;
+    ThreadSamples* thread_samples = GetThreadSamples();
+    auto record = std::make_unique<SampleRecord>(
+        Sample(size, total_allocated, ordinal), thread_samples);
+    RecordStackTrace(&record->sample, skip_frames);
+    if (UNLIKELY(has_observers_.load(std::memory_order_relaxed))) {
+      base::AutoLock lock(mutex_);
+      for (auto* observer : observers_)
+        observer->SampleAdded(ordinal, size, total_allocated);
+    }
+    SampleRecord* record_ptr = record.get();
+    thread_samples->Add(std::move(record));
     // TODO(alph): Sometimes RecordAlloc is called twice in a row without
     // a RecordFree in between. Investigate it.
-    if (!sampled_addresses_set().Contains(address))
-      sampled_addresses_set().Insert(address);
-    BalanceAddressesHashSet();
+    auto* replaced =
+        static_cast<SampleRecord*>(samples_.Insert(address, record_ptr));
+    if (replaced)
+      ReleaseRecord(replaced);
   }
   entered_.Set(false);
 }
@@ -377,7 +492,7 @@ void SamplingHeapProfiler::DoRecordAlloc(size_t total_allocated,
 void SamplingHeapProfiler::RecordFree(void* address) {
   if (UNLIKELY(address == nullptr))
     return;
-  if (UNLIKELY(sampled_addresses_set().Contains(address)))
+  if (UNLIKELY(instance_->samples_.Contains(address)))
     instance_->DoRecordFree(address);
 }
 
@@ -388,44 +503,20 @@ void SamplingHeapProfiler::DoRecordFree(void* address) {
     return;
   entered_.Set(true);
   {
-    base::AutoLock lock(mutex_);
-    auto it = samples_.find(address);
-    CHECK(it != samples_.end());
-    for (auto* observer : observers_)
-      observer->SampleRemoved(it->second.ordinal);
-    samples_.erase(it);
-    sampled_addresses_set().Remove(address);
+    auto* record = static_cast<SampleRecord*>(samples_.Remove(address));
+    if (record)
+      ReleaseRecord(record);
   }
   entered_.Set(false);
 }
 
-void SamplingHeapProfiler::BalanceAddressesHashSet() {
-  // Check if the load_factor of the current addresses hash set becomes higher
-  // than 1, allocate a new twice larger one, copy all the data,
-  // and switch to using it.
-  // During the copy process no other writes are made to both sets
-  // as it's behind the lock.
-  // All the readers continue to use the old one until the atomic switch
-  // process takes place.
-  LockFreeAddressHashSet& current_set = sampled_addresses_set();
-  if (current_set.load_factor() < 1)
-    return;
-  auto new_set =
-      std::make_unique<LockFreeAddressHashSet>(current_set.buckets_count() * 2);
-  new_set->Copy(current_set);
-  // Atomically switch all the new readers to the new set.
-  base::subtle::Release_Store(&g_sampled_addresses_set,
-                              reinterpret_cast<AtomicWord>(new_set.get()));
-  // We still have to keep all the old maps alive to resolve the theoretical
-  // race with readers in |RecordFree| that have already obtained the map,
-  // but haven't yet managed to access it.
-  sampled_addresses_stack_.push(std::move(new_set));
-}
-
-// static
-LockFreeAddressHashSet& SamplingHeapProfiler::sampled_addresses_set() {
-  return *reinterpret_cast<LockFreeAddressHashSet*>(
-      base::subtle::NoBarrier_Load(&g_sampled_addresses_set));
+void SamplingHeapProfiler::ReleaseRecord(SampleRecord* record) {
+  if (UNLIKELY(has_observers_.load(std::memory_order_relaxed))) {
+    base::AutoLock lock(mutex_);
+    for (auto* observer : observers_)
+      observer->SampleRemoved(record->sample.ordinal);
+  }
+  record->owner->Release(record);
 }
 
 // static
@@ -445,6 +536,7 @@ void SamplingHeapProfiler::AddSamplesObserver(SamplesObserver* observer) {
   {
     base::AutoLock lock(mutex_);
     observers_.push_back(observer);
+    has_observers_.store(true, std::memory_order_relaxed);
   }
   entered_.Set(false);
 }
@@ -457,6 +549,7 @@ void SamplingHeapProfiler::RemoveSamplesObserver(SamplesObserver* observer) {
     auto it = std::find(observers_.begin(), observers_.end(), observer);
     CHECK(it != observers_.end());
     observers_.erase(it);
+    has_observers_.store(!observers_.empty(), std::memory_order_relaxed);
   }
   entered_.Set(false);
 }
@@ -468,10 +561,9 @@ std::vector<SamplingHeapProfiler::Sample> SamplingHeapProfiler::GetSamples(
   std::vector<Sample> samples;
   {
     base::AutoLock lock(mutex_);
-    for (auto& it : samples_) {
-      Sample& sample = it.second;
-      if (sample.ordinal > profile_id)
-        samples.push_back(sample);
+    for (ThreadSamples* thread_samples = thread_samples_; thread_samples;
+         thread_samples = thread_samples->next) {
+      thread_samples->AppendSamples(profile_id, &samples);
     }
   }
   entered_.Set(false);
@@ -5,28 +5,32 @@
 #ifndef BASE_SAMPLING_HEAP_PROFILER_SAMPLING_HEAP_PROFILER_H_
 #define BASE_SAMPLING_HEAP_PROFILER_SAMPLING_HEAP_PROFILER_H_
 
-#include <memory>
-#include <stack>
-#include <unordered_map>
+#include <atomic>
 #include <vector>
 
 #include "base/base_export.h"
 #include "base/macros.h"
+#include "base/sampling_heap_profiler/lock_free_address_hash_map.h"
 #include "base/synchronization/lock.h"
 #include "base/threading/thread_local.h"
+#include "base/threading/thread_local_storage.h"
 
 namespace base {
 
 template <typename T>
 class NoDestructor;
 
-class LockFreeAddressHashSet;
-
 // The class implements sampling profiling of native memory heap.
 // It hooks on base::allocator and base::PartitionAlloc.
 // When started it selects and records allocation samples based on
 // the sampling_interval parameter.
 // The recorded samples can then be retrieved using GetSamples method.
+//
+// Recording samples takes no lock shared between threads: each thread adds
+// its samples to its own buffer, and the sampled addresses are kept in a
+// LockFreeAddressHashMap, so that any thread can find and release a sample
+// when the allocation is freed. GetSamples merges the buffers of all threads.
+// Observers, when there are any, are notified under a lock.
 class BASE_EXPORT SamplingHeapProfiler {
  public:
   class BASE_EXPORT Sample {
@@ -90,22 +94,43 @@ class BASE_EXPORT SamplingHeapProfiler {
   static bool InstallAllocatorHooks();
   static size_t GetNextSampleInterval(size_t base_interval);
 
+  // A sample of a live allocation, owned by the ThreadSamples of the thread
+  // that allocated it.
+  struct SampleRecord;
+  // Buffer of the samples recorded on a thread.
+  class ThreadSamples;
+
   void DoRecordAlloc(size_t total_allocated,
                      size_t allocation_size,
                      void* address,
                      uint32_t skip_frames);
   void DoRecordFree(void* address);
   void RecordStackTrace(Sample*, uint32_t skip_frames);
-  static LockFreeAddressHashSet& sampled_addresses_set();
 
-  void BalanceAddressesHashSet();
+  // Releases |record|, whose allocation was freed, notifying observers.
+  void ReleaseRecord(SampleRecord* record);
+
+  // Returns the buffer of the current thread, creating it if needed.
+  ThreadSamples* GetThreadSamples();
+  static ThreadLocalStorage::Slot& ThreadSamplesTLS();
+  static void OnThreadExit(void* thread_samples);
 
   base::ThreadLocalBoolean entered_;
+
+  // Guards |observers_| and the lists of ThreadSamples, and serializes
+  // notifications.
   base::Lock mutex_;
-  std::stack<std::unique_ptr<LockFreeAddressHashSet>> sampled_addresses_stack_;
-  std::unordered_map<void*, Sample> samples_;
   std::vector<SamplesObserver*> observers_;
-  uint32_t last_sample_ordinal_ = 1;
+  std::atomic<bool> has_observers_{false};
+  // All buffers, linked through ThreadSamples::next. Buffers are never freed,
+  // since other threads may release their samples at any time.
+  ThreadSamples* thread_samples_ = nullptr;
+  // Buffers of exited threads, which new threads reuse.
+  ThreadSamples* orphaned_thread_samples_ = nullptr;
+
+  // Maps sampled addresses to their SampleRecord.
+  LockFreeAddressHashMap samples_;
+  std::atomic<uint32_t> last_sample_ordinal_{1};
 
   static SamplingHeapProfiler* instance_;
 
@@ -5,7 +5,9 @@
 #include "base/sampling_heap_profiler/sampling_heap_profiler.h"
 
 #include <stdlib.h>
+#include <algorithm>
 #include <cinttypes>
+#include <vector>
 
 #include "base/allocator/allocator_shim.h"
 #include "base/debug/alias.h"
@@ -62,6 +64,58 @@ TEST_F(SamplingHeapProfilerTest, CollectSamples) {
   CHECK(collector.sample_removed);
 }
 
+// Allocates blocks of |size| bytes and leaves them allocated.
+class AllocatingThread : public SimpleThread {
+ public:
+  AllocatingThread(size_t size, size_t count)
+      : SimpleThread("AllocatingThread"), size_(size) {
+    blocks_.reserve(count);
+  }
+
+  void Run() override {
+    while (blocks_.size() < blocks_.capacity())
+      blocks_.push_back(malloc(size_));
+  }
+
+  const std::vector<void*>& blocks() const { return blocks_; }
+
+ private:
+  const size_t size_;
+  std::vector<void*> blocks_;
+};
+
+size_t CountSamplesOfSize(
+    const std::vector<SamplingHeapProfiler::Sample>& samples,
+    size_t size) {
+  return std::count_if(samples.begin(), samples.end(),
+                       [size](const SamplingHeapProfiler::Sample& sample) {
+                         return sample.size == size;
+                       });
+}
+
+TEST_F(SamplingHeapProfilerTest, SamplesOfExitedThread) {
+  const size_t kSize = 3333;
+  const size_t kCount = 100;
+  SamplingHeapProfiler::InitTLSSlot();
+  SamplingHeapProfiler* profiler = SamplingHeapProfiler::GetInstance();
+  profiler->SuppressRandomnessForTest(true);
+  profiler->SetSamplingInterval(1024);
+  uint32_t id = profiler->Start();
+
+  // Allocations larger than the sampling interval are all sampled. They stay
+  // live after their thread exits.
+  AllocatingThread thread(kSize, kCount);
+  thread.Start();
+  thread.Join();
+  EXPECT_EQ(kCount, CountSamplesOfSize(profiler->GetSamples(id), kSize));
+
+  // Freeing them on another thread releases the samples.
+  for (void* block : thread.blocks())
+    free(block);
+  EXPECT_EQ(0u, CountSamplesOfSize(profiler->GetSamples(id), kSize));
+  profiler->Stop();
+}
+
 const int kNumberOfAllocations = 10000;
 
 NOINLINE void Allocate1() {
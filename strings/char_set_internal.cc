@@ -0,0 +1,147 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/strings/char_set_internal.h"
+
+#include <string.h>
+
+#include "base/bits.h"
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_FAMILY)
+#include <tmmintrin.h>
+
+#include "base/cpu.h"
+
+// Lets a function use SSSE3 instructions without building the whole file for
+// SSSE3. The caller checks that the CPU supports them.
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#else
+#define TARGET_SSSE3
+#endif
+#endif  // defined(ARCH_CPU_X86_FAMILY)
+
+namespace base {
+namespace internal {
+
+namespace {
+
+// Returns the position of the first character of |data| at or after |pos|
+// whose membership in |bitmap| (see CharSet::bitmap_) differs from |negate|,
+// or StringPiece::npos.
+using FindFunction = size_t (*)(const uint8_t* bitmap,
+                                const char* data,
+                                size_t size,
+                                size_t pos,
+                                bool negate);
+
+size_t FindPortable(const uint8_t* bitmap,
+                    const char* data,
+                    size_t size,
+                    size_t pos,
+                    bool negate) {
+  for (; pos < size; ++pos) {
+    const uint8_t byte = static_cast<uint8_t>(data[pos]);
+    const bool in_set =
+        (bitmap[(byte >> 7) * 16 + (byte & 15)] >> ((byte >> 4) & 7)) & 1;
+    if (in_set != negate)
+      return pos;
+  }
+  return StringPiece::npos;
+}
+
+#if defined(ARCH_CPU_X86_FAMILY)
+// Tests 16 characters at a time, by looking up the row of the bitmap for their
+// low 4 bits with PSHUFB, then the bit for their high 4 bits in that row
+// (Wojciech Mula, "SIMD-ized searching for a set of bytes").
+TARGET_SSSE3 size_t FindSsse3(const uint8_t* bitmap,
+                              const char* data,
+                              size_t size,
+                              size_t pos,
+                              bool negate) {
+  const __m128i low_bitmap =
+      _mm_load_si128(reinterpret_cast<const __m128i*>(bitmap));
+  const __m128i high_bitmap =
+      _mm_load_si128(reinterpret_cast<const __m128i*>(bitmap + 16));
+  const __m128i bit_for_row = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2,
+                                            4, 8, 16, 32, 64, -128);
+  const __m128i low_nibble_mask = _mm_set1_epi8(0x0f);
+  const __m128i zero = _mm_setzero_si128();
+  // The loop computes a mask of the characters that are not in the set.
+  const unsigned flip = negate ? 0 : 0xffff;
+
+  for (; pos + 16 <= size; pos += 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+    const __m128i low = _mm_and_si128(chunk, low_nibble_mask);
+    const __m128i high =
+        _mm_and_si128(_mm_srli_epi16(chunk, 4), low_nibble_mask);
+    const __m128i top_bit_set = _mm_cmplt_epi8(chunk, zero);
+    const __m128i row = _mm_or_si128(
+        _mm_andnot_si128(top_bit_set, _mm_shuffle_epi8(low_bitmap, low)),
+        _mm_and_si128(top_bit_set, _mm_shuffle_epi8(high_bitmap, low)));
+    const __m128i not_in_set = _mm_cmpeq_epi8(
+        _mm_and_si128(row, _mm_shuffle_epi8(bit_for_row, high)), zero);
+    const unsigned matches =
+        static_cast<unsigned>(_mm_movemask_epi8(not_in_set)) ^ flip;
+    if (matches)
+      return pos + bits::CountTrailingZeroBits(matches);
+  }
+  return FindPortable(bitmap, data, size, pos, negate);
+}
+#endif  // defined(ARCH_CPU_X86_FAMILY)
+
+FindFunction GetFindFunction() {
+#if defined(ARCH_CPU_X86_FAMILY)
+  if (CPU().has_ssse3())
+    return &FindSsse3;
+#endif
+  return &FindPortable;
+}
+
+size_t Find(const uint8_t* bitmap,
+            StringPiece input,
+            size_t pos,
+            bool negate) {
+  static const FindFunction find = GetFindFunction();
+  return find(bitmap, input.data(), input.size(), pos, negate);
+}
+
+}  // namespace
+
+CharSet::CharSet(StringPiece chars)
+    : bitmap_(), is_single_char_(false), single_char_(0) {
+  int size = 0;
+  for (char c : chars) {
+    if (Contains(c))
+      continue;
+    const uint8_t byte = static_cast<uint8_t>(c);
+    bitmap_[(byte >> 7) * 16 + (byte & 15)] |= 1 << ((byte >> 4) & 7);
+    single_char_ = c;
+    ++size;
+  }
+  is_single_char_ = size == 1;
+}
+
+size_t CharSet::FindFirstIn(StringPiece input, size_t pos) const {
+  if (pos >= input.size())
+    return StringPiece::npos;
+  if (is_single_char_) {
+    const void* found =
+        memchr(input.data() + pos, single_char_, input.size() - pos);
+    return found ? static_cast<const char*>(found) - input.data()
+                 : StringPiece::npos;
+  }
+  return Find(bitmap_, input, pos, false);
+}
+
+size_t CharSet::FindFirstNotIn(StringPiece input, size_t pos) const {
+  if (pos >= input.size())
+    return StringPiece::npos;
+  return Find(bitmap_, input, pos, true);
+}
+
+}  // namespace internal
+}  // namespace base
@@ -0,0 +1,51 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_STRINGS_CHAR_SET_INTERNAL_H_
+#define BASE_STRINGS_CHAR_SET_INTERNAL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "base/base_export.h"
+#include "base/strings/string_piece.h"
+
+namespace base {
+namespace internal {
+
+// A set of 8-bit characters, precomputed once so that it can be searched for
+// repeatedly, as StringPiece::find_first_of() and SplitStringPiece() do.
+// Searches use SSSE3 when the CPU has it, and memchr() for sets of one
+// character.
+class BASE_EXPORT CharSet {
+ public:
+  explicit CharSet(StringPiece chars);
+
+  bool Contains(char c) const {
+    const uint8_t byte = static_cast<uint8_t>(c);
+    return (bitmap_[(byte >> 7) * 16 + (byte & 15)] >> ((byte >> 4) & 7)) & 1;
+  }
+
+  // Returns the position of the first character of |input| at or after |pos|
+  // that is in the set (or, for FindFirstNotIn(), that isn't), or
+  // StringPiece::npos.
+  size_t FindFirstIn(StringPiece input, size_t pos) const;
+  size_t FindFirstNotIn(StringPiece input, size_t pos) const;
+
+ private:
+  // The set as 256 bits, laid out for a 16-byte table lookup on the low 4 bits
+  // of a character: bit h of bitmap_[l] is set if (h << 4 | l) is in the set,
+  // and bitmap_[16 + l] does the same for the characters with the top bit
+  // set.
+  alignas(16) uint8_t bitmap_[32];
+
+  // Set when the set holds exactly one character, |single_char_|.
+  bool is_single_char_;
+  char single_char_;
+};
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_STRINGS_CHAR_SET_INTERNAL_H_
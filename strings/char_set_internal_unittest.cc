@@ -0,0 +1,91 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/strings/char_set_internal.h"
+
+#include <stddef.h>
+
+#include <string>
+
+#include "base/rand_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+size_t NaiveFind(StringPiece input, StringPiece chars, size_t pos, bool in) {
+  for (; pos < input.size(); ++pos) {
+    if ((chars.find(input[pos]) != StringPiece::npos) == in)
+      return pos;
+  }
+  return StringPiece::npos;
+}
+
+}  // namespace
+
+TEST(CharSetTest, Contains) {
+  CharSet set("a,\x80\xff");
+  EXPECT_TRUE(set.Contains('a'));
+  EXPECT_TRUE(set.Contains(','));
+  EXPECT_TRUE(set.Contains('\x80'));
+  EXPECT_TRUE(set.Contains('\xff'));
+  EXPECT_FALSE(set.Contains('b'));
+  EXPECT_FALSE(set.Contains('A'));
+  EXPECT_FALSE(set.Contains('\0'));
+  EXPECT_FALSE(set.Contains('\x7f'));
+
+  CharSet empty("");
+  for (int c = 0; c < 256; ++c)
+    EXPECT_FALSE(empty.Contains(static_cast<char>(c)));
+}
+
+TEST(CharSetTest, Find) {
+  EXPECT_EQ(3u, CharSet(",;").FindFirstIn("abc;d,", 0));
+  EXPECT_EQ(5u, CharSet(",;").FindFirstIn("abc;d,", 4));
+  EXPECT_EQ(StringPiece::npos, CharSet(",;").FindFirstIn("abc;d,", 6));
+  EXPECT_EQ(StringPiece::npos, CharSet(",;").FindFirstIn("abcd", 0));
+  EXPECT_EQ(2u, CharSet("aa").FindFirstIn("bba", 0));
+  EXPECT_EQ(StringPiece::npos, CharSet("").FindFirstIn("abc", 0));
+
+  EXPECT_EQ(2u, CharSet(" \t").FindFirstNotIn(" \tx ", 0));
+  EXPECT_EQ(StringPiece::npos, CharSet(" \t").FindFirstNotIn(" \tx ", 3));
+  EXPECT_EQ(0u, CharSet("").FindFirstNotIn("abc", 0));
+}
+
+// Compares with a naive search at every offset, for inputs long enough to use
+// the vectorized search and sets of every size.
+TEST(CharSetTest, MatchesNaiveSearch) {
+  for (size_t set_size = 1; set_size <= 40; set_size += 3) {
+    std::string chars;
+    for (size_t i = 0; i < set_size; ++i)
+      chars.push_back(static_cast<char>(RandInt(0, 255)));
+    const CharSet set(chars);
+
+    // Characters are rarely in the set, so that matches are found at all
+    // positions of a vector.
+    std::string input;
+    for (size_t i = 0; i < 100; ++i) {
+      input.push_back(RandInt(0, 20) == 0 ? chars[RandInt(0, set_size - 1)]
+                                          : static_cast<char>(RandInt(0, 255)));
+    }
+    for (size_t pos = 0; pos <= input.size(); ++pos) {
+      EXPECT_EQ(NaiveFind(input, chars, pos, true),
+                set.FindFirstIn(input, pos));
+      EXPECT_EQ(NaiveFind(input, chars, pos, false),
+                set.FindFirstNotIn(input, pos));
+    }
+
+    std::string all_in(50, chars[0]);
+    EXPECT_EQ(StringPiece::npos, set.FindFirstNotIn(all_in, 0));
+    all_in.push_back(chars.back());
+    all_in.push_back('\x01');
+    EXPECT_EQ(NaiveFind(all_in, chars, 0, false),
+              set.FindFirstNotIn(all_in, 0));
+  }
+}
+
+}  // namespace internal
+}  // namespace base
@@ -0,0 +1,619 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/strings/compiled_pattern_set.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <utility>
+
+#include "base/logging.h"
+#include "base/strings/string_util.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+bool IsContinuationByte(uint8_t byte) {
+  return (byte & 0xc0) == 0x80;
+}
+
+}  // namespace
+
+// A set of patterns, compiled into a non-deterministic automaton over bytes,
+// then into a deterministic one unless it would be too large.
+//
+// The non-deterministic automaton is a trie of the patterns' tokens, so that
+// patterns share the states of their common prefixes. In particular, all the
+// patterns that start with * share a single looping state, and the states of
+// the deterministic automaton stay small however many such patterns there
+// are.
+//
+// Wildcards work on UTF-8 characters: a character is a byte that isn't a
+// continuation byte, followed by any continuation bytes. As in MatchPattern(),
+// invalid UTF-8 is matched on a best effort basis.
+class PatternAutomaton {
+ public:
+  enum class TokenType {
+    kLiteral,
+    kAnyCharOrNone,
+    kAnyChars,
+    // Matches nothing, so that the pattern can't match.
+    kNever,
+  };
+
+  struct Token {
+    TokenType type;
+    uint8_t byte;
+  };
+
+  // When several patterns match, the one with the lowest |priorities| value
+  // is reported.
+  PatternAutomaton(const std::vector<std::vector<Token>>& patterns,
+                   const std::vector<size_t>& priorities);
+
+  // Parses |pattern|, which has the syntax of MatchPattern().
+  static std::vector<Token> ParsePattern(StringPiece pattern);
+
+  // Returns the index of the pattern that matches the whole of |string|, or
+  // CompiledPatternSet::kNoMatch.
+  size_t Match(StringPiece string) const;
+
+  bool is_deterministic() const { return !dfa_accepted_.empty(); }
+
+ private:
+  // The deterministic automaton, when there is one. Once in kDeadState, no
+  // pattern can match.
+  static constexpr int kDeadState = 0;
+  static constexpr int kStartState = 1;
+
+  // The start of the non-deterministic automaton, the root of the trie.
+  static constexpr int kNfaRoot = 0;
+
+  struct NfaState {
+    enum class Kind {
+      kAny,           // Consumes any byte.
+      kLeadByte,      // Consumes a byte that starts a character.
+      kContinuation,  // Consumes a continuation byte.
+      kNone,          // Consumes nothing but the bytes of |literals|.
+    };
+
+    // The transition that consumes a byte other than those of |literals|.
+    Kind kind = Kind::kNone;
+    int target = -1;
+    // Pairs of a byte and the state it leads to, sorted by byte.
+    std::vector<std::pair<uint8_t, int>> literals;
+    // The states reached without consuming a byte.
+    std::vector<int> epsilons;
+    // The pattern that matched when in this state.
+    size_t pattern = CompiledPatternSet::kNoMatch;
+  };
+
+  int AddNfaState(NfaState::Kind kind);
+
+  // Returns the state reached from |state| by |token|, adding it to the trie
+  // if there isn't one yet.
+  int GetOrAddChild(int state, const Token& token);
+
+  // Adds |state| and the states reachable from it without consuming a byte to
+  // |states|, unless already in |in_set|.
+  void AddWithClosure(int state,
+                      std::vector<int>* states,
+                      std::vector<bool>* in_set) const;
+
+  // Sets |to| to the states reached from |from| by consuming a byte of class
+  // |byte_class|.
+  void Step(const std::vector<int>& from,
+            int byte_class,
+            std::vector<int>* to,
+            std::vector<bool>* in_set) const;
+
+  // Returns the pattern accepted by |states|, or kNoMatch.
+  size_t GetAccepted(const std::vector<int>& states) const;
+
+  // Builds the deterministic automaton by subset construction, unless it has
+  // more than |max_states| states or takes too long to build.
+  void BuildDfa(size_t max_states);
+
+  int Next(int state, char c) const {
+    return dfa_transitions_[state * num_classes_ +
+                            byte_classes_[static_cast<uint8_t>(c)]];
+  }
+
+  std::vector<NfaState> nfa_;
+  std::vector<size_t> priorities_;
+
+  // Bytes that no pattern tells apart share a class.
+  uint8_t byte_classes_[256];
+  int num_classes_ = 0;
+  // Whether the bytes of each class are continuation bytes.
+  std::vector<bool> class_is_continuation_;
+  // The byte of each class that has a single literal byte, or -1.
+  std::vector<int> class_literal_;
+
+  // Indexed by |state| * |num_classes_| + byte class.
+  std::vector<int> dfa_transitions_;
+  std::vector<size_t> dfa_accepted_;
+
+  DISALLOW_COPY_AND_ASSIGN(PatternAutomaton);
+};
+
+constexpr int PatternAutomaton::kDeadState;
+constexpr int PatternAutomaton::kStartState;
+constexpr int PatternAutomaton::kNfaRoot;
+
+// Large enough for any reasonable set of patterns, while keeping the tables
+// of pathological ones to a few megabytes.
+constexpr size_t kMinMaxDfaStates = 4096;
+
+// Bounds the time spent building the deterministic automaton, counted in NFA
+// states stepped, for sets that have fewer states but large ones.
+constexpr size_t kMaxDfaBuildSteps = 1 << 25;
+
+PatternAutomaton::PatternAutomaton(
+    const std::vector<std::vector<Token>>& patterns,
+    const std::vector<size_t>& priorities)
+    : priorities_(priorities) {
+  DCHECK_EQ(patterns.size(), priorities.size());
+
+  // Each literal byte gets a class of its own. The other bytes only need to
+  // be told apart by whether they are continuation bytes.
+  bool is_literal[256] = {};
+  for (const std::vector<Token>& pattern : patterns) {
+    for (const Token& token : pattern) {
+      if (token.type == TokenType::kLiteral)
+        is_literal[token.byte] = true;
+    }
+  }
+  int other_classes[2] = {-1, -1};
+  for (int byte = 0; byte < 256; ++byte) {
+    const bool is_continuation = IsContinuationByte(byte);
+    int byte_class = is_literal[byte] ? -1 : other_classes[is_continuation];
+    if (byte_class == -1) {
+      byte_class = num_classes_++;
+      class_is_continuation_.push_back(is_continuation);
+      class_literal_.push_back(is_literal[byte] ? byte : -1);
+      if (!is_literal[byte])
+        other_classes[is_continuation] = byte_class;
+    }
+    byte_classes_[byte] = static_cast<uint8_t>(byte_class);
+  }
+
+  AddNfaState(NfaState::Kind::kNone);
+  for (size_t i = 0; i < patterns.size(); ++i) {
+    const bool never_matches =
+        std::any_of(patterns[i].begin(), patterns[i].end(),
+                    [](const Token& token) {
+                      return token.type == TokenType::kNever;
+                    });
+    if (never_matches)
+      continue;
+
+    int current = kNfaRoot;
+    for (const Token& token : patterns[i])
+      current = GetOrAddChild(current, token);
+    size_t& pattern = nfa_[current].pattern;
+    if (pattern == CompiledPatternSet::kNoMatch ||
+        priorities_[i] < priorities_[pattern]) {
+      pattern = i;
+    }
+  }
+
+  BuildDfa(std::max(kMinMaxDfaStates, 4 * nfa_.size()));
+}
+
+// static
+std::vector<PatternAutomaton::Token> PatternAutomaton::ParsePattern(
+    StringPiece pattern) {
+  // As with MatchPattern(), invalid characters don't match anything.
+  if (!IsStringUTF8(pattern))
+    return {{TokenType::kNever, 0}};
+
+  std::vector<Token> tokens;
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    const uint8_t byte = static_cast<uint8_t>(pattern[i]);
+    if (byte == '*') {
+      tokens.push_back({TokenType::kAnyChars, 0});
+    } else if (byte == '?') {
+      tokens.push_back({TokenType::kAnyCharOrNone, 0});
+    } else if (byte == '\\') {
+      // Escapes the next character. The continuation bytes of a multibyte
+      // character are literals anyway. A trailing backslash is ignored.
+      if (++i < pattern.size()) {
+        tokens.push_back(
+            {TokenType::kLiteral, static_cast<uint8_t>(pattern[i])});
+      }
+    } else {
+      tokens.push_back({TokenType::kLiteral, byte});
+    }
+  }
+  return tokens;
+}
+
+size_t PatternAutomaton::Match(StringPiece string) const {
+  if (is_deterministic()) {
+    int state = kStartState;
+    for (char c : string) {
+      state = Next(state, c);
+      if (state == kDeadState)
+        return CompiledPatternSet::kNoMatch;
+    }
+    return dfa_accepted_[state];
+  }
+
+  std::vector<bool> in_set(nfa_.size());
+  std::vector<int> states;
+  AddWithClosure(kNfaRoot, &states, &in_set);
+  std::vector<int> next_states;
+  for (char c : string) {
+    for (int state : states)
+      in_set[state] = false;
+    Step(states, byte_classes_[static_cast<uint8_t>(c)], &next_states,
+         &in_set);
+    states.swap(next_states);
+    if (states.empty())
+      return CompiledPatternSet::kNoMatch;
+  }
+  return GetAccepted(states);
+}
+
+int PatternAutomaton::AddNfaState(NfaState::Kind kind) {
+  nfa_.emplace_back();
+  nfa_.back().kind = kind;
+  return static_cast<int>(nfa_.size() - 1);
+}
+
+int PatternAutomaton::GetOrAddChild(int state, const Token& token) {
+  switch (token.type) {
+    case TokenType::kLiteral: {
+      const std::vector<std::pair<uint8_t, int>>& literals =
+          nfa_[state].literals;
+      auto it = std::lower_bound(literals.begin(), literals.end(),
+                                 std::make_pair(token.byte, -1));
+      if (it != literals.end() && it->first == token.byte)
+        return it->second;
+      // Adding a state invalidates |literals|.
+      const size_t index = it - literals.begin();
+      const int child = AddNfaState(NfaState::Kind::kNone);
+      nfa_[state].literals.emplace(nfa_[state].literals.begin() + index,
+                                   token.byte, child);
+      return child;
+    }
+    case TokenType::kAnyChars: {
+      // A state that loops on any byte.
+      for (int epsilon : nfa_[state].epsilons) {
+        if (nfa_[epsilon].kind == NfaState::Kind::kAny)
+          return epsilon;
+      }
+      const int child = AddNfaState(NfaState::Kind::kAny);
+      nfa_[child].target = child;
+      nfa_[state].epsilons.push_back(child);
+      return child;
+    }
+    case TokenType::kAnyCharOrNone: {
+      // A state that consumes a lead byte, then the continuation bytes after
+      // it, with a way around both to the next state.
+      for (int epsilon : nfa_[state].epsilons) {
+        if (nfa_[epsilon].kind == NfaState::Kind::kLeadByte)
+          return nfa_[epsilon].epsilons[0];
+      }
+      const int lead_byte = AddNfaState(NfaState::Kind::kLeadByte);
+      const int in_char = AddNfaState(NfaState::Kind::kContinuation);
+      const int next = AddNfaState(NfaState::Kind::kNone);
+      nfa_[lead_byte].target = in_char;
+      nfa_[lead_byte].epsilons.push_back(next);
+      nfa_[in_char].target = in_char;
+      nfa_[in_char].epsilons.push_back(next);
+      nfa_[state].epsilons.push_back(lead_byte);
+      return next;
+    }
+    case TokenType::kNever:
+      break;
+  }
+  NOTREACHED();
+  return state;
+}
+
+void PatternAutomaton::AddWithClosure(int state,
+                                      std::vector<int>* states,
+                                      std::vector<bool>* in_set) const {
+  if ((*in_set)[state])
+    return;
+  size_t i = states->size();
+  (*in_set)[state] = true;
+  states->push_back(state);
+  for (; i < states->size(); ++i) {
+    for (int epsilon : nfa_[(*states)[i]].epsilons) {
+      if (!(*in_set)[epsilon]) {
+        (*in_set)[epsilon] = true;
+        states->push_back(epsilon);
+      }
+    }
+  }
+}
+
+void PatternAutomaton::Step(const std::vector<int>& from,
+                            int byte_class,
+                            std::vector<int>* to,
+                            std::vector<bool>* in_set) const {
+  to->clear();
+  const bool is_continuation = class_is_continuation_[byte_class];
+  const int literal = class_literal_[byte_class];
+  for (int state : from) {
+    const NfaState& nfa_state = nfa_[state];
+    if (literal != -1 && !nfa_state.literals.empty()) {
+      auto it = std::lower_bound(
+          nfa_state.literals.begin(), nfa_state.literals.end(),
+          std::make_pair(static_cast<uint8_t>(literal), -1));
+      if (it != nfa_state.literals.end() && it->first == literal)
+        AddWithClosure(it->second, to, in_set);
+    }
+
+    bool consumes = false;
+    switch (nfa_state.kind) {
+      case NfaState::Kind::kAny:
+        consumes = true;
+        break;
+      case NfaState::Kind::kLeadByte:
+        consumes = !is_continuation;
+        break;
+      case NfaState::Kind::kContinuation:
+        consumes = is_continuation;
+        break;
+      case NfaState::Kind::kNone:
+        break;
+    }
+    if (consumes)
+      AddWithClosure(nfa_state.target, to, in_set);
+  }
+}
+
+size_t PatternAutomaton::GetAccepted(const std::vector<int>& states) const {
+  size_t accepted = CompiledPatternSet::kNoMatch;
+  for (int state : states) {
+    const size_t pattern = nfa_[state].pattern;
+    if (pattern != CompiledPatternSet::kNoMatch &&
+        (accepted == CompiledPatternSet::kNoMatch ||
+         priorities_[pattern] < priorities_[accepted])) {
+      accepted = pattern;
+    }
+  }
+  return accepted;
+}
+
+void PatternAutomaton::BuildDfa(size_t max_states) {
+  // DFA states are identified by their sorted set of NFA states.
+  std::map<std::vector<int>, int> state_ids;
+  std::vector<std::vector<int>> pending;
+  std::vector<bool> in_set(nfa_.size());
+
+  auto add_state = [&](std::vector<int> states) {
+    std::sort(states.begin(), states.end());
+    auto inserted =
+        state_ids.emplace(states, static_cast<int>(pending.size()));
+    if (inserted.second) {
+      dfa_accepted_.push_back(GetAccepted(states));
+      pending.push_back(std::move(states));
+    }
+    return inserted.first->second;
+  };
+
+  add_state(std::vector<int>());
+  DCHECK_EQ(1u, pending.size());
+  std::vector<int> start;
+  AddWithClosure(kNfaRoot, &start, &in_set);
+  for (int state : start)
+    in_set[state] = false;
+  // The start state is added even when it is the same set as the dead state,
+  // as happens when there are no patterns.
+  state_ids.emplace(start, kStartState);
+  dfa_accepted_.push_back(GetAccepted(start));
+  pending.push_back(std::move(start));
+
+  std::vector<int> next;
+  size_t steps = 0;
+  for (size_t id = 0; id < pending.size(); ++id) {
+    steps += pending[id].size() * num_classes_;
+    if (pending.size() > max_states || steps > kMaxDfaBuildSteps) {
+      dfa_transitions_.clear();
+      dfa_accepted_.clear();
+      return;
+    }
+    dfa_transitions_.resize((id + 1) * num_classes_);
+    for (int byte_class = 0; byte_class < num_classes_; ++byte_class) {
+      Step(pending[id], byte_class, &next, &in_set);
+      for (int state : next)
+        in_set[state] = false;
+      dfa_transitions_[id * num_classes_ + byte_class] = add_state(next);
+    }
+    // The NFA states of a DFA state are no longer needed once its transitions
+    // are known.
+    std::vector<int>().swap(pending[id]);
+  }
+}
+
+// The Aho-Corasick automaton of a set of substrings: a trie of the substrings,
+// where each node also links to the node of the longest proper suffix of its
+// string that is in the trie. The suffix links are followed when a node has
+// no child for a byte, so that scanning a string takes linear time and the
+// automaton takes space linear in the total length of the substrings.
+class SubstringAutomaton {
+ public:
+  static constexpr int kRoot = 0;
+
+  // Empty substrings are ignored.
+  explicit SubstringAutomaton(const std::vector<StringPiece>& substrings);
+
+  // Returns the node reached from |node| by consuming |byte|.
+  int Next(int node, uint8_t byte) const {
+    while (node != kRoot) {
+      const int child = FindChild(node, byte);
+      if (child != -1)
+        return child;
+      node = nodes_[node].suffix;
+    }
+    return root_children_[byte];
+  }
+
+  // Returns the index in |substrings| of the longest substring that ends at
+  // |node|, or CompiledPatternSet::kNoMatch.
+  size_t Match(int node) const { return nodes_[node].match; }
+
+ private:
+  struct Node {
+    int suffix = kRoot;
+    size_t match = CompiledPatternSet::kNoMatch;
+    // The range of |edges_| that holds the children, sorted by byte.
+    size_t first_edge = 0;
+    size_t num_edges = 0;
+  };
+
+  // Returns the child of |node| for |byte|, or -1.
+  int FindChild(int node, uint8_t byte) const;
+
+  std::vector<Node> nodes_;
+  std::vector<std::pair<uint8_t, int>> edges_;
+  // The children of the root, which most bytes lead to, or kRoot for bytes
+  // that don't start a substring.
+  int root_children_[256];
+
+  DISALLOW_COPY_AND_ASSIGN(SubstringAutomaton);
+};
+
+constexpr int SubstringAutomaton::kRoot;
+
+SubstringAutomaton::SubstringAutomaton(
+    const std::vector<StringPiece>& substrings) {
+  // The children are kept in maps while the trie is built.
+  std::vector<std::map<uint8_t, int>> children(1);
+  nodes_.emplace_back();
+  for (size_t i = 0; i < substrings.size(); ++i) {
+    if (substrings[i].empty())
+      continue;
+    int node = kRoot;
+    for (char c : substrings[i]) {
+      const auto inserted = children[node].emplace(
+          static_cast<uint8_t>(c), static_cast<int>(nodes_.size()));
+      node = inserted.first->second;
+      if (inserted.second) {
+        nodes_.emplace_back();
+        children.emplace_back();
+      }
+    }
+    if (nodes_[node].match == CompiledPatternSet::kNoMatch)
+      nodes_[node].match = i;
+  }
+
+  for (size_t node = 0; node < nodes_.size(); ++node) {
+    nodes_[node].first_edge = edges_.size();
+    nodes_[node].num_edges = children[node].size();
+    edges_.insert(edges_.end(), children[node].begin(), children[node].end());
+  }
+  std::fill(std::begin(root_children_), std::end(root_children_), kRoot);
+  for (const auto& child : children[kRoot])
+    root_children_[child.first] = child.second;
+
+  // The suffix links point to shallower nodes, so they are set in breadth
+  // first order. A node that isn't the end of a substring matches the longest
+  // substring that is one of its suffixes.
+  std::vector<int> queue(1, kRoot);
+  for (size_t i = 0; i < queue.size(); ++i) {
+    const int node = queue[i];
+    for (const auto& child : children[node]) {
+      Node& child_node = nodes_[child.second];
+      if (node != kRoot)
+        child_node.suffix = Next(nodes_[node].suffix, child.first);
+      if (child_node.match == CompiledPatternSet::kNoMatch)
+        child_node.match = nodes_[child_node.suffix].match;
+      queue.push_back(child.second);
+    }
+  }
+}
+
+int SubstringAutomaton::FindChild(int node, uint8_t byte) const {
+  const auto begin = edges_.begin() + nodes_[node].first_edge;
+  const auto end = begin + nodes_[node].num_edges;
+  const auto it = std::lower_bound(begin, end, std::make_pair(byte, -1));
+  return it != end && it->first == byte ? it->second : -1;
+}
+
+}  // namespace internal
+
+constexpr size_t CompiledPatternSet::kNoMatch;
+
+CompiledPatternSet::CompiledPatternSet(
+    const std::vector<std::string>& patterns) {
+  std::vector<std::vector<internal::PatternAutomaton::Token>> parsed;
+  std::vector<size_t> priorities;
+  for (const std::string& pattern : patterns) {
+    parsed.push_back(internal::PatternAutomaton::ParsePattern(pattern));
+    priorities.push_back(priorities.size());
+  }
+  automaton_ =
+      std::make_unique<internal::PatternAutomaton>(parsed, priorities);
+}
+
+CompiledPatternSet::CompiledPatternSet(CompiledPatternSet&& other) = default;
+
+CompiledPatternSet& CompiledPatternSet::operator=(
+    CompiledPatternSet&& other) = default;
+
+CompiledPatternSet::~CompiledPatternSet() = default;
+
+size_t CompiledPatternSet::FindFirstMatch(StringPiece string) const {
+  return automaton_->Match(string);
+}
+
+bool CompiledPatternSet::IsDeterministicForTesting() const {
+  return automaton_->is_deterministic();
+}
+
+SubstringReplacer::SubstringReplacer(
+    const std::vector<std::pair<std::string, std::string>>& replacements) {
+  std::vector<StringPiece> substrings;
+  for (const auto& replacement : replacements) {
+    DCHECK(!replacement.first.empty());
+    substrings.push_back(replacement.first);
+    find_lengths_.push_back(replacement.first.size());
+    replace_with_.push_back(replacement.second);
+  }
+  automaton_ = std::make_unique<internal::SubstringAutomaton>(substrings);
+}
+
+SubstringReplacer::~SubstringReplacer() = default;
+
+bool SubstringReplacer::ReplaceAllAfterOffset(std::string* str,
+                                              size_t start_offset) const {
+  using internal::SubstringAutomaton;
+
+  std::string result;
+  size_t copied = 0;
+  int node = SubstringAutomaton::kRoot;
+  for (size_t i = start_offset; i < str->size(); ++i) {
+    node = automaton_->Next(node, static_cast<uint8_t>((*str)[i]));
+    const size_t match = automaton_->Match(node);
+    if (match == CompiledPatternSet::kNoMatch)
+      continue;
+
+    const size_t match_start = i + 1 - find_lengths_[match];
+    if (result.empty())
+      result.reserve(str->size());
+    result.append(*str, copied, match_start - copied);
+    result.append(replace_with_[match]);
+    copied = i + 1;
+    node = SubstringAutomaton::kRoot;
+  }
+  if (copied == 0)
+    return false;
+
+  result.append(*str, copied, std::string::npos);
+  str->swap(result);
+  return true;
+}
+
+}  // namespace base
@@ -0,0 +1,112 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_STRINGS_COMPILED_PATTERN_SET_H_
+#define BASE_STRINGS_COMPILED_PATTERN_SET_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/macros.h"
+#include "base/strings/string_piece.h"
+
+namespace base {
+
+namespace internal {
+class PatternAutomaton;
+class SubstringAutomaton;
+}  // namespace internal
+
+// Matches strings against many patterns at once. The patterns have the syntax
+// of MatchPattern(): * matches 0 or more characters, ? matches 0 or 1
+// character, and \ escapes the next character. They are compiled once into a
+// deterministic automaton, so that matching a string takes time linear in its
+// length, however many patterns there are. Use this instead of MatchPattern()
+// in a loop when the same patterns are matched against many strings, as with
+// filters and allowlists.
+//
+// Unlike MatchPattern(), which doesn't backtrack, this finds every match: for
+// instance "*a?b" matches "aXab" here but not with MatchPattern().
+//
+// Patterns that share a prefix share the states for it, so sets of prefixes,
+// of suffixes like "*.debug" and of literals have automatons about as large as
+// the patterns. Sets whose automaton would be too large, which takes many
+// wildcards in the middle of patterns, like many "*foo*" patterns or "*a???",
+// are matched by simulating the non-deterministic automaton instead, in time
+// proportional to the length of the string times the number of patterns that
+// could still match.
+//
+// Immutable once built, so it can be used from any thread.
+//
+// Example:
+//   CompiledPatternSet filter({"cc*", "*.debug", "gpu?"});
+//   if (filter.MatchesAny(category)) ...
+class BASE_EXPORT CompiledPatternSet {
+ public:
+  static constexpr size_t kNoMatch = static_cast<size_t>(-1);
+
+  explicit CompiledPatternSet(const std::vector<std::string>& patterns);
+  CompiledPatternSet(CompiledPatternSet&& other);
+  CompiledPatternSet& operator=(CompiledPatternSet&& other);
+  ~CompiledPatternSet();
+
+  // Returns the index in |patterns| of the first pattern that matches the
+  // whole of |string|, or kNoMatch.
+  size_t FindFirstMatch(StringPiece string) const;
+
+  bool MatchesAny(StringPiece string) const {
+    return FindFirstMatch(string) != kNoMatch;
+  }
+
+  bool IsDeterministicForTesting() const;
+
+ private:
+  std::unique_ptr<internal::PatternAutomaton> automaton_;
+
+  DISALLOW_COPY_AND_ASSIGN(CompiledPatternSet);
+};
+
+// Replaces occurrences of several substrings in a single pass, with an
+// automaton built once (Aho-Corasick). Where ReplaceSubstringsAfterOffset()
+// scans the string once per substring, this scans it once in all.
+//
+// The scan replaces the occurrence that ends first, or the longest one if
+// several end at the same position, then resumes after it. Replacements are
+// not scanned.
+//
+// Immutable once built, so it can be used from any thread.
+//
+// Example:
+//   static const NoDestructor<SubstringReplacer> kEscaper(
+//       std::vector<std::pair<std::string, std::string>>{
+//           {"&", "&amp;"}, {"<", "&lt;"}, {">", "&gt;"}});
+//   kEscaper->ReplaceAllAfterOffset(&html, 0);
+class BASE_EXPORT SubstringReplacer {
+ public:
+  // |replacements| holds pairs of a substring to find, which must not be
+  // empty, and what to replace it with.
+  explicit SubstringReplacer(
+      const std::vector<std::pair<std::string, std::string>>& replacements);
+  ~SubstringReplacer();
+
+  // Replaces the occurrences that start at or after |start_offset| in |str|.
+  // Returns whether anything was replaced.
+  bool ReplaceAllAfterOffset(std::string* str, size_t start_offset) const;
+
+ private:
+  std::unique_ptr<internal::SubstringAutomaton> automaton_;
+  std::vector<size_t> find_lengths_;
+  std::vector<std::string> replace_with_;
+
+  DISALLOW_COPY_AND_ASSIGN(SubstringReplacer);
+};
+
+}  // namespace base
+
+#endif  // BASE_STRINGS_COMPILED_PATTERN_SET_H_
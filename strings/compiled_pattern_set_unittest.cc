@@ -0,0 +1,237 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/strings/compiled_pattern_set.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/strings/pattern.h"
+#include "base/strings/string_number_conversions.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+bool Matches(StringPiece string, const std::string& pattern) {
+  return CompiledPatternSet({pattern}).MatchesAny(string);
+}
+
+std::string Replace(
+    std::string str,
+    const std::vector<std::pair<std::string, std::string>>& replacements) {
+  SubstringReplacer(replacements).ReplaceAllAfterOffset(&str, 0);
+  return str;
+}
+
+}  // namespace
+
+// The cases of MatchPatternTest.
+TEST(CompiledPatternSetTest, SinglePattern) {
+  EXPECT_TRUE(Matches("www.google.com", "*.com"));
+  EXPECT_TRUE(Matches("www.google.com", "*"));
+  EXPECT_FALSE(Matches("www.google.com", "www*.g*.org"));
+  EXPECT_TRUE(Matches("Hello", "H?l?o"));
+  EXPECT_FALSE(Matches("www.google.com", "http://*)"));
+  EXPECT_FALSE(Matches("www.msn.com", "*.COM"));
+  EXPECT_TRUE(Matches("Hello*1234", "He??o\\*1*"));
+  EXPECT_FALSE(Matches("Hello1234", "He??o\\*1*"));
+  EXPECT_FALSE(Matches("", "*.*"));
+  EXPECT_TRUE(Matches("", "*"));
+  EXPECT_TRUE(Matches("", "?"));
+  EXPECT_TRUE(Matches("", ""));
+  EXPECT_FALSE(Matches("Hello", ""));
+  EXPECT_TRUE(Matches("Hello*", "Hello*"));
+  EXPECT_TRUE(Matches("abcd", "*???"));
+  EXPECT_FALSE(Matches("abcd", "???"));
+  EXPECT_TRUE(Matches("abcb", "a*b"));
+  EXPECT_FALSE(Matches("abcb", "a?b"));
+  EXPECT_TRUE(Matches("a\\b", "a\\\\b"));
+  EXPECT_TRUE(Matches("ab", "ab\\"));
+
+  // UTF-8.
+  EXPECT_TRUE(Matches("heart: \xe2\x99\xa0", "*\xe2\x99\xa0"));
+  EXPECT_TRUE(Matches("heart: \xe2\x99\xa0.", "heart: ?."));
+  EXPECT_FALSE(Matches("heart: \xe2\x99\xa0\xe2\x99\xa0.", "heart: ?."));
+  EXPECT_TRUE(Matches("hearts: \xe2\x99\xa0\xe2\x99\xa0", "*"));
+  EXPECT_TRUE(Matches("invalid: \xef\xbf\xbe", "invalid: ?"));
+  EXPECT_FALSE(Matches("\xf4\x90\x80\x80", "\xf4\x90\x80\x80"));
+
+  EXPECT_TRUE(Matches("Hello", "He********************************o"));
+  EXPECT_TRUE(Matches("123456789012345678", "?????????????????*"));
+  EXPECT_TRUE(Matches("aaaaaaaaaaab", "a*a*a*a*a*a*a*a*a*a*a*b"));
+
+  // MatchPattern() doesn't backtrack, and misses this one.
+  EXPECT_TRUE(Matches("aXab", "*a?b"));
+}
+
+TEST(CompiledPatternSetTest, FindFirstMatch) {
+  CompiledPatternSet set({"foo*", "*bar", "foo?bar", "baz"});
+  EXPECT_TRUE(set.IsDeterministicForTesting());
+  EXPECT_EQ(0u, set.FindFirstMatch("foobar"));
+  EXPECT_EQ(0u, set.FindFirstMatch("foo"));
+  EXPECT_EQ(1u, set.FindFirstMatch("xbar"));
+  EXPECT_EQ(3u, set.FindFirstMatch("baz"));
+  EXPECT_EQ(CompiledPatternSet::kNoMatch, set.FindFirstMatch("bazz"));
+  EXPECT_EQ(CompiledPatternSet::kNoMatch, set.FindFirstMatch(""));
+  EXPECT_FALSE(set.MatchesAny("fo"));
+
+  CompiledPatternSet empty({});
+  EXPECT_FALSE(empty.MatchesAny(""));
+  EXPECT_FALSE(empty.MatchesAny("a"));
+}
+
+// Compares with MatchPattern() on many patterns at once.
+TEST(CompiledPatternSetTest, ManyPatterns) {
+  std::vector<std::string> patterns;
+  for (int i = 0; i < 1000; ++i) {
+    const std::string number = IntToString(i);
+    patterns.push_back("category" + number + "*");
+    patterns.push_back("test_" + number + "_?");
+    patterns.push_back("Suite" + number + ".Test");
+  }
+  CompiledPatternSet set(patterns);
+  EXPECT_TRUE(set.IsDeterministicForTesting());
+
+  const char* const kStrings[] = {
+      "category12",  "category999.x", "category1000.5", "category", "",
+      "test_5_",     "test_5_a",      "test_5_ab",      "test_",    "test_0",
+      "Suite7.Test", "Suite7.Tests",  "Suite1000.Test"};
+  for (const char* string : kStrings) {
+    size_t expected = CompiledPatternSet::kNoMatch;
+    for (size_t i = 0; i < patterns.size(); ++i) {
+      if (MatchPattern(string, patterns[i])) {
+        expected = i;
+        break;
+      }
+    }
+    EXPECT_EQ(expected, set.FindFirstMatch(string)) << string;
+  }
+}
+
+// Patterns that start with * share their looping state, so sets of suffixes
+// stay deterministic.
+TEST(CompiledPatternSetTest, ManySuffixPatterns) {
+  std::vector<std::string> patterns;
+  for (int i = 0; i < 1000; ++i) {
+    const std::string number = IntToString(i);
+    patterns.push_back("*.debug" + number);
+    patterns.push_back("*/test" + number);
+    patterns.push_back("*_" + number + "?");
+  }
+  CompiledPatternSet set(patterns);
+  EXPECT_TRUE(set.IsDeterministicForTesting());
+
+  const char* const kStrings[] = {
+      "a.debug12",     "a.debug12.debug999", ".debug1000",   "debug5",
+      "x/test7",       "/test7/y/test8",     "test7",        "/test1000",
+      "ab_5",          "ab_5c",              "_12cd",        "_",
+      "a.debug3/test4/_5"};
+  for (const char* string : kStrings) {
+    size_t expected = CompiledPatternSet::kNoMatch;
+    for (size_t i = 0; i < patterns.size(); ++i) {
+      if (MatchPattern(string, patterns[i])) {
+        expected = i;
+        break;
+      }
+    }
+    EXPECT_EQ(expected, set.FindFirstMatch(string)) << string;
+  }
+}
+
+// Patterns whose deterministic automaton would be too large are still
+// matched correctly. Here it would need a state for every combination of the
+// distances to the last 'a', 'b', 'c' and 'd'.
+TEST(CompiledPatternSetTest, NonDeterministic) {
+  const std::string kAnyTwenty(20, '?');
+  CompiledPatternSet set({"*a" + kAnyTwenty, "*b" + kAnyTwenty,
+                          "*c" + kAnyTwenty, "*d" + kAnyTwenty, "x*"});
+  EXPECT_FALSE(set.IsDeterministicForTesting());
+
+  const std::string kTwenty(20, 'x');
+  EXPECT_EQ(0u, set.FindFirstMatch(kTwenty + "a"));
+  EXPECT_EQ(0u, set.FindFirstMatch("a" + kTwenty));
+  EXPECT_EQ(2u, set.FindFirstMatch("a" + kTwenty + "c" + kTwenty));
+  EXPECT_EQ(3u, set.FindFirstMatch("d\xe2\x99\xa0" + kTwenty.substr(1)));
+  EXPECT_EQ(4u, set.FindFirstMatch("xa" + kTwenty + "y"));
+  EXPECT_EQ(CompiledPatternSet::kNoMatch,
+            set.FindFirstMatch("abcd" + kTwenty + "y"));
+}
+
+TEST(SubstringReplacerTest, ReplaceAll) {
+  const std::vector<std::pair<std::string, std::string>> kEscapes = {
+      {"&", "&amp;"}, {"<", "&lt;"}, {">", "&gt;"}};
+  EXPECT_EQ("&lt;a href=&gt;&amp;&amp;", Replace("<a href=>&&", kEscapes));
+  EXPECT_EQ("no match", Replace("no match", kEscapes));
+  EXPECT_EQ("", Replace("", kEscapes));
+
+  // Replacements aren't rescanned.
+  EXPECT_EQ("ba", Replace("ab", {{"a", "b"}, {"b", "a"}}));
+  // The occurrence that ends first wins, then the longest.
+  EXPECT_EQ("aX", Replace("abc", {{"bc", "X"}, {"abcd", "Y"}}));
+  EXPECT_EQ("Y", Replace("abcd", {{"bcd", "X"}, {"abcd", "Y"}}));
+  EXPECT_EQ("XX", Replace("aaaa", {{"aa", "X"}}));
+
+  const std::vector<std::pair<std::string, std::string>> kScope = {
+      {".", "::"}};
+  const SubstringReplacer replacer(kScope);
+  std::string str = "a.b.c";
+  EXPECT_TRUE(replacer.ReplaceAllAfterOffset(&str, 2));
+  EXPECT_EQ("a.b::c", str);
+  EXPECT_FALSE(replacer.ReplaceAllAfterOffset(&str, 4));
+}
+
+// Compares with a straightforward implementation on thousands of substrings.
+TEST(SubstringReplacerTest, ManySubstrings) {
+  // A fixed pseudo-random sequence of lowercase letters.
+  uint32_t seed = 1;
+  auto random_letters = [&seed](size_t size) {
+    std::string letters;
+    for (size_t i = 0; i < size; ++i) {
+      seed = seed * 1103515245 + 12345;
+      letters.push_back('a' + (seed >> 16) % 8);
+    }
+    return letters;
+  };
+
+  constexpr size_t kMinLength = 4;
+  constexpr size_t kMaxLength = 12;
+  std::vector<std::pair<std::string, std::string>> replacements;
+  // The first index of each substring.
+  std::map<std::string, size_t> indices;
+  for (size_t i = 0; i < 5000; ++i) {
+    replacements.emplace_back(
+        random_letters(kMinLength + i % (kMaxLength - kMinLength + 1)),
+        NumberToString(i));
+    indices.emplace(replacements.back().first, i);
+  }
+  const std::string text = random_letters(100000);
+
+  std::string expected;
+  size_t copied = 0;
+  for (size_t end = kMinLength; end <= text.size(); ++end) {
+    // The longest substring that ends at |end|.
+    size_t length = std::min(kMaxLength, end - copied);
+    auto it = indices.end();
+    for (; length >= kMinLength && it == indices.end(); --length)
+      it = indices.find(text.substr(end - length, length));
+    if (it == indices.end())
+      continue;
+    expected.append(text, copied, end - it->first.size() - copied);
+    expected.append(replacements[it->second].second);
+    copied = end;
+  }
+  expected.append(text, copied, std::string::npos);
+  ASSERT_NE(text, expected);
+
+  EXPECT_EQ(expected, Replace(text, replacements));
+}
+
+}  // namespace base
@@ -0,0 +1,38 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_STRINGS_DOUBLE_CONVERSIONS_INTERNAL_H_
+#define BASE_STRINGS_DOUBLE_CONVERSIONS_INTERNAL_H_
+
+#include <stddef.h>
+
+#include "base/base_export.h"
+#include "base/strings/string_piece.h"
+
+namespace base {
+namespace internal {
+
+// Enough for a sign, 17 digits, a decimal point and "e-308", with room to
+// spare. Doesn't include a terminating null.
+constexpr size_t kDoubleToStringBufferSize = 32;
+
+// Writes the shortest decimal representation of |value| that reads back as
+// |value| to |buffer|, which must hold kDoubleToStringBufferSize characters,
+// and returns its length. The output is the same as dmg_fp::g_fmt(), e.g.
+// "0", "1.5", ".001", "1e+21", "-Infinity" or "NaN", but is not
+// null-terminated.
+BASE_EXPORT size_t DoubleToShortestString(double value, char* buffer);
+
+// Parses |input|, which must be entirely of the form
+// [+-]digits[.digits][(e|E)[+-]digits], into |*output| with correct rounding.
+// Returns false without touching |*output| when the input has another form
+// or is too hard to convert quickly (more than 19 significant digits, a
+// result that is subnormal or overflows, ...); callers fall back to
+// dmg_fp::strtod() in that case.
+BASE_EXPORT bool FastStringToDouble(StringPiece input, double* output);
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_STRINGS_DOUBLE_CONVERSIONS_INTERNAL_H_
@@ -0,0 +1,166 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/strings/interned_string.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <memory>
+#include <ostream>
+
+#include "base/debug/leak_annotations.h"
+#include "base/hash.h"
+#include "base/logging.h"
+#include "base/no_destructor.h"
+#include "base/synchronization/lock.h"
+
+namespace base {
+
+using internal::InternedStringEntry;
+
+namespace {
+
+constexpr size_t kInitialCapacity = 256;
+
+// An open addressing hash table with linear probing. Slots go from null to an
+// entry once and never change after that, so readers can probe them without
+// a lock. When the table gets half full, the writer copies the entries to a
+// table twice as large and publishes it in |g_table|. The old table is leaked,
+// since readers may still be probing it. Readers that miss an entry because
+// they probed an old table fall back to taking the lock in Intern().
+struct Table {
+  explicit Table(size_t capacity)
+      : capacity(capacity),
+        slots(new std::atomic<const InternedStringEntry*>[capacity]()) {}
+
+  // A power of two.
+  const size_t capacity;
+  const std::unique_ptr<std::atomic<const InternedStringEntry*>[]> slots;
+};
+
+std::atomic<Table*> g_table{nullptr};
+
+// Number of entries in |g_table|. Protected by GetLock().
+size_t g_num_entries = 0;
+
+// Serializes the writers.
+Lock& GetLock() {
+  static NoDestructor<Lock> lock;
+  return *lock;
+}
+
+size_t HashString(StringPiece string) {
+  return Hash(string.data(), string.size());
+}
+
+// Returns the entry of |table| that holds |string|, or null if there is none.
+const InternedStringEntry* FindInTable(const Table& table,
+                                       StringPiece string,
+                                       size_t hash) {
+  const size_t mask = table.capacity - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    const InternedStringEntry* entry =
+        table.slots[i].load(std::memory_order_acquire);
+    if (!entry)
+      return nullptr;
+    if (entry->hash == hash && entry->length == string.size() &&
+        memcmp(entry->data, string.data(), string.size()) == 0) {
+      return entry;
+    }
+  }
+}
+
+const InternedStringEntry* FindEntry(StringPiece string, size_t hash) {
+  const Table* table = g_table.load(std::memory_order_acquire);
+  return table ? FindInTable(*table, string, hash) : nullptr;
+}
+
+// Stores |entry| in the first free slot of its probe sequence.
+void AddToTable(Table* table, const InternedStringEntry* entry) {
+  const size_t mask = table->capacity - 1;
+  size_t i = entry->hash & mask;
+  while (table->slots[i].load(std::memory_order_relaxed))
+    i = (i + 1) & mask;
+  // Publishes the contents of |entry| to the readers.
+  table->slots[i].store(entry, std::memory_order_release);
+}
+
+// Returns |g_table|, replacing it with a larger table first if it has no room
+// for another entry.
+Table* GetTableForInsertion() {
+  GetLock().AssertAcquired();
+  Table* table = g_table.load(std::memory_order_relaxed);
+  if (table && (g_num_entries + 1) * 2 <= table->capacity)
+    return table;
+
+  Table* new_table = new Table(table ? table->capacity * 2 : kInitialCapacity);
+  if (table) {
+    for (size_t i = 0; i < table->capacity; ++i) {
+      const InternedStringEntry* entry =
+          table->slots[i].load(std::memory_order_relaxed);
+      if (entry)
+        AddToTable(new_table, entry);
+    }
+    ANNOTATE_LEAKING_OBJECT_PTR(table);
+  }
+  g_table.store(new_table, std::memory_order_release);
+  return new_table;
+}
+
+const InternedStringEntry* NewEntry(StringPiece string, size_t hash) {
+  InternedStringEntry* entry = static_cast<InternedStringEntry*>(
+      malloc(offsetof(InternedStringEntry, data) + string.size() + 1));
+  CHECK(entry);
+  entry->hash = hash;
+  entry->length = string.size();
+  memcpy(entry->data, string.data(), string.size());
+  entry->data[string.size()] = '\0';
+  return entry;
+}
+
+}  // namespace
+
+// static
+InternedString InternedString::Intern(StringPiece string) {
+  if (string.empty())
+    return InternedString();
+
+  const size_t hash = HashString(string);
+  if (const InternedStringEntry* entry = FindEntry(string, hash))
+    return InternedString(entry);
+
+  AutoLock auto_lock(GetLock());
+  // Another thread may have added |string| since the lookup above, or the
+  // lookup may have probed a table that has since been replaced.
+  if (const InternedStringEntry* entry = FindEntry(string, hash))
+    return InternedString(entry);
+
+  Table* table = GetTableForInsertion();
+  const InternedStringEntry* entry = NewEntry(string, hash);
+  AddToTable(table, entry);
+  ++g_num_entries;
+  return InternedString(entry);
+}
+
+// static
+bool InternedString::Find(StringPiece string, InternedString* interned) {
+  if (string.empty()) {
+    *interned = InternedString();
+    return true;
+  }
+
+  const InternedStringEntry* entry = FindEntry(string, HashString(string));
+  if (!entry)
+    return false;
+  *interned = InternedString(entry);
+  return true;
+}
+
+std::ostream& operator<<(std::ostream& o, const InternedString& string) {
+  return o << string.piece();
+}
+
+}  // namespace base
@@ -0,0 +1,105 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_STRINGS_INTERNED_STRING_H_
+#define BASE_STRINGS_INTERNED_STRING_H_
+
+#include <stddef.h>
+
+#include <iosfwd>
+
+#include "base/base_export.h"
+#include "base/strings/string_piece.h"
+
+namespace base {
+
+namespace internal {
+
+// The storage of an interned string. Entries are never freed.
+struct InternedStringEntry {
+  size_t hash;
+  size_t length;
+  // |length| characters followed by a '\0'.
+  char data[1];
+};
+
+}  // namespace internal
+
+// InternedString --------------------------------------------------------------
+//
+// An immutable string stored once per process. All InternedStrings with the
+// same contents share the same storage, so they are compared by pointer and
+// copied as cheaply as a pointer. Their hash is computed when they are first
+// interned.
+//
+//   InternedString name = InternedString::Intern("Memory.Browser");
+//   if (name == other_name)  // No string comparison.
+//     ...
+//
+// Interned strings are never freed, so the characters behind piece() and
+// c_str() stay valid for the lifetime of the process. Only intern strings
+// that come from a bounded set, like histogram names or trace categories,
+// never strings built from arbitrary data.
+//
+// Looking up a string that was already interned doesn't take a lock, so both
+// Intern() and Find() are fast and safe to call from any thread.
+class BASE_EXPORT InternedString {
+ public:
+  // The empty string.
+  constexpr InternedString() : entry_(nullptr) {}
+
+  // Returns the interned string with the same contents as |string|, adding it
+  // to the pool if it wasn't there already.
+  static InternedString Intern(StringPiece string);
+
+  // Sets |*interned| to the interned string with the same contents as |string|
+  // and returns true if there is one. Returns false otherwise, without adding
+  // |string| to the pool. Never blocks.
+  static bool Find(StringPiece string, InternedString* interned);
+
+  StringPiece piece() const {
+    return entry_ ? StringPiece(entry_->data, entry_->length) : StringPiece();
+  }
+  const char* c_str() const { return entry_ ? entry_->data : ""; }
+  size_t size() const { return entry_ ? entry_->length : 0; }
+  bool empty() const { return !entry_; }
+
+  // The hash of the contents. It is the same for all InternedStrings with the
+  // same contents within a process, but may differ between processes.
+  size_t hash() const { return entry_ ? entry_->hash : 0; }
+
+  bool operator==(const InternedString& other) const {
+    return entry_ == other.entry_;
+  }
+  bool operator!=(const InternedString& other) const {
+    return entry_ != other.entry_;
+  }
+  // Orders by contents, so that sorting doesn't depend on where the strings
+  // were allocated.
+  bool operator<(const InternedString& other) const {
+    return entry_ != other.entry_ && piece() < other.piece();
+  }
+
+ private:
+  explicit InternedString(const internal::InternedStringEntry* entry)
+      : entry_(entry) {}
+
+  // Null for the empty string, which is never stored in the pool.
+  const internal::InternedStringEntry* entry_;
+};
+
+// Allows InternedString to be used as a key in unordered containers, without
+// hashing its contents again.
+struct InternedStringHash {
+  size_t operator()(const InternedString& string) const {
+    return string.hash();
+  }
+};
+
+BASE_EXPORT std::ostream& operator<<(std::ostream& o,
+                                     const InternedString& string);
+
+}  // namespace base
+
+#endif  // BASE_STRINGS_INTERNED_STRING_H_
@@ -0,0 +1,151 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/strings/interned_string.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+// The pool is shared by the whole process, so each test uses strings that no
+// other code interns.
+
+TEST(InternedStringTest, Empty) {
+  InternedString empty;
+  EXPECT_TRUE(empty.empty());
+  EXPECT_EQ(0u, empty.size());
+  EXPECT_EQ(StringPiece(), empty.piece());
+  EXPECT_STREQ("", empty.c_str());
+  EXPECT_EQ(empty, InternedString::Intern(""));
+
+  InternedString found = InternedString::Intern("InternedStringTest.Empty");
+  EXPECT_TRUE(InternedString::Find(StringPiece(), &found));
+  EXPECT_EQ(empty, found);
+}
+
+TEST(InternedStringTest, SameContentsShareStorage) {
+  const std::string name("InternedStringTest.Same");
+  InternedString a = InternedString::Intern(name);
+  InternedString b = InternedString::Intern(std::string(name));
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(a.c_str(), b.c_str());
+  EXPECT_EQ(a.hash(), b.hash());
+  EXPECT_EQ(name, a.piece());
+  EXPECT_EQ(name.size(), a.size());
+  EXPECT_STREQ(name.c_str(), a.c_str());
+  EXPECT_NE(name.data(), a.piece().data());
+
+  InternedString c = InternedString::Intern("InternedStringTest.Other");
+  EXPECT_NE(a, c);
+  EXPECT_TRUE(c < a);
+  EXPECT_FALSE(a < c);
+  EXPECT_FALSE(a < b);
+
+  // Embedded nulls are part of the contents.
+  InternedString with_null =
+      InternedString::Intern(StringPiece("InternedStringTest.Same\0x", 25));
+  EXPECT_NE(a, with_null);
+  EXPECT_EQ(25u, with_null.size());
+}
+
+TEST(InternedStringTest, Find) {
+  const char kName[] = "InternedStringTest.Find";
+  InternedString found;
+  EXPECT_FALSE(InternedString::Find(kName, &found));
+  EXPECT_TRUE(found.empty());
+
+  InternedString interned = InternedString::Intern(kName);
+  EXPECT_TRUE(InternedString::Find(kName, &found));
+  EXPECT_EQ(interned, found);
+}
+
+// Adds enough strings to make the pool grow several times, and checks that
+// earlier strings keep their storage.
+TEST(InternedStringTest, Growth) {
+  std::vector<InternedString> strings;
+  for (int i = 0; i < 5000; ++i) {
+    strings.push_back(
+        InternedString::Intern("InternedStringTest.Growth." + IntToString(i)));
+  }
+
+  std::unordered_set<InternedString, InternedStringHash> unique(
+      strings.begin(), strings.end());
+  EXPECT_EQ(strings.size(), unique.size());
+
+  for (int i = 0; i < 5000; ++i) {
+    const std::string name = "InternedStringTest.Growth." + IntToString(i);
+    InternedString found;
+    ASSERT_TRUE(InternedString::Find(name, &found));
+    EXPECT_EQ(strings[i], found);
+    EXPECT_EQ(name, strings[i].piece());
+  }
+}
+
+TEST(InternedStringTest, Stream) {
+  std::ostringstream stream;
+  stream << InternedString::Intern("InternedStringTest.Stream");
+  EXPECT_EQ("InternedStringTest.Stream", stream.str());
+}
+
+namespace {
+
+constexpr int kNumStrings = 2000;
+
+// Interns the same strings as the other threads, in its own order.
+class InternRunner : public DelegateSimpleThread::Delegate {
+ public:
+  explicit InternRunner(int offset) : offset_(offset) {}
+
+  void Run() override {
+    for (int i = 0; i < kNumStrings; ++i) {
+      const int index = (i + offset_) % kNumStrings;
+      results_[index] = InternedString::Intern(
+          "InternedStringTest.Threads." + IntToString(index));
+    }
+  }
+
+  const InternedString* results() const { return results_; }
+
+ private:
+  const int offset_;
+  InternedString results_[kNumStrings];
+
+  DISALLOW_COPY_AND_ASSIGN(InternRunner);
+};
+
+}  // namespace
+
+TEST(InternedStringTest, Threads) {
+  constexpr int kNumThreads = 4;
+  std::vector<std::unique_ptr<InternRunner>> runners;
+  std::vector<std::unique_ptr<DelegateSimpleThread>> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    runners.push_back(
+        std::make_unique<InternRunner>(i * kNumStrings / kNumThreads));
+    threads.push_back(std::make_unique<DelegateSimpleThread>(
+        runners.back().get(), "InternedStringTest"));
+    threads.back()->Start();
+  }
+  for (const auto& thread : threads)
+    thread->Join();
+
+  for (int i = 0; i < kNumStrings; ++i) {
+    const InternedString expected = runners[0]->results()[i];
+    EXPECT_EQ("InternedStringTest.Threads." + IntToString(i),
+              expected.piece());
+    for (int j = 1; j < kNumThreads; ++j)
+      EXPECT_EQ(expected, runners[j]->results()[i]);
+  }
+}
+
+}  // namespace base
@@ -0,0 +1,340 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/strings/str_format.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "base/logging.h"
+#include "base/macros.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+// Writes the formatted string to a fixed size buffer, dropping what doesn't
+// fit but counting its length.
+class FormatOutput {
+ public:
+  FormatOutput(char* buffer, size_t buffer_size)
+      : buffer_(buffer), buffer_size_(buffer_size), size_(0) {}
+
+  void Append(const char* data, size_t size) {
+    if (size_ < buffer_size_ && size > 0)
+      memcpy(buffer_ + size_, data, std::min(size, buffer_size_ - size_));
+    size_ += size;
+  }
+
+  void AppendFill(char c, size_t count) {
+    if (size_ < buffer_size_ && count > 0)
+      memset(buffer_ + size_, c, std::min(count, buffer_size_ - size_));
+    size_ += count;
+  }
+
+  // The length of the whole output, including what didn't fit.
+  size_t size() const { return size_; }
+
+ private:
+  char* const buffer_;
+  const size_t buffer_size_;
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(FormatOutput);
+};
+
+// Appends |prefix|, then |zeros| '0's, then |body|, padded with spaces to
+// |spec.width| unless |spec| asks for zero padding, in which case more zeros
+// are added instead.
+void AppendPadded(const FormatSpec& spec,
+                  StringPiece prefix,
+                  size_t zeros,
+                  StringPiece body,
+                  bool can_zero_pad,
+                  FormatOutput* output) {
+  const size_t size = prefix.size() + zeros + body.size();
+  const size_t padding =
+      spec.width > 0 && static_cast<size_t>(spec.width) > size
+          ? spec.width - size
+          : 0;
+  const bool zero_pad = can_zero_pad && spec.zero_pad && !spec.left_align;
+  if (!spec.left_align && !zero_pad)
+    output->AppendFill(' ', padding);
+  output->Append(prefix.data(), prefix.size());
+  output->AppendFill('0', zeros + (zero_pad ? padding : 0));
+  output->Append(body.data(), body.size());
+  if (spec.left_align)
+    output->AppendFill(' ', padding);
+}
+
+void AppendInteger(const FormatSpec& spec,
+                   const FormatArg& arg,
+                   FormatOutput* output) {
+  const bool is_signed_conversion =
+      spec.conversion == 'd' || spec.conversion == 'i';
+  bool negative = false;
+  uint64_t value;
+  if (arg.type() == FormatArgType::kUnsigned) {
+    value = arg.unsigned_value();
+  } else if (is_signed_conversion) {
+    negative = arg.signed_value() < 0;
+    value = static_cast<uint64_t>(arg.signed_value());
+    if (negative)
+      value = 0 - value;
+  } else {
+    // Like printf(), other conversions take the bits of negative numbers as
+    // an unsigned number of the same size, after promoting types narrower
+    // than int to int.
+    value = static_cast<uint64_t>(arg.signed_value());
+    const size_t size = std::max(arg.int_size(), sizeof(int));
+    if (size < sizeof(value))
+      value &= (uint64_t{1} << (8 * size)) - 1;
+  }
+
+  if (spec.conversion == 'c') {
+    const char c = static_cast<char>(value);
+    AppendPadded(spec, StringPiece(), 0, StringPiece(&c, 1), false, output);
+    return;
+  }
+
+  const unsigned base = spec.conversion == 'o'
+                            ? 8
+                            : (spec.conversion == 'x' || spec.conversion == 'X')
+                                  ? 16
+                                  : 10;
+  // Enough for 64 bits in octal.
+  char buffer[24];
+  char* const end = buffer + arraysize(buffer);
+  char* start = end;
+  // Division by a constant is much faster than by a variable.
+  if (base == 10) {
+    for (uint64_t rest = value; rest; rest /= 10)
+      *--start = '0' + rest % 10;
+  } else {
+    const char* digits = spec.conversion == 'X' ? "0123456789ABCDEF"
+                                                : "0123456789abcdef";
+    const int shift = base == 16 ? 4 : 3;
+    for (uint64_t rest = value; rest; rest >>= shift)
+      *--start = digits[rest & (base - 1)];
+  }
+  size_t size = end - start;
+
+  // The precision is the minimum number of digits. A precision of 0 prints
+  // nothing for 0, and the default of 1 prints "0".
+  const size_t precision = spec.precision >= 0 ? spec.precision : 1;
+  size_t zeros = precision > size ? precision - size : 0;
+
+  StringPiece prefix;
+  if (negative)
+    prefix = "-";
+  else if (is_signed_conversion && spec.show_sign)
+    prefix = "+";
+  else if (is_signed_conversion && spec.space_sign)
+    prefix = " ";
+  else if (spec.alternate && base == 16 && value != 0)
+    prefix = spec.conversion == 'X' ? "0X" : "0x";
+  else if (spec.alternate && base == 8 && zeros == 0 &&
+           (size == 0 || *start != '0'))
+    zeros = 1;
+
+  AppendPadded(spec, prefix, zeros, StringPiece(start, size),
+               spec.precision < 0, output);
+}
+
+void AppendString(const FormatSpec& spec,
+                  const FormatArg& arg,
+                  FormatOutput* output) {
+  StringPiece string = arg.string_data()
+                           ? StringPiece(arg.string_data(), arg.string_size())
+                           : StringPiece("(null)");
+  if (spec.precision >= 0)
+    string = string.substr(0, spec.precision);
+  AppendPadded(spec, StringPiece(), 0, string, false, output);
+}
+
+// Floating point numbers are left to snprintf(), which knows how to round
+// them.
+void AppendDouble(const FormatSpec& spec,
+                  const FormatArg& arg,
+                  FormatOutput* output) {
+  const double value = arg.type() == FormatArgType::kDouble
+                           ? arg.double_value()
+                           : arg.type() == FormatArgType::kSigned
+                                 ? static_cast<double>(arg.signed_value())
+                                 : static_cast<double>(arg.unsigned_value());
+
+  char format[16];
+  char* f = format;
+  *f++ = '%';
+  if (spec.left_align)
+    *f++ = '-';
+  if (spec.show_sign)
+    *f++ = '+';
+  if (spec.space_sign)
+    *f++ = ' ';
+  if (spec.alternate)
+    *f++ = '#';
+  if (spec.zero_pad)
+    *f++ = '0';
+  *f++ = '*';
+  *f++ = '.';
+  *f++ = '*';
+  *f++ = spec.conversion;
+  *f = '\0';
+
+  // A negative precision given to printf() is as if there was none.
+  char buffer[64];
+  const int size = snprintf(buffer, sizeof(buffer), format,
+                            std::max(spec.width, 0), spec.precision, value);
+  if (size < 0)
+    return;
+  if (static_cast<size_t>(size) < sizeof(buffer)) {
+    output->Append(buffer, size);
+    return;
+  }
+  std::string large(size + 1, '\0');
+  snprintf(&large[0], large.size(), format, std::max(spec.width, 0),
+           spec.precision, value);
+  output->Append(large.data(), size);
+}
+
+void AppendPointer(const FormatSpec& spec,
+                   const FormatArg& arg,
+                   FormatOutput* output) {
+  char buffer[32];
+  const int size = snprintf(buffer, sizeof(buffer), "%p", arg.pointer_value());
+  if (size < 0 || static_cast<size_t>(size) >= sizeof(buffer))
+    return;
+  AppendPadded(spec, StringPiece(), 0, StringPiece(buffer, size), false,
+               output);
+}
+
+// Returns the value of an integer argument given for a '*', clamped to the
+// range of int.
+int GetStarValue(const FormatArg& arg) {
+  if (arg.type() == FormatArgType::kUnsigned) {
+    return static_cast<int>(std::min<uint64_t>(
+        arg.unsigned_value(), std::numeric_limits<int>::max()));
+  }
+  return static_cast<int>(
+      std::max<int64_t>(std::min<int64_t>(arg.signed_value(),
+                                          std::numeric_limits<int>::max()),
+                        -std::numeric_limits<int>::max()));
+}
+
+void Format(const char* format,
+            const FormatArg* args,
+            size_t num_args,
+            FormatOutput* output) {
+  size_t next_arg = 0;
+  const char* literal = format;
+  while (const char* percent = strchr(literal, '%')) {
+    output->Append(literal, percent - literal);
+
+    FormatSpec spec;
+    literal = ParseFormatSpec(percent + 1, &spec);
+    if (!literal) {
+      NOTREACHED() << "Invalid conversion in format string: " << format;
+      return;
+    }
+    if (spec.kind == ConversionKind::kPercent) {
+      output->Append("%", 1);
+      continue;
+    }
+
+    const size_t needed_args =
+        1 + spec.width_from_arg + spec.precision_from_arg;
+    bool args_match = num_args - next_arg >= needed_args;
+    for (size_t i = 0; args_match && i < needed_args - 1; ++i)
+      args_match = IsIntegerArg(args[next_arg + i].type());
+    if (!args_match ||
+        !ConversionAcceptsArg(spec.kind,
+                              args[next_arg + needed_args - 1].type())) {
+      NOTREACHED() << "Arguments from " << next_arg << " don't match "
+                   << StringPiece(percent, literal - percent)
+                   << " in format string: " << format;
+      return;
+    }
+
+    if (spec.width_from_arg) {
+      // A negative width means left alignment.
+      spec.width = GetStarValue(args[next_arg++]);
+      if (spec.width < 0) {
+        spec.left_align = true;
+        spec.width = -spec.width;
+      }
+    }
+    if (spec.precision_from_arg) {
+      // A negative precision is as if none was given.
+      spec.precision = std::max(GetStarValue(args[next_arg++]), -1);
+    }
+
+    const FormatArg& arg = args[next_arg++];
+    switch (spec.kind) {
+      case ConversionKind::kInteger:
+        AppendInteger(spec, arg, output);
+        break;
+      case ConversionKind::kFloat:
+        AppendDouble(spec, arg, output);
+        break;
+      case ConversionKind::kString:
+        AppendString(spec, arg, output);
+        break;
+      case ConversionKind::kPointer:
+        AppendPointer(spec, arg, output);
+        break;
+      case ConversionKind::kInvalid:
+      case ConversionKind::kPercent:
+        NOTREACHED();
+        break;
+    }
+  }
+  DCHECK_EQ(num_args, next_arg)
+      << "Too many arguments for format string: " << format;
+
+  output->Append(literal, strlen(literal));
+}
+
+}  // namespace
+
+void AppendFormat(std::string* dst,
+                  const char* format,
+                  const FormatArg* args,
+                  size_t num_args) {
+  // Most results fit on the stack. The others are formatted again, straight
+  // into |dst| now that their length is known. Strings that don't fit aren't
+  // copied the first time, so this mostly costs converting numbers twice.
+  char stack_buffer[512];
+  FormatOutput output(stack_buffer, sizeof(stack_buffer));
+  Format(format, args, num_args, &output);
+  if (output.size() <= sizeof(stack_buffer)) {
+    dst->append(stack_buffer, output.size());
+    return;
+  }
+
+  const size_t offset = dst->size();
+  dst->resize(offset + output.size());
+  FormatOutput exact_output(&(*dst)[offset], output.size());
+  Format(format, args, num_args, &exact_output);
+  DCHECK_EQ(output.size(), exact_output.size());
+}
+
+size_t FormatToBuffer(char* buffer,
+                      size_t buffer_size,
+                      const char* format,
+                      const FormatArg* args,
+                      size_t num_args) {
+  FormatOutput output(buffer, buffer_size);
+  Format(format, args, num_args, &output);
+  if (buffer_size > 0)
+    buffer[std::min(output.size(), buffer_size - 1)] = '\0';
+  return output.size();
+}
+
+}  // namespace internal
+}  // namespace base
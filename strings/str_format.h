@@ -0,0 +1,462 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_STRINGS_STR_FORMAT_H_
+#define BASE_STRINGS_STR_FORMAT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <type_traits>
+
+#include "base/base_export.h"
+#include "base/compiler_specific.h"
+#include "base/strings/string_piece.h"
+
+namespace base {
+
+// StrFormat -------------------------------------------------------------------
+//
+// StrFormat is a type-safe replacement for StringPrintf, with the same format
+// specifiers:
+//
+//   std::string name = base::StrFormat("%s.%d", prefix, index);
+//   base::StrAppendFormat(&json, ",\"ts\":%" PRId64, timestamp);
+//
+// Each conversion is checked against the type of its argument rather than
+// trusted: %d, %i, %u, %o, %x, %X and %c take any integer or unscoped enum,
+// %f, %e, %g and %a (and their capitals) any integer or floating point number,
+// %s a const char*, std::string or StringPiece, and %p any pointer. Length
+// modifiers such as l, ll and z, which PRId64 and friends expand to, are
+// accepted and ignored since the type of the argument is known. Flags, width
+// and precision, including * for either, behave as with printf(). %n and
+// positional arguments are not supported.
+//
+// Unlike printf(), %d and %i of an unsigned argument print its value rather
+// than reinterpreting its bits as signed, so StrFormat("%d", 4294967295u) is
+// "4294967295", not "-1".
+//
+// With clang, a literal format string that doesn't match its arguments is a
+// compile error. Other format strings are checked when formatting, in debug
+// builds.
+//
+// MORE INFO
+//
+// StrFormat formats into a 512-byte buffer on the stack and copies the result
+// out. Longer results are formatted a second time, straight into the
+// destination string once their length is known. Integers and strings are
+// converted without the C library; only floating point numbers and pointers
+// go through snprintf().
+
+namespace internal {
+
+// What an argument of StrFormat() is converted from.
+enum class FormatArgType : uint8_t {
+  kSigned,
+  kUnsigned,
+  kDouble,
+  kString,
+  kPointer,
+};
+
+// Defines kType for the types that StrFormat() accepts. Others fail to
+// compile.
+template <typename T, typename Enable = void>
+struct FormatArgTraits;
+
+template <typename T>
+struct FormatArgTraits<
+    T,
+    std::enable_if_t<std::is_integral<T>::value ||
+                     (std::is_enum<T>::value &&
+                      std::is_convertible<T, long long>::value)>> {
+  using Integer = typename std::conditional_t<std::is_enum<T>::value,
+                                              std::underlying_type<T>,
+                                              std::enable_if<true, T>>::type;
+  static constexpr FormatArgType kType = std::is_signed<Integer>::value
+                                             ? FormatArgType::kSigned
+                                             : FormatArgType::kUnsigned;
+};
+
+template <typename T>
+struct FormatArgTraits<T, std::enable_if_t<std::is_floating_point<T>::value>> {
+  static constexpr FormatArgType kType = FormatArgType::kDouble;
+};
+
+template <typename T>
+struct FormatArgTraits<
+    T,
+    std::enable_if_t<std::is_convertible<T, StringPiece>::value &&
+                     !std::is_same<T, std::nullptr_t>::value>> {
+  static constexpr FormatArgType kType = FormatArgType::kString;
+};
+
+template <typename T>
+struct FormatArgTraits<
+    T*,
+    std::enable_if_t<!std::is_same<std::remove_cv_t<T>, char>::value>> {
+  static constexpr FormatArgType kType = FormatArgType::kPointer;
+};
+
+template <>
+struct FormatArgTraits<std::nullptr_t> {
+  static constexpr FormatArgType kType = FormatArgType::kPointer;
+};
+
+// An argument of StrFormat(), with its type erased so that the formatting
+// code isn't instantiated for every combination of arguments.
+class FormatArg {
+ public:
+  FormatArg() : type_(FormatArgType::kSigned), int_size_(0) { value_.i = 0; }
+
+  // Arrays are taken as pointers, as with printf().
+  template <typename T>
+  explicit FormatArg(const T& value)
+      : FormatArg(value,
+                  std::integral_constant<
+                      FormatArgType,
+                      FormatArgTraits<std::decay_t<T>>::kType>()) {}
+
+  FormatArgType type() const { return type_; }
+
+  // Integers, as the signed or unsigned type they were passed as. printf()
+  // conversions that reinterpret the sign of their argument, such as %x of
+  // -1, need its size.
+  int64_t signed_value() const { return value_.i; }
+  uint64_t unsigned_value() const { return value_.u; }
+  size_t int_size() const { return int_size_; }
+
+  double double_value() const { return value_.d; }
+
+  // |string_data()| is null for a null const char*.
+  const char* string_data() const { return value_.s.data; }
+  size_t string_size() const { return value_.s.size; }
+
+  const void* pointer_value() const { return value_.p; }
+
+ private:
+  template <typename T>
+  FormatArg(const T& value,
+            std::integral_constant<FormatArgType, FormatArgType::kSigned>)
+      : type_(FormatArgType::kSigned), int_size_(sizeof(T)) {
+    value_.i = static_cast<int64_t>(value);
+  }
+
+  template <typename T>
+  FormatArg(const T& value,
+            std::integral_constant<FormatArgType, FormatArgType::kUnsigned>)
+      : type_(FormatArgType::kUnsigned), int_size_(sizeof(T)) {
+    value_.u = static_cast<uint64_t>(value);
+  }
+
+  template <typename T>
+  FormatArg(const T& value,
+            std::integral_constant<FormatArgType, FormatArgType::kDouble>)
+      : type_(FormatArgType::kDouble), int_size_(0) {
+    value_.d = static_cast<double>(value);
+  }
+
+  template <typename T>
+  FormatArg(const T& value,
+            std::integral_constant<FormatArgType, FormatArgType::kString>)
+      : type_(FormatArgType::kString), int_size_(0) {
+    const StringPiece piece(value);
+    value_.s.data = piece.data();
+    value_.s.size = piece.size();
+  }
+
+  template <typename T>
+  FormatArg(const T& value,
+            std::integral_constant<FormatArgType, FormatArgType::kPointer>)
+      : type_(FormatArgType::kPointer), int_size_(0) {
+    value_.p = static_cast<const void*>(value);
+  }
+
+  FormatArgType type_;
+  uint8_t int_size_;
+  union {
+    int64_t i;
+    uint64_t u;
+    double d;
+    struct {
+      const char* data;
+      size_t size;
+    } s;
+    const void* p;
+  } value_;
+};
+
+constexpr bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+constexpr bool IsLengthModifier(char c) {
+  return c == 'h' || c == 'l' || c == 'L' || c == 'j' || c == 'z' ||
+         c == 't' || c == 'q';
+}
+
+// What a conversion character converts.
+enum class ConversionKind : uint8_t {
+  kInvalid,
+  kInteger,
+  kFloat,
+  kString,
+  kPointer,
+  kPercent,
+};
+
+constexpr ConversionKind GetConversionKind(char conversion) {
+  switch (conversion) {
+    case 'd':
+    case 'i':
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+    case 'c':
+      return ConversionKind::kInteger;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+      return ConversionKind::kFloat;
+    case 's':
+      return ConversionKind::kString;
+    case 'p':
+      return ConversionKind::kPointer;
+    case '%':
+      return ConversionKind::kPercent;
+    default:
+      return ConversionKind::kInvalid;
+  }
+}
+
+// A conversion specification, the part of a format string that starts with
+// '%'.
+struct FormatSpec {
+  bool left_align = false;    // '-'
+  bool show_sign = false;     // '+'
+  bool space_sign = false;    // ' '
+  bool alternate = false;     // '#'
+  bool zero_pad = false;      // '0'
+  bool width_from_arg = false;
+  bool precision_from_arg = false;
+  // -1 when not given.
+  int width = -1;
+  int precision = -1;
+  char conversion = 0;
+  ConversionKind kind = ConversionKind::kInvalid;
+};
+
+// Parses the specification that |format| starts with, just after its '%',
+// into |spec|. Returns the position after it, or null if it isn't valid.
+constexpr const char* ParseFormatSpec(const char* format, FormatSpec* spec) {
+  for (;; ++format) {
+    if (*format == '-')
+      spec->left_align = true;
+    else if (*format == '+')
+      spec->show_sign = true;
+    else if (*format == ' ')
+      spec->space_sign = true;
+    else if (*format == '#')
+      spec->alternate = true;
+    else if (*format == '0')
+      spec->zero_pad = true;
+    else
+      break;
+  }
+
+  if (*format == '*') {
+    spec->width_from_arg = true;
+    ++format;
+  } else if (IsDigit(*format)) {
+    spec->width = 0;
+    for (; IsDigit(*format); ++format) {
+      if (spec->width > 100000)
+        return nullptr;
+      spec->width = spec->width * 10 + (*format - '0');
+    }
+  }
+
+  if (*format == '.') {
+    ++format;
+    spec->precision = 0;
+    if (*format == '*') {
+      spec->precision_from_arg = true;
+      ++format;
+    } else {
+      for (; IsDigit(*format); ++format) {
+        if (spec->precision > 100000)
+          return nullptr;
+        spec->precision = spec->precision * 10 + (*format - '0');
+      }
+    }
+  }
+
+  while (IsLengthModifier(*format))
+    ++format;
+
+  spec->kind = GetConversionKind(*format);
+  if (spec->kind == ConversionKind::kInvalid)
+    return nullptr;
+  spec->conversion = *format;
+  return format + 1;
+}
+
+constexpr bool IsIntegerArg(FormatArgType type) {
+  return type == FormatArgType::kSigned || type == FormatArgType::kUnsigned;
+}
+
+// Returns whether an argument of |type| can be converted by a conversion of
+// |kind|.
+constexpr bool ConversionAcceptsArg(ConversionKind kind, FormatArgType type) {
+  switch (kind) {
+    case ConversionKind::kInteger:
+      return IsIntegerArg(type);
+    case ConversionKind::kFloat:
+      return IsIntegerArg(type) || type == FormatArgType::kDouble;
+    case ConversionKind::kString:
+      return type == FormatArgType::kString;
+    case ConversionKind::kPointer:
+      return type == FormatArgType::kPointer;
+    case ConversionKind::kInvalid:
+    case ConversionKind::kPercent:
+      return false;
+  }
+  return false;
+}
+
+// Returns whether |format| is valid and takes exactly |num_args| arguments of
+// the types in |arg_types|.
+constexpr bool FormatMatchesArgs(const char* format,
+                                 const FormatArgType* arg_types,
+                                 size_t num_args) {
+  size_t arg = 0;
+  while (*format) {
+    if (*format++ != '%')
+      continue;
+    FormatSpec spec{};
+    format = ParseFormatSpec(format, &spec);
+    if (!format)
+      return false;
+    if (spec.kind == ConversionKind::kPercent)
+      continue;
+    if (spec.width_from_arg &&
+        (arg == num_args || !IsIntegerArg(arg_types[arg++]))) {
+      return false;
+    }
+    if (spec.precision_from_arg &&
+        (arg == num_args || !IsIntegerArg(arg_types[arg++]))) {
+      return false;
+    }
+    if (arg == num_args ||
+        !ConversionAcceptsArg(spec.kind, arg_types[arg++])) {
+      return false;
+    }
+  }
+  return arg == num_args;
+}
+
+template <typename... Args>
+constexpr bool FormatMatchesArgs(const char* format) {
+  // One more than needed, so that the array isn't empty.
+  const FormatArgType arg_types[sizeof...(Args) + 1] = {
+      FormatArgTraits<Args>::kType...};
+  return FormatMatchesArgs(format, arg_types, sizeof...(Args));
+}
+
+// A format string for arguments of types |Args|, checked at compile time
+// where the compiler supports it.
+template <typename... Args>
+class FormatString {
+ public:
+  // Implicit, so that string literals can be passed to StrFormat().
+  constexpr FormatString(const char* format)
+#if defined(__clang__) && defined(__has_attribute)
+#if __has_attribute(diagnose_if)
+      __attribute__((diagnose_if(!FormatMatchesArgs<Args...>(format),
+                                 "format string doesn't match the arguments",
+                                 "error")))
+#endif
+#endif
+      : format_(format) {
+  }
+
+  constexpr const char* get() const { return format_; }
+
+ private:
+  const char* format_;
+};
+
+template <typename... Args>
+struct FormatStringHolder {
+  using Type = FormatString<std::decay_t<Args>...>;
+};
+
+// Keeps the format string from taking part in template argument deduction,
+// so that |Args| are deduced from the arguments only.
+template <typename... Args>
+using FormatStringFor = typename FormatStringHolder<Args...>::Type;
+
+BASE_EXPORT void AppendFormat(std::string* dst,
+                              const char* format,
+                              const FormatArg* args,
+                              size_t num_args);
+
+BASE_EXPORT size_t FormatToBuffer(char* buffer,
+                                  size_t buffer_size,
+                                  const char* format,
+                                  const FormatArg* args,
+                                  size_t num_args);
+
+}  // namespace internal
+
+// Returns |format| formatted with |args|.
+template <typename... Args>
+std::string StrFormat(internal::FormatStringFor<Args...> format,
+                      const Args&... args) WARN_UNUSED_RESULT;
+
+template <typename... Args>
+std::string StrFormat(internal::FormatStringFor<Args...> format,
+                      const Args&... args) {
+  const internal::FormatArg format_args[sizeof...(Args) + 1] = {
+      internal::FormatArg(args)...};
+  std::string result;
+  internal::AppendFormat(&result, format.get(), format_args, sizeof...(Args));
+  return result;
+}
+
+// Appends |format| formatted with |args| to |dst|.
+template <typename... Args>
+void StrAppendFormat(std::string* dst,
+                     internal::FormatStringFor<Args...> format,
+                     const Args&... args) {
+  const internal::FormatArg format_args[sizeof...(Args) + 1] = {
+      internal::FormatArg(args)...};
+  internal::AppendFormat(dst, format.get(), format_args, sizeof...(Args));
+}
+
+// Formats into a buffer, usually on the stack, without allocating. Like
+// snprintf(), writes as much of the result as fits in |buffer| followed by a
+// null character, unless |buffer_size| is 0, and returns the length of the
+// whole result.
+template <typename... Args>
+size_t StrFormatToBuffer(char* buffer,
+                         size_t buffer_size,
+                         internal::FormatStringFor<Args...> format,
+                         const Args&... args) {
+  const internal::FormatArg format_args[sizeof...(Args) + 1] = {
+      internal::FormatArg(args)...};
+  return internal::FormatToBuffer(buffer, buffer_size, format.get(),
+                                  format_args, sizeof...(Args));
+}
+
+}  // namespace base
+
+#endif  // BASE_STRINGS_STR_FORMAT_H_
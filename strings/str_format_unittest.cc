@@ -0,0 +1,189 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/strings/str_format.h"
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <limits>
+#include <string>
+
+#include "base/strings/string_piece.h"
+#include "base/strings/stringprintf.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+enum Color { kRed, kGreen };
+
+}  // namespace
+
+TEST(StrFormatTest, Basic) {
+  EXPECT_EQ("", StrFormat(""));
+  EXPECT_EQ("no conversions", StrFormat("no conversions"));
+  EXPECT_EQ("100%", StrFormat("%d%%", 100));
+  EXPECT_EQ("123hello w", StrFormat("%3d%2s %1c", 123, "hello", 'w'));
+  EXPECT_EQ("a.1", StrFormat("%s.%d", std::string("a"), 1));
+  EXPECT_EQ("piece", StrFormat("%s", StringPiece("piece and more", 5)));
+  EXPECT_EQ("1 1", StrFormat("%d %u", kGreen, kGreen));
+  EXPECT_EQ("1 0", StrFormat("%d %d", true, false));
+  EXPECT_EQ("(null)", StrFormat("%s", static_cast<const char*>(nullptr)));
+
+  char buffer[] = "array";
+  EXPECT_EQ("array", StrFormat("%s", buffer));
+}
+
+TEST(StrFormatTest, LengthModifiers) {
+  const int64_t big = std::numeric_limits<int64_t>::min();
+  EXPECT_EQ("-9223372036854775808", StrFormat("%" PRId64, big));
+  EXPECT_EQ("18446744073709551615",
+            StrFormat("%" PRIu64, std::numeric_limits<uint64_t>::max()));
+  EXPECT_EQ("ff", StrFormat("%" PRIx64, uint64_t{255}));
+  EXPECT_EQ("7 7 7 7", StrFormat("%ld %zu %hhd %lld", 7L, size_t{7}, 7, 7LL));
+}
+
+// Negative numbers converted as unsigned are taken as unsigned numbers of the
+// same size, with types narrower than int promoted to int, as with printf().
+TEST(StrFormatTest, SignReinterpretation) {
+  EXPECT_EQ("ffffffff", StrFormat("%x", -1));
+  EXPECT_EQ(StringPrintf("%x", static_cast<int8_t>(-1)),
+            StrFormat("%x", static_cast<int8_t>(-1)));
+  EXPECT_EQ("ffffffff", StrFormat("%x", static_cast<int16_t>(-1)));
+  EXPECT_EQ("ffffffffffffffff", StrFormat("%x", int64_t{-1}));
+  EXPECT_EQ("4294967295", StrFormat("%u", -1));
+}
+
+// Unlike printf(), signed conversions of unsigned numbers keep their value.
+TEST(StrFormatTest, UnsignedAsSigned) {
+  EXPECT_EQ("4294967295", StrFormat("%d", 4294967295u));
+  EXPECT_EQ("255", StrFormat("%d", uint8_t{255}));
+}
+
+// Compares with snprintf() for combinations of flags, width and precision.
+TEST(StrFormatTest, MatchesSnprintf) {
+  const char* const kFlags[] = {"", "-", "+", " ", "#", "0", "-0", "+0", "#0"};
+  const char* const kWidths[] = {"", "1", "5", "12"};
+  const char* const kPrecisions[] = {"", ".", ".0", ".3", ".10"};
+
+  for (const char* flags : kFlags) {
+    for (const char* width : kWidths) {
+      for (const char* precision : kPrecisions) {
+        const std::string spec =
+            std::string("%") + flags + width + precision;
+        for (char conversion : std::string("diouxX")) {
+          const std::string format = spec + conversion;
+          for (int value : {0, 1, -1, 42, -12345, 0x7fffffff}) {
+            EXPECT_EQ(StringPrintf(format.c_str(), value),
+                      StrFormat(format.c_str(), value))
+                << format << " " << value;
+          }
+        }
+        for (char conversion : std::string("fFeEgGaA")) {
+          const std::string format = spec + conversion;
+          for (double value : {0.0, -0.0, 1.5, -2.25e-7, 12345.678, 1e300}) {
+            EXPECT_EQ(StringPrintf(format.c_str(), value),
+                      StrFormat(format.c_str(), value))
+                << format << " " << value;
+          }
+        }
+        if (std::string(flags).find_first_of("+ #0") == std::string::npos) {
+          const std::string format = spec + 's';
+          for (const char* value : {"", "a", "hello world"}) {
+            EXPECT_EQ(StringPrintf(format.c_str(), value),
+                      StrFormat(format.c_str(), value))
+                << format << " " << value;
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(StrFormatTest, StarWidthAndPrecision) {
+  EXPECT_EQ("   42", StrFormat("%*d", 5, 42));
+  EXPECT_EQ("42   |", StrFormat("%*d|", -5, 42));
+  EXPECT_EQ("hel", StrFormat("%.*s", 3, "hello"));
+  EXPECT_EQ("hello", StrFormat("%.*s", -1, "hello"));
+  EXPECT_EQ("  1.50", StrFormat("%*.*f", 6, 2, 1.5));
+  EXPECT_EQ("ab", StrFormat("%.*s", size_t{2}, std::string("abc")));
+}
+
+TEST(StrFormatTest, IntegersAsDoubles) {
+  EXPECT_EQ("3.0", StrFormat("%.1f", 3));
+  EXPECT_EQ("1e+10", StrFormat("%g", int64_t{10000000000}));
+}
+
+TEST(StrFormatTest, Pointers) {
+  int value;
+  EXPECT_EQ(StringPrintf("%p", &value), StrFormat("%p", &value));
+  EXPECT_EQ(StringPrintf("%p", static_cast<void*>(nullptr)),
+            StrFormat("%p", nullptr));
+  const std::string formatted = StringPrintf("%p", &value);
+  EXPECT_EQ(std::string(20 - formatted.size(), ' ') + formatted,
+            StrFormat("%20p", &value));
+}
+
+TEST(StrFormatTest, LongOutput) {
+  const std::string long_string(5000, 'x');
+  EXPECT_EQ(long_string + "!", StrFormat("%s!", long_string));
+  EXPECT_EQ(StringPrintf("%f", 1e300), StrFormat("%f", 1e300));
+  EXPECT_EQ(std::string(2000, ' ') + "1", StrFormat("%2001d", 1));
+}
+
+TEST(StrFormatTest, StrAppendFormat) {
+  std::string value("Hello");
+  StrAppendFormat(&value, " %s", "World");
+  EXPECT_EQ("Hello World", value);
+  StrAppendFormat(&value, "");
+  EXPECT_EQ("Hello World", value);
+  for (int i = 0; i < 3; ++i)
+    StrAppendFormat(&value, ",%d", i);
+  EXPECT_EQ("Hello World,0,1,2", value);
+}
+
+TEST(StrFormatTest, StrFormatToBuffer) {
+  char buffer[8];
+  EXPECT_EQ(5u, StrFormatToBuffer(buffer, sizeof(buffer), "%d-%s", 12, "ab"));
+  EXPECT_STREQ("12-ab", buffer);
+
+  // Truncated, like snprintf().
+  EXPECT_EQ(11u, StrFormatToBuffer(buffer, sizeof(buffer), "%s %5d",
+                                   "hello", 1));
+  EXPECT_STREQ("hello  ", buffer);
+
+  buffer[0] = 'z';
+  EXPECT_EQ(3u, StrFormatToBuffer(buffer, 0, "%d", 123));
+  EXPECT_EQ('z', buffer[0]);
+}
+
+TEST(StrFormatTest, FormatMatchesArgs) {
+  using internal::FormatArgType;
+  using internal::FormatMatchesArgs;
+
+  static_assert(FormatMatchesArgs<>("plain %% text"), "");
+  static_assert(FormatMatchesArgs<int, const char*>("%5d %-10s"), "");
+  static_assert(FormatMatchesArgs<int, std::string>("%.*s"), "");
+  static_assert(FormatMatchesArgs<int64_t>("%" PRId64), "");
+  static_assert(FormatMatchesArgs<float, unsigned>("%.2f %g"), "");
+  static_assert(FormatMatchesArgs<const void*, std::nullptr_t>("%p %p"), "");
+  static_assert(FormatMatchesArgs<Color>("%d"), "");
+
+  static_assert(!FormatMatchesArgs<>("%d"), "");
+  static_assert(!FormatMatchesArgs<int>("%s"), "");
+  static_assert(!FormatMatchesArgs<const char*>("%d"), "");
+  static_assert(!FormatMatchesArgs<double>("%d"), "");
+  static_assert(!FormatMatchesArgs<int*>("%s"), "");
+  static_assert(!FormatMatchesArgs<int, int>("%d"), "");
+  static_assert(!FormatMatchesArgs<std::string>("%.*s"), "");
+  static_assert(!FormatMatchesArgs<int>("%n"), "");
+  static_assert(!FormatMatchesArgs<int>("%1$d"), "");
+  static_assert(!FormatMatchesArgs<>("trailing %"), "");
+}
+
+}  // namespace base
@@ -0,0 +1,55 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This is a "No Compile Test".
+// http://dev.chromium.org/developers/testing/no-compile-tests
+
+#include "base/strings/str_format.h"
+
+#include <string>
+
+namespace base {
+
+#if defined(NCTEST_STRING_FOR_INTEGER)  // [r"format string doesn't match the arguments"]
+
+void WontCompile() {
+  std::string s = StrFormat("%d", "text");
+}
+
+#elif defined(NCTEST_INTEGER_FOR_STRING)  // [r"format string doesn't match the arguments"]
+
+void WontCompile() {
+  std::string s = StrFormat("%s", 1);
+}
+
+#elif defined(NCTEST_MISSING_ARGUMENT)  // [r"format string doesn't match the arguments"]
+
+void WontCompile() {
+  std::string s = StrFormat("%d %d", 1);
+}
+
+#elif defined(NCTEST_EXTRA_ARGUMENT)  // [r"format string doesn't match the arguments"]
+
+void WontCompile() {
+  std::string s = StrFormat("%d", 1, 2);
+}
+
+#elif defined(NCTEST_UNSUPPORTED_CONVERSION)  // [r"format string doesn't match the arguments"]
+
+void WontCompile() {
+  int count;
+  std::string s = StrFormat("%n", &count);
+}
+
+#elif defined(NCTEST_UNSUPPORTED_TYPE)  // [r"implicit instantiation of undefined template"]
+
+struct NotFormattable {};
+
+void WontCompile() {
+  std::string s = StrFormat("%d", NotFormattable());
+}
+
+#endif
+
+}  // namespace base
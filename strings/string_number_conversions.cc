@@ -15,6 +15,7 @@
 #include "base/logging.h"
 #include "base/numerics/safe_math.h"
 #include "base/scoped_clear_errno.h"
+#include "base/strings/double_conversions_internal.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/third_party/dmg_fp/dmg_fp.h"
 
@@ -361,20 +362,18 @@ string16 NumberToString16(unsigned long long value) {
 }
 
 std::string NumberToString(double value) {
-  // According to g_fmt.cc, it is sufficient to declare a buffer of size 32.
-  char buffer[32];
-  dmg_fp::g_fmt(buffer, value);
-  return std::string(buffer);
+  char buffer[internal::kDoubleToStringBufferSize];
+  size_t length = internal::DoubleToShortestString(value, buffer);
+  return std::string(buffer, length);
 }
 
 base::string16 NumberToString16(double value) {
-  // According to g_fmt.cc, it is sufficient to declare a buffer of size 32.
-  char buffer[32];
-  dmg_fp::g_fmt(buffer, value);
+  char buffer[internal::kDoubleToStringBufferSize];
+  size_t length = internal::DoubleToShortestString(value, buffer);
 
   // The number will be ASCII. This creates the string using the "input
   // iterator" variant which promotes from 8-bit to 16-bit via "=".
-  return base::string16(&buffer[0], &buffer[strlen(buffer)]);
+  return base::string16(&buffer[0], &buffer[length]);
 }
 
 bool StringToInt(StringPiece input, int* output) {
@@ -417,12 +416,19 @@ bool StringToSizeT(StringPiece16 input, size_t* output) {
   return String16ToIntImpl(input, output);
 }
 
-bool StringToDouble(const std::string& input, double* output) {
+bool StringToDouble(StringPiece input, double* output) {
+  // Plain decimal numbers, which is what most callers parse, are converted
+  // without dmg_fp, nor a copy of the input.
+  if (internal::FastStringToDouble(input, output))
+    return true;
+
   // Thread-safe?  It is on at least Mac, Linux, and Windows.
   ScopedClearErrno clear_errno;
 
+  // dmg_fp::strtod() needs a null-terminated string.
+  const std::string input_string = input.as_string();
   char* endptr = nullptr;
-  *output = dmg_fp::strtod(input.c_str(), &endptr);
+  *output = dmg_fp::strtod(input_string.c_str(), &endptr);
 
   // Cases to return false:
   //  - If errno is ERANGE, there was an overflow or underflow.
@@ -434,19 +440,15 @@ bool StringToDouble(const std::string& input, double* output) {
   //    where the string contains embedded NUL characters.
   //  - If the first character is a space, there was leading whitespace
   return errno == 0 &&
-         !input.empty() &&
-         input.c_str() + input.length() == endptr &&
-         !isspace(input[0]);
+         !input_string.empty() &&
+         input_string.c_str() + input_string.length() == endptr &&
+         !isspace(input_string[0]);
 }
 
 // Note: if you need to add String16ToDouble, first ask yourself if it's
 // really necessary. If it is, probably the best implementation here is to
 // convert to 8-bit and then use the 8-bit version.
 
-// Note: if you need to add an iterator range version of StringToDouble, first
-// ask yourself if it's really necessary. If it is, probably the best
-// implementation here is to instantiate a string and use the string version.
-
 std::string HexEncode(const void* bytes, size_t size) {
   static const char kHexChars[] = "0123456789ABCDEF";
 
@@ -14,7 +14,6 @@
 extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
   base::StringPiece string_piece_input(reinterpret_cast<const char*>(data),
                                        size);
-  std::string string_input(reinterpret_cast<const char*>(data), size);
 
   int out_int;
   base::StringToInt(string_piece_input, &out_int);
@@ -40,7 +39,7 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
   }
 
   double out_double;
-  base::StringToDouble(string_input, &out_double);
+  base::StringToDouble(string_piece_input, &out_double);
 
   base::HexStringToInt(string_piece_input, &out_int);
   base::HexStringToUInt(string_piece_input, &out_uint);
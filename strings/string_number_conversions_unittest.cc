@@ -811,6 +811,12 @@ TEST(StringNumberConversionsTest, StringToDouble) {
   double output;
   EXPECT_FALSE(StringToDouble(input_string, &output));
   EXPECT_DOUBLE_EQ(3.14, output);
+
+  // A StringPiece needn't be null-terminated.
+  EXPECT_TRUE(StringToDouble(StringPiece("2.5e3x", 5), &output));
+  EXPECT_DOUBLE_EQ(2500.0, output);
+  EXPECT_TRUE(StringToDouble(StringPiece("12345678901234567890", 3), &output));
+  EXPECT_DOUBLE_EQ(123.0, output);
 }
 
 TEST(StringNumberConversionsTest, DoubleToString) {
@@ -825,6 +831,24 @@ TEST(StringNumberConversionsTest, DoubleToString) {
     {1.33505e+012, "1.33505e+12"},
     {1.33545e+009, "1335450000"},
     {1.33503e+009, "1335030000"},
+    {-0.0, "-0"},
+    {-1.5, "-1.5"},
+    {0.1, ".1"},
+    {0.001, ".001"},
+    {0.0001, ".0001"},
+    {0.00001, "1e-05"},
+    {123456.0, "123456"},
+    {1e20, "1e+20"},
+    {1.5e6, "1500000"},
+    {1.5e7, "1.5e+07"},
+    {1e21, "1e+21"},
+    {1.5e300, "1.5e+300"},
+    {1.7976931348623157e308, "1.7976931348623157e+308"},
+    {2.2250738585072014e-308, "2.2250738585072014e-308"},
+    {4.9406564584124654e-324, "5e-324"},
+    {std::numeric_limits<double>::infinity(), "Infinity"},
+    {-std::numeric_limits<double>::infinity(), "-Infinity"},
+    {std::numeric_limits<double>::quiet_NaN(), "NaN"},
   };
 
   for (size_t i = 0; i < arraysize(cases); ++i) {
@@ -852,6 +876,44 @@ TEST(StringNumberConversionsTest, HexEncode) {
   EXPECT_EQ(hex.compare("01FF02FE038081"), 0);
 }
 
+// Every double that StringToDouble() accepts is written with the fewest digits
+// that read back as the same double. Subnormals are rejected as underflows.
+TEST(StringNumberConversionsTest, DoubleRoundTrip) {
+  static const uint64_t kBits[] = {
+      0x0010000000000000ULL,  // Smallest normal.
+      0x3fb999999999999aULL,  // 0.1
+      0x3fd5555555555555ULL,  // 1/3
+      0x4340000000000001ULL,  // 2^53 + 2
+      0x44b52d02c7e14af6ULL,  // 1e23
+      0x7fefffffffffffffULL,  // Largest normal.
+  };
+  for (uint64_t bits : kBits) {
+    for (uint64_t sign : {0ULL, 0x8000000000000000ULL}) {
+      const double input = bit_cast<double>(bits | sign);
+      double output;
+      EXPECT_TRUE(StringToDouble(NumberToString(input), &output))
+          << NumberToString(input);
+      EXPECT_EQ(bits | sign, bit_cast<uint64_t>(output))
+          << NumberToString(input);
+    }
+  }
+
+  // Neighbours of powers of 10, where the shortest output is hardest to find.
+  for (int exponent = -300; exponent <= 300; exponent += 7) {
+    const uint64_t bits = bit_cast<uint64_t>(std::pow(10.0, exponent));
+    for (uint64_t neighbour = bits - 2; neighbour <= bits + 2; ++neighbour) {
+      const double input = bit_cast<double>(neighbour);
+      double output;
+      EXPECT_TRUE(StringToDouble(NumberToString(input), &output))
+          << NumberToString(input);
+      EXPECT_EQ(neighbour, bit_cast<uint64_t>(output))
+          << NumberToString(input);
+    }
+  }
+  EXPECT_EQ("1e+23", NumberToString(1e23));
+  EXPECT_EQ("9007199254740994", NumberToString(9007199254740994.0));
+}
+
 // Test cases of known-bad strtod conversions that motivated the use of dmg_fp.
 // See https://bugs.chromium.org/p/chromium/issues/detail?id=593512.
 TEST(StringNumberConversionsTest, StrtodFailures) {
@@ -5,35 +5,15 @@
 
 #include "base/strings/string_piece.h"
 
-#include <limits.h>
-
 #include <algorithm>
 #include <ostream>
 #include <string.h>
 
+#include "base/strings/char_set_internal.h"
+
 // #include "base/logging.h"
 
 namespace base {
-namespace {
-
-// For each character in characters_wanted, sets the index corresponding
-// to the ASCII code of that character to 1 in table.  This is used by
-// the find_.*_of methods below to tell whether or not a character is in
-// the lookup table in constant time.
-// The argument `table' must be an array that is large enough to hold all
-// the possible values of an unsigned char.  Thus it should be be declared
-// as follows:
-//   bool table[UCHAR_MAX + 1]
-inline void BuildLookupTable(const StringPiece& characters_wanted,
-                             bool* table) {
-  const size_t length = characters_wanted.length();
-  const char* const data = characters_wanted.data();
-  for (size_t i = 0; i < length; ++i) {
-    table[static_cast<unsigned char>(data[i])] = true;
-  }
-}
-
-}  // namespace
 
 // MSVC doesn't like complex extern templates and DLLs.
 #if !defined(COMPILER_MSVC)
@@ -118,8 +98,23 @@ size_t findT(const BasicStringPiece<STR>& self,
   return xpos + s.size() <= self.size() ? xpos : BasicStringPiece<STR>::npos;
 }
 
+// 8-bit version, which looks for the first character with memchr().
 size_t find(const StringPiece& self, const StringPiece& s, size_t pos) {
-  return findT(self, s, pos);
+  if (pos > self.size() || s.size() > self.size() - pos)
+    return StringPiece::npos;
+  if (s.empty())
+    return pos;
+
+  const char* const last_start = self.data() + self.size() - s.size();
+  for (const char* start = self.data() + pos; start <= last_start; ++start) {
+    start = static_cast<const char*>(
+        memchr(start, s.data()[0], last_start - start + 1));
+    if (!start)
+      break;
+    if (memcmp(start + 1, s.data() + 1, s.size() - 1) == 0)
+      return static_cast<size_t>(start - self.data());
+  }
+  return StringPiece::npos;
 }
 
 size_t find(const StringPiece16& self, const StringPiece16& s, size_t pos) {
@@ -140,7 +135,13 @@ size_t findT(const BasicStringPiece<STR>& self,
 }
 
 size_t find(const StringPiece& self, char c, size_t pos) {
-  return findT(self, c, pos);
+  if (pos >= self.size())
+    return StringPiece::npos;
+
+  const void* result = memchr(self.data() + pos, c, self.size() - pos);
+  return result ? static_cast<size_t>(static_cast<const char*>(result) -
+                                      self.data())
+                : StringPiece::npos;
 }
 
 size_t find(const StringPiece16& self, char16 c, size_t pos) {
@@ -198,25 +199,18 @@ size_t rfind(const StringPiece16& self, char16 c, size_t pos) {
   return rfindT(self, c, pos);
 }
 
-// 8-bit version using lookup table.
+// 8-bit version using a CharSet.
 size_t find_first_of(const StringPiece& self,
                      const StringPiece& s,
                      size_t pos) {
   if (self.size() == 0 || s.size() == 0)
     return StringPiece::npos;
 
-  // Avoid the cost of BuildLookupTable() for a single-character search.
+  // Avoid the cost of building a CharSet for a single-character search.
   if (s.size() == 1)
     return find(self, s.data()[0], pos);
 
-  bool lookup[UCHAR_MAX + 1] = { false };
-  BuildLookupTable(s, lookup);
-  for (size_t i = pos; i < self.size(); ++i) {
-    if (lookup[static_cast<unsigned char>(self.data()[i])]) {
-      return i;
-    }
-  }
-  return StringPiece::npos;
+  return CharSet(s).FindFirstIn(self, pos);
 }
 
 // 16-bit brute force version.
@@ -230,7 +224,7 @@ size_t find_first_of(const StringPiece16& self,
   return found - self.begin();
 }
 
-// 8-bit version using lookup table.
+// 8-bit version using a CharSet.
 size_t find_first_not_of(const StringPiece& self,
                          const StringPiece& s,
                          size_t pos) {
@@ -240,18 +234,11 @@ size_t find_first_not_of(const StringPiece& self,
   if (s.size() == 0)
     return 0;
 
-  // Avoid the cost of BuildLookupTable() for a single-character search.
+  // Avoid the cost of building a CharSet for a single-character search.
   if (s.size() == 1)
     return find_first_not_of(self, s.data()[0], pos);
 
-  bool lookup[UCHAR_MAX + 1] = { false };
-  BuildLookupTable(s, lookup);
-  for (size_t i = pos; i < self.size(); ++i) {
-    if (!lookup[static_cast<unsigned char>(self.data()[i])]) {
-      return i;
-    }
-  }
-  return StringPiece::npos;
+  return CharSet(s).FindFirstNotIn(self, pos);
 }
 
 // 16-bit brute-force version.
@@ -302,19 +289,18 @@ size_t find_first_not_of(const StringPiece16& self,
   return find_first_not_ofT(self, c, pos);
 }
 
-// 8-bit version using lookup table.
+// 8-bit version using a CharSet.
 size_t find_last_of(const StringPiece& self, const StringPiece& s, size_t pos) {
   if (self.size() == 0 || s.size() == 0)
     return StringPiece::npos;
 
-  // Avoid the cost of BuildLookupTable() for a single-character search.
+  // Avoid the cost of building a CharSet for a single-character search.
   if (s.size() == 1)
     return rfind(self, s.data()[0], pos);
 
-  bool lookup[UCHAR_MAX + 1] = { false };
-  BuildLookupTable(s, lookup);
+  const CharSet set(s);
   for (size_t i = std::min(pos, self.size() - 1); ; --i) {
-    if (lookup[static_cast<unsigned char>(self.data()[i])])
+    if (set.Contains(self.data()[i]))
       return i;
     if (i == 0)
       break;
@@ -341,7 +327,7 @@ size_t find_last_of(const StringPiece16& self,
   return StringPiece16::npos;
 }
 
-// 8-bit version using lookup table.
+// 8-bit version using a CharSet.
 size_t find_last_not_of(const StringPiece& self,
                         const StringPiece& s,
                         size_t pos) {
@@ -352,14 +338,13 @@ size_t find_last_not_of(const StringPiece& self,
   if (s.size() == 0)
     return i;
 
-  // Avoid the cost of BuildLookupTable() for a single-character search.
+  // Avoid the cost of building a CharSet for a single-character search.
   if (s.size() == 1)
     return find_last_not_of(self, s.data()[0], pos);
 
-  bool lookup[UCHAR_MAX + 1] = { false };
-  BuildLookupTable(s, lookup);
+  const CharSet set(s);
   for (; ; --i) {
-    if (!lookup[static_cast<unsigned char>(self.data()[i])])
+    if (!set.Contains(self.data()[i]))
       return i;
     if (i == 0)
       break;
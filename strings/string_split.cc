@@ -7,6 +7,7 @@
 #include <stddef.h>
 
 #include "base/logging.h"
+#include "base/strings/char_set_internal.h"
 #include "base/strings/string_util.h"
 #include "base/third_party/icu/icu_utf.h"
 
@@ -54,8 +55,10 @@ size_t FindFirstOf(StringPiece piece, char c, size_t pos) {
 size_t FindFirstOf(StringPiece16 piece, char16 c, size_t pos) {
   return piece.find(c, pos);
 }
-size_t FindFirstOf(StringPiece piece, StringPiece one_of, size_t pos) {
-  return piece.find_first_of(one_of, pos);
+size_t FindFirstOf(StringPiece piece,
+                   const internal::CharSet& one_of,
+                   size_t pos) {
+  return one_of.FindFirstIn(piece, pos);
 }
 size_t FindFirstOf(StringPiece16 piece, StringPiece16 one_of, size_t pos) {
   return piece.find_first_of(one_of, pos);
@@ -65,10 +68,11 @@ size_t FindFirstOf(StringPiece16 piece, StringPiece16 one_of, size_t pos) {
 // the corresponding string or StringPiece output, and can take single- or
 // multiple-character delimiters.
 //
-// DelimiterType is either a character (Str::value_type) or a string piece of
-// multiple characters (BasicStringPiece<Str>). StringPiece has a version of
-// find for both of these cases, and the single-character version is the most
-// common and can be implemented faster, which is why this is a template.
+// DelimiterType is either a character (Str::value_type), a string piece of
+// multiple characters (BasicStringPiece<Str>) or, for 8-bit input, a CharSet
+// built once for the whole input. StringPiece has a version of find for the
+// first two cases, and the single-character version is the most common and
+// can be implemented faster, which is why this is a template.
 template<typename Str, typename OutputStringType, typename DelimiterType>
 static std::vector<OutputStringType> SplitStringT(
     BasicStringPiece<Str> str,
@@ -165,8 +169,8 @@ std::vector<std::string> SplitString(StringPiece input,
     return SplitStringT<std::string, std::string, char>(
         input, separators[0], whitespace, result_type);
   }
-  return SplitStringT<std::string, std::string, StringPiece>(
-      input, separators, whitespace, result_type);
+  return SplitStringT<std::string, std::string, internal::CharSet>(
+      input, internal::CharSet(separators), whitespace, result_type);
 }
 
 std::vector<string16> SplitString(StringPiece16 input,
@@ -189,8 +193,8 @@ std::vector<StringPiece> SplitStringPiece(StringPiece input,
     return SplitStringT<std::string, StringPiece, char>(
         input, separators[0], whitespace, result_type);
   }
-  return SplitStringT<std::string, StringPiece, StringPiece>(
-      input, separators, whitespace, result_type);
+  return SplitStringT<std::string, StringPiece, internal::CharSet>(
+      input, internal::CharSet(separators), whitespace, result_type);
 }
 
 std::vector<StringPiece16> SplitStringPiece(StringPiece16 input,
@@ -205,6 +209,46 @@ std::vector<StringPiece16> SplitStringPiece(StringPiece16 input,
       input, separators, whitespace, result_type);
 }
 
+StringPieceSplitter::Iterator::Iterator(const StringPieceSplitter* splitter,
+                                        bool at_end)
+    : splitter_(splitter), next_(0), at_end_(at_end) {
+  if (!at_end_)
+    Advance();
+}
+
+void StringPieceSplitter::Iterator::Advance() {
+  const StringPiece input = splitter_->input_;
+  while (next_ != StringPiece::npos) {
+    size_t end = splitter_->separators_->FindFirstIn(input, next_);
+    if (end == StringPiece::npos) {
+      piece_ = input.substr(next_);
+      next_ = StringPiece::npos;
+    } else {
+      piece_ = input.substr(next_, end - next_);
+      next_ = end + 1;
+    }
+
+    if (splitter_->whitespace_ == TRIM_WHITESPACE)
+      piece_ = TrimString(piece_, kWhitespaceASCII, TRIM_ALL);
+
+    if (splitter_->result_type_ == SPLIT_WANT_ALL || !piece_.empty())
+      return;
+  }
+  piece_ = StringPiece();
+  at_end_ = true;
+}
+
+StringPieceSplitter::StringPieceSplitter(StringPiece input,
+                                         StringPiece separators,
+                                         WhitespaceHandling whitespace,
+                                         SplitResult result_type)
+    : input_(input),
+      separators_(std::make_unique<internal::CharSet>(separators)),
+      whitespace_(whitespace),
+      result_type_(result_type) {}
+
+StringPieceSplitter::~StringPieceSplitter() = default;
+
 bool SplitStringIntoKeyValuePairs(StringPiece input,
                                   char key_value_delimiter,
                                   char key_value_pair_delimiter,
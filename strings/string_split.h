@@ -5,6 +5,10 @@
 #ifndef BASE_STRINGS_STRING_SPLIT_H_
 #define BASE_STRINGS_STRING_SPLIT_H_
 
+#include <stddef.h>
+
+#include <iterator>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -15,6 +19,10 @@
 
 namespace base {
 
+namespace internal {
+class CharSet;
+}  // namespace internal
+
 enum WhitespaceHandling {
   KEEP_WHITESPACE,
   TRIM_WHITESPACE,
@@ -77,6 +85,80 @@ BASE_EXPORT std::vector<StringPiece16> SplitStringPiece(
     WhitespaceHandling whitespace,
     SplitResult result_type);
 
+// Like SplitStringPiece above except that the pieces are found one at a time,
+// as the loop advances, instead of being collected in a vector. Memory use
+// doesn't grow with the input, and a loop that stops early doesn't scan the
+// rest of it. The set of separators is only built once.
+//
+// To iterate through the lines of a large input:
+//
+//   for (StringPiece line :
+//        base::StringPieceSplitter(input, "\r\n", base::TRIM_WHITESPACE,
+//                                  base::SPLIT_WANT_NONEMPTY)) {
+//     ...
+//
+// The string that |input| points to must outlive the splitter, and the
+// splitter must outlive its iterators.
+class BASE_EXPORT StringPieceSplitter {
+ public:
+  class BASE_EXPORT Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = StringPiece;
+    using difference_type = ptrdiff_t;
+    using pointer = const StringPiece*;
+    using reference = const StringPiece&;
+
+    const StringPiece& operator*() const { return piece_; }
+    const StringPiece* operator->() const { return &piece_; }
+
+    Iterator& operator++() {
+      Advance();
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator previous = *this;
+      Advance();
+      return previous;
+    }
+
+    bool operator==(const Iterator& other) const {
+      return at_end_ == other.at_end_ && (at_end_ || next_ == other.next_);
+    }
+    bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+   private:
+    friend class StringPieceSplitter;
+
+    // Creates an iterator at the first piece, or the end iterator.
+    Iterator(const StringPieceSplitter* splitter, bool at_end);
+
+    // Moves to the next piece that |splitter_| wants, or to the end.
+    void Advance();
+
+    const StringPieceSplitter* splitter_;
+    StringPiece piece_;
+    // Where the piece after |piece_| starts, or npos if |piece_| is the last.
+    size_t next_;
+    bool at_end_;
+  };
+
+  StringPieceSplitter(StringPiece input,
+                      StringPiece separators,
+                      WhitespaceHandling whitespace,
+                      SplitResult result_type);
+  ~StringPieceSplitter();
+
+  Iterator begin() const { return Iterator(this, input_.empty()); }
+  Iterator end() const { return Iterator(this, true); }
+
+ private:
+  const StringPiece input_;
+  const std::unique_ptr<const internal::CharSet> separators_;
+  const WhitespaceHandling whitespace_;
+  const SplitResult result_type_;
+};
+
 using StringPairs = std::vector<std::pair<std::string, std::string>>;
 
 // Splits |line| into key value pairs according to the given delimiters and
@@ -0,0 +1,106 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/strings/string_split.h"
+
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/strings/string_piece.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+
+namespace {
+
+constexpr size_t kMegabyte = 1024 * 1024;
+constexpr size_t kInputSize = 8 * kMegabyte;
+constexpr int kIterations = 10;
+constexpr char kSeparators[] = ",;\n";
+
+// Returns about |size| bytes of comma-separated lines with fields of varying
+// length, like a large CSV file.
+std::string MakeInput(size_t size) {
+  std::string input;
+  input.reserve(size + 64);
+  for (size_t i = 0; input.size() < size; ++i) {
+    input.append(i % 7 + 1, static_cast<char>('a' + i % 26));
+    input.push_back(i % 16 == 15 ? '\n' : (i % 5 == 4 ? ';' : ','));
+  }
+  return input;
+}
+
+// Counts the pieces with std::string::find_first_of(), which checks every
+// character against every separator. Used as the baseline.
+size_t CountWithStdFindFirstOf(const std::string& input) {
+  size_t count = 1;
+  for (size_t pos = input.find_first_of(kSeparators); pos != std::string::npos;
+       pos = input.find_first_of(kSeparators, pos + 1)) {
+    ++count;
+  }
+  return count;
+}
+
+size_t CountWithFindFirstOf(const std::string& input) {
+  const StringPiece piece(input);
+  size_t count = 1;
+  for (size_t pos = piece.find_first_of(kSeparators); pos != StringPiece::npos;
+       pos = piece.find_first_of(kSeparators, pos + 1)) {
+    ++count;
+  }
+  return count;
+}
+
+size_t CountWithSplitStringPiece(const std::string& input) {
+  return SplitStringPiece(input, kSeparators, KEEP_WHITESPACE, SPLIT_WANT_ALL)
+      .size();
+}
+
+size_t CountWithStringPieceSplitter(const std::string& input) {
+  size_t count = 0;
+  for (StringPiece piece : StringPieceSplitter(input, kSeparators,
+                                               KEEP_WHITESPACE,
+                                               SPLIT_WANT_ALL)) {
+    ALLOW_UNUSED_LOCAL(piece);
+    ++count;
+  }
+  return count;
+}
+
+template <typename CountFunction>
+void Measure(const std::string& trace,
+             const std::string& input,
+             size_t expected_count,
+             CountFunction count_function) {
+  size_t count = 0;
+  TimeTicks start = TimeTicks::Now();
+  for (int i = 0; i < kIterations; ++i)
+    count = count_function(input);
+  TimeDelta elapsed = TimeTicks::Now() - start;
+  ASSERT_EQ(expected_count, count);
+  perf_test::PrintResult(
+      "SplitString", std::to_string(input.size() / kMegabyte) + "MB", trace,
+      (input.size() / kMegabyte) * kIterations / elapsed.InSecondsF(), "MB/s",
+      true);
+}
+
+}  // namespace
+
+TEST(StringSplitPerfTest, FindFirstOfAndSplit) {
+  const std::string input = MakeInput(kInputSize);
+  const size_t expected_count = CountWithStdFindFirstOf(input);
+
+  Measure("std_find_first_of", input, expected_count,
+          &CountWithStdFindFirstOf);
+  Measure("find_first_of", input, expected_count, &CountWithFindFirstOf);
+  Measure("split_string_piece", input, expected_count,
+          &CountWithSplitStringPiece);
+  Measure("string_piece_splitter", input, expected_count,
+          &CountWithStringPieceSplitter);
+}
+
+}  // namespace base
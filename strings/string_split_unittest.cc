@@ -383,4 +383,50 @@ TEST(StringSplitTest, SplitStringAlongWhitespace) {
   }
 }
 
+// The splitter yields the same pieces as SplitStringPiece(), for all
+// combinations of flags.
+TEST(StringPieceSplitterTest, MatchesSplitStringPiece) {
+  static const char* const kInputs[] = {
+      "",  ",", ", ,", " a, b ;c;; d ", "no separators", ";;leading",
+      "trailing;;", "a\xff,\xfe,b"};
+  static const char* const kSeparators[] = {",", ",;", ", ;", "\xff,"};
+  for (const char* input : kInputs) {
+    for (const char* separators : kSeparators) {
+      for (WhitespaceHandling whitespace : {KEEP_WHITESPACE, TRIM_WHITESPACE}) {
+        for (SplitResult result_type : {SPLIT_WANT_ALL, SPLIT_WANT_NONEMPTY}) {
+          std::vector<StringPiece> expected =
+              SplitStringPiece(input, separators, whitespace, result_type);
+          std::vector<StringPiece> actual;
+          for (StringPiece piece : StringPieceSplitter(
+                   input, separators, whitespace, result_type)) {
+            actual.push_back(piece);
+          }
+          EXPECT_EQ(expected, actual)
+              << "\"" << input << "\" split on \"" << separators << "\"";
+        }
+      }
+    }
+  }
+}
+
+TEST(StringPieceSplitterTest, Iterators) {
+  StringPieceSplitter splitter("a,b,,c", ",", KEEP_WHITESPACE,
+                               SPLIT_WANT_NONEMPTY);
+  StringPieceSplitter::Iterator it = splitter.begin();
+  EXPECT_EQ("a", *it);
+  EXPECT_EQ(it, splitter.begin());
+  EXPECT_EQ("a", *it++);
+  EXPECT_EQ(1u, it->size());
+  EXPECT_EQ("b", *it);
+  EXPECT_NE(it, splitter.begin());
+  EXPECT_EQ("c", *++it);
+  EXPECT_NE(it, splitter.end());
+  ++it;
+  EXPECT_EQ(it, splitter.end());
+
+  StringPieceSplitter empty(std::string(), ",", KEEP_WHITESPACE,
+                            SPLIT_WANT_ALL);
+  EXPECT_EQ(empty.begin(), empty.end());
+}
+
 }  // namespace base
@@ -0,0 +1,267 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/synchronization/lock_contention_profiler.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <utility>
+
+#include "base/bits.h"
+#include "base/metrics/histogram.h"
+#include "base/no_destructor.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/lock.h"
+#include "base/trace_event/trace_event.h"
+#include "base/trace_event/trace_event_argument.h"
+#include "build/build_config.h"
+
+#if defined(OS_LINUX) && !defined(OS_NACL)
+#include "base/debug/elf_symbol_cache_linux.h"
+#endif
+
+namespace base {
+
+namespace {
+
+// Must be a power of 2. Waits at sites that do not fit are only counted in
+// |g_dropped_samples| and the histogram.
+constexpr size_t kMaxSites = 1024;
+
+// Waits of 0us, then [1us, 2us), [2us, 4us)... and [2^30us, infinity).
+constexpr size_t kNumWaitBuckets = 32;
+
+// Number of sites with the longest waits that Flush() adds to the trace.
+constexpr size_t kMaxTracedSites = 20;
+
+// The waits sampled at a site. |program_counter| is set once, when the site is
+// first sampled.
+struct SiteSlot {
+  std::atomic<uintptr_t> program_counter;
+  std::atomic<uint64_t> samples;
+  std::atomic<int64_t> total_wait_us;
+  std::atomic<int64_t> max_wait_us;
+};
+
+// Zero-initialized without static initializers.
+SiteSlot g_sites[kMaxSites];
+std::atomic<uint64_t> g_wait_buckets[kNumWaitBuckets];
+std::atomic<uint64_t> g_dropped_samples;
+std::atomic<uint32_t> g_contentions;
+
+size_t GetWaitBucket(int64_t wait_us) {
+  if (wait_us <= 0)
+    return 0;
+  const uint32_t clamped_wait_us = static_cast<uint32_t>(std::min<int64_t>(
+      wait_us, std::numeric_limits<uint32_t>::max()));
+  return std::min<size_t>(bits::Log2Floor(clamped_wait_us) + 1,
+                          kNumWaitBuckets - 1);
+}
+
+SiteSlot* FindOrAddSite(uintptr_t program_counter) {
+  // Same hash as LockFreeAddressHashMap::Hash().
+  size_t index = static_cast<size_t>(
+      (static_cast<uint64_t>(program_counter) * 0x4bfdb9df5a6f243bull) >> 32);
+  for (size_t probes = 0; probes < kMaxSites; ++probes, ++index) {
+    SiteSlot* slot = &g_sites[index & (kMaxSites - 1)];
+    uintptr_t slot_program_counter =
+        slot->program_counter.load(std::memory_order_relaxed);
+    if (slot_program_counter == program_counter)
+      return slot;
+    if (!slot_program_counter &&
+        (slot->program_counter.compare_exchange_strong(
+             slot_program_counter, program_counter,
+             std::memory_order_relaxed) ||
+         slot_program_counter == program_counter)) {
+      return slot;
+    }
+  }
+  return nullptr;
+}
+
+// Returns the buckets sent to the histogram by Flush(), guarded by
+// GetFlushLock().
+uint64_t* GetFlushedWaitBuckets() {
+  static uint64_t flushed_wait_buckets[kNumWaitBuckets] = {};
+  return flushed_wait_buckets;
+}
+
+Lock* GetFlushLock() {
+  static NoDestructor<Lock> flush_lock;
+  return flush_lock.get();
+}
+
+std::string GetSymbol(const void* program_counter) {
+#if defined(OS_LINUX) && !defined(OS_NACL)
+  // |program_counter| is the return address of the call to LockImpl::Lock().
+  const char* symbol = debug::ElfSymbolCache::GetInstance()->Lookup(
+      static_cast<const char*>(program_counter) - 1);
+  if (symbol)
+    return symbol;
+#endif
+  return StringPrintf("%p", program_counter);
+}
+
+}  // namespace
+
+// static
+std::atomic<uint32_t> LockContentionProfiler::sampling_interval_{0};
+
+// static
+void LockContentionProfiler::Enable(uint32_t sampling_interval) {
+  DCHECK_GT(sampling_interval, 0u);
+  sampling_interval_.store(sampling_interval, std::memory_order_relaxed);
+}
+
+// static
+void LockContentionProfiler::Disable() {
+  sampling_interval_.store(0, std::memory_order_relaxed);
+}
+
+// static
+bool LockContentionProfiler::ShouldSample() {
+  const uint32_t sampling_interval =
+      sampling_interval_.load(std::memory_order_relaxed);
+  if (sampling_interval <= 1)
+    return sampling_interval == 1;
+  return g_contentions.fetch_add(1, std::memory_order_relaxed) %
+             sampling_interval ==
+         0;
+}
+
+// static
+void LockContentionProfiler::RecordWait(const void* program_counter,
+                                        TimeDelta wait) {
+  const int64_t wait_us = wait.InMicroseconds();
+  g_wait_buckets[GetWaitBucket(wait_us)].fetch_add(1,
+                                                   std::memory_order_relaxed);
+
+  SiteSlot* slot = FindOrAddSite(reinterpret_cast<uintptr_t>(program_counter));
+  if (!slot) {
+    g_dropped_samples.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  slot->samples.fetch_add(1, std::memory_order_relaxed);
+  slot->total_wait_us.fetch_add(wait_us, std::memory_order_relaxed);
+  int64_t max_wait_us = slot->max_wait_us.load(std::memory_order_relaxed);
+  while (wait_us > max_wait_us &&
+         !slot->max_wait_us.compare_exchange_weak(max_wait_us, wait_us,
+                                                  std::memory_order_relaxed)) {
+  }
+}
+
+// static
+std::vector<LockContentionProfiler::Site> LockContentionProfiler::GetSites() {
+  const uint64_t scale =
+      std::max<uint32_t>(sampling_interval_.load(std::memory_order_relaxed), 1);
+  std::vector<Site> sites;
+  for (const SiteSlot& slot : g_sites) {
+    const uintptr_t program_counter =
+        slot.program_counter.load(std::memory_order_relaxed);
+    const uint64_t samples = slot.samples.load(std::memory_order_relaxed);
+    if (!program_counter || !samples)
+      continue;
+    Site site;
+    site.program_counter = reinterpret_cast<const void*>(program_counter);
+    site.contentions = samples * scale;
+    site.total_wait = TimeDelta::FromMicroseconds(
+        slot.total_wait_us.load(std::memory_order_relaxed) * scale);
+    site.max_wait = TimeDelta::FromMicroseconds(
+        slot.max_wait_us.load(std::memory_order_relaxed));
+    sites.push_back(site);
+  }
+  std::sort(sites.begin(), sites.end(), [](const Site& lhs, const Site& rhs) {
+    return lhs.total_wait > rhs.total_wait ||
+           (lhs.total_wait == rhs.total_wait &&
+            lhs.contentions > rhs.contentions);
+  });
+  return sites;
+}
+
+// static
+std::string LockContentionProfiler::GetReport(size_t max_sites) {
+  std::vector<Site> sites = GetSites();
+  std::string report =
+      StringPrintf("%12s %14s %12s  %s\n", "contentions", "total_wait_us",
+                   "max_wait_us", "acquired_from");
+  for (size_t i = 0; i < sites.size() && i < max_sites; ++i) {
+    StringAppendF(&report, "%12llu %14lld %12lld  %s\n",
+                  static_cast<unsigned long long>(sites[i].contentions),
+                  static_cast<long long>(sites[i].total_wait.InMicroseconds()),
+                  static_cast<long long>(sites[i].max_wait.InMicroseconds()),
+                  GetSymbol(sites[i].program_counter).c_str());
+  }
+  const uint64_t dropped_samples =
+      g_dropped_samples.load(std::memory_order_relaxed);
+  if (dropped_samples) {
+    StringAppendF(&report, "%llu samples at other sites were dropped\n",
+                  static_cast<unsigned long long>(dropped_samples));
+  }
+  return report;
+}
+
+// static
+void LockContentionProfiler::Flush() {
+  {
+    AutoLock lock(*GetFlushLock());
+    HistogramBase* histogram = Histogram::FactoryMicrosecondsTimeGet(
+        "Lock.ContentionWaitTime", TimeDelta::FromMicroseconds(1),
+        TimeDelta::FromSeconds(10), 50,
+        HistogramBase::kUmaTargetedHistogramFlag);
+    uint64_t* flushed_wait_buckets = GetFlushedWaitBuckets();
+    for (size_t i = 0; i < kNumWaitBuckets; ++i) {
+      const uint64_t count = g_wait_buckets[i].load(std::memory_order_relaxed);
+      if (count == flushed_wait_buckets[i])
+        continue;
+      // Record the waits of a bucket as its lower bound.
+      histogram->AddCount(i ? 1 << (i - 1) : 0,
+                          static_cast<int>(count - flushed_wait_buckets[i]));
+      flushed_wait_buckets[i] = count;
+    }
+  }
+
+  bool tracing_enabled;
+  TRACE_EVENT_CATEGORY_GROUP_ENABLED(
+      TRACE_DISABLED_BY_DEFAULT("lock_contention"), &tracing_enabled);
+  if (!tracing_enabled)
+    return;
+  std::vector<Site> sites = GetSites();
+  auto traced_value = std::make_unique<trace_event::TracedValue>();
+  traced_value->BeginArray("sites");
+  for (size_t i = 0; i < sites.size() && i < kMaxTracedSites; ++i) {
+    traced_value->BeginDictionary();
+    traced_value->SetString("acquired_from",
+                            GetSymbol(sites[i].program_counter));
+    traced_value->SetDouble("contentions", sites[i].contentions);
+    traced_value->SetDouble("total_wait_us",
+                            sites[i].total_wait.InMicroseconds());
+    traced_value->SetDouble("max_wait_us", sites[i].max_wait.InMicroseconds());
+    traced_value->EndDictionary();
+  }
+  traced_value->EndArray();
+  TRACE_EVENT_INSTANT1(TRACE_DISABLED_BY_DEFAULT("lock_contention"),
+                       "LockContention", TRACE_EVENT_SCOPE_PROCESS, "report",
+                       std::move(traced_value));
+}
+
+// static
+void LockContentionProfiler::ResetForTesting() {
+  for (SiteSlot& slot : g_sites) {
+    slot.program_counter.store(0, std::memory_order_relaxed);
+    slot.samples.store(0, std::memory_order_relaxed);
+    slot.total_wait_us.store(0, std::memory_order_relaxed);
+    slot.max_wait_us.store(0, std::memory_order_relaxed);
+  }
+  AutoLock lock(*GetFlushLock());
+  uint64_t* flushed_wait_buckets = GetFlushedWaitBuckets();
+  for (size_t i = 0; i < kNumWaitBuckets; ++i) {
+    g_wait_buckets[i].store(0, std::memory_order_relaxed);
+    flushed_wait_buckets[i] = 0;
+  }
+  g_dropped_samples.store(0, std::memory_order_relaxed);
+  g_contentions.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace base
@@ -0,0 +1,82 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_SYNCHRONIZATION_LOCK_CONTENTION_PROFILER_H_
+#define BASE_SYNCHRONIZATION_LOCK_CONTENTION_PROFILER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/time/time.h"
+
+namespace base {
+
+// Measures how long threads wait to acquire contended base::Locks, and
+// attributes the waits to the code that acquired the lock, identified by its
+// program counter. Only acquisitions that find the lock held are measured,
+// and only one in |sampling_interval| of those. Finding out whether the lock
+// is held means that, while profiling is enabled, every Lock::Acquire() first
+// calls Try(); the uncontended path then costs that extra attempt and one
+// load.
+//
+// The results are aggregated in fixed-size tables updated with atomics,
+// because LockImpl::Lock() calls into the profiler and so it cannot take a
+// lock or allocate. For the same reason, waits are only sent to histograms
+// and traces when Flush() is called.
+class BASE_EXPORT LockContentionProfiler {
+ public:
+  // The waits sampled at a site, with the counts scaled by the sampling
+  // interval.
+  struct Site {
+    const void* program_counter = nullptr;
+    uint64_t contentions = 0;
+    TimeDelta total_wait;
+    TimeDelta max_wait;
+  };
+
+  // Starts measuring one in |sampling_interval| contended acquisitions. Can be
+  // called again to change the interval.
+  static void Enable(uint32_t sampling_interval);
+  static void Disable();
+
+  static bool IsEnabled() {
+    return sampling_interval_.load(std::memory_order_relaxed) != 0;
+  }
+
+  // Called by LockImpl::Lock() after failing to take the lock immediately.
+  // Returns true if the wait must be measured and passed to RecordWait().
+  static bool ShouldSample();
+  static void RecordWait(const void* program_counter, TimeDelta wait);
+
+  // Returns the sites that waited, longest total wait first.
+  static std::vector<Site> GetSites();
+
+  // Returns a table of the first |max_sites| of GetSites(), symbolized where
+  // possible.
+  static std::string GetReport(size_t max_sites);
+
+  // Records the waits sampled since the last call in the
+  // "Lock.ContentionWaitTime" histogram, and if the
+  // "disabled-by-default-lock_contention" category is enabled, adds the sites
+  // with the longest waits to the trace. Must be called from outside of the
+  // lock code, e.g. from a periodic task.
+  static void Flush();
+
+  // Clears the results, including the waits not flushed yet, to isolate tests
+  // from each other.
+  static void ResetForTesting();
+
+ private:
+  // 0 when disabled.
+  static std::atomic<uint32_t> sampling_interval_;
+};
+
+}  // namespace base
+
+#endif  // BASE_SYNCHRONIZATION_LOCK_CONTENTION_PROFILER_H_
@@ -0,0 +1,152 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/synchronization/lock_contention_profiler.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/test/metrics/histogram_tester.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+class ContendingThread : public SimpleThread {
+ public:
+  ContendingThread(Lock* lock, WaitableEvent* about_to_acquire)
+      : SimpleThread("ContendingThread"),
+        lock_(lock),
+        about_to_acquire_(about_to_acquire) {}
+
+  void Run() override {
+    about_to_acquire_->Signal();
+    AutoLock auto_lock(*lock_);
+  }
+
+ private:
+  Lock* lock_;
+  WaitableEvent* about_to_acquire_;
+
+  DISALLOW_COPY_AND_ASSIGN(ContendingThread);
+};
+
+class LockContentionProfilerTest : public testing::Test {
+ protected:
+  void SetUp() override { LockContentionProfiler::ResetForTesting(); }
+  void TearDown() override {
+    LockContentionProfiler::Disable();
+    LockContentionProfiler::ResetForTesting();
+  }
+};
+
+}  // namespace
+
+TEST_F(LockContentionProfilerTest, Sampling) {
+  EXPECT_FALSE(LockContentionProfiler::IsEnabled());
+  EXPECT_FALSE(LockContentionProfiler::ShouldSample());
+
+  LockContentionProfiler::Enable(1);
+  EXPECT_TRUE(LockContentionProfiler::IsEnabled());
+  EXPECT_TRUE(LockContentionProfiler::ShouldSample());
+
+  LockContentionProfiler::Enable(4);
+  int samples = 0;
+  for (int i = 0; i < 40; ++i) {
+    if (LockContentionProfiler::ShouldSample())
+      ++samples;
+  }
+  EXPECT_EQ(10, samples);
+}
+
+TEST_F(LockContentionProfilerTest, RecordWait) {
+  LockContentionProfiler::Enable(2);
+  int first_site;
+  int second_site;
+  LockContentionProfiler::RecordWait(&first_site,
+                                     TimeDelta::FromMicroseconds(10));
+  LockContentionProfiler::RecordWait(&first_site,
+                                     TimeDelta::FromMicroseconds(30));
+  LockContentionProfiler::RecordWait(&second_site,
+                                     TimeDelta::FromMicroseconds(100));
+
+  std::vector<LockContentionProfiler::Site> sites =
+      LockContentionProfiler::GetSites();
+  ASSERT_EQ(2u, sites.size());
+  // Counts are scaled by the sampling interval, and sorted by total wait.
+  EXPECT_EQ(&second_site, sites[0].program_counter);
+  EXPECT_EQ(2u, sites[0].contentions);
+  EXPECT_EQ(TimeDelta::FromMicroseconds(200), sites[0].total_wait);
+  EXPECT_EQ(&first_site, sites[1].program_counter);
+  EXPECT_EQ(4u, sites[1].contentions);
+  EXPECT_EQ(TimeDelta::FromMicroseconds(80), sites[1].total_wait);
+  EXPECT_EQ(TimeDelta::FromMicroseconds(30), sites[1].max_wait);
+
+  std::string report = LockContentionProfiler::GetReport(1);
+  EXPECT_NE(std::string::npos, report.find("total_wait_us")) << report;
+  EXPECT_NE(std::string::npos, report.find(" 200 ")) << report;
+  EXPECT_EQ(std::string::npos, report.find(" 80 ")) << report;
+
+  LockContentionProfiler::Flush();
+}
+
+TEST_F(LockContentionProfilerTest, FlushAfterReset) {
+  HistogramTester histogram_tester;
+  LockContentionProfiler::Enable(1);
+  int site;
+  LockContentionProfiler::RecordWait(&site, TimeDelta::FromMicroseconds(10));
+  LockContentionProfiler::Flush();
+  histogram_tester.ExpectTotalCount("Lock.ContentionWaitTime", 1);
+
+  // Waits recorded after a reset are flushed like the first ones.
+  LockContentionProfiler::ResetForTesting();
+  LockContentionProfiler::RecordWait(&site, TimeDelta::FromMicroseconds(10));
+  LockContentionProfiler::Flush();
+  histogram_tester.ExpectTotalCount("Lock.ContentionWaitTime", 2);
+}
+
+TEST_F(LockContentionProfilerTest, ContendedLock) {
+  LockContentionProfiler::Enable(1);
+  Lock lock;
+  WaitableEvent about_to_acquire(WaitableEvent::ResetPolicy::MANUAL,
+                                 WaitableEvent::InitialState::NOT_SIGNALED);
+  ContendingThread thread(&lock, &about_to_acquire);
+  {
+    AutoLock auto_lock(lock);
+    thread.Start();
+    about_to_acquire.Wait();
+    PlatformThread::Sleep(TimeDelta::FromMilliseconds(50));
+  }
+  thread.Join();
+
+  // Other locks of the process may have been contended too.
+  TimeDelta max_wait;
+  for (const LockContentionProfiler::Site& site :
+       LockContentionProfiler::GetSites()) {
+    max_wait = std::max(max_wait, site.max_wait);
+  }
+  EXPECT_GE(max_wait, TimeDelta::FromMilliseconds(10));
+}
+
+// Uncontended acquisitions are not measured.
+TEST_F(LockContentionProfilerTest, UncontendedLock) {
+  LockContentionProfiler::Enable(1);
+  Lock lock;
+  for (int i = 0; i < 100; ++i)
+    AutoLock auto_lock(lock);
+  LockContentionProfiler::Disable();
+  for (const LockContentionProfiler::Site& site :
+       LockContentionProfiler::GetSites()) {
+    EXPECT_LT(site.contentions, 100u);
+  }
+}
+
+}  // namespace base
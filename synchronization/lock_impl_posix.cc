@@ -11,7 +11,10 @@
 #include "base/posix/safe_strerror.h"
 #include "base/strings/stringprintf.h"
 #include "base/synchronization/lock.h"
+#include "base/synchronization/lock_contention_profiler.h"
 #include "base/synchronization/synchronization_buildflags.h"
+#include "base/time/time.h"
+#include "base/time/time_override.h"
 #include "build/build_config.h"
 
 namespace base {
@@ -93,14 +96,26 @@ void LockImpl::Lock() {
   // vast majority of the calls, simply "try" the lock first and only do the
   // (tracked) blocking call if that fails. Since "try" itself is a system
   // call, and thus also somewhat expensive, don't bother with it unless
-  // tracking is actually enabled.
-  if (base::debug::GlobalActivityTracker::IsEnabled())
+  // tracking is actually enabled. Contention profiling also only measures
+  // acquisitions that fail to "try" the lock.
+  const bool profile_contention = LockContentionProfiler::IsEnabled();
+  if (base::debug::GlobalActivityTracker::IsEnabled() || profile_contention)
     if (Try())
       return;
 
+  TimeTicks wait_start;
+  if (profile_contention && LockContentionProfiler::ShouldSample())
+    wait_start = subtle::TimeTicksNowIgnoringOverride();
+
   base::debug::ScopedLockAcquireActivity lock_activity(this);
   int rv = pthread_mutex_lock(&native_handle_);
   DCHECK_EQ(rv, 0) << ". " << SystemErrorCodeToString(rv);
+
+  if (!wait_start.is_null()) {
+    LockContentionProfiler::RecordWait(
+        __builtin_extract_return_addr(__builtin_return_address(0)),
+        subtle::TimeTicksNowIgnoringOverride() - wait_start);
+  }
 }
 
 // static
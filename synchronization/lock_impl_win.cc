@@ -5,7 +5,11 @@
 #include "base/synchronization/lock_impl.h"
 
 #include "base/debug/activity_tracker.h"
+#include "base/synchronization/lock_contention_profiler.h"
+#include "base/time/time.h"
+#include "base/time/time_override.h"
 
+#include <intrin.h>
 #include <windows.h>
 
 namespace base {
@@ -27,13 +31,25 @@ void LockImpl::Lock() {
   // vast majority of the calls, simply "try" the lock first and only do the
   // (tracked) blocking call if that fails. Since "try" itself is a system
   // call, and thus also somewhat expensive, don't bother with it unless
-  // tracking is actually enabled.
-  if (base::debug::GlobalActivityTracker::IsEnabled())
+  // tracking is actually enabled. Contention profiling also only measures
+  // acquisitions that fail to "try" the lock.
+  const bool profile_contention = LockContentionProfiler::IsEnabled();
+  if (base::debug::GlobalActivityTracker::IsEnabled() || profile_contention)
     if (Try())
       return;
 
+  TimeTicks wait_start;
+  if (profile_contention && LockContentionProfiler::ShouldSample())
+    wait_start = subtle::TimeTicksNowIgnoringOverride();
+
   base::debug::ScopedLockAcquireActivity lock_activity(this);
   ::AcquireSRWLockExclusive(reinterpret_cast<PSRWLOCK>(&native_handle_));
+
+  if (!wait_start.is_null()) {
+    LockContentionProfiler::RecordWait(
+        _ReturnAddress(),
+        subtle::TimeTicksNowIgnoringOverride() - wait_start);
+  }
 }
 
 }  // namespace internal
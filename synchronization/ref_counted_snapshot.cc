@@ -0,0 +1,215 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/synchronization/ref_counted_snapshot.h"
+
+#include <stdint.h>
+
+#include <limits>
+#include <new>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/memory/aligned_memory.h"
+#include "base/no_destructor.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread_local_storage.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+// Size of a cache line on the architectures Chrome runs on.
+constexpr size_t kCacheLineSize = 64;
+
+// Written only by the thread that owns the record, read by the writers that
+// retire objects. Records are allocated on their own cache line, so that
+// readers on different threads don't write to the same line. They are never
+// freed: when a thread exits, its record is reused by the next new thread.
+struct ThreadRecord {
+  // The epoch in which the outermost read section of the thread started, or 0
+  // outside of read sections.
+  std::atomic<uint64_t> active_epoch;
+  // Number of nested read sections. Only accessed by the owning thread.
+  int nesting;
+  std::atomic<bool> in_use;
+  ThreadRecord* next;
+};
+
+static_assert(sizeof(ThreadRecord) <= kCacheLineSize,
+              "ThreadRecord must fit in a cache line");
+
+struct RetiredObject {
+  void* object;
+  SnapshotEpoch::Deleter deleter;
+  uint64_t epoch;
+};
+
+// Starts at 1 so that 0 can mean "not reading".
+std::atomic<uint64_t> g_epoch{1};
+
+// Push-only list of all records.
+std::atomic<ThreadRecord*> g_records{nullptr};
+
+Lock& RetiredLock() {
+  static NoDestructor<Lock> lock;
+  return *lock;
+}
+
+std::vector<RetiredObject>& RetiredObjects() {
+  static NoDestructor<std::vector<RetiredObject>> retired;
+  return *retired;
+}
+
+// Size of RetiredObjects(), readable without RetiredLock().
+std::atomic<size_t> g_retired_count{0};
+
+void ReleaseThreadRecord(void* value) {
+  ThreadRecord* record = static_cast<ThreadRecord*>(value);
+  DCHECK_EQ(0, record->nesting);
+  record->in_use.store(false, std::memory_order_release);
+}
+
+ThreadLocalStorage::Slot& ThreadRecordTLS() {
+  static NoDestructor<ThreadLocalStorage::Slot> thread_record_tls(
+      &ReleaseThreadRecord);
+  return *thread_record_tls;
+}
+
+ThreadRecord* AcquireThreadRecord() {
+  for (ThreadRecord* record = g_records.load(std::memory_order_acquire);
+       record; record = record->next) {
+    bool in_use = false;
+    if (!record->in_use.load(std::memory_order_relaxed) &&
+        record->in_use.compare_exchange_strong(in_use, true,
+                                               std::memory_order_acquire)) {
+      return record;
+    }
+  }
+
+  ThreadRecord* record = new (AlignedAlloc(kCacheLineSize, kCacheLineSize))
+      ThreadRecord();
+  record->active_epoch.store(0, std::memory_order_relaxed);
+  record->nesting = 0;
+  record->in_use.store(true, std::memory_order_relaxed);
+  record->next = g_records.load(std::memory_order_relaxed);
+  while (!g_records.compare_exchange_weak(record->next, record,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed)) {
+  }
+  return record;
+}
+
+ThreadRecord* GetThreadRecord() {
+  ThreadLocalStorage::Slot& slot = ThreadRecordTLS();
+  ThreadRecord* record = static_cast<ThreadRecord*>(slot.Get());
+  if (!record) {
+    record = AcquireThreadRecord();
+    slot.Set(record);
+  }
+  return record;
+}
+
+// Returns the oldest epoch in which a read section in progress started, or
+// the maximum epoch if there is none.
+uint64_t GetOldestActiveEpoch() {
+  // Pairs with the fence in EnterReadSection(): either the reader sees the
+  // object unlinked, or this sees the reader's epoch.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  uint64_t oldest = std::numeric_limits<uint64_t>::max();
+  for (ThreadRecord* record = g_records.load(std::memory_order_acquire);
+       record; record = record->next) {
+    const uint64_t epoch = record->active_epoch.load(std::memory_order_acquire);
+    if (epoch != 0 && epoch < oldest)
+      oldest = epoch;
+  }
+  return oldest;
+}
+
+// Deletes the retired objects that no read section can see, i.e. those
+// retired in an epoch before |oldest_active_epoch|.
+void DeleteRetiredObjects(uint64_t oldest_active_epoch) {
+  std::vector<RetiredObject> to_delete;
+  {
+    AutoLock auto_lock(RetiredLock());
+    std::vector<RetiredObject>& retired = RetiredObjects();
+    auto kept = retired.begin();
+    for (auto it = retired.begin(); it != retired.end(); ++it) {
+      if (it->epoch < oldest_active_epoch)
+        to_delete.push_back(*it);
+      else
+        *kept++ = *it;
+    }
+    retired.erase(kept, retired.end());
+    g_retired_count.store(retired.size(), std::memory_order_relaxed);
+  }
+  for (const RetiredObject& retired : to_delete)
+    retired.deleter(retired.object);
+}
+
+}  // namespace
+
+// static
+void SnapshotEpoch::EnterReadSection() {
+  ThreadRecord* record = GetThreadRecord();
+  if (record->nesting++ != 0)
+    return;
+  record->active_epoch.store(g_epoch.load(std::memory_order_acquire),
+                             std::memory_order_relaxed);
+  // Orders the store above before the loads of the read section. See
+  // GetOldestActiveEpoch().
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+// static
+void SnapshotEpoch::ExitReadSection() {
+  ThreadRecord* record = static_cast<ThreadRecord*>(ThreadRecordTLS().Get());
+  DCHECK(record);
+  DCHECK_GT(record->nesting, 0);
+  if (--record->nesting == 0)
+    record->active_epoch.store(0, std::memory_order_release);
+}
+
+// static
+void SnapshotEpoch::Retire(void* object, Deleter deleter) {
+  {
+    AutoLock auto_lock(RetiredLock());
+    // Read sections that start from now on load epochs after this one, and
+    // can't see |object|.
+    const uint64_t epoch = g_epoch.fetch_add(1, std::memory_order_acq_rel);
+    RetiredObjects().push_back({object, deleter, epoch});
+    g_retired_count.store(RetiredObjects().size(), std::memory_order_relaxed);
+  }
+  DeleteRetiredObjects(GetOldestActiveEpoch());
+}
+
+// static
+void SnapshotEpoch::ReclaimRetired() {
+  if (g_retired_count.load(std::memory_order_relaxed) == 0)
+    return;
+  DeleteRetiredObjects(GetOldestActiveEpoch());
+}
+
+// static
+void SnapshotEpoch::Synchronize() {
+  const ThreadRecord* record =
+      static_cast<ThreadRecord*>(ThreadRecordTLS().Get());
+  DCHECK(!record || record->nesting == 0);
+
+  const uint64_t epoch = g_epoch.fetch_add(1, std::memory_order_acq_rel);
+  uint64_t oldest_active_epoch;
+  while ((oldest_active_epoch = GetOldestActiveEpoch()) <= epoch)
+    PlatformThread::YieldCurrentThread();
+  DeleteRetiredObjects(oldest_active_epoch);
+}
+
+// static
+size_t SnapshotEpoch::GetRetiredCountForTesting() {
+  AutoLock auto_lock(RetiredLock());
+  return RetiredObjects().size();
+}
+
+}  // namespace internal
+}  // namespace base
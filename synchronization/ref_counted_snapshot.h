@@ -0,0 +1,180 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_SYNCHRONIZATION_REF_COUNTED_SNAPSHOT_H_
+#define BASE_SYNCHRONIZATION_REF_COUNTED_SNAPSHOT_H_
+
+#include <stddef.h>
+
+#include <atomic>
+#include <utility>
+
+#include "base/base_export.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+
+namespace base {
+
+namespace internal {
+
+// Epoch-based reclamation shared by all RefCountedSnapshots. Each thread that
+// reads has its own record, on its own cache line, where it publishes the
+// epoch in which its outermost read section started. An object unlinked by a
+// writer is retired with the current epoch and destroyed once no thread is
+// in a read section that started in that epoch or before.
+class BASE_EXPORT SnapshotEpoch {
+ public:
+  using Deleter = void (*)(void* object);
+
+  // Marks the calling thread as reading, until the matching
+  // ExitReadSection(). Read sections nest.
+  static void EnterReadSection();
+  static void ExitReadSection();
+
+  // Runs |deleter(object)| once every read section that could have seen
+  // |object| has exited. |object| must already be unreachable for new read
+  // sections. May run |deleter| for this or other objects before returning,
+  // so must not be called with a lock that a deleter takes.
+  static void Retire(void* object, Deleter deleter);
+
+  // Runs the deleters of the retired objects that no read section in progress
+  // can see, without waiting. Only costs an atomic load when nothing is
+  // retired. Same restriction on locks as Retire().
+  static void ReclaimRetired();
+
+  // Waits for every read section in progress to exit, then runs the deleters
+  // of all retired objects. Must not be called from a read section.
+  static void Synchronize();
+
+  // Returns the number of objects retired and not yet deleted.
+  static size_t GetRetiredCountForTesting();
+};
+
+}  // namespace internal
+
+// Holds a value of type T that many threads read and few threads replace.
+// Readers don't lock and don't write to memory shared with other threads;
+// they only publish their epoch in a per-thread record. Writers copy the
+// value, modify the copy and publish it; the previous value is destroyed
+// once the readers that may still use it are done.
+//
+// Values are RefCountedData<T>, so a reader can take a reference to keep a
+// value beyond its read section, at the cost of an atomic increment.
+//
+// Example:
+//   RefCountedSnapshot<std::map<std::string, int>> g_table;
+//
+//   // Any thread:
+//   {
+//     RefCountedSnapshot<std::map<std::string, int>>::ReadScope table(
+//         g_table);
+//     auto it = table->find(name);
+//     ...
+//   }
+//
+//   // Rarely:
+//   g_table.Update([&](std::map<std::string, int>* table) {
+//     (*table)[name] = value;
+//   });
+template <typename T>
+class RefCountedSnapshot {
+ public:
+  using Value = RefCountedData<T>;
+
+  // Keeps the current value alive while in scope. Must not outlive the
+  // snapshot, nor be moved across threads.
+  class ReadScope {
+   public:
+    explicit ReadScope(const RefCountedSnapshot& snapshot) {
+      internal::SnapshotEpoch::EnterReadSection();
+      value_ = snapshot.current_.load(std::memory_order_acquire);
+    }
+    ~ReadScope() { internal::SnapshotEpoch::ExitReadSection(); }
+
+    const T& operator*() const { return value_->data; }
+    const T* operator->() const { return &value_->data; }
+    const T* get() const { return &value_->data; }
+
+    // Returns a reference that keeps the value alive after this scope.
+    scoped_refptr<const Value> Retain() const {
+      return scoped_refptr<const Value>(value_);
+    }
+
+   private:
+    const Value* value_;
+
+    DISALLOW_COPY_AND_ASSIGN(ReadScope);
+  };
+
+  RefCountedSnapshot() : RefCountedSnapshot(T()) {}
+  explicit RefCountedSnapshot(T initial_value)
+      : current_(Adopt(std::move(initial_value))) {}
+
+  // No ReadScope may be in progress. Values retired by earlier updates are
+  // released by SnapshotEpoch independently of this object.
+  ~RefCountedSnapshot() {
+    current_.load(std::memory_order_relaxed)->Release();
+  }
+
+  // Returns a reference to the current value, for use outside of a read
+  // section.
+  scoped_refptr<const Value> Get() const { return ReadScope(*this).Retain(); }
+
+  // Destroys the values of all snapshots that were replaced while a read
+  // section was in progress, if those sections have exited. Otherwise such
+  // values are only destroyed by the next update of any snapshot. Readers
+  // whose values hold expensive resources may call this after a read section.
+  static void ReclaimRetired() { internal::SnapshotEpoch::ReclaimRetired(); }
+
+  // Replaces the value. Readers that already started see the previous value.
+  void Publish(T value) {
+    Value* previous;
+    {
+      AutoLock auto_lock(writer_lock_);
+      previous = current_.exchange(Adopt(std::move(value)),
+                                   std::memory_order_acq_rel);
+    }
+    internal::SnapshotEpoch::Retire(previous, &ReleaseRetired);
+  }
+
+  // Calls |updater| with a pointer to a copy of the current value, then
+  // publishes the copy. Updates are serialized, so |updater| sees the result
+  // of all earlier updates.
+  template <typename Updater>
+  void Update(Updater updater) {
+    Value* previous;
+    {
+      AutoLock auto_lock(writer_lock_);
+      Value* copy = Adopt(T(current_.load(std::memory_order_relaxed)->data));
+      updater(&copy->data);
+      previous = current_.exchange(copy, std::memory_order_acq_rel);
+    }
+    internal::SnapshotEpoch::Retire(previous, &ReleaseRetired);
+  }
+
+ private:
+  // Returns a new Value holding one reference, owned by |current_| once
+  // published.
+  static Value* Adopt(T value) {
+    Value* result = new Value(std::move(value));
+    result->AddRef();
+    return result;
+  }
+
+  static void ReleaseRetired(void* value) {
+    static_cast<Value*>(value)->Release();
+  }
+
+  std::atomic<Value*> current_;
+
+  // Serializes Publish() and Update().
+  Lock writer_lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(RefCountedSnapshot);
+};
+
+}  // namespace base
+
+#endif  // BASE_SYNCHRONIZATION_REF_COUNTED_SNAPSHOT_H_
@@ -0,0 +1,180 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/synchronization/ref_counted_snapshot.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+constexpr int kAlive = 0x7ac4ed;
+
+// Counts the live instances, and detects use after destruction.
+class Tracked {
+ public:
+  explicit Tracked(int value) : value_(value) { ++live_count_; }
+  Tracked(const Tracked& other) : value_(other.value()) { ++live_count_; }
+  ~Tracked() {
+    --live_count_;
+    state_ = 0;
+  }
+
+  int value() const {
+    EXPECT_EQ(kAlive, state_);
+    return value_;
+  }
+  void set_value(int value) { value_ = value; }
+
+  static int live_count() { return live_count_; }
+
+ private:
+  static std::atomic<int> live_count_;
+
+  int value_;
+  int state_ = kAlive;
+};
+
+std::atomic<int> Tracked::live_count_{0};
+
+// Reads the snapshot until |done| is set, checking that the values it sees
+// never go backwards.
+class Reader : public DelegateSimpleThread::Delegate {
+ public:
+  Reader(const RefCountedSnapshot<Tracked>* snapshot,
+         const std::atomic<bool>* done)
+      : snapshot_(snapshot), done_(done) {}
+
+  void Run() override {
+    int last_value = 0;
+    while (!done_->load(std::memory_order_relaxed)) {
+      RefCountedSnapshot<Tracked>::ReadScope value(*snapshot_);
+      if (value->value() < last_value)
+        ++errors_;
+      last_value = value->value();
+    }
+  }
+
+  int errors() const { return errors_; }
+
+ private:
+  const RefCountedSnapshot<Tracked>* const snapshot_;
+  const std::atomic<bool>* const done_;
+  int errors_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(Reader);
+};
+
+}  // namespace
+
+TEST(RefCountedSnapshotTest, PublishAndUpdate) {
+  RefCountedSnapshot<Tracked> snapshot(Tracked(1));
+  {
+    RefCountedSnapshot<Tracked>::ReadScope value(snapshot);
+    EXPECT_EQ(1, value->value());
+  }
+
+  snapshot.Publish(Tracked(2));
+  snapshot.Update([](Tracked* value) { value->set_value(value->value() + 1); });
+  {
+    RefCountedSnapshot<Tracked>::ReadScope value(snapshot);
+    EXPECT_EQ(3, value->value());
+  }
+}
+
+// A read section keeps the value it started with alive, and the value is
+// destroyed once the section exits.
+TEST(RefCountedSnapshotTest, RetiredAfterReadSection) {
+  internal::SnapshotEpoch::Synchronize();
+  const int initial_live_count = Tracked::live_count();
+  {
+    RefCountedSnapshot<Tracked> snapshot(Tracked(1));
+    {
+      RefCountedSnapshot<Tracked>::ReadScope value(snapshot);
+      snapshot.Publish(Tracked(2));
+      EXPECT_EQ(1u, internal::SnapshotEpoch::GetRetiredCountForTesting());
+      EXPECT_EQ(1, value->value());
+
+      // Nested read sections see the new value.
+      RefCountedSnapshot<Tracked>::ReadScope nested_value(snapshot);
+      EXPECT_EQ(2, nested_value->value());
+    }
+    internal::SnapshotEpoch::Synchronize();
+    EXPECT_EQ(0u, internal::SnapshotEpoch::GetRetiredCountForTesting());
+    EXPECT_EQ(initial_live_count + 1, Tracked::live_count());
+  }
+  EXPECT_EQ(initial_live_count, Tracked::live_count());
+}
+
+// ReclaimRetired() destroys a value replaced during a read section as soon as
+// the section has exited, without another update.
+TEST(RefCountedSnapshotTest, ReclaimRetired) {
+  internal::SnapshotEpoch::Synchronize();
+  const int initial_live_count = Tracked::live_count();
+  RefCountedSnapshot<Tracked> snapshot(Tracked(1));
+  {
+    RefCountedSnapshot<Tracked>::ReadScope value(snapshot);
+    snapshot.Publish(Tracked(2));
+    RefCountedSnapshot<Tracked>::ReclaimRetired();
+    EXPECT_EQ(1u, internal::SnapshotEpoch::GetRetiredCountForTesting());
+    EXPECT_EQ(1, value->value());
+  }
+  RefCountedSnapshot<Tracked>::ReclaimRetired();
+  EXPECT_EQ(0u, internal::SnapshotEpoch::GetRetiredCountForTesting());
+  EXPECT_EQ(initial_live_count + 1, Tracked::live_count());
+}
+
+TEST(RefCountedSnapshotTest, Retain) {
+  RefCountedSnapshot<Tracked> snapshot(Tracked(1));
+  scoped_refptr<const RefCountedSnapshot<Tracked>::Value> retained =
+      snapshot.Get();
+  snapshot.Publish(Tracked(2));
+  internal::SnapshotEpoch::Synchronize();
+  EXPECT_EQ(1, retained->data.value());
+  EXPECT_EQ(2, snapshot.Get()->data.value());
+}
+
+TEST(RefCountedSnapshotTest, ConcurrentReaders) {
+  constexpr int kNumReaders = 4;
+  constexpr int kNumUpdates = 10000;
+
+  internal::SnapshotEpoch::Synchronize();
+  const int initial_live_count = Tracked::live_count();
+  {
+    RefCountedSnapshot<Tracked> snapshot(Tracked(0));
+    std::atomic<bool> done(false);
+
+    std::vector<std::unique_ptr<Reader>> readers;
+    std::vector<std::unique_ptr<DelegateSimpleThread>> threads;
+    for (int i = 0; i < kNumReaders; ++i) {
+      readers.push_back(std::make_unique<Reader>(&snapshot, &done));
+      threads.push_back(std::make_unique<DelegateSimpleThread>(
+          readers.back().get(), "RefCountedSnapshotReader"));
+      threads.back()->Start();
+    }
+
+    for (int i = 0; i < kNumUpdates; ++i) {
+      snapshot.Update(
+          [](Tracked* value) { value->set_value(value->value() + 1); });
+    }
+    done.store(true, std::memory_order_relaxed);
+    for (auto& thread : threads)
+      thread->Join();
+
+    for (const auto& reader : readers)
+      EXPECT_EQ(0, reader->errors());
+    EXPECT_EQ(kNumUpdates, snapshot.Get()->data.value());
+    internal::SnapshotEpoch::Synchronize();
+  }
+  EXPECT_EQ(initial_live_count, Tracked::live_count());
+}
+
+}  // namespace base
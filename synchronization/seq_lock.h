@@ -0,0 +1,111 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_SYNCHRONIZATION_SEQ_LOCK_H_
+#define BASE_SYNCHRONIZATION_SEQ_LOCK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <type_traits>
+
+#include "base/macros.h"
+#include "base/threading/platform_thread.h"
+
+namespace base {
+
+// Holds a small, trivially copyable value that is read often and written
+// rarely. Readers don't write to memory shared with other threads: they copy
+// the value and retry if a write happened in the meantime, so they never slow
+// each other down, but a reader can spin while a write is in progress.
+// Concurrent writers are serialized.
+//
+// Use this for snapshots of a few words, e.g. a pair of clock readings that
+// must be seen together. For larger or non-trivial values, see
+// RefCountedSnapshot.
+//
+// Example:
+//   struct Calibration {
+//     int64_t offset;
+//     double scale;
+//   };
+//   SeqLock<Calibration> g_calibration;
+//
+//   // Any thread:
+//   Calibration calibration = g_calibration.Read();
+//
+//   // Rarely:
+//   g_calibration.Write({offset, scale});
+template <typename T>
+class SeqLock {
+ public:
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SeqLock copies the value byte by byte");
+
+  // Holds a zero-filled T. Constant-initialized, so a SeqLock can be a
+  // global without a static initializer.
+  constexpr SeqLock() : sequence_(0), words_{} {}
+
+  explicit SeqLock(const T& value) : SeqLock() { Write(value); }
+
+  // Returns a copy of the value that was not torn by a concurrent Write().
+  T Read() const {
+    Word words[kWords];
+    while (true) {
+      const uint32_t begin = sequence_.load(std::memory_order_acquire);
+      if (begin & 1) {
+        PlatformThread::YieldCurrentThread();
+        continue;
+      }
+      for (size_t i = 0; i < kWords; ++i)
+        words[i] = words_[i].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence_.load(std::memory_order_relaxed) == begin)
+        break;
+    }
+    T value;
+    memcpy(&value, words, sizeof(T));
+    return value;
+  }
+
+  void Write(const T& value) {
+    Word words[kWords] = {};
+    memcpy(words, &value, sizeof(T));
+
+    // An odd sequence number marks a write in progress. Taking it with a
+    // compare-and-swap serializes writers.
+    uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+    while ((sequence & 1) ||
+           !sequence_.compare_exchange_weak(sequence, sequence + 1,
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+      if (sequence & 1) {
+        PlatformThread::YieldCurrentThread();
+        sequence = sequence_.load(std::memory_order_relaxed);
+      }
+    }
+    // Orders the odd sequence number before the stores below, for readers
+    // that load them.
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWords; ++i)
+      words_[i].store(words[i], std::memory_order_relaxed);
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+ private:
+  using Word = uintptr_t;
+  static constexpr size_t kWords =
+      (sizeof(T) + sizeof(Word) - 1) / sizeof(Word);
+
+  std::atomic<uint32_t> sequence_;
+  std::atomic<Word> words_[kWords];
+
+  DISALLOW_COPY_AND_ASSIGN(SeqLock);
+};
+
+}  // namespace base
+
+#endif  // BASE_SYNCHRONIZATION_SEQ_LOCK_H_
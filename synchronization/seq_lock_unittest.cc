@@ -0,0 +1,154 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/synchronization/seq_lock.h"
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Every field holds the same value, so a torn read is detected by comparing
+// them.
+struct Words {
+  uint64_t values[5];
+};
+
+Words MakeWords(uint64_t value) {
+  Words words;
+  for (uint64_t& word : words.values)
+    word = value;
+  return words;
+}
+
+bool IsConsistent(const Words& words) {
+  for (uint64_t word : words.values) {
+    if (word != words.values[0])
+      return false;
+  }
+  return true;
+}
+
+class Writer : public DelegateSimpleThread::Delegate {
+ public:
+  Writer(SeqLock<Words>* seq_lock, uint64_t first, uint64_t count)
+      : seq_lock_(seq_lock), first_(first), count_(count) {}
+
+  void Run() override {
+    for (uint64_t i = first_; i < first_ + count_; ++i)
+      seq_lock_->Write(MakeWords(i));
+  }
+
+ private:
+  SeqLock<Words>* const seq_lock_;
+  const uint64_t first_;
+  const uint64_t count_;
+
+  DISALLOW_COPY_AND_ASSIGN(Writer);
+};
+
+class Reader : public DelegateSimpleThread::Delegate {
+ public:
+  Reader(const SeqLock<Words>* seq_lock, const std::atomic<bool>* done)
+      : seq_lock_(seq_lock), done_(done) {}
+
+  void Run() override {
+    while (!done_->load(std::memory_order_relaxed)) {
+      if (!IsConsistent(seq_lock_->Read()))
+        ++torn_reads_;
+    }
+  }
+
+  int torn_reads() const { return torn_reads_; }
+
+ private:
+  const SeqLock<Words>* const seq_lock_;
+  const std::atomic<bool>* const done_;
+  int torn_reads_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(Reader);
+};
+
+}  // namespace
+
+TEST(SeqLockTest, DefaultIsZero) {
+  SeqLock<Words> seq_lock;
+  Words words = seq_lock.Read();
+  EXPECT_TRUE(IsConsistent(words));
+  EXPECT_EQ(0u, words.values[0]);
+}
+
+TEST(SeqLockTest, ReadReturnsLastWrite) {
+  SeqLock<Words> seq_lock(MakeWords(1));
+  EXPECT_EQ(1u, seq_lock.Read().values[4]);
+  seq_lock.Write(MakeWords(2));
+  seq_lock.Write(MakeWords(3));
+  EXPECT_EQ(3u, seq_lock.Read().values[4]);
+}
+
+// Values whose size isn't a multiple of a word are copied exactly.
+TEST(SeqLockTest, OddSize) {
+  struct Bytes {
+    char bytes[11];
+  };
+  Bytes value;
+  for (size_t i = 0; i < arraysize(value.bytes); ++i)
+    value.bytes[i] = static_cast<char>(i + 1);
+  SeqLock<Bytes> seq_lock(value);
+  Bytes read = seq_lock.Read();
+  for (size_t i = 0; i < arraysize(value.bytes); ++i)
+    EXPECT_EQ(value.bytes[i], read.bytes[i]);
+}
+
+TEST(SeqLockTest, ConcurrentWritersAndReaders) {
+  constexpr int kNumWriters = 2;
+  constexpr int kNumReaders = 4;
+  constexpr uint64_t kWritesPerWriter = 50000;
+
+  SeqLock<Words> seq_lock;
+  std::atomic<bool> done(false);
+
+  std::vector<std::unique_ptr<Reader>> readers;
+  std::vector<std::unique_ptr<DelegateSimpleThread>> reader_threads;
+  for (int i = 0; i < kNumReaders; ++i) {
+    readers.push_back(std::make_unique<Reader>(&seq_lock, &done));
+    reader_threads.push_back(std::make_unique<DelegateSimpleThread>(
+        readers.back().get(), "SeqLockReader"));
+    reader_threads.back()->Start();
+  }
+
+  std::vector<std::unique_ptr<Writer>> writers;
+  std::vector<std::unique_ptr<DelegateSimpleThread>> writer_threads;
+  for (int i = 0; i < kNumWriters; ++i) {
+    writers.push_back(std::make_unique<Writer>(
+        &seq_lock, 1 + i * kWritesPerWriter, kWritesPerWriter));
+    writer_threads.push_back(std::make_unique<DelegateSimpleThread>(
+        writers.back().get(), "SeqLockWriter"));
+    writer_threads.back()->Start();
+  }
+
+  for (auto& thread : writer_threads)
+    thread->Join();
+  done.store(true, std::memory_order_relaxed);
+  for (auto& thread : reader_threads)
+    thread->Join();
+
+  for (const auto& reader : readers)
+    EXPECT_EQ(0, reader->torn_reads());
+  Words last = seq_lock.Read();
+  EXPECT_TRUE(IsConsistent(last));
+  EXPECT_TRUE(last.values[0] == kWritesPerWriter ||
+              last.values[0] == kNumWriters * kWritesPerWriter);
+}
+
+}  // namespace base
@@ -24,6 +24,9 @@
 #include "base/memory/ref_counted.h"
 #include "base/synchronization/lock.h"
 #elif defined(OS_POSIX) || defined(OS_FUCHSIA)
+#include <stdint.h>
+
+#include <atomic>
 #include <list>
 #include <utility>
 
@@ -249,9 +252,29 @@ class BASE_EXPORT WaitableEvent {
 
     bool Dequeue(Waiter* waiter, void* tag);
 
+    // Returns true if the event is signaled, and resets it if it is an
+    // automatic reset event. Does not need |lock_|.
+    bool TryAcquireSignal();
+
+    // Called with |lock_| held before checking whether the event is signaled
+    // in order to enqueue a waiter. Makes Signal() take |lock_|, so that the
+    // event cannot be signaled between the check and Enqueue().
+    void PrepareEnqueue();
+
+    // Called with |lock_| held after |waiters_| changed, or after
+    // PrepareEnqueue() if no waiter was enqueued. Lets Signal() skip |lock_|
+    // again once there are no waiters to fire.
+    void UpdateHasWaiters();
+
     base::Lock lock_;
     const bool manual_reset_;
-    bool signaled_;
+
+    // Whether the event is signaled, whether |waiters_| may have waiters, and
+    // on Linux, the number of threads blocked in a futex wait on this word.
+    // See waitable_event_posix.cc.
+    std::atomic<int32_t> state_;
+
+    // Guarded by |lock_|.
     std::list<Waiter*> waiters_;
 
    private:
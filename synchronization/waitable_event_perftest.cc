@@ -47,6 +47,8 @@ class TraceWaitableEvent {
 
   bool IsSignaled() { return event_.IsSignaled(); }
 
+  WaitableEvent* event() { return &event_; }
+
   const std::vector<TimeDelta>& signal_times() const { return signal_times_; }
   const std::vector<TimeDelta>& wait_times() const { return wait_times_; }
   size_t samples() const { return samples_; }
@@ -175,4 +177,41 @@ TEST(WaitableEventPerfTest, Throughput) {
   EXPECT_LE(event.wait_times().capacity(), kCapacity);
 }
 
+TEST(WaitableEventPerfTest, WaitMany) {
+  const size_t kSamples = 1000;
+  const size_t kNumEvents = 8;
+
+  TraceWaitableEvent signaler(kSamples);
+  TraceWaitableEvent* events[kNumEvents];
+  WaitableEvent* raw_events[kNumEvents];
+  for (size_t i = 0; i < kNumEvents; ++i) {
+    events[i] = new TraceWaitableEvent(kSamples);
+    raw_events[i] = events[i]->event();
+  }
+
+  // The other thread signals the last event each time it is signaled, so that
+  // WaitMany() has to block on all of them.
+  SignalerThread thread(&signaler, events[kNumEvents - 1]);
+  thread.Start();
+
+  TimeTicks start = TimeTicks::Now();
+  for (size_t i = 0; i < kSamples; ++i) {
+    signaler.Signal();
+    EXPECT_EQ(kNumEvents - 1, WaitableEvent::WaitMany(raw_events, kNumEvents));
+  }
+  const TimeDelta elapsed = TimeTicks::Now() - start;
+
+  thread.RequestStop();
+  signaler.Signal();
+  thread.Join();
+
+  perf_test::PrintResult(
+      "round_trip_time", "", "waitmany-8-events-1000-samples",
+      static_cast<size_t>(elapsed.InNanoseconds()) / kSamples, "ns/sample",
+      true);
+
+  for (TraceWaitableEvent* event : events)
+    delete event;
+}
+
 }  // namespace base
@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include <algorithm>
 #include <limits>
@@ -15,6 +16,16 @@
 #include "base/synchronization/waitable_event.h"
 #include "base/threading/scoped_blocking_call.h"
 #include "base/threading/thread_restrictions.h"
+#include "build/build_config.h"
+
+#if (defined(OS_LINUX) || defined(OS_ANDROID)) && !defined(OS_NACL)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WAITABLE_EVENT_USE_FUTEX 1
+#endif
 
 // -----------------------------------------------------------------------------
 // A WaitableEvent on POSIX is implemented as a wait-list. Currently we don't
@@ -35,13 +46,58 @@
 // the wait-list of many events. An event passes a pointer to itself when
 // firing a waiter and so we can store that pointer to find out which event
 // triggered.
+//
+// Whether the event is signaled is kept in an atomic state word, together with
+// a bit telling whether the wait-list may be non-empty. While it is clear,
+// signaling is a single compare-and-swap that doesn't take the lock. On Linux,
+// Wait() and TimedWait() don't use the wait-list either: they count themselves
+// in the state word and block in a futex wait on it, so that Signal() only
+// makes a system call if there are such waiters.
 // -----------------------------------------------------------------------------
 
 namespace base {
 
-// -----------------------------------------------------------------------------
-// This is just an abstract base class for waking the two types of waiters
-// -----------------------------------------------------------------------------
+namespace {
+
+// The bits of WaitableEventKernel::state_.
+constexpr int32_t kSignaled = 1 << 0;
+constexpr int32_t kHasWaiters = 1 << 1;
+// The unit of the number of threads blocked in a futex wait, in the remaining
+// bits.
+constexpr int32_t kFutexWaiter = 1 << 2;
+
+#if defined(WAITABLE_EVENT_USE_FUTEX)
+
+static_assert(sizeof(std::atomic<int32_t>) == sizeof(int32_t),
+              "futex words must be plain 32-bit integers");
+
+// Blocks until |word| is woken up, unless it no longer holds |expected|. Can
+// return spuriously.
+void FutexWait(std::atomic<int32_t>* word,
+               int32_t expected,
+               const struct timespec* timeout) {
+  syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, expected, timeout, nullptr, 0);
+}
+
+// Wakes up to |count| threads blocked in FutexWait() on |word|. The memory of
+// |word| is not accessed, so it is safe to call after the event was deleted.
+void FutexWake(std::atomic<int32_t>* word, int count) {
+  syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+#endif  // defined(WAITABLE_EVENT_USE_FUTEX)
+
+// Wakes the threads blocked in a futex wait on |state|, after it was signaled.
+void WakeFutexWaiters(std::atomic<int32_t>* state, bool manual_reset) {
+#if defined(WAITABLE_EVENT_USE_FUTEX)
+  FutexWake(state, manual_reset ? std::numeric_limits<int>::max() : 1);
+#else
+  NOTREACHED();
+#endif
+}
+
+}  // namespace
+
 WaitableEvent::WaitableEvent(ResetPolicy reset_policy,
                              InitialState initial_state)
     : kernel_(new WaitableEventKernel(reset_policy, initial_state)) {}
@@ -49,39 +105,105 @@ WaitableEvent::WaitableEvent(ResetPolicy reset_policy,
 WaitableEvent::~WaitableEvent() = default;
 
 void WaitableEvent::Reset() {
-  base::AutoLock locked(kernel_->lock_);
-  kernel_->signaled_ = false;
+  kernel_->state_.fetch_and(~kSignaled, std::memory_order_relaxed);
 }
 
 void WaitableEvent::Signal() {
-  base::AutoLock locked(kernel_->lock_);
+  // A wait can return, and the event be deleted, as soon as the signal is
+  // visible. Only locals are used after that.
+  WaitableEventKernel* const kernel = kernel_.get();
+  const bool manual_reset = kernel->manual_reset_;
+
+  int32_t state = kernel->state_.load(std::memory_order_relaxed);
+  while (!(state & kHasWaiters)) {
+    if (state & kSignaled)
+      return;
+    if (kernel->state_.compare_exchange_weak(state, state | kSignaled,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+      if (state >= kFutexWaiter)
+        WakeFutexWaiters(&kernel->state_, manual_reset);
+      return;
+    }
+  }
+
+  // There are waiters to fire, which can return as soon as they are fired, so
+  // a reference keeps the kernel alive until |lock_| is released.
+  scoped_refptr<WaitableEventKernel> kernel_ref(kernel);
+  base::AutoLock locked(kernel->lock_);
 
-  if (kernel_->signaled_)
+  if (kernel->state_.load(std::memory_order_relaxed) & kSignaled)
     return;
 
-  if (kernel_->manual_reset_) {
+  if (manual_reset) {
     SignalAll();
-    kernel_->signaled_ = true;
-  } else {
-    // In the case of auto reset, if no waiters were woken, we remain
-    // signaled.
-    if (!SignalOne())
-      kernel_->signaled_ = true;
+  } else if (SignalOne()) {
+    kernel->UpdateHasWaiters();
+    return;
   }
+  // In the case of auto reset, if no waiters were woken, we remain signaled.
+  kernel->UpdateHasWaiters();
+  state = kernel->state_.fetch_or(kSignaled, std::memory_order_release);
+  if (state >= kFutexWaiter)
+    WakeFutexWaiters(&kernel->state_, manual_reset);
 }
 
 bool WaitableEvent::IsSignaled() {
-  base::AutoLock locked(kernel_->lock_);
-
-  const bool result = kernel_->signaled_;
-  if (result && !kernel_->manual_reset_)
-    kernel_->signaled_ = false;
-  return result;
+  return kernel_->TryAcquireSignal();
 }
 
 // -----------------------------------------------------------------------------
 // Synchronous waits
 
+#if defined(WAITABLE_EVENT_USE_FUTEX)
+
+// -----------------------------------------------------------------------------
+// This is a synchronous waiter for WaitMany(). The thread is blocked in a futex
+// wait on the state of this object. Fire() is called with the lock of the
+// signaling event held, and WaitMany() takes that lock before returning, so the
+// waiter outlives the calls to Fire().
+// -----------------------------------------------------------------------------
+class SyncWaiter : public WaitableEvent::Waiter {
+ public:
+  SyncWaiter() = default;
+
+  bool Fire(WaitableEvent* signaling_event) override {
+    int32_t state = kWaiting;
+    if (!state_.compare_exchange_strong(state, kFiring,
+                                        std::memory_order_relaxed)) {
+      return false;
+    }
+    signaling_event_ = signaling_event;
+    state_.store(kFired, std::memory_order_release);
+    FutexWake(&state_, 1);
+    return true;
+  }
+
+  bool Compare(void* tag) override { return this == tag; }
+
+  // Blocks until the waiter is fired.
+  void Wait() {
+    for (;;) {
+      const int32_t state = state_.load(std::memory_order_acquire);
+      if (state == kFired)
+        return;
+      FutexWait(&state_, state, nullptr);
+    }
+  }
+
+  WaitableEvent* signaling_event() const { return signaling_event_; }
+
+ private:
+  enum : int32_t { kWaiting, kFiring, kFired };
+
+  std::atomic<int32_t> state_{kWaiting};
+  WaitableEvent* signaling_event_ = nullptr;  // The WaitableEvent which woke us
+
+  DISALLOW_COPY_AND_ASSIGN(SyncWaiter);
+};
+
+#else  // defined(WAITABLE_EVENT_USE_FUTEX)
+
 // -----------------------------------------------------------------------------
 // This is a synchronous waiter. The thread is waiting on the given condition
 // variable and the fired flag in this object.
@@ -143,6 +265,13 @@ class SyncWaiter : public WaitableEvent::Waiter {
     return &cv_;
   }
 
+  // Blocks until the waiter is fired.
+  void Wait() {
+    base::AutoLock locked(lock_);
+    while (!fired_)
+      cv_.Wait();
+  }
+
  private:
   bool fired_;
   WaitableEvent* signaling_event_;  // The WaitableEvent which woke us
@@ -150,6 +279,8 @@ class SyncWaiter : public WaitableEvent::Waiter {
   base::ConditionVariable cv_;
 };
 
+#endif  // defined(WAITABLE_EVENT_USE_FUTEX)
+
 void WaitableEvent::Wait() {
   bool result = TimedWaitUntil(TimeTicks::Max());
   DCHECK(result) << "TimedWait() should never fail with infinite timeout";
@@ -163,20 +294,59 @@ bool WaitableEvent::TimedWait(const TimeDelta& wait_delta) {
 
 bool WaitableEvent::TimedWaitUntil(const TimeTicks& end_time) {
   internal::AssertBaseSyncPrimitivesAllowed();
+  // An event that is already signaled doesn't block.
+  if (kernel_->TryAcquireSignal())
+    return true;
+
   ScopedBlockingCall scoped_blocking_call(BlockingType::MAY_BLOCK);
   // Record the event that this thread is blocking upon (for hang diagnosis).
   base::debug::ScopedEventWaitActivity event_activity(this);
 
   const bool finite_time = !end_time.is_max();
 
-  kernel_->lock_.Acquire();
-  if (kernel_->signaled_) {
-    if (!kernel_->manual_reset_) {
-      // In this case we were signaled when we had no waiters. Now that
-      // someone has waited upon us, we can automatically reset.
-      kernel_->signaled_ = false;
+#if defined(WAITABLE_EVENT_USE_FUTEX)
+  WaitableEventKernel* const kernel = kernel_.get();
+  const int32_t reset_bits = kernel->manual_reset_ ? 0 : kSignaled;
+
+  // Count this thread as a futex waiter, so that Signal() wakes it up.
+  int32_t state =
+      kernel->state_.fetch_add(kFutexWaiter, std::memory_order_relaxed) +
+      kFutexWaiter;
+  for (;;) {
+    if (state & kSignaled) {
+      if (kernel->state_.compare_exchange_weak(
+              state, (state - kFutexWaiter) & ~reset_bits,
+              std::memory_order_acquire, std::memory_order_relaxed)) {
+        return true;
+      }
+      continue;
     }
 
+    struct timespec timeout;
+    const struct timespec* timeout_ptr = nullptr;
+    if (finite_time) {
+      const TimeDelta max_wait = end_time - TimeTicks::Now();
+      if (max_wait <= TimeDelta()) {
+        // Fails if the event was signaled meanwhile, which must then be
+        // returned.
+        if (kernel->state_.compare_exchange_weak(state, state - kFutexWaiter,
+                                                 std::memory_order_relaxed)) {
+          return false;
+        }
+        continue;
+      }
+      timeout = max_wait.ToTimeSpec();
+      timeout_ptr = &timeout;
+    }
+
+    FutexWait(&kernel->state_, state, timeout_ptr);
+    state = kernel->state_.load(std::memory_order_relaxed);
+  }
+#else
+  kernel_->lock_.Acquire();
+  kernel_->PrepareEnqueue();
+  if (kernel_->TryAcquireSignal()) {
+    kernel_->UpdateHasWaiters();
     kernel_->lock_.Release();
     return true;
   }
@@ -223,6 +393,7 @@ bool WaitableEvent::TimedWaitUntil(const TimeTicks& end_time) {
       sw.cv()->Wait();
     }
   }
+#endif  // defined(WAITABLE_EVENT_USE_FUTEX)
 }
 
 // -----------------------------------------------------------------------------
@@ -239,6 +410,14 @@ size_t WaitableEvent::WaitMany(WaitableEvent** raw_waitables,
                                size_t count) {
   internal::AssertBaseSyncPrimitivesAllowed();
   DCHECK(count) << "Cannot wait on no events";
+
+  // Return the lowest index of an event that is already signaled without
+  // sorting and locking the events.
+  for (size_t i = 0; i < count; ++i) {
+    if (raw_waitables[i]->kernel_->TryAcquireSignal())
+      return i;
+  }
+
   ScopedBlockingCall scoped_blocking_call(BlockingType::MAY_BLOCK);
   // Record an event (the first) that this thread is blocking upon.
   base::debug::ScopedEventWaitActivity event_activity(raw_waitables[0]);
@@ -272,20 +451,13 @@ size_t WaitableEvent::WaitMany(WaitableEvent** raw_waitables,
   }
 
   // At this point, we hold the locks on all the WaitableEvents and we have
-  // enqueued our waiter in them all.
-  sw.lock()->Acquire();
-    // Release the WaitableEvent locks in the reverse order
-    for (size_t i = 0; i < count; ++i) {
-      waitables[count - (1 + i)].first->kernel_->lock_.Release();
-    }
-
-    for (;;) {
-      if (sw.fired())
-        break;
+  // enqueued our waiter in them all. Release the WaitableEvent locks in the
+  // reverse order. A signal that fires the waiter before it blocks is not lost.
+  for (size_t i = 0; i < count; ++i) {
+    waitables[count - (1 + i)].first->kernel_->lock_.Release();
+  }
 
-      sw.cv()->Wait();
-    }
-  sw.lock()->Release();
+  sw.Wait();
 
   // The address of the WaitableEvent which fired is stored in the SyncWaiter.
   WaitableEvent *const signaled_event = sw.signaling_event();
@@ -329,33 +501,45 @@ size_t WaitableEvent::WaitMany(WaitableEvent** raw_waitables,
 size_t WaitableEvent::EnqueueMany(std::pair<WaitableEvent*, size_t>* waitables,
                                   size_t count,
                                   Waiter* waiter) {
-  size_t winner = count;
-  size_t winner_index = count;
   for (size_t i = 0; i < count; ++i) {
     auto& kernel = waitables[i].first->kernel_;
     kernel->lock_.Acquire();
-    if (kernel->signaled_ && waitables[i].second < winner) {
-      winner = waitables[i].second;
-      winner_index = i;
-    }
+    kernel->PrepareEnqueue();
   }
 
-  // No events signaled. All locks acquired. Enqueue the Waiter on all of them
-  // and return.
-  if (winner == count) {
-    for (size_t i = 0; i < count; ++i)
-      waitables[i].first->Enqueue(waiter);
-    return count;
+  // No event can be signaled while the locks are held, but a Wait() may reset
+  // the winner before it is claimed, in which case another one is chosen.
+  size_t winner_index;
+  for (;;) {
+    size_t winner = count;
+    winner_index = count;
+    for (size_t i = 0; i < count; ++i) {
+      if ((waitables[i].first->kernel_->state_.load(
+               std::memory_order_relaxed) &
+           kSignaled) &&
+          waitables[i].second < winner) {
+        winner = waitables[i].second;
+        winner_index = i;
+      }
+    }
+
+    // No events signaled. All locks acquired. Enqueue the Waiter on all of
+    // them and return.
+    if (winner == count) {
+      for (size_t i = 0; i < count; ++i)
+        waitables[i].first->Enqueue(waiter);
+      return count;
+    }
+
+    if (waitables[winner_index].first->kernel_->TryAcquireSignal())
+      break;
   }
 
-  // Unlock in reverse order and possibly clear the chosen winner's signal
-  // before returning its index.
+  // Unlock in reverse order before returning the index of the winner, whose
+  // signal was cleared if it is automatic reset.
   for (auto* w = waitables + count - 1; w >= waitables; --w) {
     auto& kernel = w->first->kernel_;
-    if (w->second == winner) {
-      if (!kernel->manual_reset_)
-        kernel->signaled_ = false;
-    }
+    kernel->UpdateHasWaiters();
     kernel->lock_.Release();
   }
 
@@ -372,10 +556,37 @@ WaitableEvent::WaitableEventKernel::WaitableEventKernel(
     ResetPolicy reset_policy,
     InitialState initial_state)
     : manual_reset_(reset_policy == ResetPolicy::MANUAL),
-      signaled_(initial_state == InitialState::SIGNALED) {}
+      state_(initial_state == InitialState::SIGNALED ? kSignaled : 0) {}
 
 WaitableEvent::WaitableEventKernel::~WaitableEventKernel() = default;
 
+bool WaitableEvent::WaitableEventKernel::TryAcquireSignal() {
+  int32_t state = state_.load(std::memory_order_acquire);
+  if (manual_reset_)
+    return (state & kSignaled) != 0;
+  while (state & kSignaled) {
+    if (state_.compare_exchange_weak(state, state & ~kSignaled,
+                                     std::memory_order_acquire,
+                                     std::memory_order_acquire)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void WaitableEvent::WaitableEventKernel::PrepareEnqueue() {
+  lock_.AssertAcquired();
+  state_.fetch_or(kHasWaiters, std::memory_order_relaxed);
+}
+
+void WaitableEvent::WaitableEventKernel::UpdateHasWaiters() {
+  lock_.AssertAcquired();
+  if (waiters_.empty())
+    state_.fetch_and(~kHasWaiters, std::memory_order_relaxed);
+  else
+    state_.fetch_or(kHasWaiters, std::memory_order_relaxed);
+}
+
 // -----------------------------------------------------------------------------
 // Wake all waiting waiters. Called with lock held.
 // -----------------------------------------------------------------------------
@@ -412,6 +623,8 @@ bool WaitableEvent::SignalOne() {
 // Add a waiter to the list of those waiting. Called with lock held.
 // -----------------------------------------------------------------------------
 void WaitableEvent::Enqueue(Waiter* waiter) {
+  DCHECK(kernel_->state_.load(std::memory_order_relaxed) & kHasWaiters)
+      << "PrepareEnqueue() must be called first";
   kernel_->waiters_.push_back(waiter);
 }
 
@@ -424,6 +637,7 @@ bool WaitableEvent::WaitableEventKernel::Dequeue(Waiter* waiter, void* tag) {
        i = waiters_.begin(); i != waiters_.end(); ++i) {
     if (*i == waiter && (*i)->Compare(tag)) {
       waiters_.erase(i);
+      UpdateHasWaiters();
       return true;
     }
   }
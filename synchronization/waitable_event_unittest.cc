@@ -7,8 +7,10 @@
 #include <stddef.h>
 
 #include <algorithm>
+#include <atomic>
 
 #include "base/compiler_specific.h"
+#include "base/macros.h"
 #include "base/threading/platform_thread.h"
 #include "base/time/time.h"
 #include "build/build_config.h"
@@ -204,6 +206,91 @@ TEST(WaitableEventTest, WaitMany) {
   EXPECT_EQ(2u, index);
 }
 
+namespace {
+
+// Consumes the signals of an automatic reset event, acknowledging each one,
+// until one is received after |done| is set.
+class WaitableEventConsumer : public PlatformThread::Delegate {
+ public:
+  WaitableEventConsumer(WaitableEvent* event,
+                        bool use_wait_many,
+                        const std::atomic<bool>* done,
+                        std::atomic<int>* consumed,
+                        WaitableEvent* ack)
+      : event_(event),
+        use_wait_many_(use_wait_many),
+        done_(done),
+        consumed_(consumed),
+        ack_(ack) {}
+
+  void ThreadMain() override {
+    WaitableEvent never_signaled(WaitableEvent::ResetPolicy::MANUAL,
+                                 WaitableEvent::InitialState::NOT_SIGNALED);
+    WaitableEvent* events[] = {&never_signaled, event_};
+    for (;;) {
+      if (use_wait_many_)
+        EXPECT_EQ(1u, WaitableEvent::WaitMany(events, arraysize(events)));
+      else
+        event_->Wait();
+      const bool done = done_->load();
+      if (!done)
+        consumed_->fetch_add(1);
+      ack_->Signal();
+      if (done)
+        return;
+    }
+  }
+
+ private:
+  WaitableEvent* const event_;
+  const bool use_wait_many_;
+  const std::atomic<bool>* const done_;
+  std::atomic<int>* const consumed_;
+  WaitableEvent* const ack_;
+
+  DISALLOW_COPY_AND_ASSIGN(WaitableEventConsumer);
+};
+
+}  // namespace
+
+// Tests that each signal of an automatic reset event wakes exactly one of the
+// threads in Wait() and WaitMany() on it.
+TEST(WaitableEventTest, AutoResetWakesOneWaiter) {
+  constexpr int kSignals = 1000;
+  WaitableEvent event(WaitableEvent::ResetPolicy::AUTOMATIC,
+                      WaitableEvent::InitialState::NOT_SIGNALED);
+  WaitableEvent ack(WaitableEvent::ResetPolicy::AUTOMATIC,
+                    WaitableEvent::InitialState::NOT_SIGNALED);
+  std::atomic<bool> done(false);
+  std::atomic<int> consumed(0);
+
+  WaitableEventConsumer wait_consumer(&event, false, &done, &consumed, &ack);
+  WaitableEventConsumer other_wait_consumer(&event, false, &done, &consumed,
+                                            &ack);
+  WaitableEventConsumer wait_many_consumer(&event, true, &done, &consumed,
+                                           &ack);
+  PlatformThreadHandle threads[3];
+  PlatformThread::Create(0, &wait_consumer, &threads[0]);
+  PlatformThread::Create(0, &other_wait_consumer, &threads[1]);
+  PlatformThread::Create(0, &wait_many_consumer, &threads[2]);
+
+  for (int i = 0; i < kSignals; ++i) {
+    event.Signal();
+    ack.Wait();
+    EXPECT_EQ(i + 1, consumed.load());
+  }
+  EXPECT_FALSE(event.IsSignaled());
+
+  done.store(true);
+  for (size_t i = 0; i < arraysize(threads); ++i) {
+    event.Signal();
+    ack.Wait();
+  }
+  for (PlatformThreadHandle thread : threads)
+    PlatformThread::Join(thread);
+  EXPECT_EQ(kSignals, consumed.load());
+}
+
 // Tests that using TimeDelta::Max() on TimedWait() is not the same as passing
 // a timeout of 0. (crbug.com/465948)
 TEST(WaitableEventTest, TimedWait) {
@@ -144,9 +144,9 @@ bool WaitableEventWatcher::StartWatching(
 
   AutoLock locked(kernel->lock_);
 
-  if (kernel->signaled_) {
-    if (!kernel->manual_reset_)
-      kernel->signaled_ = false;
+  kernel->PrepareEnqueue();
+  if (kernel->TryAcquireSignal()) {
+    kernel->UpdateHasWaiters();
 
     // No hairpinning - we can't call the delegate directly here. We have to
     // post a task to |task_runner| as usual.
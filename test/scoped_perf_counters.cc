@@ -0,0 +1,53 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/test/scoped_perf_counters.h"
+
+#include <memory>
+#include <utility>
+
+#include "base/test/perf_log.h"
+#include "base/trace_event/trace_event.h"
+#include "base/trace_event/trace_event_argument.h"
+
+namespace base {
+
+ScopedPerfCounters::ScopedPerfCounters(const char* test_name)
+    : logged_(false), test_name_(test_name) {
+  counters_.Start();
+}
+
+ScopedPerfCounters::~ScopedPerfCounters() {
+  if (!logged_)
+    Done();
+}
+
+void ScopedPerfCounters::Done() {
+  counters_.Stop();
+  logged_ = true;
+  const PerfCounterGroup::Values values = counters_.Read();
+  if (!values.available_mask)
+    return;
+
+  auto traced_value = std::make_unique<trace_event::TracedValue>();
+  for (int i = 0; i < PerfCounterGroup::kNumCounters; ++i) {
+    const auto counter = static_cast<PerfCounterGroup::Counter>(i);
+    if (!values.IsAvailable(counter))
+      continue;
+    const char* counter_name = PerfCounterGroup::GetCounterName(counter);
+    LogPerfResult((test_name_ + "_" + counter_name).c_str(),
+                  values.counts[counter], counter_name);
+    traced_value->SetDouble(counter_name, values.counts[counter]);
+  }
+  const double ipc = values.GetInstructionsPerCycle();
+  if (ipc) {
+    LogPerfResult((test_name_ + "_ipc").c_str(), ipc, "instructions/cycle");
+    traced_value->SetDouble("ipc", ipc);
+  }
+  TRACE_EVENT_COPY_INSTANT1(TRACE_DISABLED_BY_DEFAULT("perf_counters"),
+                            test_name_.c_str(), TRACE_EVENT_SCOPE_THREAD,
+                            "counters", std::move(traced_value));
+}
+
+}  // namespace base
@@ -0,0 +1,41 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TEST_SCOPED_PERF_COUNTERS_H_
+#define BASE_TEST_SCOPED_PERF_COUNTERS_H_
+
+#include <string>
+
+#include "base/macros.h"
+#include "base/profiler/perf_counter_group.h"
+
+namespace base {
+
+// Like PerfTimeLogger, but for hardware performance counters: counts the
+// cycles, instructions, cache misses and branch misses of the current thread
+// until Done() or destruction, then calls LogPerfResult() for each available
+// counter as "<test_name>_<counter>", and for the instructions per cycle as
+// "<test_name>_ipc". Counters that are not available on the machine running
+// the test are not logged.
+//
+// The counts are also added to the trace as an instant event named
+// |test_name| in the "disabled-by-default-perf_counters" category.
+class ScopedPerfCounters {
+ public:
+  explicit ScopedPerfCounters(const char* test_name);
+  ~ScopedPerfCounters();
+
+  void Done();
+
+ private:
+  bool logged_;
+  std::string test_name_;
+  PerfCounterGroup counters_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedPerfCounters);
+};
+
+}  // namespace base
+
+#endif  // BASE_TEST_SCOPED_PERF_COUNTERS_H_
@@ -4,9 +4,12 @@
 
 #include "base/threading/thread_local_storage.h"
 
+#include <string.h>
+
+#include <atomic>
+
 #include "base/atomicops.h"
 #include "base/logging.h"
-#include "base/synchronization/lock.h"
 #include "build/build_config.h"
 
 using base::internal::PlatformThreadLocalStorage;
@@ -56,6 +59,13 @@ using base::internal::PlatformThreadLocalStorage;
 // managing any necessary lifetime of the data in their slots. The only
 // convenience provided is automatic destruction when a thread ends. If a client
 // frees a slot, that client is responsible for destroying the data in the slot.
+//
+// Slots are allocated and freed without locks, by atomically changing the
+// status of their metadata entry. Where the toolchain supports initial-exec
+// static TLS, the pointer to the Chrome TLS Array is also cached in a static
+// TLS variable, so that Slot::Get() and Slot::Set() are a static TLS load and
+// an array access instead of a call to pthread_getspecific(). The OS TLS slot
+// remains the source of truth for thread destruction.
 
 namespace {
 // In order to make TLS destructors work, we need to keep around a function
@@ -113,10 +123,22 @@ constexpr int kThreadLocalStorageSize = 256;
 
 enum TlsStatus {
   FREE,
+  // The slot is being allocated, and |destructor| and |version| are not
+  // published yet.
+  INITIALIZING,
   IN_USE,
 };
 
+// Zero-initialized, so that all slots start FREE, without static
+// initializers.
 struct TlsMetadata {
+  std::atomic<TlsStatus> status;
+  std::atomic<base::ThreadLocalStorage::TLSDestructorFunc> destructor;
+  std::atomic<uint32_t> version;
+};
+
+// A copy of a TlsMetadata entry.
+struct TlsMetadataSnapshot {
   TlsStatus status;
   base::ThreadLocalStorage::TLSDestructorFunc destructor;
   uint32_t version;
@@ -127,14 +149,38 @@ struct TlsVectorEntry {
   uint32_t version;
 };
 
-// This lock isn't needed until after we've constructed the per-thread TLS
-// vector, so it's safe to use.
-base::Lock* GetTLSMetadataLock() {
-  static auto* lock = new base::Lock();
-  return lock;
-}
 TlsMetadata g_tls_metadata[kThreadLocalStorageSize];
-size_t g_last_assigned_slot = 0;
+std::atomic<size_t> g_last_assigned_slot;
+
+// Static TLS is only used where it cannot be emulated or allocated lazily,
+// either of which would make it slower than the OS TLS slot.
+#if defined(OS_LINUX) && !defined(OS_NACL) && defined(COMPILER_GCC)
+#define TLS_VECTOR_IN_STATIC_TLS 1
+// Mirrors the value of the OS TLS slot for the current thread. Trivially
+// destructible, so that it can still be accessed by pthread key destructors.
+__thread void* g_tls_vector __attribute__((tls_model("initial-exec"))) =
+    nullptr;
+#else
+#define TLS_VECTOR_IN_STATIC_TLS 0
+#endif
+
+// Returns the value of the OS TLS slot, which is kUninitialized, kDestroyed or
+// the current thread's TLS vector.
+void* GetTlsVectorValue() {
+#if TLS_VECTOR_IN_STATIC_TLS
+  return g_tls_vector;
+#else
+  return PlatformThreadLocalStorage::GetTLSValue(
+      base::subtle::NoBarrier_Load(&g_native_tls_key));
+#endif
+}
+
+void SetTlsVectorValue(PlatformThreadLocalStorage::TLSKey key, void* value) {
+  PlatformThreadLocalStorage::SetTLSValue(key, value);
+#if TLS_VECTOR_IN_STATIC_TLS
+  g_tls_vector = value;
+#endif
+}
 
 // The maximum number of times to try to clear slots by calling destructors.
 // Use pthread naming convention for clarity.
@@ -191,12 +237,12 @@ TlsVectorEntry* ConstructTlsVector() {
   TlsVectorEntry stack_allocated_tls_data[kThreadLocalStorageSize];
   memset(stack_allocated_tls_data, 0, sizeof(stack_allocated_tls_data));
   // Ensure that any rentrant calls change the temp version.
-  PlatformThreadLocalStorage::SetTLSValue(key, stack_allocated_tls_data);
+  SetTlsVectorValue(key, stack_allocated_tls_data);
 
   // Allocate an array to store our data.
   TlsVectorEntry* tls_data = new TlsVectorEntry[kThreadLocalStorageSize];
   memcpy(tls_data, stack_allocated_tls_data, sizeof(stack_allocated_tls_data));
-  PlatformThreadLocalStorage::SetTLSValue(key, tls_data);
+  SetTlsVectorValue(key, tls_data);
   return tls_data;
 }
 
@@ -207,7 +253,7 @@ void OnThreadExitInternal(TlsVectorEntry* tls_data) {
   if (tls_data == kDestroyed) {
     PlatformThreadLocalStorage::TLSKey key =
         base::subtle::NoBarrier_Load(&g_native_tls_key);
-    PlatformThreadLocalStorage::SetTLSValue(key, kUninitialized);
+    SetTlsVectorValue(key, kUninitialized);
     return;
   }
 
@@ -226,14 +272,28 @@ void OnThreadExitInternal(TlsVectorEntry* tls_data) {
   // Ensure that any re-entrant calls change the temp version.
   PlatformThreadLocalStorage::TLSKey key =
       base::subtle::NoBarrier_Load(&g_native_tls_key);
-  PlatformThreadLocalStorage::SetTLSValue(key, stack_allocated_tls_data);
+  SetTlsVectorValue(key, stack_allocated_tls_data);
   delete[] tls_data;  // Our last dependence on an allocator.
 
-  // Snapshot the TLS Metadata so we don't have to lock on every access.
-  TlsMetadata tls_metadata[kThreadLocalStorageSize];
-  {
-    base::AutoLock auto_lock(*GetTLSMetadataLock());
-    memcpy(tls_metadata, g_tls_metadata, sizeof(g_tls_metadata));
+  // Snapshot the TLS Metadata. Slots may be freed and reallocated by other
+  // threads meanwhile, so an entry is only kept as IN_USE if its version did
+  // not change while it was read, and the version is checked again right
+  // before the destructor runs.
+  TlsMetadataSnapshot tls_metadata[kThreadLocalStorageSize];
+  for (int slot = 0; slot < kThreadLocalStorageSize; ++slot) {
+    const uint32_t version =
+        g_tls_metadata[slot].version.load(std::memory_order_acquire);
+    // Pairs with the release stores in Slot::Initialize() and Slot::Free().
+    tls_metadata[slot].status =
+        g_tls_metadata[slot].status.load(std::memory_order_acquire);
+    tls_metadata[slot].destructor =
+        g_tls_metadata[slot].destructor.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (g_tls_metadata[slot].version.load(std::memory_order_relaxed) !=
+        version) {
+      tls_metadata[slot].status = TlsStatus::FREE;
+    }
+    tls_metadata[slot].version = version;
   }
 
   int remaining_attempts = kMaxDestructorIterations;
@@ -248,7 +308,7 @@ void OnThreadExitInternal(TlsVectorEntry* tls_data) {
     // (but it might help).
     for (int slot = 0; slot < kThreadLocalStorageSize ; ++slot) {
       void* tls_value = stack_allocated_tls_data[slot].data;
-      if (!tls_value || tls_metadata[slot].status == TlsStatus::FREE ||
+      if (!tls_value || tls_metadata[slot].status != TlsStatus::IN_USE ||
           stack_allocated_tls_data[slot].version != tls_metadata[slot].version)
         continue;
 
@@ -256,6 +316,11 @@ void OnThreadExitInternal(TlsVectorEntry* tls_data) {
           tls_metadata[slot].destructor;
       if (!destructor)
         continue;
+      // Skip slots freed since the snapshot; their owner destroys the data.
+      if (g_tls_metadata[slot].version.load(std::memory_order_acquire) !=
+          tls_metadata[slot].version) {
+        continue;
+      }
       stack_allocated_tls_data[slot].data = nullptr;  // pre-clear the slot.
       destructor(tls_value);
       // Any destructor might have called a different service, which then set a
@@ -270,7 +335,7 @@ void OnThreadExitInternal(TlsVectorEntry* tls_data) {
   }
 
   // Remove our stack allocated vector.
-  PlatformThreadLocalStorage::SetTLSValue(key, kDestroyed);
+  SetTlsVectorValue(key, kDestroyed);
 }
 
 }  // namespace
@@ -309,38 +374,43 @@ bool ThreadLocalStorage::HasBeenDestroyed() {
       base::subtle::NoBarrier_Load(&g_native_tls_key);
   if (key == PlatformThreadLocalStorage::TLS_KEY_OUT_OF_INDEXES)
     return false;
-  return PlatformThreadLocalStorage::GetTLSValue(key) == kDestroyed;
+  return GetTlsVectorValue() == kDestroyed;
 }
 
 void ThreadLocalStorage::Slot::Initialize(TLSDestructorFunc destructor) {
   PlatformThreadLocalStorage::TLSKey key =
       base::subtle::NoBarrier_Load(&g_native_tls_key);
   if (key == PlatformThreadLocalStorage::TLS_KEY_OUT_OF_INDEXES ||
-      PlatformThreadLocalStorage::GetTLSValue(key) == kUninitialized) {
+      GetTlsVectorValue() == kUninitialized) {
     ConstructTlsVector();
   }
 
   // Grab a new slot.
-  {
-    base::AutoLock auto_lock(*GetTLSMetadataLock());
-    for (int i = 0; i < kThreadLocalStorageSize; ++i) {
-      // Tracking the last assigned slot is an attempt to find the next
-      // available slot within one iteration. Under normal usage, slots remain
-      // in use for the lifetime of the process (otherwise before we reclaimed
-      // slots, we would have run out of slots). This makes it highly likely the
-      // next slot is going to be a free slot.
-      size_t slot_candidate =
-          (g_last_assigned_slot + 1 + i) % kThreadLocalStorageSize;
-      if (g_tls_metadata[slot_candidate].status == TlsStatus::FREE) {
-        g_tls_metadata[slot_candidate].status = TlsStatus::IN_USE;
-        g_tls_metadata[slot_candidate].destructor = destructor;
-        g_last_assigned_slot = slot_candidate;
-        DCHECK_EQ(kInvalidSlotValue, slot_);
-        slot_ = slot_candidate;
-        version_ = g_tls_metadata[slot_candidate].version;
-        break;
-      }
+  const size_t last_assigned_slot =
+      g_last_assigned_slot.load(std::memory_order_relaxed);
+  for (int i = 0; i < kThreadLocalStorageSize; ++i) {
+    // Tracking the last assigned slot is an attempt to find the next
+    // available slot within one iteration. Under normal usage, slots remain
+    // in use for the lifetime of the process (otherwise before we reclaimed
+    // slots, we would have run out of slots). This makes it highly likely the
+    // next slot is going to be a free slot.
+    size_t slot_candidate =
+        (last_assigned_slot + 1 + i) % kThreadLocalStorageSize;
+    TlsMetadata& metadata = g_tls_metadata[slot_candidate];
+    TlsStatus status = TlsStatus::FREE;
+    if (!metadata.status.compare_exchange_strong(
+            status, TlsStatus::INITIALIZING, std::memory_order_acquire,
+            std::memory_order_relaxed)) {
+      continue;
     }
+    metadata.destructor.store(destructor, std::memory_order_relaxed);
+    // Publishes |destructor| to exiting threads.
+    metadata.status.store(TlsStatus::IN_USE, std::memory_order_release);
+    g_last_assigned_slot.store(slot_candidate, std::memory_order_relaxed);
+    DCHECK_EQ(kInvalidSlotValue, slot_);
+    slot_ = slot_candidate;
+    version_ = metadata.version.load(std::memory_order_relaxed);
+    break;
   }
   CHECK_NE(slot_, kInvalidSlotValue);
   CHECK_LT(slot_, kThreadLocalStorageSize);
@@ -349,19 +419,17 @@ void ThreadLocalStorage::Slot::Initialize(TLSDestructorFunc destructor) {
 void ThreadLocalStorage::Slot::Free() {
   DCHECK_NE(slot_, kInvalidSlotValue);
   DCHECK_LT(slot_, kThreadLocalStorageSize);
-  {
-    base::AutoLock auto_lock(*GetTLSMetadataLock());
-    g_tls_metadata[slot_].status = TlsStatus::FREE;
-    g_tls_metadata[slot_].destructor = nullptr;
-    ++(g_tls_metadata[slot_].version);
-  }
+  TlsMetadata& metadata = g_tls_metadata[slot_];
+  DCHECK_EQ(TlsStatus::IN_USE, metadata.status.load(std::memory_order_relaxed));
+  metadata.destructor.store(nullptr, std::memory_order_relaxed);
+  metadata.version.fetch_add(1, std::memory_order_relaxed);
+  // The slot can only be reallocated once the version is incremented.
+  metadata.status.store(TlsStatus::FREE, std::memory_order_release);
   slot_ = kInvalidSlotValue;
 }
 
 void* ThreadLocalStorage::Slot::Get() const {
-  TlsVectorEntry* tls_data = static_cast<TlsVectorEntry*>(
-      PlatformThreadLocalStorage::GetTLSValue(
-          base::subtle::NoBarrier_Load(&g_native_tls_key)));
+  TlsVectorEntry* tls_data = static_cast<TlsVectorEntry*>(GetTlsVectorValue());
   DCHECK_NE(tls_data, kDestroyed);
   if (!tls_data)
     return nullptr;
@@ -374,9 +442,7 @@ void* ThreadLocalStorage::Slot::Get() const {
 }
 
 void ThreadLocalStorage::Slot::Set(void* value) {
-  TlsVectorEntry* tls_data = static_cast<TlsVectorEntry*>(
-      PlatformThreadLocalStorage::GetTLSValue(
-          base::subtle::NoBarrier_Load(&g_native_tls_key)));
+  TlsVectorEntry* tls_data = static_cast<TlsVectorEntry*>(GetTlsVectorValue());
   DCHECK_NE(tls_data, kDestroyed);
   if (!tls_data)
     tls_data = ConstructTlsVector();
@@ -0,0 +1,91 @@
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/threading/thread_local_storage.h"
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/debug/alias.h"
+#include "base/macros.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+
+namespace {
+
+constexpr int kIterations = 10000000;
+constexpr int kSlotIterations = 10000;
+constexpr int kThreads = 8;
+
+void PrintNanosecondsPerOp(const std::string& trace,
+                           TimeDelta elapsed,
+                           int operations) {
+  perf_test::PrintResult("ThreadLocalStorage", trace, "",
+                         elapsed.InMicrosecondsF() * 1000 / operations, "ns",
+                         true);
+}
+
+// Allocates and frees slots, concurrently with other threads.
+class SlotChurnThread : public SimpleThread {
+ public:
+  SlotChurnThread() : SimpleThread("ThreadLocalStoragePerfTest") {}
+
+  void Run() override {
+    for (int i = 0; i < kSlotIterations; ++i) {
+      ThreadLocalStorage::Slot slot;
+      slot.Set(this);
+    }
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(SlotChurnThread);
+};
+
+}  // namespace
+
+TEST(ThreadLocalStoragePerfTest, Get) {
+  ThreadLocalStorage::Slot slot;
+  int value = 0;
+  slot.Set(&value);
+  void* result = nullptr;
+  TimeTicks start = TimeTicks::Now();
+  for (int i = 0; i < kIterations; ++i) {
+    result = slot.Get();
+    debug::Alias(&result);
+  }
+  PrintNanosecondsPerOp("_get", TimeTicks::Now() - start, kIterations);
+  EXPECT_EQ(&value, result);
+}
+
+TEST(ThreadLocalStoragePerfTest, Set) {
+  ThreadLocalStorage::Slot slot;
+  int values[2];
+  TimeTicks start = TimeTicks::Now();
+  for (int i = 0; i < kIterations; ++i)
+    slot.Set(&values[i & 1]);
+  PrintNanosecondsPerOp("_set", TimeTicks::Now() - start, kIterations);
+  EXPECT_EQ(&values[1], slot.Get());
+}
+
+TEST(ThreadLocalStoragePerfTest, SlotAllocation) {
+  std::vector<std::unique_ptr<SlotChurnThread>> threads;
+  TimeTicks start = TimeTicks::Now();
+  for (int i = 0; i < kThreads; ++i) {
+    threads.push_back(std::make_unique<SlotChurnThread>());
+    threads.back()->Start();
+  }
+  for (auto& thread : threads)
+    thread->Join();
+  PrintNanosecondsPerOp("_slot_allocation", TimeTicks::Now() - start,
+                        kThreads * kSlotIterations);
+}
+
+}  // namespace base
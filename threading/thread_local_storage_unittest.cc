@@ -9,6 +9,8 @@
 #include <process.h>
 #endif
 
+#include <memory>
+
 #include "base/macros.h"
 #include "base/no_destructor.h"
 #include "base/threading/simple_thread.h"
@@ -257,6 +259,42 @@ TEST(ThreadLocalStorageTest, TLSReclaim) {
   }
 }
 
+namespace {
+
+// Allocates, uses and frees slots concurrently with other threads.
+class SlotChurnRunner : public DelegateSimpleThread::Delegate {
+ public:
+  SlotChurnRunner() = default;
+  ~SlotChurnRunner() override = default;
+
+  void Run() override {
+    for (int i = 0; i < 1000; ++i) {
+      ThreadLocalStorage::Slot slot(nullptr);
+      EXPECT_EQ(nullptr, slot.Get());
+      slot.Set(this);
+      EXPECT_EQ(this, slot.Get());
+    }
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(SlotChurnRunner);
+};
+
+}  // namespace
+
+TEST(ThreadLocalStorageTest, ConcurrentSlotAllocation) {
+  constexpr int kThreads = 8;
+  SlotChurnRunner runners[kThreads];
+  std::unique_ptr<DelegateSimpleThread> threads[kThreads];
+  for (int i = 0; i < kThreads; ++i) {
+    threads[i] = std::make_unique<DelegateSimpleThread>(
+        &runners[i], "ThreadLocalStorageTest");
+    threads[i]->Start();
+  }
+  for (auto& thread : threads)
+    thread->Join();
+}
+
 #if defined(OS_POSIX)
 // Unlike POSIX, Windows does not iterate through the OS TLS to cleanup any
 // values there. Instead a per-module thread destruction function is called.
@@ -42,6 +42,7 @@
 #include "base/cpu.h"
 #include "base/logging.h"
 #include "base/synchronization/lock.h"
+#include "base/synchronization/seq_lock.h"
 #include "base/threading/platform_thread.h"
 #include "base/time/time_override.h"
 
@@ -76,12 +77,22 @@ int64_t CurrentWallclockMicroseconds() {
 // Time between resampling the un-granular clock for this API.
 constexpr TimeDelta kMaxTimeToAvoidDrift = TimeDelta::FromSeconds(60);
 
-int64_t g_initial_time = 0;
-TimeTicks g_initial_ticks;
+// A wall clock reading and the TimeTicks at which it was taken, from which
+// Time::Now() extrapolates. Every Time::Now() reads both, and any thread may
+// resync them, so they are kept in a SeqLock to be read without tearing and
+// without contention.
+struct ClockSync {
+  TimeTicks initial_ticks;
+  int64_t initial_time;
+};
+SeqLock<ClockSync> g_clock_sync;
 
-void InitializeClock() {
-  g_initial_ticks = subtle::TimeTicksNowIgnoringOverride();
-  g_initial_time = CurrentWallclockMicroseconds();
+ClockSync InitializeClock() {
+  ClockSync clock_sync;
+  clock_sync.initial_ticks = subtle::TimeTicksNowIgnoringOverride();
+  clock_sync.initial_time = CurrentWallclockMicroseconds();
+  g_clock_sync.Write(clock_sync);
+  return clock_sync;
 }
 
 // The two values that ActivateHighResolutionTimer uses to set the systemwide
@@ -130,14 +141,15 @@ bool SafeConvertToWord(int in, WORD* out) {
 
 namespace subtle {
 Time TimeNowIgnoringOverride() {
-  if (g_initial_time == 0)
-    InitializeClock();
+  ClockSync clock_sync = g_clock_sync.Read();
+  if (clock_sync.initial_time == 0)
+    clock_sync = InitializeClock();
 
   // We implement time using the high-resolution timers so that we can get
   // timeouts which are smaller than 10-15ms.  If we just used
   // CurrentWallclockMicroseconds(), we'd have the less-granular timer.
   //
-  // To make this work, we initialize the clock (g_initial_time) and the
+  // To make this work, we initialize the clock (initial_time) and the
   // counter (initial_ctr).  To compute the initial time, we can check
   // the number of ticks that have elapsed, and compute the delta.
   //
@@ -147,22 +159,22 @@ Time TimeNowIgnoringOverride() {
     TimeTicks ticks = TimeTicksNowIgnoringOverride();
 
     // Calculate the time elapsed since we started our timer
-    TimeDelta elapsed = ticks - g_initial_ticks;
+    TimeDelta elapsed = ticks - clock_sync.initial_ticks;
 
     // Check if enough time has elapsed that we need to resync the clock.
     if (elapsed > kMaxTimeToAvoidDrift) {
-      InitializeClock();
+      clock_sync = InitializeClock();
       continue;
     }
 
-    return Time() + elapsed + TimeDelta::FromMicroseconds(g_initial_time);
+    return Time() + elapsed +
+           TimeDelta::FromMicroseconds(clock_sync.initial_time);
   }
 }
 
 Time TimeNowFromSystemTimeIgnoringOverride() {
   // Force resync.
-  InitializeClock();
-  return Time() + TimeDelta::FromMicroseconds(g_initial_time);
+  return Time() + TimeDelta::FromMicroseconds(InitializeClock().initial_time);
 }
 }  // namespace subtle
 
@@ -9,8 +9,8 @@
 #include <type_traits>
 
 #include "base/atomicops.h"
-#include "base/debug/leak_annotations.h"
 #include "base/logging.h"
+#include "base/strings/interned_string.h"
 #include "base/third_party/dynamic_annotations/dynamic_annotations.h"
 #include "base/trace_event/trace_category.h"
 
@@ -20,7 +20,7 @@ namespace trace_event {
 namespace {
 
 constexpr size_t kMaxCategories = 200;
-const int kNumBuiltinCategories = 4;
+constexpr size_t kNumBuiltinCategories = 4;
 
 // |g_categories| might end up causing creating dynamic initializers if not POD.
 static_assert(std::is_pod<TraceCategory>::value, "TraceCategory must be POD");
@@ -84,11 +84,21 @@ TraceCategory* CategoryRegistry::GetCategoryByName(const char* category_name) {
   size_t category_index = base::subtle::Acquire_Load(&g_category_index);
 
   // Search for pre-existing category group.
-  for (size_t i = 0; i < category_index; ++i) {
+  for (size_t i = 0; i < kNumBuiltinCategories; ++i) {
     if (strcmp(g_categories[i].name(), category_name) == 0) {
       return &g_categories[i];
     }
   }
+
+  // The names of the other categories are interned, so they can be compared
+  // by pointer. A name that was never interned isn't a category.
+  InternedString interned_name;
+  if (!InternedString::Find(category_name, &interned_name))
+    return nullptr;
+  for (size_t i = kNumBuiltinCategories; i < category_index; ++i) {
+    if (g_categories[i].name() == interned_name.c_str())
+      return &g_categories[i];
+  }
   return nullptr;
 }
 
@@ -111,11 +121,10 @@ bool CategoryRegistry::GetOrCreateCategoryLocked(
     return false;
   }
 
-  // TODO(primiano): this strdup should be removed. The only documented reason
-  // for it was TraceWatchEvent, which is gone. However, something might have
-  // ended up relying on this. Needs some auditing before removal.
-  const char* category_name_copy = strdup(category_name);
-  ANNOTATE_LEAKING_OBJECT_PTR(category_name_copy);
+  // The name is copied into the intern pool, which never frees it, so that
+  // GetCategoryByName() can compare names by pointer.
+  const char* category_name_copy =
+      InternedString::Intern(category_name).c_str();
 
   *category = &g_categories[category_index];
   DCHECK(!(*category)->is_valid());
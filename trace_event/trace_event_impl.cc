@@ -11,9 +11,9 @@
 #include "base/memory/ptr_util.h"
 #include "base/process/process_handle.h"
 #include "base/stl_util.h"
+#include "base/strings/str_format.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_util.h"
-#include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/trace_event/trace_event.h"
 #include "base/trace_event/trace_event_argument.h"
@@ -217,10 +217,10 @@ void TraceEvent::AppendValueAsJSON(unsigned char type,
       *out += value.as_bool ? "true" : "false";
       break;
     case TRACE_VALUE_TYPE_UINT:
-      StringAppendF(out, "%" PRIu64, static_cast<uint64_t>(value.as_uint));
+      StrAppendFormat(out, "%" PRIu64, static_cast<uint64_t>(value.as_uint));
       break;
     case TRACE_VALUE_TYPE_INT:
-      StringAppendF(out, "%" PRId64, static_cast<int64_t>(value.as_int));
+      StrAppendFormat(out, "%" PRId64, static_cast<int64_t>(value.as_int));
       break;
     case TRACE_VALUE_TYPE_DOUBLE: {
       // FIXME: base/json/json_writer.cc is using the same code,
@@ -254,13 +254,13 @@ void TraceEvent::AppendValueAsJSON(unsigned char type,
       } else {
         real = "\"Infinity\"";
       }
-      StringAppendF(out, "%s", real.c_str());
+      *out += real;
       break;
     }
     case TRACE_VALUE_TYPE_POINTER:
       // JSON only supports double and int numbers.
       // So as not to lose bits from a 64-bit pointer, output as a hex string.
-      StringAppendF(
+      StrAppendFormat(
           out, "\"0x%" PRIx64 "\"",
           static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value.as_pointer)));
       break;
@@ -293,9 +293,10 @@ void TraceEvent::AppendAsJSON(
 
   // Category group checked at category creation time.
   DCHECK(!strchr(name_, '"'));
-  StringAppendF(out, "{\"pid\":%i,\"tid\":%i,\"ts\":%" PRId64
-                     ",\"ph\":\"%c\",\"cat\":\"%s\",\"name\":",
-                process_id, thread_id, time_int64, phase_, category_group_name);
+  StrAppendFormat(out, "{\"pid\":%i,\"tid\":%i,\"ts\":%" PRId64
+                       ",\"ph\":\"%c\",\"cat\":\"%s\",\"name\":",
+                  process_id, thread_id, time_int64, phase_,
+                  category_group_name);
   EscapeJSONString(name_, true, out);
   *out += ",\"args\":";
 
@@ -338,23 +339,23 @@ void TraceEvent::AppendAsJSON(
   if (phase_ == TRACE_EVENT_PHASE_COMPLETE) {
     int64_t duration = duration_.ToInternalValue();
     if (duration != -1)
-      StringAppendF(out, ",\"dur\":%" PRId64, duration);
+      StrAppendFormat(out, ",\"dur\":%" PRId64, duration);
     if (!thread_timestamp_.is_null()) {
       int64_t thread_duration = thread_duration_.ToInternalValue();
       if (thread_duration != -1)
-        StringAppendF(out, ",\"tdur\":%" PRId64, thread_duration);
+        StrAppendFormat(out, ",\"tdur\":%" PRId64, thread_duration);
     }
   }
 
   // Output tts if thread_timestamp is valid.
   if (!thread_timestamp_.is_null()) {
     int64_t thread_time_int64 = thread_timestamp_.ToInternalValue();
-    StringAppendF(out, ",\"tts\":%" PRId64, thread_time_int64);
+    StrAppendFormat(out, ",\"tts\":%" PRId64, thread_time_int64);
   }
 
   // Output async tts marker field if flag is set.
   if (flags_ & TRACE_EVENT_FLAG_ASYNC_TTS) {
-    StringAppendF(out, ", \"use_async_tts\":1");
+    *out += ", \"use_async_tts\":1";
   }
 
   // If id_ is set, print it out as a hex string so we don't loose any
@@ -364,22 +365,22 @@ void TraceEvent::AppendAsJSON(
                                      TRACE_EVENT_FLAG_HAS_GLOBAL_ID);
   if (id_flags_) {
     if (scope_ != trace_event_internal::kGlobalScope)
-      StringAppendF(out, ",\"scope\":\"%s\"", scope_);
+      StrAppendFormat(out, ",\"scope\":\"%s\"", scope_);
 
     switch (id_flags_) {
       case TRACE_EVENT_FLAG_HAS_ID:
-        StringAppendF(out, ",\"id\":\"0x%" PRIx64 "\"",
-                      static_cast<uint64_t>(id_));
+        StrAppendFormat(out, ",\"id\":\"0x%" PRIx64 "\"",
+                        static_cast<uint64_t>(id_));
         break;
 
       case TRACE_EVENT_FLAG_HAS_LOCAL_ID:
-        StringAppendF(out, ",\"id2\":{\"local\":\"0x%" PRIx64 "\"}",
-                      static_cast<uint64_t>(id_));
+        StrAppendFormat(out, ",\"id2\":{\"local\":\"0x%" PRIx64 "\"}",
+                        static_cast<uint64_t>(id_));
         break;
 
       case TRACE_EVENT_FLAG_HAS_GLOBAL_ID:
-        StringAppendF(out, ",\"id2\":{\"global\":\"0x%" PRIx64 "\"}",
-                      static_cast<uint64_t>(id_));
+        StrAppendFormat(out, ",\"id2\":{\"global\":\"0x%" PRIx64 "\"}",
+                        static_cast<uint64_t>(id_));
         break;
 
       default:
@@ -389,17 +390,17 @@ void TraceEvent::AppendAsJSON(
   }
 
   if (flags_ & TRACE_EVENT_FLAG_BIND_TO_ENCLOSING)
-    StringAppendF(out, ",\"bp\":\"e\"");
+    *out += ",\"bp\":\"e\"";
 
   if ((flags_ & TRACE_EVENT_FLAG_FLOW_OUT) ||
       (flags_ & TRACE_EVENT_FLAG_FLOW_IN)) {
-    StringAppendF(out, ",\"bind_id\":\"0x%" PRIx64 "\"",
-                  static_cast<uint64_t>(bind_id_));
+    StrAppendFormat(out, ",\"bind_id\":\"0x%" PRIx64 "\"",
+                    static_cast<uint64_t>(bind_id_));
   }
   if (flags_ & TRACE_EVENT_FLAG_FLOW_IN)
-    StringAppendF(out, ",\"flow_in\":true");
+    *out += ",\"flow_in\":true";
   if (flags_ & TRACE_EVENT_FLAG_FLOW_OUT)
-    StringAppendF(out, ",\"flow_out\":true");
+    *out += ",\"flow_out\":true";
 
   // Instant events also output their scope.
   if (phase_ == TRACE_EVENT_PHASE_INSTANT) {
@@ -417,7 +418,7 @@ void TraceEvent::AppendAsJSON(
         scope = TRACE_EVENT_SCOPE_NAME_THREAD;
         break;
     }
-    StringAppendF(out, ",\"s\":\"%c\"", scope);
+    StrAppendFormat(out, ",\"s\":\"%c\"", scope);
   }
 
   *out += "}";
@@ -471,13 +472,13 @@ TraceID::AsConvertableToTraceFormat() const {
 
   if (has_prefix_) {
     value->SetString(id_field_name,
-                     base::StringPrintf("0x%" PRIx64 "/0x%" PRIx64,
-                                        static_cast<uint64_t>(prefix_),
-                                        static_cast<uint64_t>(raw_id_)));
+                     base::StrFormat("0x%" PRIx64 "/0x%" PRIx64,
+                                     static_cast<uint64_t>(prefix_),
+                                     static_cast<uint64_t>(raw_id_)));
   } else {
     value->SetString(
         id_field_name,
-        base::StringPrintf("0x%" PRIx64, static_cast<uint64_t>(raw_id_)));
+        base::StrFormat("0x%" PRIx64, static_cast<uint64_t>(raw_id_)));
   }
 
   if (id_flags_ != TRACE_EVENT_FLAG_HAS_ID)